@@ -0,0 +1,208 @@
+// 这个文件是 MCF 的一部分。
+// 有关具体授权说明，请参阅 MCFLicense.txt。
+// Copyleft 2013 - 2018, LH_Mouse. All wrongs reserved.
+
+#ifndef MCF_ALGORITHMS_PARALLEL_HPP_
+#define MCF_ALGORITHMS_PARALLEL_HPP_
+
+#include "Sort.hpp"
+#include "../Core/Cpu.hpp"
+#include "../Core/Exception.hpp"
+#include "../Core/MinMax.hpp"
+#include "../Containers/Vector.hpp"
+#include "../Thread/ThreadPool.hpp"
+#include <type_traits>
+#include <utility>
+#include <cstddef>
+
+namespace MCF {
+
+namespace Impl_Parallel {
+	enum : std::size_t {
+		kMinBlockSize = 1024,
+	};
+
+	// 每块的大小为二级缓存的一半，使得一块的输入和输出可以同时留在缓存中。
+	template<typename ElementT>
+	std::size_t GetBlockSize() noexcept {
+		const auto uCacheSize = CpuGetCacheSize(_MCFCRT_kCpuCacheLevel2);
+		return Max(uCacheSize / 2 / sizeof(ElementT), static_cast<std::size_t>(kMinBlockSize));
+	}
+
+	// 对 [0, uSize) 中的每个块调用 fnBlock(uBlockBegin, uBlockEnd)。
+	template<typename BlockFunctionT>
+	void ForEachBlock(ThreadPool &vPool, std::size_t uSize, std::size_t uBlockSize, BlockFunctionT &&fnBlock){
+		const auto uBlockCount = (uSize + uBlockSize - 1) / uBlockSize;
+		vPool.ParallelFor(0, uBlockCount, [&](std::size_t uBlock){
+			const auto uBlockBegin = uBlock * uBlockSize;
+			fnBlock(uBlockBegin, Min(uBlockBegin + uBlockSize, uSize));
+		});
+	}
+}
+
+// 以下函数把输入分成与缓存大小相当的块，在 vPool 的工作线程中处理。
+// 可以在同一线程池的工作线程中调用，此时调用者也参与计算。容器的要求与 Sort.hpp 中的函数相同。
+
+// 并行排序。先在各个块内部进行内省排序，再逐轮两两合并。每一轮的输出也被分成块，每块在两个输入序列中的起点通过二分查找确定，因此最后几轮同样可以完全并行。
+// 不稳定。需要和输入大小相同的临时存储，元素的移动构造和移动赋值不能抛出异常。
+template<typename ContainerT, typename ComparatorT = Less>
+void ParallelSort(ThreadPool &vPool, ContainerT &&vContainer, ComparatorT fnComparator = ComparatorT()){
+	using Element = std::remove_reference_t<decltype(*vContainer.GetBegin())>;
+	static_assert(std::is_nothrow_move_constructible<Element>::value, "The element type must be nothrow move-constructible.");
+	static_assert(std::is_nothrow_move_assignable<Element>::value, "The element type must be nothrow move-assignable.");
+
+	const auto pBegin = vContainer.GetBegin();
+	const auto uSize = static_cast<std::size_t>(vContainer.GetEnd() - pBegin);
+	const auto uBlockSize = Impl_Parallel::GetBlockSize<Element>();
+	if((uSize <= uBlockSize) || (vPool.GetWorkerCount() <= 1)){
+		Impl_Sort::IntroSort(pBegin, pBegin + uSize, fnComparator);
+		return;
+	}
+
+	Impl_Parallel::ForEachBlock(vPool, uSize, uBlockSize, [&](std::size_t uBlockBegin, std::size_t uBlockEnd){
+		Impl_Sort::IntroSort(pBegin + uBlockBegin, pBegin + uBlockEnd, fnComparator);
+	});
+
+	Impl_Sort::ScratchBuffer<Element> vBuffer(uSize);
+	const auto pBuffer = vBuffer.GetData();
+	Impl_Parallel::ForEachBlock(vPool, uSize, uBlockSize, [&](std::size_t uBlockBegin, std::size_t uBlockEnd){
+		for(auto uIndex = uBlockBegin; uIndex < uBlockEnd; ++uIndex){
+			Construct(pBuffer + uIndex, std::move(pBegin[uIndex]));
+		}
+	});
+	vBuffer.SetConstructedSize(uSize);
+
+	auto pSource = pBuffer;
+	auto pDestination = pBegin;
+	for(auto uRunLength = uBlockSize; uRunLength < uSize; uRunLength *= 2){
+		// 有序段的长度是块大小的整数倍，因此每个输出块都完全位于一对有序段的合并结果之中。
+		Impl_Parallel::ForEachBlock(vPool, uSize, uBlockSize, [&](std::size_t uBlockBegin, std::size_t uBlockEnd){
+			const auto uPairBegin = uBlockBegin / (uRunLength * 2) * (uRunLength * 2);
+			const auto uMiddle = Min(uPairBegin + uRunLength, uSize);
+			const auto uPairEnd = Min(uPairBegin + uRunLength * 2, uSize);
+			const auto pFirst = pSource + uPairBegin;
+			const auto uFirstSize = uMiddle - uPairBegin;
+			const auto pSecond = pSource + uMiddle;
+			const auto uSecondSize = uPairEnd - uMiddle;
+			const auto uRankBegin = uBlockBegin - uPairBegin;
+			const auto uRankEnd = uBlockEnd - uPairBegin;
+			const auto uFirstBegin = Impl_Sort::FindMergeSplit(uRankBegin, pFirst, uFirstSize, pSecond, uSecondSize, fnComparator);
+			const auto uFirstEnd = Impl_Sort::FindMergeSplit(uRankEnd, pFirst, uFirstSize, pSecond, uSecondSize, fnComparator);
+			Impl_Sort::MergeMove(pFirst + uFirstBegin, pFirst + uFirstEnd, pSecond + (uRankBegin - uFirstBegin), pSecond + (uRankEnd - uFirstEnd),
+				pDestination + uBlockBegin, fnComparator);
+		});
+		std::swap(pSource, pDestination);
+	}
+	if(pSource != pBegin){
+		Impl_Parallel::ForEachBlock(vPool, uSize, uBlockSize, [&](std::size_t uBlockBegin, std::size_t uBlockEnd){
+			for(auto uIndex = uBlockBegin; uIndex < uBlockEnd; ++uIndex){
+				pBegin[uIndex] = std::move(pSource[uIndex]);
+			}
+		});
+	}
+}
+
+// 对每个下标 i 执行 vOutput[i] = fnTransform(vInput[i])。输入和输出的大小必须相同，可以是同一个容器。
+template<typename OutputContainerT, typename InputContainerT, typename TransformT>
+void ParallelTransform(ThreadPool &vPool, OutputContainerT &&vOutput, InputContainerT &&vInput, TransformT &&fnTransform){
+	using Element = std::remove_reference_t<decltype(*vOutput.GetBegin())>;
+
+	const auto pOutput = vOutput.GetBegin();
+	const auto pInput = vInput.GetBegin();
+	const auto uSize = static_cast<std::size_t>(vInput.GetEnd() - pInput);
+	if(static_cast<std::size_t>(vOutput.GetEnd() - pOutput) != uSize){
+		MCF_THROW(Exception, ERROR_INVALID_PARAMETER, Rcntws::View(L"ParallelTransform: 输入和输出的大小不一致。"));
+	}
+	Impl_Parallel::ForEachBlock(vPool, uSize, Impl_Parallel::GetBlockSize<Element>(), [&](std::size_t uBlockBegin, std::size_t uBlockEnd){
+		for(auto uIndex = uBlockBegin; uIndex < uBlockEnd; ++uIndex){
+			pOutput[uIndex] = fnTransform(pInput[uIndex]);
+		}
+	});
+}
+
+// 返回 fnReducer(... fnReducer(fnReducer(vInit, vInput[0]), vInput[1]) ..., vInput[n - 1])。
+// 各个块的部分结果以元素本身为初值，因此 fnReducer 必须满足结合律，但 vInit 不需要是单位元。
+template<typename InputContainerT, typename ValueT, typename ReducerT>
+std::decay_t<ValueT> ParallelReduce(ThreadPool &vPool, InputContainerT &&vInput, ValueT &&vInit, ReducerT &&fnReducer){
+	using Value = std::decay_t<ValueT>;
+	using Element = std::remove_reference_t<decltype(*vInput.GetBegin())>;
+
+	const auto pInput = vInput.GetBegin();
+	const auto uSize = static_cast<std::size_t>(vInput.GetEnd() - pInput);
+	const auto uBlockSize = Impl_Parallel::GetBlockSize<Element>();
+	Value vResult(std::forward<ValueT>(vInit));
+	if(uSize <= uBlockSize){
+		for(std::size_t uIndex = 0; uIndex < uSize; ++uIndex){
+			vResult = fnReducer(std::move(vResult), pInput[uIndex]);
+		}
+		return vResult;
+	}
+
+	Vector<Value> vecPartials;
+	vecPartials.Append((uSize + uBlockSize - 1) / uBlockSize, vResult);
+	Impl_Parallel::ForEachBlock(vPool, uSize, uBlockSize, [&](std::size_t uBlockBegin, std::size_t uBlockEnd){
+		Value vPartial(pInput[uBlockBegin]);
+		for(auto uIndex = uBlockBegin + 1; uIndex < uBlockEnd; ++uIndex){
+			vPartial = fnReducer(std::move(vPartial), pInput[uIndex]);
+		}
+		vecPartials[uBlockBegin / uBlockSize] = std::move(vPartial);
+	});
+	for(auto &vPartial : vecPartials){
+		vResult = fnReducer(std::move(vResult), std::move(vPartial));
+	}
+	return vResult;
+}
+
+// 令 vOutput[0] = vInput[0]，vOutput[i] = fnScanner(vOutput[i - 1], vInput[i])。输入和输出的大小必须相同，可以是同一个容器。
+// 第一趟计算每块的总和，然后顺序计算各块的前缀，第二趟在各块内部扫描。fnScanner 必须满足结合律。
+template<typename OutputContainerT, typename InputContainerT, typename ScannerT>
+void ParallelInclusiveScan(ThreadPool &vPool, OutputContainerT &&vOutput, InputContainerT &&vInput, ScannerT &&fnScanner){
+	using Value = std::remove_cv_t<std::remove_reference_t<decltype(*vOutput.GetBegin())>>;
+
+	const auto pOutput = vOutput.GetBegin();
+	const auto pInput = vInput.GetBegin();
+	const auto uSize = static_cast<std::size_t>(vInput.GetEnd() - pInput);
+	if(static_cast<std::size_t>(vOutput.GetEnd() - pOutput) != uSize){
+		MCF_THROW(Exception, ERROR_INVALID_PARAMETER, Rcntws::View(L"ParallelInclusiveScan: 输入和输出的大小不一致。"));
+	}
+	if(uSize == 0){
+		return;
+	}
+	const auto uBlockSize = Impl_Parallel::GetBlockSize<Value>();
+	if(uSize <= uBlockSize){
+		Value vSum(pInput[0]);
+		pOutput[0] = vSum;
+		for(std::size_t uIndex = 1; uIndex < uSize; ++uIndex){
+			vSum = fnScanner(std::move(vSum), pInput[uIndex]);
+			pOutput[uIndex] = vSum;
+		}
+		return;
+	}
+
+	Vector<Value> vecSums;
+	vecSums.Append((uSize + uBlockSize - 1) / uBlockSize, pInput[0]);
+	Impl_Parallel::ForEachBlock(vPool, uSize, uBlockSize, [&](std::size_t uBlockBegin, std::size_t uBlockEnd){
+		Value vSum(pInput[uBlockBegin]);
+		for(auto uIndex = uBlockBegin + 1; uIndex < uBlockEnd; ++uIndex){
+			vSum = fnScanner(std::move(vSum), pInput[uIndex]);
+		}
+		vecSums[uBlockBegin / uBlockSize] = std::move(vSum);
+	});
+	for(std::size_t uBlock = 1; uBlock < vecSums.GetSize(); ++uBlock){
+		vecSums[uBlock] = fnScanner(vecSums[uBlock - 1], std::move(vecSums[uBlock]));
+	}
+	// 原地扫描时，每个元素都在被覆盖之前读取。
+	Impl_Parallel::ForEachBlock(vPool, uSize, uBlockSize, [&](std::size_t uBlockBegin, std::size_t uBlockEnd){
+		const auto uBlock = uBlockBegin / uBlockSize;
+		Value vSum((uBlock == 0) ? Value(pInput[uBlockBegin]) : fnScanner(vecSums[uBlock - 1], pInput[uBlockBegin]));
+		pOutput[uBlockBegin] = vSum;
+		for(auto uIndex = uBlockBegin + 1; uIndex < uBlockEnd; ++uIndex){
+			vSum = fnScanner(std::move(vSum), pInput[uIndex]);
+			pOutput[uIndex] = vSum;
+		}
+	});
+}
+
+}
+
+#endif
@@ -0,0 +1,363 @@
+// 这个文件是 MCF 的一部分。
+// 有关具体授权说明，请参阅 MCFLicense.txt。
+// Copyleft 2013 - 2018, LH_Mouse. All wrongs reserved.
+
+#ifndef MCF_ALGORITHMS_SORT_HPP_
+#define MCF_ALGORITHMS_SORT_HPP_
+
+#include "../Core/ConstructDestruct.hpp"
+#include "../Core/CountLeadingTrailingZeroes.hpp"
+#include "../Core/MinMax.hpp"
+#include "../SmartPointers/UniquePtr.hpp"
+#include "../Function/Comparators.hpp"
+#include <type_traits>
+#include <utility>
+#include <climits>
+#include <cstddef>
+#include <new>
+
+namespace MCF {
+
+namespace Impl_Sort {
+	enum : std::size_t {
+		kInsertionSortThreshold = 16,
+		kMergeSortRunLength     = 32,
+	};
+
+	template<typename ElementT, typename ComparatorT>
+	void InsertionSort(ElementT *pBegin, ElementT *pEnd, ComparatorT &fnComparator){
+		if(pBegin == pEnd){
+			return;
+		}
+		for(auto pCur = pBegin + 1; pCur != pEnd; ++pCur){
+			if(fnComparator(*pCur, *pBegin)){
+				auto vValue = std::move(*pCur);
+				for(auto pHole = pCur; pHole != pBegin; --pHole){
+					*pHole = std::move(pHole[-1]);
+				}
+				*pBegin = std::move(vValue);
+			} else {
+				// *pBegin 不大于 vValue，因此下面的循环不会越过 pBegin。
+				auto vValue = std::move(*pCur);
+				auto pHole = pCur;
+				while(fnComparator(vValue, pHole[-1])){
+					*pHole = std::move(pHole[-1]);
+					--pHole;
+				}
+				*pHole = std::move(vValue);
+			}
+		}
+	}
+
+	template<typename ElementT, typename ComparatorT>
+	void SiftDown(ElementT *pBase, std::size_t uHole, std::size_t uSize, ElementT vValue, ComparatorT &fnComparator){
+		for(;;){
+			auto uChild = uHole * 2 + 1;
+			if(uChild >= uSize){
+				break;
+			}
+			if((uChild + 1 < uSize) && fnComparator(pBase[uChild], pBase[uChild + 1])){
+				++uChild;
+			}
+			if(!fnComparator(vValue, pBase[uChild])){
+				break;
+			}
+			pBase[uHole] = std::move(pBase[uChild]);
+			uHole = uChild;
+		}
+		pBase[uHole] = std::move(vValue);
+	}
+	template<typename ElementT, typename ComparatorT>
+	void HeapSort(ElementT *pBegin, ElementT *pEnd, ComparatorT &fnComparator){
+		const auto uSize = static_cast<std::size_t>(pEnd - pBegin);
+		for(auto uIndex = uSize / 2; uIndex != 0; --uIndex){
+			SiftDown(pBegin, uIndex - 1, uSize, std::move(pBegin[uIndex - 1]), fnComparator);
+		}
+		for(auto uLast = uSize; uLast > 1; --uLast){
+			auto vValue = std::move(pBegin[uLast - 1]);
+			pBegin[uLast - 1] = std::move(pBegin[0]);
+			SiftDown(pBegin, 0, uLast - 1, std::move(vValue), fnComparator);
+		}
+	}
+
+	// 把 *pFirst、*pSecond 和 *pThird 的中位数交换到 *pResult。
+	template<typename ElementT, typename ComparatorT>
+	void MoveMedianToFirst(ElementT *pResult, ElementT *pFirst, ElementT *pSecond, ElementT *pThird, ComparatorT &fnComparator){
+		using std::swap;
+
+		if(fnComparator(*pFirst, *pSecond)){
+			if(fnComparator(*pSecond, *pThird)){
+				swap(*pResult, *pSecond);
+			} else if(fnComparator(*pFirst, *pThird)){
+				swap(*pResult, *pThird);
+			} else {
+				swap(*pResult, *pFirst);
+			}
+		} else {
+			if(fnComparator(*pFirst, *pThird)){
+				swap(*pResult, *pFirst);
+			} else if(fnComparator(*pSecond, *pThird)){
+				swap(*pResult, *pThird);
+			} else {
+				swap(*pResult, *pSecond);
+			}
+		}
+	}
+	// 枢轴位于 *pBegin，且 [pBegin + 1, pEnd) 中既有不小于它的元素也有不大于它的元素，因此两个扫描都不需要检查边界。
+	template<typename ElementT, typename ComparatorT>
+	ElementT *Partition(ElementT *pBegin, ElementT *pEnd, ComparatorT &fnComparator){
+		using std::swap;
+
+		auto pLeft = pBegin + 1;
+		auto pRight = pEnd;
+		for(;;){
+			while(fnComparator(*pLeft, *pBegin)){
+				++pLeft;
+			}
+			--pRight;
+			while(fnComparator(*pBegin, *pRight)){
+				--pRight;
+			}
+			if(pLeft >= pRight){
+				return pLeft;
+			}
+			swap(*pLeft, *pRight);
+			++pLeft;
+		}
+	}
+
+	template<typename ElementT, typename ComparatorT>
+	void IntroSortLoop(ElementT *pBegin, ElementT *pEnd, unsigned uDepthLimit, ComparatorT &fnComparator){
+		while(static_cast<std::size_t>(pEnd - pBegin) > kInsertionSortThreshold){
+			if(uDepthLimit == 0){
+				HeapSort(pBegin, pEnd, fnComparator);
+				return;
+			}
+			--uDepthLimit;
+			MoveMedianToFirst(pBegin, pBegin + 1, pBegin + (pEnd - pBegin) / 2, pEnd - 1, fnComparator);
+			const auto pCut = Partition(pBegin, pEnd, fnComparator);
+			// 递归处理较短的一半，保证栈的深度是对数级别的。
+			if(pCut - pBegin < pEnd - pCut){
+				IntroSortLoop(pBegin, pCut, uDepthLimit, fnComparator);
+				pBegin = pCut;
+			} else {
+				IntroSortLoop(pCut, pEnd, uDepthLimit, fnComparator);
+				pEnd = pCut;
+			}
+		}
+		InsertionSort(pBegin, pEnd, fnComparator);
+	}
+	template<typename ElementT, typename ComparatorT>
+	void IntroSort(ElementT *pBegin, ElementT *pEnd, ComparatorT &fnComparator){
+		const auto uSize = static_cast<std::size_t>(pEnd - pBegin);
+		if(uSize < 2){
+			return;
+		}
+		const auto uLog2 = sizeof(std::size_t) * CHAR_BIT - 1 - CountLeadingZeroes(uSize);
+		IntroSortLoop(pBegin, pEnd, static_cast<unsigned>(uLog2 * 2), fnComparator);
+	}
+
+	// 把两个有序序列移动合并到 pOutput。相等的元素中，第一个序列中的排在前面。
+	template<typename ElementT, typename ComparatorT>
+	ElementT *MergeMove(ElementT *pFirst, ElementT *pFirstEnd, ElementT *pSecond, ElementT *pSecondEnd, ElementT *pOutput, ComparatorT &fnComparator){
+		while((pFirst != pFirstEnd) && (pSecond != pSecondEnd)){
+			if(fnComparator(*pSecond, *pFirst)){
+				*pOutput = std::move(*pSecond);
+				++pSecond;
+			} else {
+				*pOutput = std::move(*pFirst);
+				++pFirst;
+			}
+			++pOutput;
+		}
+		while(pFirst != pFirstEnd){
+			*pOutput = std::move(*pFirst);
+			++pFirst;
+			++pOutput;
+		}
+		while(pSecond != pSecondEnd){
+			*pOutput = std::move(*pSecond);
+			++pSecond;
+			++pOutput;
+		}
+		return pOutput;
+	}
+	// 返回 i，使得合并 pFirst[0, uFirstSize) 和 pSecond[0, uSecondSize) 的结果中，前 uRank 个元素恰好由 pFirst[0, i) 和 pSecond[0, uRank - i) 组成。
+	template<typename ElementT, typename ComparatorT>
+	std::size_t FindMergeSplit(std::size_t uRank, const ElementT *pFirst, std::size_t uFirstSize, const ElementT *pSecond, std::size_t uSecondSize, ComparatorT &fnComparator){
+		auto uLow = (uRank > uSecondSize) ? (uRank - uSecondSize) : 0;
+		auto uHigh = Min(uRank, uFirstSize);
+		while(uLow < uHigh){
+			const auto uMiddle = uLow + (uHigh - uLow) / 2;
+			const auto uSecondIndex = uRank - uMiddle;
+			// 如果 pSecond[j - 1] 不小于 pFirst[i]，后者应当排在前面，因此 i 太小了。
+			if((uSecondIndex != 0) && !fnComparator(pSecond[uSecondIndex - 1], pFirst[uMiddle])){
+				uLow = uMiddle + 1;
+			} else {
+				uHigh = uMiddle;
+			}
+		}
+		return uLow;
+	}
+
+	// 未初始化的临时存储。调用者负责构造元素，并通过 SetConstructedSize() 告知需要析构的元素数目。
+	template<typename ElementT>
+	class ScratchBuffer {
+		static_assert(alignof(ElementT) <= alignof(std::max_align_t), "Over-aligned types are not supported.");
+
+	private:
+		ElementT *x_pData;
+		std::size_t x_uConstructedSize;
+
+	public:
+		explicit ScratchBuffer(std::size_t uCapacity)
+			: x_pData(static_cast<ElementT *>(::operator new(uCapacity * sizeof(ElementT)))), x_uConstructedSize(0)
+		{ }
+		~ScratchBuffer(){
+			for(std::size_t uIndex = 0; uIndex < x_uConstructedSize; ++uIndex){
+				Destruct(x_pData + uIndex);
+			}
+			::operator delete(x_pData);
+		}
+
+		ScratchBuffer(const ScratchBuffer &) = delete;
+		ScratchBuffer &operator=(const ScratchBuffer &) = delete;
+
+	public:
+		ElementT *GetData() const noexcept {
+			return x_pData;
+		}
+		void SetConstructedSize(std::size_t uConstructedSize) noexcept {
+			x_uConstructedSize = uConstructedSize;
+		}
+	};
+
+	template<typename ElementT, typename ComparatorT>
+	void MergeSort(ElementT *pBegin, ElementT *pEnd, ComparatorT &fnComparator){
+		static_assert(std::is_nothrow_move_constructible<ElementT>::value, "The element type must be nothrow move-constructible.");
+		static_assert(std::is_nothrow_move_assignable<ElementT>::value, "The element type must be nothrow move-assignable.");
+
+		const auto uSize = static_cast<std::size_t>(pEnd - pBegin);
+		if(uSize <= kMergeSortRunLength){
+			InsertionSort(pBegin, pEnd, fnComparator);
+			return;
+		}
+		ScratchBuffer<ElementT> vBuffer(uSize);
+		for(std::size_t uIndex = 0; uIndex < uSize; ++uIndex){
+			Construct(vBuffer.GetData() + uIndex, std::move(pBegin[uIndex]));
+		}
+		vBuffer.SetConstructedSize(uSize);
+
+		// 插入排序是稳定的，先用它生成有序段，然后自底向上在两块存储之间来回合并。
+		auto pSource = vBuffer.GetData();
+		auto pDestination = pBegin;
+		for(std::size_t uOffset = 0; uOffset < uSize; uOffset += kMergeSortRunLength){
+			InsertionSort(pSource + uOffset, pSource + Min(uOffset + kMergeSortRunLength, uSize), fnComparator);
+		}
+		for(std::size_t uRunLength = kMergeSortRunLength; uRunLength < uSize; uRunLength *= 2){
+			for(std::size_t uOffset = 0; uOffset < uSize; uOffset += uRunLength * 2){
+				const auto uMiddle = Min(uOffset + uRunLength, uSize);
+				const auto uLast = Min(uOffset + uRunLength * 2, uSize);
+				MergeMove(pSource + uOffset, pSource + uMiddle, pSource + uMiddle, pSource + uLast, pDestination + uOffset, fnComparator);
+			}
+			std::swap(pSource, pDestination);
+		}
+		if(pSource != pBegin){
+			for(std::size_t uIndex = 0; uIndex < uSize; ++uIndex){
+				pBegin[uIndex] = std::move(pSource[uIndex]);
+			}
+		}
+	}
+
+	template<typename ElementT>
+	auto GetRadixKey(ElementT vElement) noexcept {
+		using Key = std::make_unsigned_t<ElementT>;
+
+		auto uKey = static_cast<Key>(vElement);
+		if(std::is_signed<ElementT>::value){
+			// 翻转符号位，使负数排在前面。
+			uKey ^= static_cast<Key>(Key(1) << (sizeof(Key) * CHAR_BIT - 1));
+		}
+		return uKey;
+	}
+	template<typename ElementT>
+	void RadixSort(ElementT *pBegin, ElementT *pEnd){
+		enum : std::size_t {
+			kDigitBits  = 8,
+			kRadix      = 1u << kDigitBits,
+			kPassCount  = sizeof(ElementT) * CHAR_BIT / kDigitBits,
+		};
+
+		const auto uSize = static_cast<std::size_t>(pEnd - pBegin);
+		if(uSize <= kInsertionSortThreshold){
+			Less fnComparator;
+			InsertionSort(pBegin, pEnd, fnComparator);
+			return;
+		}
+
+		// 一次扫描统计所有位的直方图。
+		std::size_t auCounts[kPassCount][kRadix] = { };
+		for(std::size_t uIndex = 0; uIndex < uSize; ++uIndex){
+			const auto uKey = GetRadixKey(pBegin[uIndex]);
+			for(std::size_t uPass = 0; uPass < kPassCount; ++uPass){
+				++auCounts[uPass][(uKey >> (uPass * kDigitBits)) & (kRadix - 1)];
+			}
+		}
+
+		UniquePtr<ElementT [], DefaultDeleter<ElementT []>> pBuffer(new ElementT[uSize]);
+		auto pSource = pBegin;
+		auto pDestination = pBuffer.Get();
+		for(std::size_t uPass = 0; uPass < kPassCount; ++uPass){
+			const auto puCounts = auCounts[uPass];
+			const auto uShift = uPass * kDigitBits;
+			// 如果所有元素的这一位都相同，这一趟不会改变顺序。
+			if(puCounts[(GetRadixKey(pSource[0]) >> uShift) & (kRadix - 1)] == uSize){
+				continue;
+			}
+			std::size_t uOffset = 0;
+			for(std::size_t uDigit = 0; uDigit < kRadix; ++uDigit){
+				const auto uCount = puCounts[uDigit];
+				puCounts[uDigit] = uOffset;
+				uOffset += uCount;
+			}
+			for(std::size_t uIndex = 0; uIndex < uSize; ++uIndex){
+				const auto vElement = pSource[uIndex];
+				pDestination[puCounts[(GetRadixKey(vElement) >> uShift) & (kRadix - 1)]++] = vElement;
+			}
+			std::swap(pSource, pDestination);
+		}
+		if(pSource != pBegin){
+			for(std::size_t uIndex = 0; uIndex < uSize; ++uIndex){
+				pBegin[uIndex] = pSource[uIndex];
+			}
+		}
+	}
+}
+
+// 以下函数接受 ArrayView、Vector 或者任何提供 GetBegin() 和 GetEnd() 并返回元素指针的容器。
+// 比较器不应抛出异常，否则元素的顺序及其值都是未指定的。
+
+// 内省排序。不稳定，最坏情况下时间复杂度为 O(n log n)，不需要额外的存储。
+template<typename ContainerT, typename ComparatorT = Less>
+void Sort(ContainerT &&vContainer, ComparatorT fnComparator = ComparatorT()){
+	Impl_Sort::IntroSort(vContainer.GetBegin(), vContainer.GetEnd(), fnComparator);
+}
+
+// 归并排序。稳定，需要和输入大小相同的临时存储。元素的移动构造和移动赋值不能抛出异常。
+template<typename ContainerT, typename ComparatorT = Less>
+void StableSort(ContainerT &&vContainer, ComparatorT fnComparator = ComparatorT()){
+	Impl_Sort::MergeSort(vContainer.GetBegin(), vContainer.GetEnd(), fnComparator);
+}
+
+// 对整数按升序进行 LSD 基数排序，每趟处理 8 位。需要和输入大小相同的临时存储。
+template<typename ContainerT>
+void RadixSort(ContainerT &&vContainer){
+	using Element = std::remove_reference_t<decltype(*vContainer.GetBegin())>;
+	static_assert(std::is_integral<Element>::value && !std::is_same<std::remove_cv_t<Element>, bool>::value, "Only integral keys can be radix-sorted.");
+
+	Impl_Sort::RadixSort(vContainer.GetBegin(), vContainer.GetEnd());
+}
+
+}
+
+#endif
@@ -328,6 +328,11 @@ public:
 			uElementsToAlloc = uNewCapacity;
 		}
 		const auto uBytesToAlloc = Impl_CheckedSizeArithmetic::Mul(sizeof(Element), uElementsToAlloc);
+		if(Impl_DefaultAllocator::TryExpandInPlace(Allocator(), x_pStorage, uBytesToAlloc)){
+			// 原地扩展成功，无需移动元素。内存块的剩余部分也可以使用。
+			x_uCapacity = Impl_DefaultAllocator::GetUsableSize(Allocator(), x_pStorage, uBytesToAlloc) / sizeof(Element);
+			return;
+		}
 		const auto pNewStorage = static_cast<Element *>(Allocator()(uBytesToAlloc));
 		const auto pOldStorage = x_pStorage;
 		auto pWrite = pNewStorage;
@@ -350,7 +355,7 @@ public:
 		Allocator()(static_cast<void *>(pOldStorage));
 
 		x_pStorage  = pNewStorage;
-		x_uCapacity = uElementsToAlloc;
+		x_uCapacity = Impl_DefaultAllocator::GetUsableSize(Allocator(), pNewStorage, uBytesToAlloc) / sizeof(Element);
 	}
 	void ReserveMore(std::size_t uDeltaCapacity){
 		const auto uNewCapacity = Impl_CheckedSizeArithmetic::Add(uDeltaCapacity, GetSize());
@@ -0,0 +1,153 @@
+// 这个文件是 MCF 的一部分。
+// 有关具体授权说明，请参阅 MCFLicense.txt。
+// Copyleft 2013 - 2018, LH_Mouse. All wrongs reserved.
+
+#ifndef MCF_CORE_ARENA_HPP_
+#define MCF_CORE_ARENA_HPP_
+
+#include "UniqueHandle.hpp"
+#include "Assert.hpp"
+#include <MCFCRT/env/arena.h>
+#include <new>
+#include <cstddef>
+
+namespace MCF {
+
+// 区域分配器。内存块不能单独释放，只能通过 Reset() 一并释放。非线程安全。
+class Arena {
+private:
+	struct X_ArenaDeleter {
+		constexpr ::_MCFCRT_Arena *operator()() const noexcept {
+			return nullptr;
+		}
+		void operator()(::_MCFCRT_Arena *pArena) const noexcept {
+			::_MCFCRT_ArenaDestroy(pArena);
+		}
+	};
+
+private:
+	UniqueHandle<X_ArenaDeleter> x_pArena;
+
+public:
+	explicit Arena(std::size_t uChunkSize = 0){
+		const auto pTemp = ::_MCFCRT_ArenaCreate(uChunkSize);
+		if(!pTemp){
+			throw std::bad_alloc();
+		}
+		x_pArena.Reset(pTemp);
+	}
+
+public:
+	__attribute__((__malloc__))
+	void *Allocate(std::size_t uSize, std::size_t uAlignment = _MCFCRT_ARENA_DEFAULT_ALIGNMENT){
+		const auto pBlock = ::_MCFCRT_ArenaAlloc(x_pArena.Get(), uSize, uAlignment);
+		if(!pBlock){
+			throw std::bad_alloc();
+		}
+		return pBlock;
+	}
+	__attribute__((__malloc__))
+	void *Allocate(const std::nothrow_t &, std::size_t uSize, std::size_t uAlignment = _MCFCRT_ARENA_DEFAULT_ALIGNMENT) noexcept {
+		return ::_MCFCRT_ArenaAlloc(x_pArena.Get(), uSize, uAlignment);
+	}
+	void Reset() noexcept {
+		::_MCFCRT_ArenaReset(x_pArena.Get());
+	}
+
+	void Swap(Arena &vOther) noexcept {
+		using std::swap;
+		swap(x_pArena, vOther.x_pArena);
+	}
+
+public:
+	friend void swap(Arena &vSelf, Arena &vOther) noexcept {
+		vSelf.Swap(vOther);
+	}
+};
+
+// 用法：
+//   static Arena s_vArena;
+//   Vector<int, ArenaAllocator<s_vArena>> vecInts;
+// 释放操作什么都不做，内存在 s_vArena.Reset() 时一并回收。容器必须在此之前析构或清空。
+// 模板参数只能引用具有静态存储期的区域分配器。由于 Arena 不是线程安全的，所有使用它的容器都只能在同一线程中增长。
+// 对于每个请求或每个线程各自的区域分配器，请使用下面的 ArenaScope 和 ThreadLocalArenaAllocator。
+template<Arena &kArena>
+struct ArenaAllocator {
+	__attribute__((__malloc__))
+	void *operator()(std::size_t uSize){
+		return kArena.Allocate(uSize);
+	}
+	__attribute__((__malloc__))
+	void *operator()(const std::nothrow_t &, std::size_t uSize) noexcept {
+		return kArena.Allocate(std::nothrow, uSize);
+	}
+	void operator()(void * /* pBlock */) noexcept {
+	}
+};
+
+// 在本对象的生存期内，把一个区域分配器绑定到当前线程。可以嵌套，最内层的优先。
+// 必须按照构造的相反顺序析构，并且不能跨线程传递。
+class ArenaScope {
+private:
+	static ArenaScope *&X_GetInnermost() noexcept {
+		static thread_local ArenaScope *s_pInnermost = nullptr;
+		return s_pInnermost;
+	}
+
+public:
+	// 返回当前线程最内层的 ArenaScope 所绑定的区域分配器；如果没有，返回 nullptr。
+	static Arena *GetCurrentArena() noexcept {
+		const auto pInnermost = X_GetInnermost();
+		if(!pInnermost){
+			return nullptr;
+		}
+		return pInnermost->x_pArena;
+	}
+
+private:
+	Arena *x_pArena;
+	ArenaScope *x_pOuter;
+
+public:
+	explicit ArenaScope(Arena &vArena) noexcept
+		: x_pArena(&vArena), x_pOuter(X_GetInnermost())
+	{
+		X_GetInnermost() = this;
+	}
+	~ArenaScope(){
+		MCF_ASSERT_MSG(X_GetInnermost() == this, L"ArenaScope 没有按照构造的相反顺序析构。");
+		X_GetInnermost() = x_pOuter;
+	}
+
+	ArenaScope(const ArenaScope &) = delete;
+	ArenaScope &operator=(const ArenaScope &) = delete;
+};
+
+// 用法：
+//   Arena vArena;
+//   const ArenaScope vScope(vArena);
+//   Vector<int, ThreadLocalArenaAllocator> vecInts;
+// 内存从当前线程最内层的 ArenaScope 所绑定的区域分配器中分配，因此区域分配器可以是局部变量，每个线程或每个请求使用自己的一个。
+// 容器只能在绑定了区域分配器的线程中增长，并且在不同的 ArenaScope 中增长时会从不同的区域分配器中分配内存。
+// 释放操作什么都不做。容器必须在它用到的所有区域分配器被重置或析构之前析构或清空。
+struct ThreadLocalArenaAllocator {
+	__attribute__((__malloc__))
+	void *operator()(std::size_t uSize){
+		const auto pArena = ArenaScope::GetCurrentArena();
+		MCF_ASSERT_MSG(pArena, L"当前线程没有绑定区域分配器。");
+		return pArena->Allocate(uSize);
+	}
+	__attribute__((__malloc__))
+	void *operator()(const std::nothrow_t &, std::size_t uSize) noexcept {
+		const auto pArena = ArenaScope::GetCurrentArena();
+		if(!pArena){
+			return nullptr;
+		}
+		return pArena->Allocate(std::nothrow, uSize);
+	}
+	void operator()(void * /* pBlock */) noexcept {
+	}
+};
+}
+
+#endif
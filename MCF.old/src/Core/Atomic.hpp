@@ -5,8 +5,10 @@
 #ifndef MCF_CORE_ATOMIC_HPP_
 #define MCF_CORE_ATOMIC_HPP_
 
+#include <MCFCRT/env/wait_on_address.h>
 #include <type_traits>
 #include <cstddef>
+#include <cstdint>
 #include "AddressOf.hpp"
 
 namespace MCF {
@@ -192,6 +194,22 @@ public:
 	{
 		return SubFetch(1, eModel);
 	}
+
+	// 如果当前值等于 vExpected 则睡眠，直到被 NotifyOne() 或 NotifyAll() 唤醒或超时。可能出现虚假唤醒，返回后需重新检查。
+	// 仅在超时的情况下返回 false。
+	bool Wait(const Element &vExpected, std::uint64_t u64UntilFastMonoClock) const volatile noexcept {
+		return ::_MCFCRT_WaitOnAddress(AddressOf(x_vElement), AddressOf(vExpected), sizeof(Element), u64UntilFastMonoClock);
+	}
+	void Wait(const Element &vExpected) const volatile noexcept {
+		::_MCFCRT_WaitOnAddressForever(AddressOf(x_vElement), AddressOf(vExpected), sizeof(Element));
+	}
+	// 修改值之后调用。返回被唤醒的线程数。
+	std::size_t NotifyOne() const volatile noexcept {
+		return ::_MCFCRT_WakeByAddressSingle(AddressOf(x_vElement));
+	}
+	std::size_t NotifyAll() const volatile noexcept {
+		return ::_MCFCRT_WakeByAddressAll(AddressOf(x_vElement));
+	}
 };
 
 inline void AtomicFence(MemoryModel eModel) noexcept {
@@ -0,0 +1,39 @@
+// 这个文件是 MCF 的一部分。
+// 有关具体授权说明，请参阅 MCFLicense.txt。
+// Copyleft 2013 - 2018, LH_Mouse. All wrongs reserved.
+
+#ifndef MCF_CORE_CPU_HPP_
+#define MCF_CORE_CPU_HPP_
+
+#include <MCFCRT/env/cpu.h>
+#include <cstddef>
+
+namespace MCF {
+
+using CpuCacheLevel = ::_MCFCRT_CpuCacheLevel;
+using CpuFeature    = ::_MCFCRT_CpuFeature;
+
+inline std::size_t CpuGetCacheSize(CpuCacheLevel eLevel) noexcept {
+	return ::_MCFCRT_CpuGetCacheSize(eLevel);
+}
+inline std::size_t CpuGetLineSize() noexcept {
+	return ::_MCFCRT_CpuGetLineSize();
+}
+
+inline bool CpuHasFeature(CpuFeature eFeature) noexcept {
+	return ::_MCFCRT_CpuHasFeature(eFeature);
+}
+
+inline std::size_t CpuGetLogicalCount() noexcept {
+	return ::_MCFCRT_CpuGetLogicalCount();
+}
+inline std::size_t CpuGetCoreCount() noexcept {
+	return ::_MCFCRT_CpuGetCoreCount();
+}
+inline std::size_t CpuGetPackageCount() noexcept {
+	return ::_MCFCRT_CpuGetPackageCount();
+}
+
+}
+
+#endif
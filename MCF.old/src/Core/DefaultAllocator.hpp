@@ -5,25 +5,73 @@
 #ifndef MCF_CORE_DEFAULT_ALLOCATOR_HPP_
 #define MCF_CORE_DEFAULT_ALLOCATOR_HPP_
 
+#include <MCFCRT/env/heap.h>
 #include <new>
+#include <utility>
 #include <cstddef>
 
 namespace MCF {
 
+// 内存块直接从 CRT 堆分配，而不经过可被替换的 `::operator new`，因为原地扩展和查询可用大小只对 CRT 堆中的内存块有效。
 struct DefaultAllocator {
 	__attribute__((__malloc__))
 	void *operator()(std::size_t uSize){
-		return ::operator new(uSize);
+		const auto pBlock = ::_MCFCRT_malloc(uSize);
+		if(!pBlock){
+			throw std::bad_alloc();
+		}
+		return pBlock;
 	}
 	__attribute__((__malloc__))
 	void *operator()(const std::nothrow_t &, std::size_t uSize) noexcept {
-		return ::operator new(uSize, std::nothrow);
+		return ::_MCFCRT_malloc(uSize);
 	}
 	void operator()(void *pBlock) noexcept {
-		::operator delete(pBlock);
+		::_MCFCRT_free(pBlock);
+	}
+	bool operator()(void *pBlock, std::size_t uSize) noexcept {
+		return ::_MCFCRT_TryExpandInPlace(pBlock, uSize);
+	}
+	std::size_t GetUsableSize(const void *pBlock) const noexcept {
+		return ::_MCFCRT_malloc_usable_size(pBlock);
 	}
 };
 
+namespace Impl_DefaultAllocator {
+	// 如果分配器提供了 `bool operator()(void *, std::size_t)`，尝试原地扩展内存块；否则返回 false。
+	template<class AllocatorT>
+	auto TryExpandInPlace(AllocatorT &&vAllocator, void *pBlock, std::size_t uSize, int) noexcept -> decltype(static_cast<bool>(std::forward<AllocatorT>(vAllocator)(pBlock, uSize))) {
+		return static_cast<bool>(std::forward<AllocatorT>(vAllocator)(pBlock, uSize));
+	}
+	template<class AllocatorT>
+	bool TryExpandInPlace(AllocatorT &&, void *, std::size_t, long) noexcept {
+		return false;
+	}
+
+	template<class AllocatorT>
+	bool TryExpandInPlace(AllocatorT &&vAllocator, void *pBlock, std::size_t uSize) noexcept {
+		if(!pBlock){
+			return false;
+		}
+		return TryExpandInPlace(std::forward<AllocatorT>(vAllocator), pBlock, uSize, 0);
+	}
+
+	// 如果分配器提供了 `std::size_t GetUsableSize(const void *) const`，返回内存块的实际可用大小；否则返回申请的大小 uSize。
+	template<class AllocatorT>
+	auto GetUsableSize(AllocatorT &&vAllocator, const void *pBlock, std::size_t /* uSize */, int) noexcept -> decltype(static_cast<std::size_t>(std::forward<AllocatorT>(vAllocator).GetUsableSize(pBlock))) {
+		return static_cast<std::size_t>(std::forward<AllocatorT>(vAllocator).GetUsableSize(pBlock));
+	}
+	template<class AllocatorT>
+	std::size_t GetUsableSize(AllocatorT &&, const void *, std::size_t uSize, long) noexcept {
+		return uSize;
+	}
+
+	template<class AllocatorT>
+	std::size_t GetUsableSize(AllocatorT &&vAllocator, const void *pBlock, std::size_t uSize) noexcept {
+		return GetUsableSize(std::forward<AllocatorT>(vAllocator), pBlock, uSize, 0);
+	}
+}
+
 }
 
 #endif
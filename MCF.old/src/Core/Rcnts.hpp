@@ -8,6 +8,9 @@
 #include "_CheckedSizeArithmetic.hpp"
 #include "Atomic.hpp"
 #include "ConstructDestruct.hpp"
+#include <MCFCRT/ext/strmismatch.h>
+#include <MCFCRT/ext/wcsmismatch.h>
+#include <type_traits>
 #include <cstring>
 #include <cstddef>
 #include <cstdint>
@@ -36,22 +39,39 @@ private:
 			++uIndex;
 		}
 	}
-	static int X_Compare(const Char *pszSelf, const Char *pszOther) noexcept {
+	// 返回第一个不同的字符的下标，如果两个字符串相同则返回结束符的下标。
+	static std::size_t X_Mismatch(const char *pszSelf, const char *pszOther) noexcept {
+		return ::_MCFCRT_strmismatch(pszSelf, pszOther);
+	}
+	static std::size_t X_Mismatch(const wchar_t *pszSelf, const wchar_t *pszOther) noexcept {
+		return ::_MCFCRT_wcsmismatch(pszSelf, pszOther);
+	}
+	static std::size_t X_Mismatch(const char16_t *pszSelf, const char16_t *pszOther) noexcept {
+		static_assert(sizeof(char16_t) == sizeof(wchar_t), "Unsupported wchar_t.");
+		return ::_MCFCRT_wcsmismatch(reinterpret_cast<const wchar_t *>(pszSelf), reinterpret_cast<const wchar_t *>(pszOther));
+	}
+	template<typename OtherCharT>
+	static std::size_t X_Mismatch(const OtherCharT *pszSelf, const OtherCharT *pszOther) noexcept {
 		std::size_t uIndex = 0;
 		for(;;){
 			const auto chSelf = pszSelf[uIndex];
 			const auto chOther = pszOther[uIndex];
-			const bool bEndMarkSelf = chSelf == Char();
-			const bool bEndMarkOther = chOther == Char();
-			if(bEndMarkSelf || bEndMarkOther){
-				return bEndMarkOther - bEndMarkSelf;
-			}
-			if(chSelf != chOther){
-				return (static_cast<std::make_unsigned_t<Char>>(chSelf) < static_cast<std::make_unsigned_t<Char>>(chOther)) ? -1 : 1;
+			if((chSelf != chOther) || (chSelf == OtherCharT())){
+				return uIndex;
 			}
 			++uIndex;
 		}
 	}
+	static int X_Compare(const Char *pszSelf, const Char *pszOther) noexcept {
+		const auto uIndex = X_Mismatch(pszSelf, pszOther);
+		// 结束符小于其他任何字符，因此不需要单独判断。
+		const auto chSelf = static_cast<std::make_unsigned_t<Char>>(pszSelf[uIndex]);
+		const auto chOther = static_cast<std::make_unsigned_t<Char>>(pszOther[uIndex]);
+		if(chSelf == chOther){
+			return 0;
+		}
+		return (chSelf < chOther) ? -1 : 1;
+	}
 
 public:
 	static Rcnts Copy(const Char *pszBegin){
@@ -11,7 +11,9 @@
 #include "Assert.hpp"
 #include "CountOf.hpp"
 #include "CopyMoveFill.hpp"
+#include <MCFCRT/env/heap.h>
 #include <initializer_list>
+#include <new>
 #include <type_traits>
 #include <cstring>
 #include <cstddef>
@@ -154,7 +156,7 @@ public:
 	}
 	~String() noexcept {
 		if(x_schComplLength < 0){
-			::operator delete[](x_pchData);
+			::_MCFCRT_free(x_pchData);
 		}
 #ifndef NDEBUG
 		std::memset(this, 0xDD, sizeof(*this));
@@ -182,7 +184,16 @@ private:
 				uCharsToAlloc = uNewSize + 1;
 			}
 			const auto uBytesToAlloc = Impl_CheckedSizeArithmetic::Mul(sizeof(Char), uCharsToAlloc);
-			pchNewBuffer = (Char *)::operator new[](uBytesToAlloc);
+			if((x_schComplLength < 0) && ::_MCFCRT_TryExpandInPlace(pchOldBuffer, uBytesToAlloc)){
+				// 原地扩展成功，无需重新分配。
+				x_uCapacity = uCharsToAlloc - 1;
+			} else {
+				// 缓冲区必须从 CRT 堆分配，否则不能原地扩展。
+				pchNewBuffer = (Char *)::_MCFCRT_malloc(uBytesToAlloc);
+				if(!pchNewBuffer){
+					throw std::bad_alloc();
+				}
+			}
 		}
 
 		if((pchNewBuffer + uFirstOffset != pchOldBuffer) && (uRemovedBegin != 0)){
@@ -196,7 +207,7 @@ private:
 			if(x_schComplLength >= 0){
 				x_schComplLength = -1;
 			} else {
-				::operator delete[](pchOldBuffer);
+				::_MCFCRT_free(pchOldBuffer);
 			}
 
 			x_pchData = pchNewBuffer;
@@ -575,7 +586,7 @@ public:
 		MCF_DEBUG_CHECK(this != &strOther);
 
 		if(x_schComplLength < 0){
-			::operator delete[](x_pchData);
+			::_MCFCRT_free(x_pchData);
 		}
 		std::memcpy(this, &strOther, sizeof(*this));
 #ifndef NDEBUG
@@ -9,6 +9,10 @@
 #include "_Enumerator.hpp"
 #include "Assert.hpp"
 #include "Exception.hpp"
+#include <MCFCRT/ext/memeq.h>
+#include <MCFCRT/ext/memmismatch.h>
+#include <MCFCRT/ext/memmem.h>
+#include <MCFCRT/ext/wmemmem.h>
 #include <iterator>
 #include <utility>
 #include <type_traits>
@@ -44,6 +48,28 @@ private:
 		return uRet;
 	}
 
+	// 字符串是连续的，单字节和双字节字符可以直接使用 CRT 中的向量化实现。
+	template<std::size_t kSizeT>
+	static const Char *X_FindSpan(const std::integral_constant<std::size_t, kSizeT> &, const Char *pchTextBegin, const Char *pchTextEnd, const Char *pchPatternBegin, const Char *pchPatternEnd) noexcept {
+		return Impl_StringTraits::FindSpan(pchTextBegin, pchTextEnd, pchPatternBegin, pchPatternEnd);
+	}
+	static const Char *X_FindSpan(const std::integral_constant<std::size_t, 1> &, const Char *pchTextBegin, const Char *pchTextEnd, const Char *pchPatternBegin, const Char *pchPatternEnd) noexcept {
+		const auto pFound = ::_MCFCRT_memmem(pchTextBegin, static_cast<std::size_t>(pchTextEnd - pchTextBegin), pchPatternBegin, static_cast<std::size_t>(pchPatternEnd - pchPatternBegin));
+		if(!pFound){
+			return pchTextEnd;
+		}
+		return static_cast<const Char *>(pFound);
+	}
+	static const Char *X_FindSpan(const std::integral_constant<std::size_t, 2> &, const Char *pchTextBegin, const Char *pchTextEnd, const Char *pchPatternBegin, const Char *pchPatternEnd) noexcept {
+		static_assert(sizeof(Char) == sizeof(wchar_t), "Unsupported wchar_t.");
+
+		const auto pFound = ::_MCFCRT_wmemmem(reinterpret_cast<const wchar_t *>(pchTextBegin), static_cast<std::size_t>(pchTextEnd - pchTextBegin), reinterpret_cast<const wchar_t *>(pchPatternBegin), static_cast<std::size_t>(pchPatternEnd - pchPatternBegin));
+		if(!pFound){
+			return pchTextEnd;
+		}
+		return reinterpret_cast<const Char *>(pFound);
+	}
+
 private:
 	const Char *x_pchBegin;
 	const Char *x_pchEnd;
@@ -216,7 +242,18 @@ public:
 	}
 
 	int Compare(const StringView &svOther) const noexcept {
-		return Impl_StringTraits::Compare(GetBegin(), GetEnd(), svOther.GetBegin(), svOther.GetEnd());
+		const auto uMinSize = (GetSize() < svOther.GetSize()) ? GetSize() : svOther.GetSize();
+		// 先找到第一个不同的字节，再比较包含它的字符。
+		const auto uIndex = ::_MCFCRT_memmismatch(GetBegin(), svOther.GetBegin(), uMinSize * sizeof(Char)) / sizeof(Char);
+		if(uIndex == uMinSize){
+			if(GetSize() == svOther.GetSize()){
+				return 0;
+			}
+			return (GetSize() < svOther.GetSize()) ? -1 : 1;
+		}
+		const auto chSelf = static_cast<std::make_unsigned_t<Char>>(GetBegin()[uIndex]);
+		const auto chOther = static_cast<std::make_unsigned_t<Char>>(svOther.GetBegin()[uIndex]);
+		return (chSelf < chOther) ? -1 : 1;
 	}
 
 	void Assign(const Char *pchBegin, const Char *pchEnd) noexcept {
@@ -254,7 +291,7 @@ public:
 		const auto uRealBegin = X_TranslateOffset(nBegin, GetLength());
 		const auto itRealBegin = GetBegin() + uRealBegin;
 		const auto itRealEnd = GetEnd();
-		const auto itPosition = Impl_StringTraits::FindSpan(itRealBegin, itRealEnd, svToFind.GetBegin(), svToFind.GetEnd());
+		const auto itPosition = X_FindSpan(std::integral_constant<std::size_t, sizeof(Char)>(), itRealBegin, itRealEnd, svToFind.GetBegin(), svToFind.GetEnd());
 		if(itPosition == itRealEnd){
 			return kNpos;
 		}
@@ -318,13 +355,14 @@ public:
 		if(GetSize() != svOther.GetSize()){
 			return false;
 		}
-		return Compare(svOther) == 0;
+		// 只判断相等时不需要计算大小关系。
+		return ::_MCFCRT_memeq(GetBegin(), svOther.GetBegin(), GetSize() * sizeof(Char));
 	}
 	bool operator!=(const StringView &svOther) noexcept {
 		if(GetSize() != svOther.GetSize()){
 			return true;
 		}
-		return Compare(svOther) != 0;
+		return !::_MCFCRT_memeq(GetBegin(), svOther.GetBegin(), GetSize() * sizeof(Char));
 	}
 	bool operator<(const StringView &svOther) noexcept {
 		return Compare(svOther) < 0;
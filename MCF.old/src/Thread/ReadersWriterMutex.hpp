@@ -5,14 +5,20 @@
 #ifndef MCF_THREAD_READER_WRITER_MUTEX_HPP_
 #define MCF_THREAD_READER_WRITER_MUTEX_HPP_
 
-#include "Mutex.hpp"
 #include "../Core/Atomic.hpp"
+#include "UniqueLock.hpp"
+#include <MCFCRT/env/rwlock.h>
+#include <type_traits>
+#include <cstddef>
 
 namespace MCF {
 
+// 写者优先。读者较多时，可以提供一组 ::_MCFCRT_RwLockReaderSlots 启用分散计数模式，此时读者锁必须由加锁的线程解锁。
+// 读者槽必须零初始化，且生存期不短于本对象。
+
 class ReadersWriterMutex {
 public:
-	enum : std::size_t { kSuggestedSpinCount = Mutex::kSuggestedSpinCount };
+	enum : std::size_t { kSuggestedSpinCount = _MCFCRT_RWLOCK_SUGGESTED_SPIN_COUNT };
 
 	struct MutexTraitsAsReader {
 		static bool Try(ReadersWriterMutex *pMutex, std::uint64_t u64UntilFastMonoClock){
@@ -38,13 +44,12 @@ public:
 	};
 
 private:
-	Mutex x_mtxReaderGuard;
-	Mutex x_mtxExclusive;
-	Atomic<std::size_t> x_uReaderCount;
+	::_MCFCRT_RwLock x_vLock;
+	Atomic<std::size_t> x_uSpinCount;
 
 public:
-	explicit constexpr ReadersWriterMutex(std::size_t uSpinCount = kSuggestedSpinCount) noexcept
-		: x_mtxReaderGuard(kSuggestedSpinCount), x_mtxExclusive(uSpinCount), x_uReaderCount(0)
+	explicit constexpr ReadersWriterMutex(std::size_t uSpinCount = kSuggestedSpinCount, ::_MCFCRT_RwLockReaderSlots *pReaderSlots = nullptr) noexcept
+		: x_vLock{ 0, pReaderSlots }, x_uSpinCount(uSpinCount)
 	{ }
 
 	ReadersWriterMutex(const ReadersWriterMutex &) = delete;
@@ -52,15 +57,21 @@ public:
 
 public:
 	std::size_t GetSpinCount() const noexcept {
-		return x_mtxExclusive.GetSpinCount();
+		return x_uSpinCount.Load(kAtomicRelaxed);
 	}
 	void SetSpinCount(std::size_t uSpinCount) noexcept {
-		x_mtxExclusive.SetSpinCount(uSpinCount);
+		x_uSpinCount.Store(uSpinCount, kAtomicRelaxed);
 	}
 
-	bool TryAsReader(std::uint64_t u64UntilFastMonoClock = 0) noexcept;
-	void LockAsReader() noexcept;
-	void UnlockAsReader() noexcept;
+	bool TryAsReader(std::uint64_t u64UntilFastMonoClock = 0) noexcept {
+		return ::_MCFCRT_WaitForRwLockAsReader(&x_vLock, GetSpinCount(), u64UntilFastMonoClock);
+	}
+	void LockAsReader() noexcept {
+		::_MCFCRT_WaitForRwLockAsReaderForever(&x_vLock, GetSpinCount());
+	}
+	void UnlockAsReader() noexcept {
+		::_MCFCRT_SignalRwLockAsReader(&x_vLock);
+	}
 
 	UniqueLock<ReadersWriterMutex, MutexTraitsAsReader> TryGetLockAsReader(std::uint64_t u64UntilFastMonoClock = 0) noexcept {
 		return UniqueLock<ReadersWriterMutex, MutexTraitsAsReader>(*this, u64UntilFastMonoClock);
@@ -69,9 +80,15 @@ public:
 		return UniqueLock<ReadersWriterMutex, MutexTraitsAsReader>(*this);
 	}
 
-	bool TryAsWriter(std::uint64_t u64UntilFastMonoClock = 0) noexcept;
-	void LockAsWriter() noexcept;
-	void UnlockAsWriter() noexcept;
+	bool TryAsWriter(std::uint64_t u64UntilFastMonoClock = 0) noexcept {
+		return ::_MCFCRT_WaitForRwLockAsWriter(&x_vLock, GetSpinCount(), u64UntilFastMonoClock);
+	}
+	void LockAsWriter() noexcept {
+		::_MCFCRT_WaitForRwLockAsWriterForever(&x_vLock, GetSpinCount());
+	}
+	void UnlockAsWriter() noexcept {
+		::_MCFCRT_SignalRwLockAsWriter(&x_vLock);
+	}
 
 	UniqueLock<ReadersWriterMutex, MutexTraitsAsWriter> TryGetLockAsWriter(std::uint64_t u64UntilFastMonoClock = 0) noexcept {
 		return UniqueLock<ReadersWriterMutex, MutexTraitsAsWriter>(*this, u64UntilFastMonoClock);
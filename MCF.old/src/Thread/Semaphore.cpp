@@ -3,33 +3,42 @@
 // Copyleft 2013 - 2018, LH_Mouse. All wrongs reserved.
 
 #include "Semaphore.hpp"
+#include "../Core/Assert.hpp"
 
 namespace MCF {
 
+bool Semaphore::X_TryDecrement() noexcept {
+	auto uOldCount = x_uCount.Load(kAtomicRelaxed);
+	while(uOldCount != 0){
+		if(x_uCount.CompareExchange(uOldCount, uOldCount - 1, kAtomicAcquire, kAtomicRelaxed)){
+			return true;
+		}
+	}
+	return false;
+}
+
 bool Semaphore::Wait(std::uint64_t u64UntilFastMonoClock) noexcept {
-	auto vLock = x_mtxGuard.GetLock();
-	while(x_uCount == 0){
-		if(!x_cvWaiter.WaitOrAbandon(vLock, u64UntilFastMonoClock)){
-			return false;
+	while(!X_TryDecrement()){
+		if(!x_uCount.Wait(0, u64UntilFastMonoClock)){
+			return X_TryDecrement();
 		}
 	}
-	--x_uCount;
 	return true;
 }
 void Semaphore::Wait() noexcept {
-	auto vLock = x_mtxGuard.GetLock();
-	while(x_uCount == 0){
-		x_cvWaiter.Wait(vLock);
+	while(!X_TryDecrement()){
+		x_uCount.Wait(0);
 	}
-	--x_uCount;
 }
 std::size_t Semaphore::Post(std::size_t uPostCount) noexcept {
-	auto vLock = x_mtxGuard.GetLock();
-	const auto uOldCount = x_uCount;
-	const auto uNewCount = uOldCount + uPostCount;
-	MCF_DEBUG_CHECK_MSG(uNewCount >= uOldCount, L"算术运算结果超出可表示范围。");
-	x_uCount = uNewCount;
-	x_cvWaiter.Signal(uPostCount);
+	const auto uOldCount = x_uCount.FetchAdd(uPostCount, kAtomicRelease);
+	MCF_DEBUG_CHECK_MSG(uOldCount + uPostCount >= uOldCount, L"算术运算结果超出可表示范围。");
+	// 即使原来的计数不为零，也可能有线程尚未被唤醒。没有线程在睡眠时 NotifyOne() 的开销很小。
+	for(std::size_t i = 0; i < uPostCount; ++i){
+		if(x_uCount.NotifyOne() == 0){
+			break;
+		}
+	}
 	return uOldCount;
 }
 
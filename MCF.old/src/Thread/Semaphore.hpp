@@ -5,8 +5,7 @@
 #ifndef MCF_THREAD_SEMAPHORE_HPP_
 #define MCF_THREAD_SEMAPHORE_HPP_
 
-#include "Mutex.hpp"
-#include "ConditionVariable.hpp"
+#include "../Core/Atomic.hpp"
 #include <type_traits>
 #include <cstddef>
 #include <cstdint>
@@ -15,18 +14,20 @@ namespace MCF {
 
 class Semaphore {
 private:
-	mutable Mutex x_mtxGuard;
-	mutable ConditionVariable x_cvWaiter;
-	std::size_t x_uCount;
+	// 等待的线程直接睡眠在计数上，不需要互斥体和条件变量。
+	Atomic<std::size_t> x_uCount;
 
 public:
 	explicit constexpr Semaphore(std::size_t uInitCount) noexcept
-		: x_mtxGuard(), x_cvWaiter(), x_uCount(uInitCount)
+		: x_uCount(uInitCount)
 	{ }
 
 	Semaphore(const Semaphore &) = delete;
 	Semaphore &operator=(const Semaphore &) = delete;
 
+private:
+	bool X_TryDecrement() noexcept;
+
 public:
 	bool Wait(std::uint64_t u64UntilFastMonoClock) noexcept;
 	void Wait() noexcept;
@@ -0,0 +1,371 @@
+// 这个文件是 MCF 的一部分。
+// 有关具体授权说明，请参阅 MCFLicense.txt。
+// Copyleft 2013 - 2018, LH_Mouse. All wrongs reserved.
+
+#include "ThreadPool.hpp"
+#include "Thread.hpp"
+#include "../Core/Exception.hpp"
+#include "../Core/Clocks.hpp"
+#include "../Core/Cpu.hpp"
+#include "../Core/Assert.hpp"
+#include "../Core/Bail.hpp"
+
+namespace MCF {
+
+ThreadPoolTask::~ThreadPoolTask(){ }
+
+template class IntrusivePtr<ThreadPoolTask>;
+
+void ThreadPoolTask::X_Execute() noexcept {
+	try {
+		X_Run();
+	} catch(...){
+		x_pException = std::current_exception();
+	}
+	x_bCompleted.Store(true, kAtomicRelease);
+	x_bCompleted.NotifyAll();
+}
+
+bool ThreadPoolTask::Wait(std::uint64_t u64UntilFastMonoClock) const noexcept {
+	while(!x_bCompleted.Load(kAtomicAcquire)){
+		if(!x_bCompleted.Wait(false, u64UntilFastMonoClock)){
+			return IsCompleted();
+		}
+	}
+	return true;
+}
+void ThreadPoolTask::Wait() const noexcept {
+	while(!x_bCompleted.Load(kAtomicAcquire)){
+		x_bCompleted.Wait(false);
+	}
+}
+void ThreadPoolTask::Rethrow() const {
+	MCF_ASSERT(IsCompleted());
+	if(x_pException){
+		std::rethrow_exception(x_pException);
+	}
+}
+
+// Chase-Lev 双端队列。只有所有者可以在底部压入和弹出，任何线程都可以从顶部窃取。
+// 参见 Lê, Pop, Cohen, Zappa Nardelli, "Correct and Efficient Work-Stealing for Weak Memory Models", PPoPP 2013。
+class ThreadPool::X_Worker {
+private:
+	using X_Slot = Atomic<ThreadPoolTask *>;
+
+	struct X_Buffer {
+		std::size_t uMask;
+		UniquePtr<X_Slot [], DefaultDeleter<X_Slot []>> pSlots;
+
+		explicit X_Buffer(std::size_t uCapacity)
+			: uMask(uCapacity - 1), pSlots(new X_Slot[uCapacity])
+		{ }
+
+		X_Slot &operator[](std::intptr_t nIndex) const noexcept {
+			return pSlots.Get()[static_cast<std::size_t>(nIndex) & uMask];
+		}
+	};
+
+	enum : std::size_t { kInitCapacity = 256 };
+
+public:
+	IntrusivePtr<Thread> pThread;
+	std::uint32_t u32Seed;
+
+private:
+	alignas(_MCFCRT_CACHE_LINE_SIZE) Atomic<std::intptr_t> x_nTop;
+	alignas(_MCFCRT_CACHE_LINE_SIZE) Atomic<std::intptr_t> x_nBottom;
+	Atomic<X_Buffer *> x_pBuffer;
+	// 扩容之后，旧的缓冲区可能仍然被窃取者读取，因此在队列析构之前不能释放。
+	Vector<UniquePtr<X_Buffer>> x_vecBuffers;
+
+public:
+	explicit X_Worker(std::uint32_t u32InitSeed)
+		: pThread(), u32Seed(u32InitSeed)
+		, x_nTop(0), x_nBottom(0), x_pBuffer(nullptr), x_vecBuffers()
+	{
+		const auto pBuffer = x_vecBuffers.Push(MakeUnique<X_Buffer>(kInitCapacity)).Get();
+		x_pBuffer.Store(pBuffer, kAtomicRelaxed);
+	}
+	~X_Worker(){
+		MCF_ASSERT(IsEmpty());
+	}
+
+	X_Worker(const X_Worker &) = delete;
+	X_Worker &operator=(const X_Worker &) = delete;
+
+public:
+	bool IsEmpty() const noexcept {
+		const auto nTop = x_nTop.Load(kAtomicAcquire);
+		const auto nBottom = x_nBottom.Load(kAtomicAcquire);
+		return nBottom <= nTop;
+	}
+
+	// 获得任务的所有权。扩容失败时抛出异常，此时任务的所有权不变。
+	void Push(ThreadPoolTask *pTask){
+		const auto nBottom = x_nBottom.Load(kAtomicRelaxed);
+		const auto nTop = x_nTop.Load(kAtomicAcquire);
+		auto pBuffer = x_pBuffer.Load(kAtomicRelaxed);
+		if(static_cast<std::size_t>(nBottom - nTop) > pBuffer->uMask){
+			auto pNewBuffer = MakeUnique<X_Buffer>((pBuffer->uMask + 1) * 2);
+			for(auto nIndex = nTop; nIndex < nBottom; ++nIndex){
+				(*pNewBuffer)[nIndex].Store((*pBuffer)[nIndex].Load(kAtomicRelaxed), kAtomicRelaxed);
+			}
+			pBuffer = x_vecBuffers.Push(std::move(pNewBuffer)).Get();
+			x_pBuffer.Store(pBuffer, kAtomicRelease);
+		}
+		(*pBuffer)[nBottom].Store(pTask, kAtomicRelaxed);
+		AtomicFence(kAtomicRelease);
+		x_nBottom.Store(nBottom + 1, kAtomicRelaxed);
+	}
+	ThreadPoolTask *Take() noexcept {
+		const auto nBottom = x_nBottom.Load(kAtomicRelaxed) - 1;
+		const auto pBuffer = x_pBuffer.Load(kAtomicRelaxed);
+		x_nBottom.Store(nBottom, kAtomicRelaxed);
+		AtomicFence(kAtomicSeqCst);
+		auto nTop = x_nTop.Load(kAtomicRelaxed);
+		if(nTop > nBottom){
+			x_nBottom.Store(nBottom + 1, kAtomicRelaxed);
+			return nullptr;
+		}
+		auto pTask = (*pBuffer)[nBottom].Load(kAtomicRelaxed);
+		if(nTop == nBottom){
+			// 这是最后一个任务，和窃取者竞争。
+			if(!x_nTop.CompareExchange(nTop, nTop + 1, kAtomicSeqCst, kAtomicRelaxed)){
+				pTask = nullptr;
+			}
+			x_nBottom.Store(nBottom + 1, kAtomicRelaxed);
+		}
+		return pTask;
+	}
+	// 队列为空或者竞争失败时返回空指针。
+	ThreadPoolTask *Steal() noexcept {
+		auto nTop = x_nTop.Load(kAtomicAcquire);
+		AtomicFence(kAtomicSeqCst);
+		const auto nBottom = x_nBottom.Load(kAtomicAcquire);
+		if(nTop >= nBottom){
+			return nullptr;
+		}
+		const auto pBuffer = x_pBuffer.Load(kAtomicConsume);
+		const auto pTask = (*pBuffer)[nTop].Load(kAtomicRelaxed);
+		if(!x_nTop.CompareExchange(nTop, nTop + 1, kAtomicSeqCst, kAtomicRelaxed)){
+			return nullptr;
+		}
+		return pTask;
+	}
+};
+
+ThreadPool::ThreadPool(std::size_t uWorkerCount)
+	: x_vecWorkers(), x_tlsCurrentWorker()
+	, x_mtxInjection(), x_pInjectedFirst(nullptr), x_pInjectedLast(nullptr), x_uInjectedCount(0)
+	, x_mtxIdle(), x_cvIdle(), x_uSleepingCount(0)
+	, x_uOutstandingCount(0), x_bShuttingDown(false)
+{
+	if(uWorkerCount == 0){
+		uWorkerCount = Max(CpuGetLogicalCount(), std::size_t(1));
+	}
+	// 工作线程会互相窃取任务，因此在启动任何一个线程之前创建全部队列。
+	x_vecWorkers.Reserve(uWorkerCount);
+	for(std::size_t uIndex = 0; uIndex < uWorkerCount; ++uIndex){
+		x_vecWorkers.Push(MakeUnique<X_Worker>(static_cast<std::uint32_t>(uIndex * 0x9E3779B9u + 1)));
+	}
+	try {
+		for(std::size_t uIndex = 0; uIndex < uWorkerCount; ++uIndex){
+			const auto pWorker = x_vecWorkers[uIndex].Get();
+			const auto fnProc = [this, pWorker]{ X_WorkerProc(pWorker); };
+			pWorker->pThread = MakeThread(fnProc);
+		}
+	} catch(...){
+		Shutdown();
+		throw;
+	}
+}
+ThreadPool::~ThreadPool(){
+	Shutdown();
+}
+
+ThreadPool::X_Worker *ThreadPool::X_GetCurrentWorker() const noexcept {
+	const auto ppWorker = x_tlsCurrentWorker.Get();
+	if(!ppWorker){
+		return nullptr;
+	}
+	return *ppWorker;
+}
+bool ThreadPool::X_IsLocalQueueEmpty(X_Worker *pWorker) const noexcept {
+	return pWorker->IsEmpty();
+}
+bool ThreadPool::X_HasVisibleWork() const noexcept {
+	if(x_uInjectedCount.Load(kAtomicRelaxed) != 0){
+		return true;
+	}
+	for(const auto &pWorker : x_vecWorkers){
+		if(!pWorker->IsEmpty()){
+			return true;
+		}
+	}
+	return false;
+}
+void ThreadPool::X_WakeOne() noexcept {
+	// 与 X_WorkerProc() 中的栅栏配对：要么睡眠的线程能看到新任务，要么这里能看到它在睡眠。
+	AtomicFence(kAtomicSeqCst);
+	if(x_uSleepingCount.Load(kAtomicRelaxed) == 0){
+		return;
+	}
+	const auto vLock = x_mtxIdle.GetLock();
+	x_cvIdle.Signal();
+}
+
+void ThreadPool::X_Enqueue(IntrusivePtr<ThreadPoolTask> pTask){
+	MCF_ASSERT(pTask);
+
+	const auto pWorker = X_GetCurrentWorker();
+	x_uOutstandingCount.Increment(kAtomicSeqCst);
+	if(pWorker){
+		// 工作线程提交的任务总是被接受，否则正在执行的任务无法完成。
+		try {
+			pWorker->Push(pTask.Get());
+		} catch(...){
+			x_uOutstandingCount.Decrement(kAtomicSeqCst);
+			throw;
+		}
+		pTask.Release();
+	} else {
+		if(x_bShuttingDown.Load(kAtomicSeqCst)){
+			if(x_uOutstandingCount.Decrement(kAtomicSeqCst) == 0){
+				const auto vLock = x_mtxIdle.GetLock();
+				x_cvIdle.Broadcast();
+			}
+			MCF_THROW(Exception, ERROR_OPERATION_ABORTED, Rcntws::View(L"ThreadPool: 线程池已经关闭。"));
+		}
+		const auto pRaw = pTask.Release();
+		const auto vLock = x_mtxInjection.GetLock();
+		pRaw->x_pNextInjected = nullptr;
+		if(x_pInjectedLast){
+			x_pInjectedLast->x_pNextInjected = pRaw;
+		} else {
+			x_pInjectedFirst = pRaw;
+		}
+		x_pInjectedLast = pRaw;
+		x_uInjectedCount.Increment(kAtomicRelaxed);
+	}
+	X_WakeOne();
+}
+IntrusivePtr<ThreadPoolTask> ThreadPool::X_FindTask(X_Worker *pWorker) noexcept {
+	ThreadPoolTask *pRaw = nullptr;
+	if(pWorker){
+		pRaw = pWorker->Take();
+		if(pRaw){
+			return IntrusivePtr<ThreadPoolTask>(pRaw);
+		}
+	}
+	if(x_uInjectedCount.Load(kAtomicRelaxed) != 0){
+		const auto vLock = x_mtxInjection.GetLock();
+		pRaw = x_pInjectedFirst;
+		if(pRaw){
+			x_pInjectedFirst = pRaw->x_pNextInjected;
+			if(!x_pInjectedFirst){
+				x_pInjectedLast = nullptr;
+			}
+			x_uInjectedCount.Decrement(kAtomicRelaxed);
+			return IntrusivePtr<ThreadPoolTask>(pRaw);
+		}
+	}
+	// 从一个随机的位置开始，依次尝试从其他工作线程窃取。
+	const auto uWorkerCount = x_vecWorkers.GetSize();
+	std::size_t uStart = 0;
+	if(pWorker){
+		auto u32Seed = pWorker->u32Seed;
+		u32Seed ^= u32Seed << 13;
+		u32Seed ^= u32Seed >> 17;
+		u32Seed ^= u32Seed << 5;
+		pWorker->u32Seed = u32Seed;
+		uStart = u32Seed % uWorkerCount;
+	}
+	for(std::size_t uOffset = 0; uOffset < uWorkerCount; ++uOffset){
+		const auto pVictim = x_vecWorkers[(uStart + uOffset) % uWorkerCount].Get();
+		if(pVictim == pWorker){
+			continue;
+		}
+		pRaw = pVictim->Steal();
+		if(pRaw){
+			return IntrusivePtr<ThreadPoolTask>(pRaw);
+		}
+	}
+	return nullptr;
+}
+void ThreadPool::X_RunTask(IntrusivePtr<ThreadPoolTask> pTask) noexcept {
+	pTask->X_Execute();
+	pTask.Reset();
+	if(x_uOutstandingCount.Decrement(kAtomicSeqCst) == 0){
+		if(x_bShuttingDown.Load(kAtomicSeqCst)){
+			const auto vLock = x_mtxIdle.GetLock();
+			x_cvIdle.Broadcast();
+		}
+	}
+}
+void ThreadPool::X_RunUntil(X_Worker *pWorker, const Atomic<std::size_t> &uRemaining) noexcept {
+	for(;;){
+		const auto uOld = uRemaining.Load(kAtomicAcquire);
+		if(uOld == 0){
+			break;
+		}
+		auto pTask = X_FindTask(pWorker);
+		if(pTask){
+			X_RunTask(std::move(pTask));
+			continue;
+		}
+		// 剩下的部分都在其他线程中执行。短暂睡眠，以便帮忙执行新提交的任务。
+		uRemaining.Wait(uOld, GetFastMonoClock() + 1);
+	}
+}
+void ThreadPool::X_WorkerProc(X_Worker *pWorker) noexcept {
+	enum : std::size_t { kSpinCount = 100 };
+
+	// 只有一个逻辑处理器时，自旋只会推迟提交任务的线程。
+	const auto uSpinCount = (CpuGetLogicalCount() > 1) ? std::size_t(kSpinCount) : 0;
+
+	try {
+		x_tlsCurrentWorker.Require(pWorker);
+	} catch(...){
+		Bail(L"ThreadPool: 无法设置当前工作线程。");
+	}
+	for(;;){
+		auto pTask = X_FindTask(pWorker);
+		for(std::size_t uRound = 0; !pTask && (uRound < uSpinCount); ++uRound){
+			__builtin_ia32_pause();
+			pTask = X_FindTask(pWorker);
+		}
+		if(pTask){
+			X_RunTask(std::move(pTask));
+			continue;
+		}
+
+		auto vLock = x_mtxIdle.GetLock();
+		x_uSleepingCount.Increment(kAtomicRelaxed);
+		AtomicFence(kAtomicSeqCst);
+		if(x_bShuttingDown.Load(kAtomicSeqCst) && (x_uOutstandingCount.Load(kAtomicSeqCst) == 0)){
+			x_uSleepingCount.Decrement(kAtomicRelaxed);
+			break;
+		}
+		if(!X_HasVisibleWork()){
+			x_cvIdle.Wait(vLock);
+		}
+		x_uSleepingCount.Decrement(kAtomicRelaxed);
+	}
+}
+
+void ThreadPool::Shutdown() noexcept {
+	MCF_ASSERT_MSG(!X_GetCurrentWorker(), L"不能在工作线程中关闭线程池。");
+
+	x_bShuttingDown.Store(true, kAtomicSeqCst);
+	{
+		const auto vLock = x_mtxIdle.GetLock();
+		x_cvIdle.Broadcast();
+	}
+	for(const auto &pWorker : x_vecWorkers){
+		if(pWorker->pThread){
+			pWorker->pThread->Wait();
+		}
+	}
+}
+
+}
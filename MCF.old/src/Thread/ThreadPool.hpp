@@ -0,0 +1,251 @@
+// 这个文件是 MCF 的一部分。
+// 有关具体授权说明，请参阅 MCFLicense.txt。
+// Copyleft 2013 - 2018, LH_Mouse. All wrongs reserved.
+
+#ifndef MCF_THREAD_THREAD_POOL_HPP_
+#define MCF_THREAD_THREAD_POOL_HPP_
+
+#include "../Core/Atomic.hpp"
+#include "../Core/MinMax.hpp"
+#include "../SmartPointers/IntrusivePtr.hpp"
+#include "../SmartPointers/UniquePtr.hpp"
+#include "../Containers/Vector.hpp"
+#include "Mutex.hpp"
+#include "ConditionVariable.hpp"
+#include "ThreadLocal.hpp"
+#include <exception>
+#include <type_traits>
+#include <utility>
+#include <cstddef>
+#include <cstdint>
+
+namespace MCF {
+
+class ThreadPool;
+
+// 提交到线程池的任务，同时也是任务完成的通知句柄。
+class ThreadPoolTask : public IntrusiveBase<ThreadPoolTask> {
+	friend ThreadPool;
+
+private:
+	ThreadPoolTask *x_pNextInjected = nullptr;
+	Atomic<bool> x_bCompleted;
+	std::exception_ptr x_pException;
+
+protected:
+	ThreadPoolTask() noexcept = default;
+
+public:
+	virtual ~ThreadPoolTask();
+
+protected:
+	virtual void X_Run() = 0;
+
+private:
+	void X_Execute() noexcept;
+
+public:
+	bool IsCompleted() const noexcept {
+		return x_bCompleted.Load(kAtomicAcquire);
+	}
+	// 在工作线程中等待同一线程池中的任务会占用该工作线程。
+	bool Wait(std::uint64_t u64UntilFastMonoClock) const noexcept;
+	void Wait() const noexcept;
+	// 任务完成之后，如果它抛出了异常，重新抛出该异常。
+	void Rethrow() const;
+};
+
+extern template class IntrusivePtr<ThreadPoolTask>;
+
+namespace Impl_ThreadPool {
+	template<typename FunctionT>
+	class ConcreteTask final : public ThreadPoolTask {
+	private:
+		std::decay_t<FunctionT> x_vFunction;
+
+	public:
+		explicit ConcreteTask(FunctionT &vFunction)
+			: x_vFunction(std::forward<FunctionT>(vFunction))
+		{ }
+		~ConcreteTask() override;
+
+	protected:
+		void X_Run() override {
+			std::forward<FunctionT>(x_vFunction)();
+		}
+	};
+
+	template<typename FunctionT>
+	ConcreteTask<FunctionT>::~ConcreteTask(){ }
+}
+
+// 每个工作线程拥有一个 Chase-Lev 工作窃取双端队列。工作线程提交的任务放入自己的队列，其他线程提交的任务放入全局注入队列。
+// 空闲的工作线程睡眠在条件变量上。
+class ThreadPool {
+private:
+	class X_Worker;
+
+	struct X_ParallelForControl {
+		Atomic<std::size_t> uRemaining;
+		Atomic<bool> bCancelled;
+		Mutex mtxException;
+		std::exception_ptr pException;
+		std::size_t uGrain;
+	};
+
+	template<typename FunctionT>
+	class X_RangeTask final : public ThreadPoolTask {
+	private:
+		ThreadPool *x_pPool;
+		X_ParallelForControl *x_pControl;
+		FunctionT *x_pFunction;
+		std::size_t x_uBegin;
+		std::size_t x_uEnd;
+
+	public:
+		X_RangeTask(ThreadPool *pPool, X_ParallelForControl *pControl, FunctionT *pFunction, std::size_t uBegin, std::size_t uEnd) noexcept
+			: x_pPool(pPool), x_pControl(pControl), x_pFunction(pFunction), x_uBegin(uBegin), x_uEnd(uEnd)
+		{ }
+		~X_RangeTask() override;
+
+	protected:
+		void X_Run() override {
+			x_pPool->X_RunRange(x_pControl, x_pFunction, x_uBegin, x_uEnd);
+		}
+	};
+
+private:
+	Vector<UniquePtr<X_Worker>> x_vecWorkers;
+	ThreadLocal<X_Worker *> x_tlsCurrentWorker;
+
+	mutable Mutex x_mtxInjection;
+	ThreadPoolTask *x_pInjectedFirst;
+	ThreadPoolTask *x_pInjectedLast;
+	Atomic<std::size_t> x_uInjectedCount;
+
+	mutable Mutex x_mtxIdle;
+	mutable ConditionVariable x_cvIdle;
+	Atomic<std::size_t> x_uSleepingCount;
+
+	// 已提交但尚未完成的任务数。
+	Atomic<std::size_t> x_uOutstandingCount;
+	Atomic<bool> x_bShuttingDown;
+
+public:
+	// 如果 uWorkerCount 为零，创建与逻辑处理器数目相同的工作线程。
+	explicit ThreadPool(std::size_t uWorkerCount = 0);
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool &) = delete;
+	ThreadPool &operator=(const ThreadPool &) = delete;
+
+private:
+	X_Worker *X_GetCurrentWorker() const noexcept;
+	bool X_IsLocalQueueEmpty(X_Worker *pWorker) const noexcept;
+	bool X_HasVisibleWork() const noexcept;
+	void X_WakeOne() noexcept;
+
+	void X_Enqueue(IntrusivePtr<ThreadPoolTask> pTask);
+	IntrusivePtr<ThreadPoolTask> X_FindTask(X_Worker *pWorker) noexcept;
+	void X_RunTask(IntrusivePtr<ThreadPoolTask> pTask) noexcept;
+	void X_RunUntil(X_Worker *pWorker, const Atomic<std::size_t> &uRemaining) noexcept;
+	void X_WorkerProc(X_Worker *pWorker) noexcept;
+
+	template<typename FunctionT>
+	void X_RunRange(X_ParallelForControl *pControl, FunctionT *pFunction, std::size_t uBegin, std::size_t uEnd){
+		const auto pWorker = X_GetCurrentWorker();
+		std::size_t uDone = 0;
+		while(uBegin < uEnd){
+			if(pControl->bCancelled.Load(kAtomicRelaxed)){
+				uDone += uEnd - uBegin;
+				break;
+			}
+			// 如果本地队列已经被取空，说明有其他线程空闲，把剩余范围的后一半分出去。
+			if((uEnd - uBegin > pControl->uGrain) && pWorker && X_IsLocalQueueEmpty(pWorker)){
+				const auto uMiddle = uBegin + (uEnd - uBegin) / 2;
+				try {
+					X_Enqueue(MakeIntrusive<X_RangeTask<FunctionT>>(this, pControl, pFunction, uMiddle, uEnd));
+					uEnd = uMiddle;
+					continue;
+				} catch(std::bad_alloc &){
+					// 不拆分了。
+				}
+			}
+			const auto uChunkEnd = uBegin + Min(pControl->uGrain, uEnd - uBegin);
+			try {
+				for(auto uIndex = uBegin; uIndex < uChunkEnd; ++uIndex){
+					(*pFunction)(uIndex);
+				}
+			} catch(...){
+				const auto vLock = pControl->mtxException.GetLock();
+				if(!pControl->pException){
+					pControl->pException = std::current_exception();
+				}
+				pControl->bCancelled.Store(true, kAtomicRelaxed);
+			}
+			uDone += uChunkEnd - uBegin;
+			uBegin = uChunkEnd;
+		}
+		if(pControl->uRemaining.SubFetch(uDone, kAtomicAcqRel) == 0){
+			// 此时 ParallelFor() 可能已经返回，*pControl 已被销毁。NotifyAll() 只使用其地址，不会访问其内容。
+			pControl->uRemaining.NotifyAll();
+		}
+	}
+
+public:
+	std::size_t GetWorkerCount() const noexcept {
+		return x_vecWorkers.GetSize();
+	}
+
+	template<typename FunctionT>
+	IntrusivePtr<ThreadPoolTask> Submit(FunctionT &&vFunction){
+		IntrusivePtr<ThreadPoolTask> pTask = MakeIntrusive<Impl_ThreadPool::ConcreteTask<FunctionT>>(vFunction);
+		X_Enqueue(pTask);
+		return pTask;
+	}
+
+	// 对 [uBegin, uEnd) 中的每个下标调用 vFunction(uIndex)，返回时全部调用都已完成。
+	// 范围只在有线程空闲时才被拆分，因此不需要指定粒度。如果有调用抛出异常，剩余的下标被跳过，第一个异常被重新抛出。
+	template<typename FunctionT>
+	void ParallelFor(std::size_t uBegin, std::size_t uEnd, FunctionT &&vFunction){
+		if(uBegin >= uEnd){
+			return;
+		}
+		const auto uCount = uEnd - uBegin;
+		X_ParallelForControl vControl;
+		vControl.uRemaining.Store(uCount, kAtomicRelaxed);
+		vControl.bCancelled.Store(false, kAtomicRelaxed);
+		vControl.uGrain = Max(uCount / (GetWorkerCount() * 64 + 1), std::size_t(1));
+
+		using Function = std::remove_reference_t<FunctionT>;
+		const auto pFunction = AddressOf(vFunction);
+		const auto pWorker = X_GetCurrentWorker();
+		if(pWorker){
+			// 在工作线程中直接执行，等待时帮忙执行其他任务。
+			X_RunRange<Function>(&vControl, pFunction, uBegin, uEnd);
+			X_RunUntil(pWorker, vControl.uRemaining);
+		} else {
+			X_Enqueue(MakeIntrusive<X_RangeTask<Function>>(this, &vControl, pFunction, uBegin, uEnd));
+			for(;;){
+				const auto uRemaining = vControl.uRemaining.Load(kAtomicAcquire);
+				if(uRemaining == 0){
+					break;
+				}
+				vControl.uRemaining.Wait(uRemaining);
+			}
+		}
+		if(vControl.pException){
+			std::rethrow_exception(vControl.pException);
+		}
+	}
+
+	// 不再接受其他线程提交的任务，等待已提交的任务全部完成，然后结束所有工作线程。不能在工作线程中调用。
+	void Shutdown() noexcept;
+};
+
+template<typename FunctionT>
+ThreadPool::X_RangeTask<FunctionT>::~X_RangeTask(){ }
+
+}
+
+#endif
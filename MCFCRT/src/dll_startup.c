@@ -4,6 +4,7 @@
 
 #include "mcfcrt.h"
 #include "env/cpu.h"
+#include "env/_heap_impl.h"
 #include "env/thread.h"
 #include "env/mcfwin.h"
 
@@ -35,6 +36,7 @@ static unsigned long WrappedDllStartup(void *pOpaque){
 		return true;
 
 	case DLL_THREAD_DETACH:
+		__MCFCRT_HeapImplThreadCleanup();
 		return true;
 
 	default:
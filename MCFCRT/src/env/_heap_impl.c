@@ -0,0 +1,1143 @@
+// 这个文件是 MCF 的一部分。
+// 有关具体授权说明，请参阅 MCFLicense.txt。
+// Copyleft 2013 - 2018, LH_Mouse. All wrongs reserved.
+
+#include "_heap_impl.h"
+#include "mcfwin.h"
+#include "mutex.h"
+#include "once_flag.h"
+#include "inline_mem.h"
+#include "bail.h"
+#include "xassert.h"
+#include "expect.h"
+
+// Segments are aligned to their size, so the segment of a block can be located by masking off the lower bits of its address.
+#define SEGMENT_SIZE            ((size_t)0x400000)
+// This is the allocation granularity of Windows.
+#define SPAN_PAGE_SIZE          ((size_t)0x10000)
+#define PAGES_PER_SEGMENT       ((unsigned)(SEGMENT_SIZE / SPAN_PAGE_SIZE))
+
+static_assert(PAGES_PER_SEGMENT == 64, "The page bitmap of a segment must fit in a `uint64_t`.");
+
+// Classes 0 ~ 7 are multiples of 16 bytes. Every power of two above 128 bytes is split into 4 classes.
+#define CLASS_COUNT             48u
+#define SMALL_SIZE_MAX          ((size_t)0x20000)
+// Every span shall be able to hold at least this number of blocks.
+#define SPAN_BLOCK_COUNT_MIN    8u
+// When the first span of a class is exhausted, at most this number of spans are examined before a new span is acquired.
+#define SPAN_SCAN_COUNT_MAX     8u
+
+#define HUGE_HEADER_SIZE        ((size_t)_MCFCRT_CACHE_LINE_SIZE)
+// Huge blocks are located after their headers within the first segment-sized region of their reservations, which limits their alignment.
+#define HUGE_ALIGNMENT_MAX      (SEGMENT_SIZE / 2)
+// Huge blocks of at least this size reserve extra address space after them, so they can grow in place.
+#define HUGE_GROWTH_THRESHOLD   ((size_t)0x100000)
+#define HEAP_CHUNK_SIZE         ((size_t)0x10000)
+
+// Each thread accumulates changes of live bytes locally and flushes them to the global counter when they exceed this threshold.
+// Hence the peak is accurate to within (number of threads * threshold) bytes.
+#define LIVE_DELTA_FLUSH_THRESHOLD  ((intptr_t)0x40000)
+#define SAMPLING_INTERVAL_DEFAULT   ((size_t)0x80000)
+// If sampling is disabled, threads check whether it has been enabled again after allocating this number of bytes.
+#define SAMPLING_RECHECK_INTERVAL   ((size_t)0x1000000)
+
+#define KIND_SMALL              ((uintptr_t)0x6C616D53)
+#define KIND_HUGE               ((uintptr_t)0x65677548)
+
+static inline unsigned GetClassFromSize(size_t uSize){
+	_MCFCRT_ASSERT(uSize <= SMALL_SIZE_MAX);
+	if(uSize <= 128){
+		return (unsigned)((uSize + 15) / 16) - (uSize != 0);
+	}
+	const size_t uIndex = uSize - 1;
+	const unsigned uLog2 = (unsigned)(sizeof(unsigned long long) * CHAR_BIT - 1) - (unsigned)__builtin_clzll(uIndex);
+	return 8 + (uLog2 - 7) * 4 + (unsigned)((uIndex >> (uLog2 - 2)) & 3);
+}
+static inline size_t GetSizeOfClass(unsigned uClass){
+	_MCFCRT_ASSERT(uClass < CLASS_COUNT);
+	if(uClass < 8){
+		return (uClass + 1) * (size_t)16;
+	}
+	const unsigned uGroup = (uClass - 8) / 4;
+	const unsigned uStep = (uClass - 8) % 4;
+	return (size_t)(5 + uStep) << (uGroup + 5);
+}
+// Spans are aligned to `SPAN_PAGE_SIZE`, so blocks of a class whose size is a multiple of the alignment are aligned, too.
+// This function returns `CLASS_COUNT` if there is no such class.
+static inline unsigned GetClassFromSizeAndAlignment(size_t uSize, size_t uAlignment){
+	if(uAlignment > SPAN_PAGE_SIZE){
+		return CLASS_COUNT;
+	}
+	unsigned uClass = GetClassFromSize(uSize);
+	while((uClass < CLASS_COUNT) && (GetSizeOfClass(uClass) % uAlignment != 0)){
+		++uClass;
+	}
+	return uClass;
+}
+static inline unsigned GetSpanPageCountOfClass(unsigned uClass){
+	const size_t uBytes = GetSizeOfClass(uClass) * SPAN_BLOCK_COUNT_MIN;
+	return (unsigned)((uBytes + SPAN_PAGE_SIZE - 1) / SPAN_PAGE_SIZE);
+}
+
+static_assert(SMALL_SIZE_MAX * SPAN_BLOCK_COUNT_MIN < SEGMENT_SIZE - SPAN_PAGE_SIZE, "The largest span would not fit in a segment.");
+
+typedef struct tagFreeBlock {
+	struct tagFreeBlock *pNext;
+} FreeBlock;
+
+struct tagThreadHeap;
+
+typedef struct tagSpan {
+	struct tagSegment *pSegment;
+	struct tagThreadHeap *pOwner; // Atomic. This is a null pointer if the span has been abandoned.
+	struct tagSpan *pPrev; // By owner
+	struct tagSpan *pNext; // By owner
+
+	unsigned uClass;
+	unsigned uPageIndex;
+	unsigned uPageCount;
+	size_t uBlockSize;
+
+	// These members are accessed exclusively by the owner.
+	size_t uBlocksInUse;
+	unsigned char *pbyBump;
+	unsigned char *pbyEnd;
+	FreeBlock *pLocalFree;
+
+	// This is a lock-free stack where other threads push blocks that they free.
+	alignas(_MCFCRT_CACHE_LINE_SIZE) FreeBlock *pRemoteFree;
+} Span;
+
+typedef struct tagSpanQueue {
+	struct tagSpan *pFirst;
+	struct tagSpan *pLast;
+} SpanQueue;
+
+typedef struct tagSegment {
+	uintptr_t uKind;
+	void *pReservationBase;
+	struct tagSegment *pPrev;
+	struct tagSegment *pNext;
+
+	// These bitmaps are protected by the central mutex. The first page is always in use since it holds this header.
+	uint64_t u64PagesInUse;
+	uint64_t u64PagesCommitted;
+
+	Span *apSpanByPage[PAGES_PER_SEGMENT];
+	Span aSpans[PAGES_PER_SEGMENT];
+} Segment;
+
+static_assert(sizeof(Segment) <= SPAN_PAGE_SIZE, "The segment header would not fit in the first page.");
+
+#define SEGMENT_HEADER_COMMIT_SIZE   ((sizeof(Segment) + _MCFCRT_PAGE_SIZE_MINIMUM - 1) & ~(size_t)(_MCFCRT_PAGE_SIZE_MINIMUM - 1))
+
+typedef struct tagHugeHeader {
+	uintptr_t uKind;
+	void *pReservationBase;
+	size_t uBlockOffset; // This is `HUGE_HEADER_SIZE` unless the block is over-aligned.
+	size_t uReserved;    // Including the header
+	size_t uCommitted;   // Including the header
+} HugeHeader;
+
+static_assert(sizeof(HugeHeader) <= HUGE_HEADER_SIZE, "??");
+
+// These counters are written by the owner only, but may be read by other threads at any time.
+typedef struct tagHeapCounters {
+	uint64_t u64AllocCount;
+	uint64_t u64ReallocCount;
+	uint64_t u64FreeCount;
+	uint64_t u64BytesAllocated;
+	uint64_t u64BytesFreed;
+	uint64_t au64Histogram[_MCFCRT_HEAP_HISTOGRAM_SIZE];
+} HeapCounters;
+
+typedef struct tagThreadHeap {
+	struct tagThreadHeap *pNextFree;
+	// All heaps that are in use form a list, which is protected by the central mutex.
+	struct tagThreadHeap *pPrevLive;
+	struct tagThreadHeap *pNextLive;
+	SpanQueue aQueues[CLASS_COUNT];
+
+	HeapCounters vCounters;
+	intptr_t nLiveDelta;
+	intptr_t nBytesUntilSample;
+} ThreadHeap;
+
+typedef enum tagOperation {
+	kOperationAlloc,
+	kOperationRealloc,
+	kOperationFree,
+} Operation;
+
+typedef struct tagProfileSite {
+	const void *pRetAddrOuter;
+	const void *pRetAddrInner;
+	uint64_t u64SampleCount; // This is zero if the site is not in use.
+	uint64_t u64EstimatedBytes;
+} ProfileSite;
+
+// This marks a thread that has exited. Such a thread allocates memory from the shared heap.
+#define HEAP_DEAD               ((ThreadHeap *)(intptr_t)-1)
+
+static _MCFCRT_Mutex g_mtxCentral                         = { 0 };
+static Segment *     g_pFirstSegment                      = _MCFCRT_NULLPTR;
+static Segment *     g_pCachedSegment                     = _MCFCRT_NULLPTR;
+static SpanQueue     g_aAbandonedQueues[CLASS_COUNT]      = { { 0 } };
+static ThreadHeap *  g_pFirstFreeHeap                     = _MCFCRT_NULLPTR;
+
+static ThreadHeap *  g_pFirstLiveHeap                     = _MCFCRT_NULLPTR;
+static HeapCounters  g_vRetiredCounters                   = { 0 };
+
+static _MCFCRT_Mutex g_mtxShared                          = { 0 };
+static ThreadHeap    g_vSharedHeap                        = { 0 };
+
+static volatile intptr_t g_nLiveBytes                     = 0;
+static volatile intptr_t g_nPeakBytes                     = 0;
+
+static volatile size_t g_uSamplingInterval                = SAMPLING_INTERVAL_DEFAULT;
+static _MCFCRT_Mutex   g_mtxProfile                       = { 0 };
+static ProfileSite     g_aProfileSites[__MCFCRT_HEAP_PROFILE_SITE_COUNT_MAX] = { { 0 } };
+static uint64_t        g_u64SampleCount                   = 0;
+static uint64_t        g_u64DroppedSampleCount            = 0;
+
+static _MCFCRT_OnceFlag g_onceTlsIndex                    = { 0 };
+static DWORD            g_dwTlsIndex                      = TLS_OUT_OF_INDEXES;
+
+// `*ppBase` receives the address that shall be passed to `ReleaseAddressSpace()`, which may differ from the return value.
+static void *ReserveAlignedAddressSpace(void **ppBase, size_t uSize){
+	size_t uSizeToProbe;
+	if(__builtin_add_overflow(uSize, SEGMENT_SIZE - SPAN_PAGE_SIZE, &uSizeToProbe)){
+		return _MCFCRT_NULLPTR;
+	}
+	for(unsigned uRetryCount = 0; uRetryCount < 4; ++uRetryCount){
+		// Reserve a larger region, release it, then reserve an aligned region inside it.
+		// This fails if another thread steals the address space in between, in which case we try again.
+		void *const pProbe = VirtualAlloc(_MCFCRT_NULLPTR, uSizeToProbe, MEM_RESERVE, PAGE_NOACCESS);
+		if(!pProbe){
+			return _MCFCRT_NULLPTR;
+		}
+		void *const pAligned = (void *)(((uintptr_t)pProbe + SEGMENT_SIZE - 1) & ~(uintptr_t)(SEGMENT_SIZE - 1));
+		if(pAligned == pProbe){
+			// Lucky. Keep the slack at the end, which is never committed.
+			*ppBase = pProbe;
+			return pAligned;
+		}
+		VirtualFree(pProbe, 0, MEM_RELEASE);
+		void *const pReserved = VirtualAlloc(pAligned, uSize, MEM_RESERVE, PAGE_NOACCESS);
+		if(pReserved){
+			_MCFCRT_ASSERT(pReserved == pAligned);
+			*ppBase = pReserved;
+			return pReserved;
+		}
+	}
+	// We have been racing with other threads for too long. Waste some address space rather than failing.
+	void *const pProbe = VirtualAlloc(_MCFCRT_NULLPTR, uSizeToProbe, MEM_RESERVE, PAGE_NOACCESS);
+	if(!pProbe){
+		return _MCFCRT_NULLPTR;
+	}
+	*ppBase = pProbe;
+	return (void *)(((uintptr_t)pProbe + SEGMENT_SIZE - 1) & ~(uintptr_t)(SEGMENT_SIZE - 1));
+}
+static inline bool CommitAddressSpace(void *pBase, size_t uSize){
+	return VirtualAlloc(pBase, uSize, MEM_COMMIT, PAGE_READWRITE) != _MCFCRT_NULLPTR;
+}
+static inline void DecommitAddressSpace(void *pBase, size_t uSize){
+	VirtualFree(pBase, uSize, MEM_DECOMMIT);
+}
+static inline void ReleaseAddressSpace(void *pBase){
+	VirtualFree(pBase, 0, MEM_RELEASE);
+}
+
+static inline void QueueRemove(SpanQueue *restrict pQueue, Span *restrict pSpan){
+	Span *const pPrev = pSpan->pPrev;
+	Span *const pNext = pSpan->pNext;
+	if(pPrev){
+		pPrev->pNext = pNext;
+	} else {
+		pQueue->pFirst = pNext;
+	}
+	if(pNext){
+		pNext->pPrev = pPrev;
+	} else {
+		pQueue->pLast = pPrev;
+	}
+}
+static inline void QueuePushFront(SpanQueue *restrict pQueue, Span *restrict pSpan){
+	Span *const pPrev = _MCFCRT_NULLPTR;
+	Span *const pNext = pQueue->pFirst;
+	if(pNext){
+		pNext->pPrev = pSpan;
+	} else {
+		pQueue->pLast = pSpan;
+	}
+	pQueue->pFirst = pSpan;
+	pSpan->pPrev = pPrev;
+	pSpan->pNext = pNext;
+}
+static inline void QueuePushBack(SpanQueue *restrict pQueue, Span *restrict pSpan){
+	Span *const pPrev = pQueue->pLast;
+	Span *const pNext = _MCFCRT_NULLPTR;
+	if(pPrev){
+		pPrev->pNext = pSpan;
+	} else {
+		pQueue->pFirst = pSpan;
+	}
+	pQueue->pLast = pSpan;
+	pSpan->pPrev = pPrev;
+	pSpan->pNext = pNext;
+}
+
+static inline uint64_t GetPageMask(unsigned uPageIndex, unsigned uPageCount){
+	_MCFCRT_ASSERT(uPageCount < PAGES_PER_SEGMENT);
+	return (((uint64_t)1 << uPageCount) - 1) << uPageIndex;
+}
+static inline unsigned FindFreePages(uint64_t u64PagesInUse, unsigned uPageCount){
+	for(unsigned uPageIndex = 1; uPageIndex + uPageCount <= PAGES_PER_SEGMENT; ++uPageIndex){
+		if(!(u64PagesInUse & GetPageMask(uPageIndex, uPageCount))){
+			return uPageIndex;
+		}
+	}
+	return 0;
+}
+
+// The caller must have the central mutex locked!
+static Segment *CreateSegmentUnsafe(void){
+	Segment *pSegment = g_pCachedSegment;
+	if(pSegment){
+		g_pCachedSegment = _MCFCRT_NULLPTR;
+	} else {
+		void *pReservationBase;
+		pSegment = ReserveAlignedAddressSpace(&pReservationBase, SEGMENT_SIZE);
+		if(!pSegment){
+			return _MCFCRT_NULLPTR;
+		}
+		if(!CommitAddressSpace(pSegment, SEGMENT_HEADER_COMMIT_SIZE)){
+			ReleaseAddressSpace(pReservationBase);
+			return _MCFCRT_NULLPTR;
+		}
+		pSegment->uKind             = KIND_SMALL;
+		pSegment->pReservationBase  = pReservationBase;
+		pSegment->u64PagesCommitted = 1;
+	}
+	pSegment->u64PagesInUse = 1;
+
+	Segment *const pNext = g_pFirstSegment;
+	if(pNext){
+		pNext->pPrev = pSegment;
+	}
+	g_pFirstSegment = pSegment;
+	pSegment->pPrev = _MCFCRT_NULLPTR;
+	pSegment->pNext = pNext;
+	return pSegment;
+}
+// The caller must have the central mutex locked!
+static Segment *DetachEmptySegmentUnsafe(Segment *pSegment){
+	_MCFCRT_ASSERT(pSegment->u64PagesInUse == 1);
+
+	Segment *const pPrev = pSegment->pPrev;
+	Segment *const pNext = pSegment->pNext;
+	if(pPrev){
+		pPrev->pNext = pNext;
+	} else {
+		g_pFirstSegment = pNext;
+	}
+	if(pNext){
+		pNext->pPrev = pPrev;
+	}
+	// Keep one empty segment around so the next span can be carved without a system call.
+	if(!g_pCachedSegment){
+		g_pCachedSegment = pSegment;
+		return _MCFCRT_NULLPTR;
+	}
+	return pSegment;
+}
+
+// The caller must have the central mutex locked!
+static Span *CarveSpanUnsafe(unsigned uClass){
+	const unsigned uPageCount = GetSpanPageCountOfClass(uClass);
+	unsigned uPageIndex = 0;
+	Segment *pSegment = g_pFirstSegment;
+	while(pSegment){
+		uPageIndex = FindFreePages(pSegment->u64PagesInUse, uPageCount);
+		if(uPageIndex != 0){
+			break;
+		}
+		pSegment = pSegment->pNext;
+	}
+	if(!pSegment){
+		pSegment = CreateSegmentUnsafe();
+		if(!pSegment){
+			return _MCFCRT_NULLPTR;
+		}
+		uPageIndex = 1;
+	}
+	const uint64_t u64Mask = GetPageMask(uPageIndex, uPageCount);
+	unsigned char *const pbyBegin = (unsigned char *)pSegment + uPageIndex * SPAN_PAGE_SIZE;
+	if((pSegment->u64PagesCommitted & u64Mask) != u64Mask){
+		if(!CommitAddressSpace(pbyBegin, uPageCount * SPAN_PAGE_SIZE)){
+			return _MCFCRT_NULLPTR;
+		}
+		pSegment->u64PagesCommitted |= u64Mask;
+	}
+	pSegment->u64PagesInUse |= u64Mask;
+
+	Span *const pSpan = pSegment->aSpans + uPageIndex;
+	for(unsigned uIndex = 0; uIndex < uPageCount; ++uIndex){
+		pSegment->apSpanByPage[uPageIndex + uIndex] = pSpan;
+	}
+	const size_t uBlockSize = GetSizeOfClass(uClass);
+	pSpan->pSegment     = pSegment;
+	pSpan->pOwner       = _MCFCRT_NULLPTR;
+	pSpan->pPrev        = _MCFCRT_NULLPTR;
+	pSpan->pNext        = _MCFCRT_NULLPTR;
+	pSpan->uClass       = uClass;
+	pSpan->uPageIndex   = uPageIndex;
+	pSpan->uPageCount   = uPageCount;
+	pSpan->uBlockSize   = uBlockSize;
+	pSpan->uBlocksInUse = 0;
+	pSpan->pbyBump      = pbyBegin;
+	pSpan->pbyEnd       = pbyBegin + uPageCount * SPAN_PAGE_SIZE / uBlockSize * uBlockSize;
+	pSpan->pLocalFree   = _MCFCRT_NULLPTR;
+	pSpan->pRemoteFree  = _MCFCRT_NULLPTR;
+	return pSpan;
+}
+// The span must have been detached from its owner and all blocks in it must have been freed.
+static void ReleaseSpan(Span *pSpan){
+	_MCFCRT_ASSERT(pSpan->uBlocksInUse == 0);
+	_MCFCRT_ASSERT(!pSpan->pRemoteFree);
+
+	Segment *const pSegment = pSpan->pSegment;
+	Segment *pSegmentToRelease = _MCFCRT_NULLPTR;
+	_MCFCRT_WaitForMutexForever(&g_mtxCentral, _MCFCRT_MUTEX_SUGGESTED_SPIN_COUNT);
+	{
+		for(unsigned uIndex = 0; uIndex < pSpan->uPageCount; ++uIndex){
+			pSegment->apSpanByPage[pSpan->uPageIndex + uIndex] = _MCFCRT_NULLPTR;
+		}
+		pSegment->u64PagesInUse &= ~GetPageMask(pSpan->uPageIndex, pSpan->uPageCount);
+		if(pSegment->u64PagesInUse == 1){
+			pSegmentToRelease = DetachEmptySegmentUnsafe(pSegment);
+		}
+	}
+	_MCFCRT_SignalMutex(&g_mtxCentral);
+
+	if(pSegmentToRelease){
+		ReleaseAddressSpace(pSegmentToRelease->pReservationBase);
+	}
+}
+
+// The caller must own the span!
+static inline void CollectRemoteFrees(Span *pSpan){
+	if(_MCFCRT_EXPECT(!__atomic_load_n(&(pSpan->pRemoteFree), __ATOMIC_RELAXED))){
+		return;
+	}
+	FreeBlock *const pFirst = __atomic_exchange_n(&(pSpan->pRemoteFree), _MCFCRT_NULLPTR, __ATOMIC_ACQUIRE);
+	if(!pFirst){
+		return;
+	}
+	size_t uCount = 1;
+	FreeBlock *pLast = pFirst;
+	while(pLast->pNext){
+		pLast = pLast->pNext;
+		++uCount;
+	}
+	pLast->pNext = pSpan->pLocalFree;
+	pSpan->pLocalFree = pFirst;
+	_MCFCRT_ASSERT(pSpan->uBlocksInUse >= uCount);
+	pSpan->uBlocksInUse -= uCount;
+}
+// The caller must own the span!
+static inline void *PopBlockFromSpan(Span *pSpan){
+	FreeBlock *pBlock = pSpan->pLocalFree;
+	if(_MCFCRT_EXPECT_NOT(!pBlock)){
+		if(pSpan->pbyBump != pSpan->pbyEnd){
+			pBlock = (FreeBlock *)pSpan->pbyBump;
+			pSpan->pbyBump += pSpan->uBlockSize;
+			++(pSpan->uBlocksInUse);
+			return pBlock;
+		}
+		CollectRemoteFrees(pSpan);
+		pBlock = pSpan->pLocalFree;
+		if(!pBlock){
+			return _MCFCRT_NULLPTR;
+		}
+	}
+	pSpan->pLocalFree = pBlock->pNext;
+	++(pSpan->uBlocksInUse);
+	return pBlock;
+}
+
+static Span *AcquireSpan(ThreadHeap *pHeap, unsigned uClass){
+	Span *pSpan;
+	_MCFCRT_WaitForMutexForever(&g_mtxCentral, _MCFCRT_MUTEX_SUGGESTED_SPIN_COUNT);
+	{
+		// Adopt a span that was abandoned by an exited thread, if any. Otherwise carve a new one.
+		SpanQueue *const pAbandoned = g_aAbandonedQueues + uClass;
+		pSpan = pAbandoned->pFirst;
+		if(pSpan){
+			QueueRemove(pAbandoned, pSpan);
+		} else {
+			pSpan = CarveSpanUnsafe(uClass);
+		}
+		if(pSpan){
+			__atomic_store_n(&(pSpan->pOwner), pHeap, __ATOMIC_RELAXED);
+		}
+	}
+	_MCFCRT_SignalMutex(&g_mtxCentral);
+
+	if(!pSpan){
+		return _MCFCRT_NULLPTR;
+	}
+	QueuePushFront(pHeap->aQueues + uClass, pSpan);
+	return pSpan;
+}
+
+static void *AllocSmall(ThreadHeap *pHeap, unsigned uClass){
+	SpanQueue *const pQueue = pHeap->aQueues + uClass;
+	void *pBlock;
+	Span *pSpan = pQueue->pFirst;
+	if(_MCFCRT_EXPECT(pSpan)){
+		pBlock = PopBlockFromSpan(pSpan);
+		if(_MCFCRT_EXPECT(pBlock)){
+			return pBlock;
+		}
+		// The first span is exhausted. Move it to the back and try the next one.
+		for(unsigned uScanCount = 1; uScanCount < SPAN_SCAN_COUNT_MAX; ++uScanCount){
+			if(pQueue->pFirst == pQueue->pLast){
+				break;
+			}
+			QueueRemove(pQueue, pSpan);
+			QueuePushBack(pQueue, pSpan);
+			pSpan = pQueue->pFirst;
+			pBlock = PopBlockFromSpan(pSpan);
+			if(pBlock){
+				return pBlock;
+			}
+		}
+	}
+	for(;;){
+		pSpan = AcquireSpan(pHeap, uClass);
+		if(!pSpan){
+			return _MCFCRT_NULLPTR;
+		}
+		// An adopted span may have no free blocks. It stays in the queue anyway, since it is owned by us now.
+		pBlock = PopBlockFromSpan(pSpan);
+		if(pBlock){
+			return pBlock;
+		}
+	}
+}
+static void FreeSmall(ThreadHeap *pHeap, Span *pSpan, void *pBlock){
+	FreeBlock *const pFreeBlock = pBlock;
+	if(_MCFCRT_EXPECT(pHeap && (__atomic_load_n(&(pSpan->pOwner), __ATOMIC_RELAXED) == pHeap))){
+		pFreeBlock->pNext = pSpan->pLocalFree;
+		pSpan->pLocalFree = pFreeBlock;
+		_MCFCRT_ASSERT(pSpan->uBlocksInUse > 0);
+		if(_MCFCRT_EXPECT_NOT(--(pSpan->uBlocksInUse) == 0)){
+			// Give empty spans back unless it is the one we are allocating from.
+			SpanQueue *const pQueue = pHeap->aQueues + pSpan->uClass;
+			if(pQueue->pFirst != pSpan){
+				QueueRemove(pQueue, pSpan);
+				ReleaseSpan(pSpan);
+			}
+		}
+		return;
+	}
+	// Hand the block over to its owner.
+	FreeBlock *pOld = __atomic_load_n(&(pSpan->pRemoteFree), __ATOMIC_RELAXED);
+	do {
+		pFreeBlock->pNext = pOld;
+	} while(_MCFCRT_EXPECT_NOT(!__atomic_compare_exchange_n(&(pSpan->pRemoteFree), &pOld, pFreeBlock, false, __ATOMIC_RELEASE, __ATOMIC_RELAXED)));
+}
+
+static inline size_t GetHugeHeadroom(size_t uSizeToCommit){
+	if(uSizeToCommit < HUGE_GROWTH_THRESHOLD){
+		return 0;
+	}
+#ifdef _WIN64
+	// Address space is cheap. Allow the block to double its size in place.
+	return uSizeToCommit;
+#else
+	// Address space is scarce. Be conservative.
+	return uSizeToCommit / 4;
+#endif
+}
+
+static void *AllocHuge(size_t uSize, size_t uAlignment){
+	_MCFCRT_ASSERT(uAlignment <= HUGE_ALIGNMENT_MAX);
+	const size_t uBlockOffset = (uAlignment > HUGE_HEADER_SIZE) ? uAlignment : HUGE_HEADER_SIZE;
+	size_t uSizeToCommit, uSizeToReserve;
+	if(__builtin_add_overflow(uSize, uBlockOffset + _MCFCRT_PAGE_SIZE_MINIMUM - 1, &uSizeToCommit)){
+		return _MCFCRT_NULLPTR;
+	}
+	uSizeToCommit &= ~(size_t)(_MCFCRT_PAGE_SIZE_MINIMUM - 1);
+	if(__builtin_add_overflow(uSizeToCommit, SPAN_PAGE_SIZE - 1, &uSizeToReserve)){
+		return _MCFCRT_NULLPTR;
+	}
+	uSizeToReserve &= ~(size_t)(SPAN_PAGE_SIZE - 1);
+
+	void *pReservationBase;
+	HugeHeader *pHeader = _MCFCRT_NULLPTR;
+	size_t uSizeWithHeadroom;
+	if(!__builtin_add_overflow(uSizeToReserve, GetHugeHeadroom(uSizeToCommit) & ~(size_t)(SPAN_PAGE_SIZE - 1), &uSizeWithHeadroom) && (uSizeWithHeadroom != uSizeToReserve)){
+		// If we fail to reserve the headroom, retry without it.
+		pHeader = ReserveAlignedAddressSpace(&pReservationBase, uSizeWithHeadroom);
+		if(pHeader){
+			uSizeToReserve = uSizeWithHeadroom;
+		}
+	}
+	if(!pHeader){
+		pHeader = ReserveAlignedAddressSpace(&pReservationBase, uSizeToReserve);
+		if(!pHeader){
+			return _MCFCRT_NULLPTR;
+		}
+	}
+	if(!CommitAddressSpace(pHeader, uSizeToCommit)){
+		ReleaseAddressSpace(pReservationBase);
+		return _MCFCRT_NULLPTR;
+	}
+	pHeader->uKind            = KIND_HUGE;
+	pHeader->pReservationBase = pReservationBase;
+	pHeader->uBlockOffset     = uBlockOffset;
+	pHeader->uReserved        = uSizeToReserve;
+	pHeader->uCommitted       = uSizeToCommit;
+	// Pages are zeroed by the system.
+	return (unsigned char *)pHeader + uBlockOffset;
+}
+static bool ResizeHugeInPlace(HugeHeader *pHeader, size_t uSize){
+	size_t uSizeToCommit;
+	if(__builtin_add_overflow(uSize, pHeader->uBlockOffset + _MCFCRT_PAGE_SIZE_MINIMUM - 1, &uSizeToCommit)){
+		return false;
+	}
+	uSizeToCommit &= ~(size_t)(_MCFCRT_PAGE_SIZE_MINIMUM - 1);
+	if(uSizeToCommit > pHeader->uCommitted){
+		// Grow the block by committing pages that have been reserved after it. They are zeroed by the system.
+		if(uSizeToCommit > pHeader->uReserved){
+			return false;
+		}
+		if(!CommitAddressSpace((unsigned char *)pHeader + pHeader->uCommitted, uSizeToCommit - pHeader->uCommitted)){
+			return false;
+		}
+		pHeader->uCommitted = uSizeToCommit;
+		return true;
+	}
+	// Give trailing pages back to the system if the block has shrunk by at least a quarter.
+	const size_t uSizeToDecommit = pHeader->uCommitted - uSizeToCommit;
+	if(uSizeToDecommit >= pHeader->uCommitted / 4){
+		DecommitAddressSpace((unsigned char *)pHeader + uSizeToCommit, uSizeToDecommit);
+		pHeader->uCommitted = uSizeToCommit;
+	}
+	return true;
+}
+
+static inline void AddToCounter(uint64_t *pu64Counter, uint64_t u64Delta){
+	// Only the owner writes the counter, so no read-modify-write operation is required. Other threads may read it at any time.
+	__atomic_store_n(pu64Counter, __atomic_load_n(pu64Counter, __ATOMIC_RELAXED) + u64Delta, __ATOMIC_RELAXED);
+}
+static inline unsigned GetHistogramBucket(size_t uSize){
+	const unsigned uLog2 = (unsigned)(sizeof(unsigned long long) * CHAR_BIT - 1) - (unsigned)__builtin_clzll(uSize | 1);
+	return (uLog2 < _MCFCRT_HEAP_HISTOGRAM_SIZE) ? uLog2 : (_MCFCRT_HEAP_HISTOGRAM_SIZE - 1);
+}
+static void AccumulateCounters(HeapCounters *restrict pTotal, const HeapCounters *restrict pCounters){
+	pTotal->u64AllocCount     += __atomic_load_n(&(pCounters->u64AllocCount),     __ATOMIC_RELAXED);
+	pTotal->u64ReallocCount   += __atomic_load_n(&(pCounters->u64ReallocCount),   __ATOMIC_RELAXED);
+	pTotal->u64FreeCount      += __atomic_load_n(&(pCounters->u64FreeCount),      __ATOMIC_RELAXED);
+	pTotal->u64BytesAllocated += __atomic_load_n(&(pCounters->u64BytesAllocated), __ATOMIC_RELAXED);
+	pTotal->u64BytesFreed     += __atomic_load_n(&(pCounters->u64BytesFreed),     __ATOMIC_RELAXED);
+	for(unsigned uBucket = 0; uBucket < _MCFCRT_HEAP_HISTOGRAM_SIZE; ++uBucket){
+		pTotal->au64Histogram[uBucket] += __atomic_load_n(pCounters->au64Histogram + uBucket, __ATOMIC_RELAXED);
+	}
+}
+
+static void FlushLiveDelta(ThreadHeap *pHeap){
+	const intptr_t nDelta = pHeap->nLiveDelta;
+	if(nDelta == 0){
+		return;
+	}
+	pHeap->nLiveDelta = 0;
+	const intptr_t nLiveBytes = __atomic_add_fetch(&g_nLiveBytes, nDelta, __ATOMIC_RELAXED);
+	intptr_t nPeakBytes = __atomic_load_n(&g_nPeakBytes, __ATOMIC_RELAXED);
+	while(nPeakBytes < nLiveBytes){
+		if(__atomic_compare_exchange_n(&g_nPeakBytes, &nPeakBytes, nLiveBytes, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED)){
+			break;
+		}
+	}
+}
+
+static inline size_t HashProfileSite(const void *pRetAddrOuter, const void *pRetAddrInner){
+	uint64_t u64Hash = (uint64_t)(uintptr_t)pRetAddrOuter * 0x9E3779B97F4A7C15u;
+	u64Hash ^= (uint64_t)(uintptr_t)pRetAddrInner;
+	u64Hash *= 0xC2B2AE3D27D4EB4Fu;
+	return (size_t)(u64Hash >> 32) % __MCFCRT_HEAP_PROFILE_SITE_COUNT_MAX;
+}
+__attribute__((__noinline__))
+static void SampleAllocation(ThreadHeap *pHeap, const void *pRetAddrOuter, const void *pRetAddrInner){
+	const size_t uInterval = __atomic_load_n(&g_uSamplingInterval, __ATOMIC_RELAXED);
+	if(uInterval == 0){
+		pHeap->nBytesUntilSample = (intptr_t)SAMPLING_RECHECK_INTERVAL;
+		return;
+	}
+	// Every sample represents `uInterval` bytes. Large blocks may cover multiple intervals.
+	const size_t uIntervalCount = (size_t)-(pHeap->nBytesUntilSample) / uInterval + 1;
+	pHeap->nBytesUntilSample += (intptr_t)(uIntervalCount * uInterval);
+	const uint64_t u64EstimatedBytes = (uint64_t)uIntervalCount * uInterval;
+
+	_MCFCRT_WaitForMutexForever(&g_mtxProfile, _MCFCRT_MUTEX_SUGGESTED_SPIN_COUNT);
+	{
+		++g_u64SampleCount;
+		size_t uIndex = HashProfileSite(pRetAddrOuter, pRetAddrInner);
+		size_t uProbeCount = 0;
+		for(;;){
+			ProfileSite *const pSite = g_aProfileSites + uIndex;
+			if(pSite->u64SampleCount == 0){
+				pSite->pRetAddrOuter     = pRetAddrOuter;
+				pSite->pRetAddrInner     = pRetAddrInner;
+				pSite->u64SampleCount    = 1;
+				pSite->u64EstimatedBytes = u64EstimatedBytes;
+				break;
+			}
+			if((pSite->pRetAddrOuter == pRetAddrOuter) && (pSite->pRetAddrInner == pRetAddrInner)){
+				pSite->u64SampleCount    += 1;
+				pSite->u64EstimatedBytes += u64EstimatedBytes;
+				break;
+			}
+			if(++uProbeCount == __MCFCRT_HEAP_PROFILE_SITE_COUNT_MAX){
+				// The table is full.
+				++g_u64DroppedSampleCount;
+				break;
+			}
+			uIndex = (uIndex + 1) % __MCFCRT_HEAP_PROFILE_SITE_COUNT_MAX;
+		}
+	}
+	_MCFCRT_SignalMutex(&g_mtxProfile);
+}
+
+// The caller shall own `pCounterHeap`. If it is the shared heap, `g_mtxShared` shall be locked.
+static void RecordOperationUnsafe(ThreadHeap *pCounterHeap, Operation eOperation, size_t uSizeAllocated, size_t uSizeFreed, const void *pRetAddrOuter, const void *pRetAddrInner){
+	HeapCounters *const pCounters = &(pCounterHeap->vCounters);
+	switch(eOperation){
+	case kOperationAlloc:
+		AddToCounter(&(pCounters->u64AllocCount), 1);
+		break;
+	case kOperationRealloc:
+		AddToCounter(&(pCounters->u64ReallocCount), 1);
+		break;
+	case kOperationFree:
+		AddToCounter(&(pCounters->u64FreeCount), 1);
+		break;
+	}
+	if(uSizeAllocated != 0){
+		AddToCounter(&(pCounters->u64BytesAllocated), uSizeAllocated);
+		AddToCounter(pCounters->au64Histogram + GetHistogramBucket(uSizeAllocated), 1);
+	}
+	if(uSizeFreed != 0){
+		AddToCounter(&(pCounters->u64BytesFreed), uSizeFreed);
+	}
+
+	pCounterHeap->nLiveDelta += (intptr_t)(uSizeAllocated - uSizeFreed);
+	if(_MCFCRT_EXPECT_NOT((pCounterHeap->nLiveDelta >= LIVE_DELTA_FLUSH_THRESHOLD) || (pCounterHeap->nLiveDelta <= -LIVE_DELTA_FLUSH_THRESHOLD))){
+		FlushLiveDelta(pCounterHeap);
+	}
+	if(uSizeAllocated != 0){
+		pCounterHeap->nBytesUntilSample -= (intptr_t)uSizeAllocated;
+		if(_MCFCRT_EXPECT_NOT(pCounterHeap->nBytesUntilSample <= 0)){
+			SampleAllocation(pCounterHeap, pRetAddrOuter, pRetAddrInner);
+		}
+	}
+}
+// `pHeap` is a null pointer if the operation has been performed on the shared heap.
+// This function is for operations that have not locked the shared heap themselves. Those that have shall call `RecordOperationUnsafe()` before unlocking it.
+static void RecordOperation(ThreadHeap *pHeap, Operation eOperation, size_t uSizeAllocated, size_t uSizeFreed, const void *pRetAddrOuter, const void *pRetAddrInner){
+	if(_MCFCRT_EXPECT(pHeap)){
+		RecordOperationUnsafe(pHeap, eOperation, uSizeAllocated, uSizeFreed, pRetAddrOuter, pRetAddrInner);
+		return;
+	}
+	_MCFCRT_WaitForMutexForever(&g_mtxShared, _MCFCRT_MUTEX_SUGGESTED_SPIN_COUNT);
+	RecordOperationUnsafe(&g_vSharedHeap, eOperation, uSizeAllocated, uSizeFreed, pRetAddrOuter, pRetAddrInner);
+	_MCFCRT_SignalMutex(&g_mtxShared);
+}
+
+static DWORD GetTlsIndex(void){
+	const _MCFCRT_OnceResult eResult = _MCFCRT_WaitForOnceFlagForever(&g_onceTlsIndex);
+	if(_MCFCRT_EXPECT(eResult == _MCFCRT_kOnceResultFinished)){
+		return g_dwTlsIndex;
+	}
+	_MCFCRT_ASSERT(eResult == _MCFCRT_kOnceResultInitial);
+
+	const DWORD dwTlsIndex = TlsAlloc();
+	if(dwTlsIndex == TLS_OUT_OF_INDEXES){
+		_MCFCRT_Bail(L"TlsAlloc() 失败：无法为堆分配线程局部存储。");
+	}
+	__atomic_store_n(&g_dwTlsIndex, dwTlsIndex, __ATOMIC_RELEASE);
+	_MCFCRT_SignalOnceFlagAsFinished(&g_onceTlsIndex);
+	return dwTlsIndex;
+}
+static inline ThreadHeap *LoadThreadHeap(DWORD dwTlsIndex){
+	// `TlsGetValue()` clears the last error code on success. Don't let `malloc()` do that.
+	const DWORD dwLastError = GetLastError();
+	ThreadHeap *const pHeap = TlsGetValue(dwTlsIndex);
+	SetLastError(dwLastError);
+	return pHeap;
+}
+
+static ThreadHeap *CreateThreadHeap(void){
+	ThreadHeap *pHeap;
+	_MCFCRT_WaitForMutexForever(&g_mtxCentral, _MCFCRT_MUTEX_SUGGESTED_SPIN_COUNT);
+	{
+		pHeap = g_pFirstFreeHeap;
+		if(!pHeap){
+			ThreadHeap *const pChunk = VirtualAlloc(_MCFCRT_NULLPTR, HEAP_CHUNK_SIZE, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+			if(pChunk){
+				for(size_t uIndex = HEAP_CHUNK_SIZE / sizeof(ThreadHeap); uIndex != 0; --uIndex){
+					pChunk[uIndex - 1].pNextFree = g_pFirstFreeHeap;
+					g_pFirstFreeHeap = pChunk + uIndex - 1;
+				}
+				pHeap = g_pFirstFreeHeap;
+			}
+		}
+		if(pHeap){
+			g_pFirstFreeHeap = pHeap->pNextFree;
+			_MCFCRT_inline_mempset_fwd(pHeap, 0, sizeof(*pHeap));
+			const size_t uInterval = __atomic_load_n(&g_uSamplingInterval, __ATOMIC_RELAXED);
+			pHeap->nBytesUntilSample = (intptr_t)((uInterval != 0) ? uInterval : SAMPLING_RECHECK_INTERVAL);
+			// Link it into the list of live heaps.
+			pHeap->pNextLive = g_pFirstLiveHeap;
+			if(g_pFirstLiveHeap){
+				g_pFirstLiveHeap->pPrevLive = pHeap;
+			}
+			g_pFirstLiveHeap = pHeap;
+		}
+	}
+	_MCFCRT_SignalMutex(&g_mtxCentral);
+
+	return pHeap;
+}
+static void AbandonThreadHeap(ThreadHeap *pHeap){
+	for(unsigned uClass = 0; uClass < CLASS_COUNT; ++uClass){
+		SpanQueue *const pQueue = pHeap->aQueues + uClass;
+		for(;;){
+			Span *const pSpan = pQueue->pFirst;
+			if(!pSpan){
+				break;
+			}
+			QueueRemove(pQueue, pSpan);
+			CollectRemoteFrees(pSpan);
+			if(pSpan->uBlocksInUse == 0){
+				ReleaseSpan(pSpan);
+				continue;
+			}
+			// Some blocks are still in use. Blocks that are freed later will be pushed onto the remote-free list.
+			_MCFCRT_WaitForMutexForever(&g_mtxCentral, _MCFCRT_MUTEX_SUGGESTED_SPIN_COUNT);
+			{
+				__atomic_store_n(&(pSpan->pOwner), _MCFCRT_NULLPTR, __ATOMIC_RELAXED);
+				QueuePushBack(g_aAbandonedQueues + uClass, pSpan);
+			}
+			_MCFCRT_SignalMutex(&g_mtxCentral);
+		}
+	}
+
+	FlushLiveDelta(pHeap);
+
+	_MCFCRT_WaitForMutexForever(&g_mtxCentral, _MCFCRT_MUTEX_SUGGESTED_SPIN_COUNT);
+	{
+		// Keep its counters, then unlink it from the list of live heaps.
+		AccumulateCounters(&g_vRetiredCounters, &(pHeap->vCounters));
+		if(pHeap->pPrevLive){
+			pHeap->pPrevLive->pNextLive = pHeap->pNextLive;
+		} else {
+			g_pFirstLiveHeap = pHeap->pNextLive;
+		}
+		if(pHeap->pNextLive){
+			pHeap->pNextLive->pPrevLive = pHeap->pPrevLive;
+		}
+
+		pHeap->pNextFree = g_pFirstFreeHeap;
+		g_pFirstFreeHeap = pHeap;
+	}
+	_MCFCRT_SignalMutex(&g_mtxCentral);
+}
+
+// This function returns a null pointer if the calling thread shall allocate memory from the shared heap.
+static inline ThreadHeap *RequireThreadHeap(void){
+	const DWORD dwTlsIndex = GetTlsIndex();
+	ThreadHeap *pHeap = LoadThreadHeap(dwTlsIndex);
+	if(_MCFCRT_EXPECT(pHeap)){
+		return (pHeap != HEAP_DEAD) ? pHeap : _MCFCRT_NULLPTR;
+	}
+	pHeap = CreateThreadHeap();
+	if(!pHeap){
+		return _MCFCRT_NULLPTR;
+	}
+	if(!TlsSetValue(dwTlsIndex, pHeap)){
+		AbandonThreadHeap(pHeap);
+		return _MCFCRT_NULLPTR;
+	}
+	return pHeap;
+}
+static inline uintptr_t GetKindOfBlock(const void *pBlock){
+	const uintptr_t *const puKind = (const uintptr_t *)((uintptr_t)pBlock & ~(uintptr_t)(SEGMENT_SIZE - 1));
+	return *puKind;
+}
+static inline Span *GetSpanOfSmallBlock(const void *pBlock){
+	Segment *const pSegment = (Segment *)((uintptr_t)pBlock & ~(uintptr_t)(SEGMENT_SIZE - 1));
+	const unsigned uPageIndex = (unsigned)(((uintptr_t)pBlock - (uintptr_t)pSegment) / SPAN_PAGE_SIZE);
+	Span *const pSpan = pSegment->apSpanByPage[uPageIndex];
+	_MCFCRT_ASSERT(pSpan);
+	return pSpan;
+}
+static inline HugeHeader *GetHeaderOfHugeBlock(const void *pBlock){
+	HugeHeader *const pHeader = (HugeHeader *)((uintptr_t)pBlock & ~(uintptr_t)(SEGMENT_SIZE - 1));
+	_MCFCRT_ASSERT((unsigned char *)pHeader + pHeader->uBlockOffset == pBlock);
+	return pHeader;
+}
+
+static inline size_t GetUsableSizeOfBlock(const void *pBlock, uintptr_t uKind){
+	if(_MCFCRT_EXPECT(uKind == KIND_SMALL)){
+		const Span *const pSpan = GetSpanOfSmallBlock(pBlock);
+		return pSpan->uBlockSize;
+	} else {
+		const HugeHeader *const pHeader = GetHeaderOfHugeBlock(pBlock);
+		return pHeader->uCommitted - pHeader->uBlockOffset;
+	}
+}
+// These functions record `eOperation` if they succeed, so the shared heap is locked only once.
+static inline void *AllocSmallBlock(ThreadHeap *pHeap, unsigned uClass, Operation eOperation, size_t uSizeFreed, const void *pRetAddrOuter, const void *pRetAddrInner){
+	void *pBlock;
+	if(_MCFCRT_EXPECT(pHeap)){
+		pBlock = AllocSmall(pHeap, uClass);
+		if(pBlock){
+			RecordOperationUnsafe(pHeap, eOperation, GetSizeOfClass(uClass), uSizeFreed, pRetAddrOuter, pRetAddrInner);
+		}
+	} else {
+		_MCFCRT_WaitForMutexForever(&g_mtxShared, _MCFCRT_MUTEX_SUGGESTED_SPIN_COUNT);
+		pBlock = AllocSmall(&g_vSharedHeap, uClass);
+		if(pBlock){
+			RecordOperationUnsafe(&g_vSharedHeap, eOperation, GetSizeOfClass(uClass), uSizeFreed, pRetAddrOuter, pRetAddrInner);
+		}
+		_MCFCRT_SignalMutex(&g_mtxShared);
+	}
+	return pBlock;
+}
+static inline void *AllocHugeBlock(ThreadHeap *pHeap, size_t uSize, size_t uAlignment, Operation eOperation, size_t uSizeFreed, const void *pRetAddrOuter, const void *pRetAddrInner){
+	void *const pBlock = AllocHuge(uSize, uAlignment);
+	if(pBlock){
+		const HugeHeader *const pHeader = GetHeaderOfHugeBlock(pBlock);
+		RecordOperation(pHeap, eOperation, pHeader->uCommitted - pHeader->uBlockOffset, uSizeFreed, pRetAddrOuter, pRetAddrInner);
+	}
+	return pBlock;
+}
+static inline void *AllocAnyBlock(ThreadHeap *pHeap, size_t uSize, Operation eOperation, size_t uSizeFreed, const void *pRetAddrOuter, const void *pRetAddrInner){
+	if(_MCFCRT_EXPECT_NOT(uSize > SMALL_SIZE_MAX)){
+		return AllocHugeBlock(pHeap, uSize, 1, eOperation, uSizeFreed, pRetAddrOuter, pRetAddrInner);
+	}
+	return AllocSmallBlock(pHeap, GetClassFromSize(uSize), eOperation, uSizeFreed, pRetAddrOuter, pRetAddrInner);
+}
+static inline void FreeAnyBlock(ThreadHeap *pHeap, void *pBlock, uintptr_t uKind){
+	if(_MCFCRT_EXPECT(uKind == KIND_SMALL)){
+		Span *const pSpan = GetSpanOfSmallBlock(pBlock);
+		FreeSmall(pHeap, pSpan, pBlock);
+	} else {
+		HugeHeader *const pHeader = GetHeaderOfHugeBlock(pBlock);
+		ReleaseAddressSpace(pHeader->pReservationBase);
+	}
+}
+
+void *__MCFCRT_HeapImplAlloc(size_t uSize, bool bFillsWithZero, const void *pRetAddrOuter, const void *pRetAddrInner){
+	ThreadHeap *const pHeap = RequireThreadHeap();
+	void *const pBlock = AllocAnyBlock(pHeap, uSize, kOperationAlloc, 0, pRetAddrOuter, pRetAddrInner);
+	if(!pBlock){
+		return _MCFCRT_NULLPTR;
+	}
+	if(bFillsWithZero && (uSize <= SMALL_SIZE_MAX)){
+		// Pages of huge blocks are zeroed by the system.
+		memset(pBlock, 0, GetUsableSizeOfBlock(pBlock, KIND_SMALL));
+	}
+	return pBlock;
+}
+void *__MCFCRT_HeapImplAllocAligned(size_t uSize, size_t uAlignment, bool bFillsWithZero, const void *pRetAddrOuter, const void *pRetAddrInner){
+	_MCFCRT_ASSERT((uAlignment != 0) && ((uAlignment & (uAlignment - 1)) == 0));
+	if(_MCFCRT_EXPECT_NOT(uAlignment > HUGE_ALIGNMENT_MAX)){
+		return _MCFCRT_NULLPTR;
+	}
+	ThreadHeap *const pHeap = RequireThreadHeap();
+	const unsigned uClass = (uSize <= SMALL_SIZE_MAX) ? GetClassFromSizeAndAlignment(uSize, uAlignment) : CLASS_COUNT;
+	void *pBlock;
+	if(_MCFCRT_EXPECT(uClass < CLASS_COUNT)){
+		pBlock = AllocSmallBlock(pHeap, uClass, kOperationAlloc, 0, pRetAddrOuter, pRetAddrInner);
+	} else {
+		pBlock = AllocHugeBlock(pHeap, uSize, uAlignment, kOperationAlloc, 0, pRetAddrOuter, pRetAddrInner);
+	}
+	if(!pBlock){
+		return _MCFCRT_NULLPTR;
+	}
+	_MCFCRT_ASSERT(((uintptr_t)pBlock & (uAlignment - 1)) == 0);
+	if(bFillsWithZero && (uClass < CLASS_COUNT)){
+		// Pages of huge blocks are zeroed by the system.
+		memset(pBlock, 0, GetSizeOfClass(uClass));
+	}
+	return pBlock;
+}
+void *__MCFCRT_HeapImplRealloc(void *pBlock, size_t uSize, bool bFillsWithZero, const void *pRetAddrOuter, const void *pRetAddrInner){
+	const uintptr_t uKind = GetKindOfBlock(pBlock);
+	if((uKind != KIND_SMALL) && (uKind != KIND_HUGE)){
+		_MCFCRT_Bail(L"__MCFCRT_HeapImplRealloc() 检测到无效的内存块，这通常是释放了不是由堆分配的内存导致的。");
+	}
+	ThreadHeap *const pHeap = RequireThreadHeap();
+	const size_t uSizeOld = GetUsableSizeOfBlock(pBlock, uKind);
+	if(uKind == KIND_SMALL){
+		const Span *const pSpan = GetSpanOfSmallBlock(pBlock);
+		if((uSize <= SMALL_SIZE_MAX) && (GetClassFromSize(uSize) == pSpan->uClass)){
+			RecordOperation(pHeap, kOperationRealloc, uSizeOld, uSizeOld, pRetAddrOuter, pRetAddrInner);
+			return pBlock;
+		}
+	} else {
+		HugeHeader *const pHeader = GetHeaderOfHugeBlock(pBlock);
+		if((uSize > SMALL_SIZE_MAX) && ResizeHugeInPlace(pHeader, uSize)){
+			RecordOperation(pHeap, kOperationRealloc, pHeader->uCommitted - pHeader->uBlockOffset, uSizeOld, pRetAddrOuter, pRetAddrInner);
+			return pBlock;
+		}
+	}
+	void *const pBlockNew = AllocAnyBlock(pHeap, uSize, kOperationRealloc, uSizeOld, pRetAddrOuter, pRetAddrInner);
+	if(!pBlockNew){
+		return _MCFCRT_NULLPTR;
+	}
+	if(uSizeOld < uSize){
+		_MCFCRT_inline_mempcpy_fwd(pBlockNew, pBlock, uSizeOld);
+		if(bFillsWithZero){
+			memset((unsigned char *)pBlockNew + uSizeOld, 0, uSize - uSizeOld);
+		}
+	} else {
+		_MCFCRT_inline_mempcpy_fwd(pBlockNew, pBlock, uSize);
+	}
+	FreeAnyBlock(pHeap, pBlock, uKind);
+	return pBlockNew;
+}
+void __MCFCRT_HeapImplFree(void *pBlock){
+	const uintptr_t uKind = GetKindOfBlock(pBlock);
+	if(_MCFCRT_EXPECT_NOT((uKind != KIND_SMALL) && (uKind != KIND_HUGE))){
+		_MCFCRT_Bail(L"__MCFCRT_HeapImplFree() 检测到无效的内存块，这通常是释放了不是由堆分配的内存导致的。");
+	}
+	ThreadHeap *const pHeap = RequireThreadHeap();
+	const size_t uSizeOld = GetUsableSizeOfBlock(pBlock, uKind);
+	FreeAnyBlock(pHeap, pBlock, uKind);
+	RecordOperation(pHeap, kOperationFree, 0, uSizeOld, _MCFCRT_NULLPTR, _MCFCRT_NULLPTR);
+}
+void __MCFCRT_HeapImplFreeSized(void *pBlock, size_t uSize, size_t uAlignment){
+	// The size and alignment are only hints. They may be stale, for example after the block has been moved by a reallocation, so the kind of the block is always read from it.
+	const uintptr_t uKind = GetKindOfBlock(pBlock);
+	if(_MCFCRT_EXPECT_NOT((uKind != KIND_SMALL) && (uKind != KIND_HUGE))){
+		_MCFCRT_Bail(L"__MCFCRT_HeapImplFreeSized() 检测到无效的内存块，这通常是释放了不是由堆分配的内存导致的。");
+	}
+	(void)uSize;
+	(void)uAlignment;
+	ThreadHeap *const pHeap = RequireThreadHeap();
+	const size_t uSizeOld = GetUsableSizeOfBlock(pBlock, uKind);
+	FreeAnyBlock(pHeap, pBlock, uKind);
+	RecordOperation(pHeap, kOperationFree, 0, uSizeOld, _MCFCRT_NULLPTR, _MCFCRT_NULLPTR);
+}
+bool __MCFCRT_HeapImplResizeInPlace(void *pBlock, size_t uSize, const void *pRetAddrOuter, const void *pRetAddrInner){
+	const uintptr_t uKind = GetKindOfBlock(pBlock);
+	if(_MCFCRT_EXPECT(uKind == KIND_SMALL)){
+		const Span *const pSpan = GetSpanOfSmallBlock(pBlock);
+		return uSize <= pSpan->uBlockSize;
+	} else if(uKind == KIND_HUGE){
+		HugeHeader *const pHeader = GetHeaderOfHugeBlock(pBlock);
+		const size_t uSizeOld = pHeader->uCommitted - pHeader->uBlockOffset;
+		// Don't let a huge block shrink into the range of small ones. Blocks of such sizes are expected to be small, and a small block would serve them better anyway.
+		// This applies to over-aligned blocks, too, since small blocks may have alignments up to `SPAN_PAGE_SIZE`.
+		if(uSize <= SMALL_SIZE_MAX){
+			return false;
+		}
+		if(!ResizeHugeInPlace(pHeader, uSize)){
+			return false;
+		}
+		RecordOperation(RequireThreadHeap(), kOperationRealloc, pHeader->uCommitted - pHeader->uBlockOffset, uSizeOld, pRetAddrOuter, pRetAddrInner);
+		return true;
+	} else {
+		_MCFCRT_Bail(L"__MCFCRT_HeapImplResizeInPlace() 检测到无效的内存块，这通常是释放了不是由堆分配的内存导致的。");
+	}
+}
+size_t __MCFCRT_HeapImplGetUsableSize(const void *pBlock){
+	const uintptr_t uKind = GetKindOfBlock(pBlock);
+	if(_MCFCRT_EXPECT_NOT((uKind != KIND_SMALL) && (uKind != KIND_HUGE))){
+		_MCFCRT_Bail(L"__MCFCRT_HeapImplGetUsableSize() 检测到无效的内存块，这通常是释放了不是由堆分配的内存导致的。");
+	}
+	return GetUsableSizeOfBlock(pBlock, uKind);
+}
+
+void __MCFCRT_HeapImplGetStatistics(_MCFCRT_HeapStatistics *pStatistics){
+	HeapCounters vTotal = { 0 };
+	_MCFCRT_WaitForMutexForever(&g_mtxCentral, _MCFCRT_MUTEX_SUGGESTED_SPIN_COUNT);
+	{
+		AccumulateCounters(&vTotal, &g_vRetiredCounters);
+		for(const ThreadHeap *pHeap = g_pFirstLiveHeap; pHeap; pHeap = pHeap->pNextLive){
+			AccumulateCounters(&vTotal, &(pHeap->vCounters));
+		}
+	}
+	_MCFCRT_SignalMutex(&g_mtxCentral);
+	AccumulateCounters(&vTotal, &(g_vSharedHeap.vCounters));
+
+	pStatistics->__u64AllocCount     = vTotal.u64AllocCount;
+	pStatistics->__u64ReallocCount   = vTotal.u64ReallocCount;
+	pStatistics->__u64FreeCount      = vTotal.u64FreeCount;
+	pStatistics->__u64BytesAllocated = vTotal.u64BytesAllocated;
+	pStatistics->__u64BytesFreed     = vTotal.u64BytesFreed;
+	// Counters of different threads are not read atomically as a whole. Don't let the result underflow.
+	const uint64_t u64LiveBytes = (vTotal.u64BytesAllocated > vTotal.u64BytesFreed) ? (vTotal.u64BytesAllocated - vTotal.u64BytesFreed) : 0;
+	const intptr_t nPeakBytes = __atomic_load_n(&g_nPeakBytes, __ATOMIC_RELAXED);
+	pStatistics->__u64LiveBytes      = u64LiveBytes;
+	pStatistics->__u64PeakBytes      = ((uint64_t)nPeakBytes > u64LiveBytes) ? (uint64_t)nPeakBytes : u64LiveBytes;
+	for(unsigned uBucket = 0; uBucket < _MCFCRT_HEAP_HISTOGRAM_SIZE; ++uBucket){
+		pStatistics->__au64Histogram[uBucket] = vTotal.au64Histogram[uBucket];
+	}
+	_MCFCRT_WaitForMutexForever(&g_mtxProfile, _MCFCRT_MUTEX_SUGGESTED_SPIN_COUNT);
+	{
+		pStatistics->__u64SampleCount        = g_u64SampleCount;
+		pStatistics->__u64DroppedSampleCount = g_u64DroppedSampleCount;
+	}
+	_MCFCRT_SignalMutex(&g_mtxProfile);
+}
+size_t __MCFCRT_HeapImplGetProfile(_MCFCRT_HeapProfileEntry *pEntries, size_t uMaxCount){
+	size_t uCount = 0;
+	_MCFCRT_WaitForMutexForever(&g_mtxProfile, _MCFCRT_MUTEX_SUGGESTED_SPIN_COUNT);
+	{
+		for(size_t uIndex = 0; uIndex < __MCFCRT_HEAP_PROFILE_SITE_COUNT_MAX; ++uIndex){
+			const ProfileSite *const pSite = g_aProfileSites + uIndex;
+			if(pSite->u64SampleCount == 0){
+				continue;
+			}
+			if(uCount < uMaxCount){
+				_MCFCRT_HeapProfileEntry *const pEntry = pEntries + uCount;
+				pEntry->__pRetAddrOuter     = pSite->pRetAddrOuter;
+				pEntry->__pRetAddrInner     = pSite->pRetAddrInner;
+				pEntry->__u64SampleCount    = pSite->u64SampleCount;
+				pEntry->__u64EstimatedBytes = pSite->u64EstimatedBytes;
+			}
+			++uCount;
+		}
+	}
+	_MCFCRT_SignalMutex(&g_mtxProfile);
+	return uCount;
+}
+size_t __MCFCRT_HeapImplGetSamplingInterval(void){
+	return __atomic_load_n(&g_uSamplingInterval, __ATOMIC_RELAXED);
+}
+size_t __MCFCRT_HeapImplSetSamplingInterval(size_t uInterval){
+	return __atomic_exchange_n(&g_uSamplingInterval, uInterval, __ATOMIC_RELAXED);
+}
+
+void __MCFCRT_HeapImplThreadCleanup(void){
+	const DWORD dwTlsIndex = __atomic_load_n(&g_dwTlsIndex, __ATOMIC_ACQUIRE);
+	if(dwTlsIndex == TLS_OUT_OF_INDEXES){
+		// No memory has ever been allocated.
+		return;
+	}
+	ThreadHeap *const pHeap = LoadThreadHeap(dwTlsIndex);
+	if(pHeap == HEAP_DEAD){
+		return;
+	}
+	// Memory allocated after this point comes from the shared heap, so it will not be leaked.
+	TlsSetValue(dwTlsIndex, HEAP_DEAD);
+	if(pHeap){
+		AbandonThreadHeap(pHeap);
+	}
+}
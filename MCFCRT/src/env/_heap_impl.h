@@ -0,0 +1,55 @@
+// 这个文件是 MCF 的一部分。
+// 有关具体授权说明，请参阅 MCFLicense.txt。
+// Copyleft 2013 - 2018, LH_Mouse. All wrongs reserved.
+
+#ifndef __MCFCRT_ENV_HEAP_IMPL_H_
+#define __MCFCRT_ENV_HEAP_IMPL_H_
+
+#include "_crtdef.h"
+#include "heap.h"
+
+_MCFCRT_EXTERN_C_BEGIN
+
+// This is the allocator underlying `__MCFCRT_HeapAlloc()`, `__MCFCRT_HeapRealloc()` and `__MCFCRT_HeapFree()`.
+// Small blocks are carved from spans of segregated size classes, which are in turn carved from large reserved segments.
+// Every thread owns the spans it allocates from and needs no locks to allocate or free blocks in them.
+// Blocks that are freed by a thread other than the owner are pushed onto a lock-free remote-free list of the span.
+// Huge blocks are mapped directly from the system.
+// Every thread keeps its own statistics counters, which are merged on demand. Allocations are sampled once every N bytes and aggregated by call site.
+
+// These functions behave like `malloc()`, `realloc()` and `free()`, except that `__pBlock` shall not be a null pointer.
+// The usable size of a block is no less than the size requested and can be obtained using `__MCFCRT_HeapImplGetUsableSize()`.
+__attribute__((__malloc__))
+extern void *__MCFCRT_HeapImplAlloc(_MCFCRT_STD size_t __uSize, bool __bFillsWithZero, const void *__pRetAddrOuter, const void *__pRetAddrInner) _MCFCRT_NOEXCEPT;
+__attribute__((__nonnull__(1)))
+extern void *__MCFCRT_HeapImplRealloc(void *__pBlock, _MCFCRT_STD size_t __uSize, bool __bFillsWithZero, const void *__pRetAddrOuter, const void *__pRetAddrInner) _MCFCRT_NOEXCEPT;
+__attribute__((__nonnull__(1)))
+extern void __MCFCRT_HeapImplFree(void *__pBlock) _MCFCRT_NOEXCEPT;
+// `__uAlignment` shall be a power of two. Alignments up to 64KiB are satisfied by small blocks of suitable size classes.
+// Larger ones, up to 2MiB, are satisfied by huge blocks. A null pointer is returned if the alignment is even larger.
+__attribute__((__malloc__))
+extern void *__MCFCRT_HeapImplAllocAligned(_MCFCRT_STD size_t __uSize, _MCFCRT_STD size_t __uAlignment, bool __bFillsWithZero, const void *__pRetAddrOuter, const void *__pRetAddrInner) _MCFCRT_NOEXCEPT;
+// `__uSize` and `__uAlignment` shall be those passed to the allocation function, or `__uAlignment` shall be one if the block was not allocated by `__MCFCRT_HeapImplAllocAligned()`.
+// This function does not examine the segment header to tell small blocks from huge ones.
+__attribute__((__nonnull__(1)))
+extern void __MCFCRT_HeapImplFreeSized(void *__pBlock, _MCFCRT_STD size_t __uSize, _MCFCRT_STD size_t __uAlignment) _MCFCRT_NOEXCEPT;
+// This function attempts to resize a block without moving it. If it returns `false`, the block is left intact.
+// Huge blocks reserve address space after them, which is committed when they grow.
+__attribute__((__nonnull__(1)))
+extern bool __MCFCRT_HeapImplResizeInPlace(void *__pBlock, _MCFCRT_STD size_t __uSize, const void *__pRetAddrOuter, const void *__pRetAddrInner) _MCFCRT_NOEXCEPT;
+__attribute__((__nonnull__(1)))
+extern _MCFCRT_STD size_t __MCFCRT_HeapImplGetUsableSize(const void *__pBlock) _MCFCRT_NOEXCEPT;
+
+// Sizes in statistics are usable sizes, which include the overhead of `__MCFCRT_HEAP_DEBUG` if it is enabled.
+extern void __MCFCRT_HeapImplGetStatistics(_MCFCRT_HeapStatistics *__pStatistics) _MCFCRT_NOEXCEPT;
+extern _MCFCRT_STD size_t __MCFCRT_HeapImplGetProfile(_MCFCRT_HeapProfileEntry *__pEntries, _MCFCRT_STD size_t __uMaxCount) _MCFCRT_NOEXCEPT;
+extern _MCFCRT_STD size_t __MCFCRT_HeapImplGetSamplingInterval(void) _MCFCRT_NOEXCEPT;
+extern _MCFCRT_STD size_t __MCFCRT_HeapImplSetSamplingInterval(_MCFCRT_STD size_t __uInterval) _MCFCRT_NOEXCEPT;
+
+// This function is called when a thread exits. Spans owned by the calling thread are released or abandoned, so they can be adopted by other threads.
+// Blocks allocated by the calling thread remain valid. If the calling thread allocates memory again, it falls back to a shared, locked heap.
+extern void __MCFCRT_HeapImplThreadCleanup(void) _MCFCRT_NOEXCEPT;
+
+_MCFCRT_EXTERN_C_END
+
+#endif
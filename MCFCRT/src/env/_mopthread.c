@@ -3,7 +3,10 @@
 // Copyleft 2013 - 2018, LH_Mouse. All wrongs reserved.
 
 #include "_mopthread.h"
+#include "rwlock.h"
 #include "mutex.h"
+#include "wait_on_address.h"
+#include "cpu.h"
 #include "avl_tree.h"
 #include "mcfwin.h"
 #include "heap.h"
@@ -24,20 +27,39 @@ extern NTSTATUS NtDuplicateObject(HANDLE hSourceProcess, HANDLE hSource, HANDLE
 
 static const _MCFCRT_ThreadHandle g_hPseudoSelfHandle = (_MCFCRT_ThreadHandle)GetCurrentThread();
 
-static _MCFCRT_Mutex   g_mtxControl    = { 0 };
-static _MCFCRT_AvlRoot g_avlControlMap = _MCFCRT_NULLPTR;
+// Control blocks are kept in shards chosen by thread IDs, so threads that create, join or detach different threads rarely contend.
+// Handle lookups lock their shards as readers, so they never wait for each other. Everything else locks its shard as a writer.
+#define SHARD_COUNT             64u
+
+typedef struct tagShard {
+	alignas(_MCFCRT_CACHE_LINE_SIZE) _MCFCRT_RwLock vLock;
+	_MCFCRT_AvlRoot avlControlMap;
+} Shard;
+
+static Shard g_aShards[SHARD_COUNT];
+
+static inline Shard *GetShard(uintptr_t uTid){
+	// Thread IDs are multiples of four on Windows.
+	return g_aShards + (uTid >> 2) % SHARD_COUNT;
+}
+static inline void LockShard(Shard *pShard){
+	_MCFCRT_WaitForRwLockAsWriterForever(&(pShard->vLock), _MCFCRT_RWLOCK_SUGGESTED_SPIN_COUNT);
+}
+static inline void UnlockShard(Shard *pShard){
+	_MCFCRT_SignalRwLockAsWriter(&(pShard->vLock));
+}
 
 static intptr_t TerminationUnlockCallback(intptr_t nContext){
-	_MCFCRT_Mutex *const pMutex = (void *)nContext;
+	Shard *const pShard = (void *)nContext;
 
-	_MCFCRT_SignalMutex(pMutex);
+	UnlockShard(pShard);
 	return 1;
 }
 static void TerminationRelockCallback(intptr_t nContext, intptr_t nUnlocked){
-	_MCFCRT_Mutex *const pMutex = (void *)nContext;
+	Shard *const pShard = (void *)nContext;
 
 	_MCFCRT_ASSERT((size_t)nUnlocked == 1);
-	_MCFCRT_WaitForMutexForever(pMutex, _MCFCRT_MUTEX_SUGGESTED_SPIN_COUNT);
+	LockShard(pShard);
 }
 
 typedef enum tagMopthreadState {
@@ -48,15 +70,30 @@ typedef enum tagMopthreadState {
 	kStateDetached,
 } MopthreadState;
 
+// A worker is a native thread that is waiting in the cache. It lives on the stack of that thread.
+typedef struct tagMopthreadWorker {
+	struct tagMopthreadWorker *pNext;
+
+	uintptr_t uTid;
+	_MCFCRT_ThreadHandle hThread;
+
+	// This is null when the worker is waiting, `WORKER_EXIT` if it shall exit, and the control block of the next thread procedure otherwise.
+	struct tagMopthreadControl *volatile pNextControl;
+} MopthreadWorker;
+
+#define WORKER_EXIT             ((MopthreadControl *)-1)
+
 typedef struct tagMopthreadControl {
 	_MCFCRT_AvlNodeHeader avlhTidIndex;
 
 	MopthreadState eState;
-	size_t uRefCount;
+	volatile size_t uRefCount;
 	_MCFCRT_ConditionVariable condTermination;
 
 	uintptr_t uTid;
 	_MCFCRT_ThreadHandle hThread;
+	// If the thread has returned to the cache, this points to its worker, which takes over `hThread` when the control block is released.
+	MopthreadWorker *pWorker;
 
 	void (*pfnProc)(void *);
 	size_t uSizeOfParams;
@@ -76,15 +113,174 @@ static inline int MopthreadControlComparatorNodes(const _MCFCRT_AvlNodeHeader *p
 }
 
 static unsigned char g_abyInitialControlStorage[sizeof(MopthreadControl) + sizeof(void *) * 3]; // XXX: This should suffice for both gthread and c11thread.
-static_assert(sizeof(g_abyInitialControlStorage) == sizeof(void *) * 17, "??");
+static_assert(sizeof(g_abyInitialControlStorage) == sizeof(void *) * 18, "??");
+
+static _MCFCRT_Mutex    g_mtxWorkerCache      = { 0 };
+static volatile size_t  g_uWorkerCacheCapacity = 0;
+static MopthreadWorker *g_pIdleWorkers         = _MCFCRT_NULLPTR;
+static volatile size_t  g_uIdleWorkerCount     = 0;
+// Threads that have returned but have not been joined or detached yet are parked. They hold slots in the cache too, so threads that are never joined can't pile up.
+static size_t           g_uParkedWorkerCount   = 0;
+
+static void WakeWorker(MopthreadWorker *pWorker, MopthreadControl *pNextControl){
+	__atomic_store_n(&(pWorker->pNextControl), pNextControl, __ATOMIC_RELEASE);
+	_MCFCRT_WakeByAddressSingle(&(pWorker->pNextControl));
+}
+static MopthreadWorker *PopIdleWorker(void){
+	if(_MCFCRT_EXPECT(__atomic_load_n(&g_uIdleWorkerCount, __ATOMIC_RELAXED) == 0)){
+		return _MCFCRT_NULLPTR;
+	}
+	MopthreadWorker *pWorker;
+	_MCFCRT_WaitForMutexForever(&g_mtxWorkerCache, _MCFCRT_MUTEX_SUGGESTED_SPIN_COUNT);
+	{
+		pWorker = g_pIdleWorkers;
+		if(pWorker){
+			g_pIdleWorkers = pWorker->pNext;
+			__atomic_store_n(&g_uIdleWorkerCount, g_uIdleWorkerCount - 1, __ATOMIC_RELAXED);
+		}
+	}
+	_MCFCRT_SignalMutex(&g_mtxWorkerCache);
+	return pWorker;
+}
+static bool ParkWorker(void){
+	if(_MCFCRT_EXPECT(__atomic_load_n(&g_uWorkerCacheCapacity, __ATOMIC_RELAXED) == 0)){
+		return false;
+	}
+	bool bParked;
+	_MCFCRT_WaitForMutexForever(&g_mtxWorkerCache, _MCFCRT_MUTEX_SUGGESTED_SPIN_COUNT);
+	{
+		bParked = g_uIdleWorkerCount + g_uParkedWorkerCount < __atomic_load_n(&g_uWorkerCacheCapacity, __ATOMIC_RELAXED);
+		if(bParked){
+			++g_uParkedWorkerCount;
+		}
+	}
+	_MCFCRT_SignalMutex(&g_mtxWorkerCache);
+	return bParked;
+}
+// The worker must have been parked.
+static void PushIdleWorker(MopthreadWorker *pWorker){
+	bool bCached;
+	_MCFCRT_WaitForMutexForever(&g_mtxWorkerCache, _MCFCRT_MUTEX_SUGGESTED_SPIN_COUNT);
+	{
+		_MCFCRT_ASSERT(g_uParkedWorkerCount > 0);
+		--g_uParkedWorkerCount;
+		// The capacity may have been reduced in the meantime.
+		bCached = g_uIdleWorkerCount + g_uParkedWorkerCount < __atomic_load_n(&g_uWorkerCacheCapacity, __ATOMIC_RELAXED);
+		if(bCached){
+			pWorker->pNext = g_pIdleWorkers;
+			g_pIdleWorkers = pWorker;
+			__atomic_store_n(&g_uIdleWorkerCount, g_uIdleWorkerCount + 1, __ATOMIC_RELAXED);
+		}
+	}
+	_MCFCRT_SignalMutex(&g_mtxWorkerCache);
+	if(!bCached){
+		WakeWorker(pWorker, WORKER_EXIT);
+	}
+}
+
+typedef struct tagCleanupCallbackNode {
+	struct tagCleanupCallbackNode *pNext;
+	__MCFCRT_MopthreadCleanupCallback pfnCallback;
+} CleanupCallbackNode;
+
+// Callbacks are invoked with no lock held, because they run destructors which may load or unload modules, which register or unregister callbacks.
+// Every thread that is running callbacks keeps a cursor on its stack, which is adjusted when the node it is about to visit is unregistered.
+typedef struct tagCleanupCallbackCursor {
+	struct tagCleanupCallbackCursor *pNext;
+
+	uintptr_t uTid;
+	// This is the node whose callback is being invoked, or null.
+	const CleanupCallbackNode *pCurrentNode;
+	// This is the node to visit next, or null.
+	const CleanupCallbackNode *pNextNode;
+} CleanupCallbackCursor;
+
+static _MCFCRT_Mutex               g_mtxCleanupCallbacks     = { 0 };
+static _MCFCRT_ConditionVariable   g_condCleanupCallbacks    = { 0 };
+static CleanupCallbackNode        *g_pCleanupCallbacks       = _MCFCRT_NULLPTR;
+static CleanupCallbackCursor      *g_pCleanupCallbackCursors = _MCFCRT_NULLPTR;
+
+static inline void LockCleanupCallbacks(void){
+	_MCFCRT_WaitForMutexForever(&g_mtxCleanupCallbacks, _MCFCRT_MUTEX_SUGGESTED_SPIN_COUNT);
+}
+static inline void UnlockCleanupCallbacks(void){
+	_MCFCRT_SignalMutex(&g_mtxCleanupCallbacks);
+}
+
+static intptr_t CleanupCallbacksUnlockCallback(intptr_t nContext){
+	(void)nContext;
+
+	UnlockCleanupCallbacks();
+	return 1;
+}
+static void CleanupCallbacksRelockCallback(intptr_t nContext, intptr_t nUnlocked){
+	(void)nContext;
+
+	_MCFCRT_ASSERT((size_t)nUnlocked == 1);
+	LockCleanupCallbacks();
+}
 
-// The caller must have the global mutex locked!
+static void RunCleanupCallbacks(void){
+	CleanupCallbackCursor vCursor;
+	vCursor.uTid         = _MCFCRT_GetCurrentThreadId();
+	vCursor.pCurrentNode = _MCFCRT_NULLPTR;
+	LockCleanupCallbacks();
+	{
+		vCursor.pNextNode = g_pCleanupCallbacks;
+		vCursor.pNext = g_pCleanupCallbackCursors;
+		g_pCleanupCallbackCursors = &vCursor;
+
+		for(;;){
+			const CleanupCallbackNode *const pNode = vCursor.pNextNode;
+			if(!pNode){
+				break;
+			}
+			vCursor.pCurrentNode = pNode;
+			vCursor.pNextNode = pNode->pNext;
+			const __MCFCRT_MopthreadCleanupCallback pfnCallback = pNode->pfnCallback;
+			UnlockCleanupCallbacks();
+			(*pfnCallback)();
+			LockCleanupCallbacks();
+			// `pNode` may have been freed. Wake up anyone who is unregistering it.
+			vCursor.pCurrentNode = _MCFCRT_NULLPTR;
+			_MCFCRT_BroadcastConditionVariable(&g_condCleanupCallbacks);
+		}
+
+		CleanupCallbackCursor **ppCursor = &g_pCleanupCallbackCursors;
+		while(*ppCursor != &vCursor){
+			ppCursor = &((*ppCursor)->pNext);
+		}
+		*ppCursor = vCursor.pNext;
+	}
+	UnlockCleanupCallbacks();
+}
+
+// The reference count is incremented with the shard locked as a reader, and decremented without locking unless it would drop to zero.
+// Hence a control block is only detached with its shard locked as a writer, after which nobody else may see it.
+static bool TryDropControlRefLockFree(MopthreadControl *restrict pControl){
+	size_t uOld = __atomic_load_n(&(pControl->uRefCount), __ATOMIC_RELAXED);
+	do {
+		_MCFCRT_ASSERT(uOld > 0);
+		if(uOld == 1){
+			return false;
+		}
+	} while(_MCFCRT_EXPECT_NOT(!__atomic_compare_exchange_n(&(pControl->uRefCount), &uOld, uOld - 1, false, __ATOMIC_RELEASE, __ATOMIC_RELAXED)));
+	return true;
+}
+// The caller must have the shard of the control block locked as a writer!
 static void DropControlRefUnsafe(MopthreadControl *restrict pControl){
-	_MCFCRT_ASSERT(pControl->uRefCount > 0);
-	if(--(pControl->uRefCount) == 0){
+	const size_t uNew = __atomic_sub_fetch(&(pControl->uRefCount), 1, __ATOMIC_ACQ_REL);
+	_MCFCRT_ASSERT(uNew != (size_t)-1);
+	if(uNew == 0){
 		_MCFCRT_ASSERT(pControl->eState == kStateJoined);
 		_MCFCRT_AvlDetach((_MCFCRT_AvlNodeHeader *)pControl);
-		_MCFCRT_CloseThread(pControl->hThread);
+		MopthreadWorker *const pWorker = pControl->pWorker;
+		if(pWorker){
+			// The thread ID can be reused from now on.
+			PushIdleWorker(pWorker);
+		} else {
+			_MCFCRT_CloseThread(pControl->hThread);
+		}
 #ifndef NDEBUG
 		pControl->hThread = (HANDLE)0xDEADBEEF;
 #endif
@@ -104,6 +300,7 @@ static void AttachInitialThread(void){
 	pControl->eState        = kStateJoinable;
 	pControl->uRefCount     = 2;
 	_MCFCRT_InitializeConditionVariable(&(pControl->condTermination));
+	pControl->pWorker       = _MCFCRT_NULLPTR;
 
 	HANDLE hThread;
 	NTSTATUS lStatus = NtDuplicateObject(GetCurrentProcess(), GetCurrentThread(), GetCurrentProcess(), &hThread, 0, 0, DUPLICATE_SAME_ACCESS);
@@ -113,7 +310,7 @@ static void AttachInitialThread(void){
 	pControl->uTid    = (uintptr_t)GetCurrentThreadId();
 	pControl->hThread = (HANDLE)hThread;
 
-	_MCFCRT_AvlAttach(&g_avlControlMap, (_MCFCRT_AvlNodeHeader *)pControl, &MopthreadControlComparatorNodes);
+	_MCFCRT_AvlAttach(&(GetShard(pControl->uTid)->avlControlMap), (_MCFCRT_AvlNodeHeader *)pControl, &MopthreadControlComparatorNodes);
 }
 static void DetachInitialThread(void){
 	MopthreadControl *const restrict pControl = (void *)g_abyInitialControlStorage;
@@ -138,8 +335,8 @@ static void DetachInitialThread(void){
 	}
 }
 
-__attribute__((__noreturn__))
-static inline void SignalMutexAndExitThread(_MCFCRT_Mutex *restrict pMutex, MopthreadControl *restrict pControl, void (*pfnModifier)(void *, size_t, intptr_t), intptr_t nContext){
+// The caller must have the shard of the control block locked as a writer!
+static void TerminateControlUnsafe(MopthreadControl *restrict pControl, void (*pfnModifier)(void *, size_t, intptr_t), intptr_t nContext){
 	switch(pControl->eState){
 	case kStateJoinable:
 		if(pfnModifier){
@@ -165,7 +362,11 @@ static inline void SignalMutexAndExitThread(_MCFCRT_Mutex *restrict pMutex, Mopt
 		_MCFCRT_ASSERT(false);
 	}
 	DropControlRefUnsafe(pControl);
-	_MCFCRT_SignalMutex(pMutex);
+}
+__attribute__((__noreturn__))
+static inline void UnlockShardAndExitThread(Shard *restrict pShard, MopthreadControl *restrict pControl, void (*pfnModifier)(void *, size_t, intptr_t), intptr_t nContext){
+	TerminateControlUnsafe(pControl, pfnModifier, nContext);
+	UnlockShard(pShard);
 
 	ExitThread(0);
 	__builtin_unreachable();
@@ -187,11 +388,45 @@ static unsigned long MopthreadProc(void *pParam){
 }
 __attribute__((__noreturn__, __stdcall__))
 static unsigned long NativeMopthreadProc(void *pParam){
-	MopthreadControl *const restrict pControl = pParam;
-	_MCFCRT_DEBUG_CHECK(pControl);
-	_MCFCRT_WrapThreadProcWithSehTop(&MopthreadProc, pControl);
-	_MCFCRT_WaitForMutexForever(&g_mtxControl, _MCFCRT_MUTEX_SUGGESTED_SPIN_COUNT);
-	SignalMutexAndExitThread(&g_mtxControl, pControl, _MCFCRT_NULLPTR, 0);
+	MopthreadControl *restrict pControl = pParam;
+	MopthreadWorker vWorker;
+	for(;;){
+		_MCFCRT_DEBUG_CHECK(pControl);
+		_MCFCRT_WrapThreadProcWithSehTop(&MopthreadProc, pControl);
+		// If the cache is full, exit as usual, which notifies every DLL.
+		const bool bCacheable = ParkWorker();
+		if(bCacheable){
+			// Do what `DLL_THREAD_DETACH` would do before anyone is able to join this thread.
+			RunCleanupCallbacks();
+		}
+		Shard *const pShard = GetShard(pControl->uTid);
+		LockShard(pShard);
+		if(!bCacheable){
+			UnlockShardAndExitThread(pShard, pControl, _MCFCRT_NULLPTR, 0);
+		}
+		vWorker.uTid         = pControl->uTid;
+		vWorker.hThread      = pControl->hThread;
+		vWorker.pNextControl = _MCFCRT_NULLPTR;
+		pControl->pWorker = &vWorker;
+		TerminateControlUnsafe(pControl, _MCFCRT_NULLPTR, 0);
+		UnlockShard(pShard);
+
+		// Wait until the control block is released and someone gives us something to do.
+		for(;;){
+			pControl = __atomic_load_n(&(vWorker.pNextControl), __ATOMIC_ACQUIRE);
+			if(pControl){
+				break;
+			}
+			const MopthreadControl *const pExpected = _MCFCRT_NULLPTR;
+			_MCFCRT_WaitOnAddressForever(&(vWorker.pNextControl), &pExpected, sizeof(pExpected));
+		}
+		if(pControl == WORKER_EXIT){
+			_MCFCRT_CloseThread(vWorker.hThread);
+			ExitThread(0);
+			__builtin_unreachable();
+		}
+		__MCFCRT_CpuResetFloatingPointEnvironment();
+	}
 }
 
 static inline uintptr_t ReallyCreateMopthread(void (*pfnProc)(void *), const void *pParams, size_t uSizeOfParams, bool bJoinable){
@@ -218,6 +453,24 @@ static inline uintptr_t ReallyCreateMopthread(void (*pfnProc)(void *), const voi
 		pControl->uRefCount = 1;
 	}
 	_MCFCRT_InitializeConditionVariable(&(pControl->condTermination));
+	pControl->pWorker = _MCFCRT_NULLPTR;
+
+	MopthreadWorker *const pWorker = PopIdleWorker();
+	if(pWorker){
+		// The previous control block of this thread has been released, so its ID can't be found in the registry.
+		pControl->uTid    = pWorker->uTid;
+		pControl->hThread = pWorker->hThread;
+		Shard *const pShard = GetShard(pWorker->uTid);
+		LockShard(pShard);
+		{
+			_MCFCRT_AvlAttach(&(pShard->avlControlMap), (_MCFCRT_AvlNodeHeader *)pControl, &MopthreadControlComparatorNodes);
+		}
+		UnlockShard(pShard);
+
+		const uintptr_t uTid = pWorker->uTid;
+		WakeWorker(pWorker, pControl);
+		return uTid;
+	}
 
 	uintptr_t uTid;
 	const _MCFCRT_ThreadHandle hThread = _MCFCRT_CreateNativeThread(&NativeMopthreadProc, pControl, true, &uTid);
@@ -229,11 +482,12 @@ static inline uintptr_t ReallyCreateMopthread(void (*pfnProc)(void *), const voi
 	pControl->hThread = hThread;
 	// XXX: Note that at the moment you must attach the control block unconditionally, because the thread could call
 	//      `__MCFCRT_MopthreadExit()` which must be able to get a valid pointer to it by thread ID.
-	_MCFCRT_WaitForMutexForever(&g_mtxControl, _MCFCRT_MUTEX_SUGGESTED_SPIN_COUNT);
+	Shard *const pShard = GetShard(uTid);
+	LockShard(pShard);
 	{
-		_MCFCRT_AvlAttach(&g_avlControlMap, (_MCFCRT_AvlNodeHeader *)pControl, &MopthreadControlComparatorNodes);
+		_MCFCRT_AvlAttach(&(pShard->avlControlMap), (_MCFCRT_AvlNodeHeader *)pControl, &MopthreadControlComparatorNodes);
 	}
-	_MCFCRT_SignalMutex(&g_mtxControl);
+	UnlockShard(pShard);
 
 	_MCFCRT_ResumeThread(hThread);
 	return uTid;
@@ -249,25 +503,27 @@ __attribute__((__noreturn__))
 void __MCFCRT_MopthreadExit(void (*pfnModifier)(void *, size_t, intptr_t), intptr_t nContext){
 	const uintptr_t uTid = _MCFCRT_GetCurrentThreadId();
 
-	_MCFCRT_WaitForMutexForever(&g_mtxControl, _MCFCRT_MUTEX_SUGGESTED_SPIN_COUNT);
-	MopthreadControl *const restrict pControl = (MopthreadControl *)_MCFCRT_AvlFind(&g_avlControlMap, (intptr_t)uTid, &MopthreadControlComparatorNodeOther);
+	Shard *const pShard = GetShard(uTid);
+	LockShard(pShard);
+	MopthreadControl *const restrict pControl = (MopthreadControl *)_MCFCRT_AvlFind(&(pShard->avlControlMap), (intptr_t)uTid, &MopthreadControlComparatorNodeOther);
 	if(!pControl){
 		_MCFCRT_Bail(L"Calling thread of __MCFCRT_MopthreadExit() was not created using __MCFCRT_MopthreadCreate().");
 	}
-	SignalMutexAndExitThread(&g_mtxControl, pControl, pfnModifier, nContext);
+	UnlockShardAndExitThread(pShard, pControl, pfnModifier, nContext);
 }
 bool __MCFCRT_MopthreadJoin(uintptr_t uTid, void *restrict pParams, size_t *restrict puSizeOfParams){
-	bool bSuccess = false;
+	MopthreadControl *pJoined = _MCFCRT_NULLPTR;
 
-	_MCFCRT_WaitForMutexForever(&g_mtxControl, _MCFCRT_MUTEX_SUGGESTED_SPIN_COUNT);
+	Shard *const pShard = GetShard(uTid);
+	LockShard(pShard);
 	{
-		MopthreadControl *const restrict pControl = (MopthreadControl *)_MCFCRT_AvlFind(&g_avlControlMap, (intptr_t)uTid, &MopthreadControlComparatorNodeOther);
+		MopthreadControl *const restrict pControl = (MopthreadControl *)_MCFCRT_AvlFind(&(pShard->avlControlMap), (intptr_t)uTid, &MopthreadControlComparatorNodeOther);
 		if(pControl){
 			switch(pControl->eState){
 			case kStateJoinable:
 				pControl->eState = kStateJoining;
 				do {
-					_MCFCRT_WaitForConditionVariableForever(&(pControl->condTermination), &TerminationUnlockCallback, &TerminationRelockCallback, (intptr_t)&g_mtxControl, 0);
+					_MCFCRT_WaitForConditionVariableForever(&(pControl->condTermination), &TerminationUnlockCallback, &TerminationRelockCallback, (intptr_t)pShard, 0);
 				} while(pControl->eState != kStateJoined);
 				goto jJoinSuccess;
 			case kStateZombie:
@@ -280,28 +536,40 @@ bool __MCFCRT_MopthreadJoin(uintptr_t uTid, void *restrict pParams, size_t *rest
 			default:
 				_MCFCRT_ASSERT(false);
 			jJoinSuccess:
-				_MCFCRT_WaitForThreadForever(pControl->hThread);
-				if(pParams){
-					const size_t uSizeCopied = (pControl->uSizeOfParams < *puSizeOfParams) ? pControl->uSizeOfParams : *puSizeOfParams;
-					_MCFCRT_inline_mempcpy_fwd(pParams, pControl->abyParams, uSizeCopied);
-					*puSizeOfParams = uSizeCopied;
-				}
-				DropControlRefUnsafe(pControl);
-				bSuccess = true;
+				pJoined = pControl;
 				break;
 			}
 		}
 	}
-	_MCFCRT_SignalMutex(&g_mtxControl);
+	UnlockShard(pShard);
 
-	return bSuccess;
+	if(!pJoined){
+		return false;
+	}
+	// The thread no longer touches its control block, which is kept alive by our reference. Don't block the shard while it is exiting.
+	// If it has returned to the cache it will not exit, but its cleanup has been done already.
+	if(!pJoined->pWorker){
+		_MCFCRT_WaitForThreadForever(pJoined->hThread);
+	}
+	if(pParams){
+		const size_t uSizeCopied = (pJoined->uSizeOfParams < *puSizeOfParams) ? pJoined->uSizeOfParams : *puSizeOfParams;
+		_MCFCRT_inline_mempcpy_fwd(pParams, pJoined->abyParams, uSizeCopied);
+		*puSizeOfParams = uSizeCopied;
+	}
+	if(!TryDropControlRefLockFree(pJoined)){
+		LockShard(pShard);
+		DropControlRefUnsafe(pJoined);
+		UnlockShard(pShard);
+	}
+	return true;
 }
 bool __MCFCRT_MopthreadDetach(uintptr_t uTid){
 	bool bSuccess = false;
 
-	_MCFCRT_WaitForMutexForever(&g_mtxControl, _MCFCRT_MUTEX_SUGGESTED_SPIN_COUNT);
+	Shard *const pShard = GetShard(uTid);
+	LockShard(pShard);
 	{
-		MopthreadControl *const restrict pControl = (MopthreadControl *)_MCFCRT_AvlFind(&g_avlControlMap, (intptr_t)uTid, &MopthreadControlComparatorNodeOther);
+		MopthreadControl *const restrict pControl = (MopthreadControl *)_MCFCRT_AvlFind(&(pShard->avlControlMap), (intptr_t)uTid, &MopthreadControlComparatorNodeOther);
 		if(pControl){
 			switch(pControl->eState){
 			case kStateJoinable:
@@ -323,7 +591,7 @@ bool __MCFCRT_MopthreadDetach(uintptr_t uTid){
 			}
 		}
 	}
-	_MCFCRT_SignalMutex(&g_mtxControl);
+	UnlockShard(pShard);
 
 	return bSuccess;
 }
@@ -341,16 +609,17 @@ const _MCFCRT_ThreadHandle *__MCFCRT_MopthreadLockHandle(uintptr_t uTid){
 	// Increment the reference count and return a real handle.
 	const _MCFCRT_ThreadHandle *phThread = _MCFCRT_NULLPTR;
 
-	_MCFCRT_WaitForMutexForever(&g_mtxControl, _MCFCRT_MUTEX_SUGGESTED_SPIN_COUNT);
+	Shard *const pShard = GetShard(uTid);
+	_MCFCRT_WaitForRwLockAsReaderForever(&(pShard->vLock), _MCFCRT_RWLOCK_SUGGESTED_SPIN_COUNT);
 	{
-		MopthreadControl *const restrict pControl = (MopthreadControl *)_MCFCRT_AvlFind(&g_avlControlMap, (intptr_t)uTid, &MopthreadControlComparatorNodeOther);
+		MopthreadControl *const restrict pControl = (MopthreadControl *)_MCFCRT_AvlFind(&(pShard->avlControlMap), (intptr_t)uTid, &MopthreadControlComparatorNodeOther);
 		if(pControl){
 			switch(pControl->eState){
 			case kStateJoinable:
 			case kStateZombie:
 			case kStateJoining:
-				_MCFCRT_ASSERT(pControl->uRefCount > 0);
-				++(pControl->uRefCount);
+				// The reference count can't drop to zero while we are holding the shard.
+				__atomic_add_fetch(&(pControl->uRefCount), 1, __ATOMIC_RELAXED);
 				phThread = &(pControl->hThread);
 				break;
 			case kStateJoined:
@@ -361,7 +630,7 @@ const _MCFCRT_ThreadHandle *__MCFCRT_MopthreadLockHandle(uintptr_t uTid){
 			}
 		}
 	}
-	_MCFCRT_SignalMutex(&g_mtxControl);
+	_MCFCRT_SignalRwLockAsReader(&(pShard->vLock));
 
 	return phThread;
 }
@@ -375,11 +644,96 @@ void __MCFCRT_MopthreadUnlockHandle(const _MCFCRT_ThreadHandle *phThread){
 		return;
 	}
 
-	_MCFCRT_WaitForMutexForever(&g_mtxControl, _MCFCRT_MUTEX_SUGGESTED_SPIN_COUNT);
+	MopthreadControl *const restrict pControl = (void *)((char *)phThread - __builtin_offsetof(MopthreadControl, hThread));
+	_MCFCRT_ASSERT(pControl);
+	if(_MCFCRT_EXPECT(TryDropControlRefLockFree(pControl))){
+		return;
+	}
+	Shard *const pShard = GetShard(pControl->uTid);
+	LockShard(pShard);
 	{
-		MopthreadControl *const restrict pControl = (void *)((char *)phThread - __builtin_offsetof(MopthreadControl, hThread));
-		_MCFCRT_ASSERT(pControl);
 		DropControlRefUnsafe(pControl);
 	}
-	_MCFCRT_SignalMutex(&g_mtxControl);
+	UnlockShard(pShard);
+}
+
+size_t __MCFCRT_MopthreadSetCacheCapacity(size_t uCapacity){
+	MopthreadWorker *pWorkersToExit = _MCFCRT_NULLPTR;
+	size_t uOldCapacity;
+	_MCFCRT_WaitForMutexForever(&g_mtxWorkerCache, _MCFCRT_MUTEX_SUGGESTED_SPIN_COUNT);
+	{
+		uOldCapacity = __atomic_exchange_n(&g_uWorkerCacheCapacity, uCapacity, __ATOMIC_RELAXED);
+		while((g_uIdleWorkerCount != 0) && (g_uIdleWorkerCount + g_uParkedWorkerCount > uCapacity)){
+			MopthreadWorker *const pWorker = g_pIdleWorkers;
+			g_pIdleWorkers = pWorker->pNext;
+			__atomic_store_n(&g_uIdleWorkerCount, g_uIdleWorkerCount - 1, __ATOMIC_RELAXED);
+			pWorker->pNext = pWorkersToExit;
+			pWorkersToExit = pWorker;
+		}
+	}
+	_MCFCRT_SignalMutex(&g_mtxWorkerCache);
+	while(pWorkersToExit){
+		MopthreadWorker *const pWorker = pWorkersToExit;
+		pWorkersToExit = pWorker->pNext;
+		WakeWorker(pWorker, WORKER_EXIT);
+	}
+	return uOldCapacity;
+}
+
+bool __MCFCRT_MopthreadRegisterCleanupCallback(__MCFCRT_MopthreadCleanupCallback pfnCallback){
+	CleanupCallbackNode *const pNode = _MCFCRT_malloc(sizeof(CleanupCallbackNode));
+	if(!pNode){
+		return false;
+	}
+	pNode->pfnCallback = pfnCallback;
+	LockCleanupCallbacks();
+	{
+		// Threads that are running callbacks already will not see this one.
+		pNode->pNext = g_pCleanupCallbacks;
+		g_pCleanupCallbacks = pNode;
+	}
+	UnlockCleanupCallbacks();
+	return true;
+}
+void __MCFCRT_MopthreadUnregisterCleanupCallback(__MCFCRT_MopthreadCleanupCallback pfnCallback){
+	const uintptr_t uTid = _MCFCRT_GetCurrentThreadId();
+
+	CleanupCallbackNode *pNode;
+	LockCleanupCallbacks();
+	{
+		CleanupCallbackNode **ppNode = &g_pCleanupCallbacks;
+		for(;;){
+			pNode = *ppNode;
+			if(!pNode){
+				break;
+			}
+			if(pNode->pfnCallback == pfnCallback){
+				*ppNode = pNode->pNext;
+				break;
+			}
+			ppNode = &(pNode->pNext);
+		}
+		if(pNode){
+			// Make sure nobody will visit this node.
+			for(CleanupCallbackCursor *pCursor = g_pCleanupCallbackCursors; pCursor; pCursor = pCursor->pNext){
+				if(pCursor->pNextNode == pNode){
+					pCursor->pNextNode = pNode->pNext;
+				}
+			}
+			// Wait for other threads that are invoking this callback.
+			// The calling thread itself may be invoking it, for example when a destructor unloads the module that registered it. Don't wait for that.
+			for(;;){
+				const CleanupCallbackCursor *pCursor = g_pCleanupCallbackCursors;
+				while(pCursor && ((pCursor->pCurrentNode != pNode) || (pCursor->uTid == uTid))){
+					pCursor = pCursor->pNext;
+				}
+				if(!pCursor){
+					break;
+				}
+				_MCFCRT_WaitForConditionVariableForever(&g_condCleanupCallbacks, &CleanupCallbacksUnlockCallback, &CleanupCallbacksRelockCallback, 0, 0);
+			}
+		}
+	}
+	UnlockCleanupCallbacks();
+	_MCFCRT_free(pNode);
 }
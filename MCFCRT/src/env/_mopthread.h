@@ -28,6 +28,22 @@ extern bool __MCFCRT_MopthreadDetach(_MCFCRT_STD uintptr_t __uTid) _MCFCRT_NOEXC
 extern const _MCFCRT_ThreadHandle *__MCFCRT_MopthreadLockHandle(_MCFCRT_STD uintptr_t __uTid) _MCFCRT_NOEXCEPT;
 extern void __MCFCRT_MopthreadUnlockHandle(const _MCFCRT_ThreadHandle *__phThread) _MCFCRT_NOEXCEPT;
 
+// Native threads are not cached by default. Once a non-zero capacity is set, a thread whose procedure returns is put into the cache instead of exiting.
+// It is reused by `__MCFCRT_MopthreadCreate()` or `__MCFCRT_MopthreadCreateDetached()` with the same thread ID, after it has been joined or detached.
+// A thread that has returned but has not been joined or detached yet takes a slot in the cache, too. When the cache is full, threads exit as usual.
+// Only thread-local objects and thread exit callbacks of modules that use MCFCRT are destroyed before the thread can be joined. Other DLLs receive
+// no `DLL_THREAD_DETACH` notifications, so their per-thread data (such as `TlsAlloc()` slots and `__declspec(thread)` objects) is neither destroyed
+// nor reset, and is seen by the next procedure that runs on the same thread. Don't enable the cache if threads use such DLLs.
+// Threads that call `__MCFCRT_MopthreadExit()` are never cached. Handles returned by `__MCFCRT_MopthreadLockHandle()` are not signaled when a cached thread terminates.
+// This function returns the old capacity. Excess threads in the cache exit.
+extern _MCFCRT_STD size_t __MCFCRT_MopthreadSetCacheCapacity(_MCFCRT_STD size_t __uCapacity) _MCFCRT_NOEXCEPT;
+
+// Every module that has thread-local data registers a callback here, which is invoked on threads that are going to be cached.
+typedef void (*__MCFCRT_MopthreadCleanupCallback)(void);
+
+extern bool __MCFCRT_MopthreadRegisterCleanupCallback(__MCFCRT_MopthreadCleanupCallback __pfnCallback) _MCFCRT_NOEXCEPT;
+extern void __MCFCRT_MopthreadUnregisterCleanupCallback(__MCFCRT_MopthreadCleanupCallback __pfnCallback) _MCFCRT_NOEXCEPT;
+
 _MCFCRT_EXTERN_C_END
 
 #endif
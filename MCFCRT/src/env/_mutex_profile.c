@@ -0,0 +1,260 @@
+// 这个文件是 MCF 的一部分。
+// 有关具体授权说明，请参阅 MCFLicense.txt。
+// Copyleft 2013 - 2018, LH_Mouse. All wrongs reserved.
+
+#include "_mutex_profile.h"
+#include "clocks.h"
+#include "thread.h"
+#include "expect.h"
+
+#define TABLE_COUNT             8u
+#define SLOT_COUNT              128u
+
+#define SLOT_FREE               ((uintptr_t)0)
+#define SLOT_CLAIMED            ((uintptr_t)1)
+#define SLOT_READY              ((uintptr_t)2)
+
+typedef struct tagSlot {
+	uintptr_t uState;
+	// These are written only when the slot is being claimed or reset.
+	const void *pMutex;
+	const void *pRetAddr;
+	// These are updated using atomic operations.
+	uint64_t u64WaitCount;
+	uint64_t u64TimeoutCount;
+	uint64_t u64SpinCount;
+	uint64_t u64ParkCount;
+	uint64_t u64TrappedSum;
+	uint64_t u64TrappedMax;
+	uint64_t u64WaitMicroseconds;
+	uint64_t u64ParkMicroseconds;
+	uint64_t au64Histogram[_MCFCRT_MUTEX_PROFILE_HISTOGRAM_SIZE];
+} Slot;
+
+// Tables are never freed. They reside in the `.bss` section, which does not occupy physical memory until profiling is enabled.
+typedef struct tagTable {
+	alignas(_MCFCRT_CACHE_LINE_SIZE) Slot aSlots[SLOT_COUNT];
+} Table;
+
+static volatile bool g_bEnabled                     = false;
+static Table         g_aTables[TABLE_COUNT]         = { { { { 0 } } } };
+
+static _MCFCRT_Mutex g_mtxSnapshot                  = { 0 };
+
+bool __MCFCRT_MutexProfileIsEnabled(void){
+	return __atomic_load_n(&g_bEnabled, __ATOMIC_RELAXED);
+}
+bool __MCFCRT_MutexProfileSetEnabled(bool bEnabled){
+	return __atomic_exchange_n(&g_bEnabled, bEnabled, __ATOMIC_RELAXED);
+}
+
+static inline uint64_t MillisecondsToMicroseconds(double dMilliseconds){
+	if(!(dMilliseconds > 0)){
+		return 0;
+	}
+	return (uint64_t)(dMilliseconds * 1000);
+}
+static inline unsigned GetHistogramIndex(uint64_t u64Microseconds){
+	if(u64Microseconds < 2){
+		return 0;
+	}
+	const unsigned uIndex = (unsigned)(63 - __builtin_clzll(u64Microseconds));
+	return (uIndex < _MCFCRT_MUTEX_PROFILE_HISTOGRAM_SIZE - 1) ? uIndex : (_MCFCRT_MUTEX_PROFILE_HISTOGRAM_SIZE - 1);
+}
+
+static inline Table *GetTableOfCurrentThread(void){
+	// Thread IDs are multiples of four on Windows, so don't take the lower bits directly.
+	const uint32_t u32Hash = (uint32_t)_MCFCRT_GetCurrentThreadId() * 0x9E3779B1u;
+	return g_aTables + (u32Hash >> 29);
+}
+
+static_assert(TABLE_COUNT == (1u << (32 - 29)), "Please update `GetTableOfCurrentThread()`.");
+
+static inline size_t HashKey(const void *pMutex, const void *pRetAddr){
+	uintptr_t uHash = (uintptr_t)pMutex ^ ((uintptr_t)pRetAddr << 7) ^ ((uintptr_t)pRetAddr >> 5);
+	uHash *= (uintptr_t)0x9E3779B97F4A7C15ull;
+	return (size_t)(uHash >> (sizeof(uintptr_t) * CHAR_BIT - 16));
+}
+
+static Slot *FindOrClaimSlot(Table *pTable, const void *pMutex, const void *pRetAddr){
+	const size_t uHash = HashKey(pMutex, pRetAddr);
+	for(size_t uProbe = 0; uProbe < SLOT_COUNT; ++uProbe){
+		Slot *const pSlot = pTable->aSlots + (uHash + uProbe) % SLOT_COUNT;
+		uintptr_t uState = __atomic_load_n(&(pSlot->uState), __ATOMIC_ACQUIRE);
+		if(uState == SLOT_FREE){
+			if(__atomic_compare_exchange_n(&(pSlot->uState), &uState, SLOT_CLAIMED, false, __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE)){
+				__atomic_store_n(&(pSlot->pMutex), pMutex, __ATOMIC_RELAXED);
+				__atomic_store_n(&(pSlot->pRetAddr), pRetAddr, __ATOMIC_RELAXED);
+				__atomic_store_n(&(pSlot->uState), SLOT_READY, __ATOMIC_RELEASE);
+				return pSlot;
+			}
+		}
+		// Slots that are being claimed by other threads are skipped, so there may be multiple slots with the same key. They are merged when a snapshot is taken.
+		if((uState == SLOT_READY) && (__atomic_load_n(&(pSlot->pMutex), __ATOMIC_RELAXED) == pMutex) && (__atomic_load_n(&(pSlot->pRetAddr), __ATOMIC_RELAXED) == pRetAddr)){
+			return pSlot;
+		}
+	}
+	return _MCFCRT_NULLPTR;
+}
+
+static inline void AtomicMax(uint64_t *pu64Value, uint64_t u64New){
+	uint64_t u64Old = __atomic_load_n(pu64Value, __ATOMIC_RELAXED);
+	while((u64Old < u64New) && !__atomic_compare_exchange_n(pu64Value, &u64Old, u64New, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)){
+		// Try again.
+	}
+}
+
+void __MCFCRT_MutexProfileBeginWait(__MCFCRT_MutexWaitRecord *pRecord){
+	pRecord->__dBeginTime    = _MCFCRT_GetHiResMonoClock();
+	pRecord->__dParkTime     = 0;
+	pRecord->__u64SpinCount  = 0;
+	pRecord->__u64ParkCount  = 0;
+	pRecord->__u64TrappedSum = 0;
+	pRecord->__u64TrappedMax = 0;
+}
+double __MCFCRT_MutexProfileBeginPark(__MCFCRT_MutexWaitRecord *pRecord, size_t uThreadsTrapped){
+	pRecord->__u64ParkCount  += 1;
+	pRecord->__u64TrappedSum += uThreadsTrapped;
+	if(pRecord->__u64TrappedMax < uThreadsTrapped){
+		pRecord->__u64TrappedMax = uThreadsTrapped;
+	}
+	return _MCFCRT_GetHiResMonoClock();
+}
+void __MCFCRT_MutexProfileEndPark(__MCFCRT_MutexWaitRecord *pRecord, double dParkBeginTime){
+	pRecord->__dParkTime += _MCFCRT_GetHiResMonoClock() - dParkBeginTime;
+}
+void __MCFCRT_MutexProfileEndWait(const __MCFCRT_MutexWaitRecord *pRecord, const void *pMutex, const void *pRetAddr, bool bLocked){
+	const uint64_t u64WaitMicroseconds = MillisecondsToMicroseconds(_MCFCRT_GetHiResMonoClock() - pRecord->__dBeginTime);
+	const uint64_t u64ParkMicroseconds = MillisecondsToMicroseconds(pRecord->__dParkTime);
+
+	Slot *const pSlot = FindOrClaimSlot(GetTableOfCurrentThread(), pMutex, pRetAddr);
+	if(_MCFCRT_EXPECT_NOT(!pSlot)){
+		// The table is full. Drop this record.
+		return;
+	}
+	__atomic_fetch_add(&(pSlot->u64WaitCount), 1, __ATOMIC_RELAXED);
+	__atomic_fetch_add(&(pSlot->u64TimeoutCount), !bLocked, __ATOMIC_RELAXED);
+	__atomic_fetch_add(&(pSlot->u64SpinCount), pRecord->__u64SpinCount, __ATOMIC_RELAXED);
+	__atomic_fetch_add(&(pSlot->u64ParkCount), pRecord->__u64ParkCount, __ATOMIC_RELAXED);
+	__atomic_fetch_add(&(pSlot->u64TrappedSum), pRecord->__u64TrappedSum, __ATOMIC_RELAXED);
+	AtomicMax(&(pSlot->u64TrappedMax), pRecord->__u64TrappedMax);
+	__atomic_fetch_add(&(pSlot->u64WaitMicroseconds), u64WaitMicroseconds, __ATOMIC_RELAXED);
+	__atomic_fetch_add(&(pSlot->u64ParkMicroseconds), u64ParkMicroseconds, __ATOMIC_RELAXED);
+	__atomic_fetch_add(&(pSlot->au64Histogram[GetHistogramIndex(u64WaitMicroseconds)]), 1, __ATOMIC_RELAXED);
+}
+
+static inline bool IsSameGroup(const Slot *pSlot, const Slot *pOther, bool bByCallSite){
+	if(bByCallSite){
+		return pSlot->pRetAddr == pOther->pRetAddr;
+	} else {
+		return pSlot->pMutex == pOther->pMutex;
+	}
+}
+static void AccumulateSlot(_MCFCRT_MutexProfileEntry *pEntry, const Slot *pSlot){
+	pEntry->__u64WaitCount        += __atomic_load_n(&(pSlot->u64WaitCount), __ATOMIC_RELAXED);
+	pEntry->__u64TimeoutCount     += __atomic_load_n(&(pSlot->u64TimeoutCount), __ATOMIC_RELAXED);
+	pEntry->__u64SpinCount        += __atomic_load_n(&(pSlot->u64SpinCount), __ATOMIC_RELAXED);
+	pEntry->__u64ParkCount        += __atomic_load_n(&(pSlot->u64ParkCount), __ATOMIC_RELAXED);
+	pEntry->__u64TrappedSum       += __atomic_load_n(&(pSlot->u64TrappedSum), __ATOMIC_RELAXED);
+	const uint64_t u64TrappedMax = __atomic_load_n(&(pSlot->u64TrappedMax), __ATOMIC_RELAXED);
+	if(pEntry->__u64TrappedMax < u64TrappedMax){
+		pEntry->__u64TrappedMax = u64TrappedMax;
+	}
+	pEntry->__u64WaitMicroseconds += __atomic_load_n(&(pSlot->u64WaitMicroseconds), __ATOMIC_RELAXED);
+	pEntry->__u64ParkMicroseconds += __atomic_load_n(&(pSlot->u64ParkMicroseconds), __ATOMIC_RELAXED);
+	for(unsigned uIndex = 0; uIndex < _MCFCRT_MUTEX_PROFILE_HISTOGRAM_SIZE; ++uIndex){
+		pEntry->__au64Histogram[uIndex] += __atomic_load_n(&(pSlot->au64Histogram[uIndex]), __ATOMIC_RELAXED);
+	}
+}
+
+static inline const Slot *GetReadySlot(size_t uSlotIndex){
+	const Slot *const pSlot = g_aTables[uSlotIndex / SLOT_COUNT].aSlots + uSlotIndex % SLOT_COUNT;
+	if(__atomic_load_n(&(pSlot->uState), __ATOMIC_ACQUIRE) != SLOT_READY){
+		return _MCFCRT_NULLPTR;
+	}
+	return pSlot;
+}
+
+size_t __MCFCRT_MutexProfileSnapshot(_MCFCRT_MutexProfileEntry *pEntries, size_t uMaxCount, bool bByCallSite){
+	size_t uGroupCount = 0;
+	size_t uEntryCount = 0;
+	_MCFCRT_WaitForMutexForever(&g_mtxSnapshot, _MCFCRT_MUTEX_SUGGESTED_SPIN_COUNT);
+	{
+		// There are at most `TABLE_COUNT * SLOT_COUNT` slots, so a quadratic merge needs no extra storage and is fast enough.
+		for(size_t uSlotIndex = 0; uSlotIndex < TABLE_COUNT * SLOT_COUNT; ++uSlotIndex){
+			const Slot *const pSlot = GetReadySlot(uSlotIndex);
+			if(!pSlot){
+				continue;
+			}
+			// Skip this slot if its group has been merged.
+			bool bMerged = false;
+			for(size_t uOtherIndex = 0; uOtherIndex < uSlotIndex; ++uOtherIndex){
+				const Slot *const pOther = GetReadySlot(uOtherIndex);
+				if(pOther && IsSameGroup(pSlot, pOther, bByCallSite)){
+					bMerged = true;
+					break;
+				}
+			}
+			if(bMerged){
+				continue;
+			}
+			_MCFCRT_MutexProfileEntry vEntry = { 0 };
+			vEntry.__pMutex   = bByCallSite ? _MCFCRT_NULLPTR : pSlot->pMutex;
+			vEntry.__pRetAddr = bByCallSite ? pSlot->pRetAddr : _MCFCRT_NULLPTR;
+			AccumulateSlot(&vEntry, pSlot);
+			for(size_t uOtherIndex = uSlotIndex + 1; uOtherIndex < TABLE_COUNT * SLOT_COUNT; ++uOtherIndex){
+				const Slot *const pOther = GetReadySlot(uOtherIndex);
+				if(pOther && IsSameGroup(pSlot, pOther, bByCallSite)){
+					AccumulateSlot(&vEntry, pOther);
+				}
+			}
+			++uGroupCount;
+			// Keep the longest ones sorted in descending order.
+			size_t uInsertAt = uEntryCount;
+			while((uInsertAt != 0) && (pEntries[uInsertAt - 1].__u64WaitMicroseconds < vEntry.__u64WaitMicroseconds)){
+				if(uInsertAt < uMaxCount){
+					pEntries[uInsertAt] = pEntries[uInsertAt - 1];
+				}
+				--uInsertAt;
+			}
+			if(uInsertAt < uMaxCount){
+				pEntries[uInsertAt] = vEntry;
+				if(uEntryCount < uMaxCount){
+					++uEntryCount;
+				}
+			}
+		}
+	}
+	_MCFCRT_SignalMutex(&g_mtxSnapshot);
+	return uGroupCount;
+}
+void __MCFCRT_MutexProfileReset(void){
+	_MCFCRT_WaitForMutexForever(&g_mtxSnapshot, _MCFCRT_MUTEX_SUGGESTED_SPIN_COUNT);
+	{
+		for(size_t uTableIndex = 0; uTableIndex < TABLE_COUNT; ++uTableIndex){
+			for(size_t uIndex = 0; uIndex < SLOT_COUNT; ++uIndex){
+				Slot *const pSlot = g_aTables[uTableIndex].aSlots + uIndex;
+				// Lock the slot out, so no other thread may claim it before it is cleared.
+				uintptr_t uState = SLOT_READY;
+				if(!__atomic_compare_exchange_n(&(pSlot->uState), &uState, SLOT_CLAIMED, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)){
+					continue;
+				}
+				__atomic_store_n(&(pSlot->pMutex), _MCFCRT_NULLPTR, __ATOMIC_RELAXED);
+				__atomic_store_n(&(pSlot->pRetAddr), _MCFCRT_NULLPTR, __ATOMIC_RELAXED);
+				__atomic_store_n(&(pSlot->u64WaitCount), 0, __ATOMIC_RELAXED);
+				__atomic_store_n(&(pSlot->u64TimeoutCount), 0, __ATOMIC_RELAXED);
+				__atomic_store_n(&(pSlot->u64SpinCount), 0, __ATOMIC_RELAXED);
+				__atomic_store_n(&(pSlot->u64ParkCount), 0, __ATOMIC_RELAXED);
+				__atomic_store_n(&(pSlot->u64TrappedSum), 0, __ATOMIC_RELAXED);
+				__atomic_store_n(&(pSlot->u64TrappedMax), 0, __ATOMIC_RELAXED);
+				__atomic_store_n(&(pSlot->u64WaitMicroseconds), 0, __ATOMIC_RELAXED);
+				__atomic_store_n(&(pSlot->u64ParkMicroseconds), 0, __ATOMIC_RELAXED);
+				for(unsigned uBucket = 0; uBucket < _MCFCRT_MUTEX_PROFILE_HISTOGRAM_SIZE; ++uBucket){
+					__atomic_store_n(&(pSlot->au64Histogram[uBucket]), 0, __ATOMIC_RELAXED);
+				}
+				__atomic_store_n(&(pSlot->uState), SLOT_FREE, __ATOMIC_RELEASE);
+			}
+		}
+	}
+	_MCFCRT_SignalMutex(&g_mtxSnapshot);
+}
@@ -0,0 +1,40 @@
+// 这个文件是 MCF 的一部分。
+// 有关具体授权说明，请参阅 MCFLicense.txt。
+// Copyleft 2013 - 2018, LH_Mouse. All wrongs reserved.
+
+#ifndef __MCFCRT_ENV_MUTEX_PROFILE_H_
+#define __MCFCRT_ENV_MUTEX_PROFILE_H_
+
+#include "_crtdef.h"
+#include "mutex.h"
+
+_MCFCRT_EXTERN_C_BEGIN
+
+// This is the backend of mutex contention profiling. See `mutex.h` for the public interface.
+// A thread that leaves the fast path fills a `__MCFCRT_MutexWaitRecord` on its stack, which is then added to a table chosen by the thread ID.
+// Tables are hash tables with open addressing. Slots are claimed and updated using atomic operations, so recording a wait never blocks.
+
+typedef struct __MCFCRT_tagMutexWaitRecord {
+	double __dBeginTime;
+	double __dParkTime;
+	_MCFCRT_STD uint64_t __u64SpinCount;
+	_MCFCRT_STD uint64_t __u64ParkCount;
+	_MCFCRT_STD uint64_t __u64TrappedSum;
+	_MCFCRT_STD uint64_t __u64TrappedMax;
+} __MCFCRT_MutexWaitRecord;
+
+extern bool __MCFCRT_MutexProfileIsEnabled(void) _MCFCRT_NOEXCEPT;
+extern bool __MCFCRT_MutexProfileSetEnabled(bool __bEnabled) _MCFCRT_NOEXCEPT;
+
+extern void __MCFCRT_MutexProfileBeginWait(__MCFCRT_MutexWaitRecord *__pRecord) _MCFCRT_NOEXCEPT;
+// `__uThreadsTrapped` is the number of threads that are sleeping on the mutex, including the current one.
+extern double __MCFCRT_MutexProfileBeginPark(__MCFCRT_MutexWaitRecord *__pRecord, _MCFCRT_STD size_t __uThreadsTrapped) _MCFCRT_NOEXCEPT;
+extern void __MCFCRT_MutexProfileEndPark(__MCFCRT_MutexWaitRecord *__pRecord, double __dParkBeginTime) _MCFCRT_NOEXCEPT;
+extern void __MCFCRT_MutexProfileEndWait(const __MCFCRT_MutexWaitRecord *__pRecord, const void *__pMutex, const void *__pRetAddr, bool __bLocked) _MCFCRT_NOEXCEPT;
+
+extern _MCFCRT_STD size_t __MCFCRT_MutexProfileSnapshot(_MCFCRT_MutexProfileEntry *__pEntries, _MCFCRT_STD size_t __uMaxCount, bool __bByCallSite) _MCFCRT_NOEXCEPT;
+extern void __MCFCRT_MutexProfileReset(void) _MCFCRT_NOEXCEPT;
+
+_MCFCRT_EXTERN_C_END
+
+#endif
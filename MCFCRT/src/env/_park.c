@@ -0,0 +1,342 @@
+// 这个文件是 MCF 的一部分。
+// 有关具体授权说明，请参阅 MCFLicense.txt。
+// Copyleft 2013 - 2018, LH_Mouse. All wrongs reserved.
+
+#include "_park.h"
+#include "_park_native.h"
+#include "clocks.h"
+#include "xassert.h"
+#include "expect.h"
+
+// Keyed events are emulated using hashed wait queues. Both parked threads and releasing threads are queued.
+// A thread that arrives at a bucket removes the first thread of the opposite role on the same key from the queue, if any, and wakes it up. Otherwise it queues itself and sleeps on its own sleep word.
+// Threads are woken up after buckets are unlocked, as waking up a thread may block until it goes to sleep.
+// Threads that are parked conditionally are woken up by `__MCFCRT_WakeParkedThreads()` only, which never queues itself.
+
+typedef struct tagWaiter {
+	struct tagWaiter *pNext;
+	const volatile void *pKey;
+	bool bReleasing;
+	// These are meaningful only for parked threads.
+	const volatile void *pRequeueKey;
+	__MCFCRT_ParkRequeueCallback pfnRequeueCallback;
+	intptr_t nRequeueContext;
+	volatile int nSleepWord;
+} Waiter;
+
+#define BUCKET_COUNT            256u
+
+typedef struct tagBucket {
+	__attribute__((__aligned__(_MCFCRT_CACHE_LINE_SIZE))) volatile int nLock;
+	Waiter *pFirst;
+	Waiter *pLast;
+	// This is the number of threads that are parked conditionally in this bucket. It allows `__MCFCRT_WakeParkedThreads()` to return early without locking the bucket.
+	volatile size_t uConditionalCount;
+} Bucket;
+
+static Bucket g_aBuckets[BUCKET_COUNT];
+
+static inline Bucket *GetBucket(const volatile void *pKey){
+	// Discard the lower bits, which are always zero due to alignment, then take the higher bits of the product.
+	const uint32_t u32Hash = (uint32_t)(((uintptr_t)pKey >> 3) * 0x9E3779B1u);
+	return g_aBuckets + (u32Hash >> 24);
+}
+
+static_assert(BUCKET_COUNT == (1u << (32 - 24)), "Please update `GetBucket()`.");
+
+static inline void LockBucket(Bucket *pBucket){
+	__MCFCRT_ParkNativeLock(&(pBucket->nLock));
+}
+static inline void UnlockBucket(Bucket *pBucket){
+	__MCFCRT_ParkNativeUnlock(&(pBucket->nLock));
+}
+
+static void Enqueue(Bucket *pBucket, Waiter *pWaiter){
+	pWaiter->pNext = _MCFCRT_NULLPTR;
+	if(pBucket->pLast){
+		pBucket->pLast->pNext = pWaiter;
+	} else {
+		pBucket->pFirst = pWaiter;
+	}
+	pBucket->pLast = pWaiter;
+}
+static bool Dequeue(Bucket *pBucket, Waiter *pWaiter){
+	Waiter *pPrev = _MCFCRT_NULLPTR;
+	for(Waiter *pCur = pBucket->pFirst; pCur; pCur = pCur->pNext){
+		if(pCur == pWaiter){
+			if(pPrev){
+				pPrev->pNext = pCur->pNext;
+			} else {
+				pBucket->pFirst = pCur->pNext;
+			}
+			if(pBucket->pLast == pCur){
+				pBucket->pLast = pPrev;
+			}
+			return true;
+		}
+		pPrev = pCur;
+	}
+	return false;
+}
+static Waiter *DequeueCounterpart(Bucket *pBucket, const volatile void *pKey, bool bReleasing){
+	for(Waiter *pCur = pBucket->pFirst; pCur; pCur = pCur->pNext){
+		if((pCur->pKey == pKey) && (pCur->bReleasing != bReleasing)){
+			Dequeue(pBucket, pCur);
+			return pCur;
+		}
+	}
+	return _MCFCRT_NULLPTR;
+}
+
+static inline void WakeWaiter(Waiter *pWaiter){
+	// `*pWaiter` may go out of scope once this function returns.
+	__MCFCRT_ParkNativeWake(&(pWaiter->nSleepWord));
+}
+
+// The bucket of the original key of `*pParked` must have been locked, and `*pParked` must have been dequeued from it.
+static bool ShouldBeRequeued(Waiter *pParked, bool bPeerWoken){
+	if(!pParked->pfnRequeueCallback){
+		return false;
+	}
+	if(!(*(pParked->pfnRequeueCallback))(pParked->nRequeueContext, bPeerWoken)){
+		return false;
+	}
+	// The parked thread reads its key with the bucket locked if it times out.
+	pParked->pKey = pParked->pRequeueKey;
+	pParked->pfnRequeueCallback = _MCFCRT_NULLPTR;
+	return true;
+}
+// `*pParked` has been taken off its original bucket, which shall not be locked.
+static void MoveParkedWaiter(Waiter *pParked){
+	Bucket *const pBucket = GetBucket(pParked->pKey);
+	LockBucket(pBucket);
+	Waiter *const pReleaser = DequeueCounterpart(pBucket, pParked->pKey, false);
+	if(pReleaser){
+		UnlockBucket(pBucket);
+		WakeWaiter(pReleaser);
+		WakeWaiter(pParked);
+		return;
+	}
+	Enqueue(pBucket, pParked);
+	UnlockBucket(pBucket);
+}
+
+// `*pSelf` has been queued into `*pBucket` with `pKey`, and `*pBucket` has been unlocked.
+static bool SleepQueued(Bucket *pBucket, const volatile void *pKey, Waiter *pSelf, bool bConditional, bool bMayTimeOut, uint64_t u64UntilFastMonoClock){
+	if(bMayTimeOut){
+		if(_MCFCRT_EXPECT(__MCFCRT_ParkNativeSleep(&(pSelf->nSleepWord), true, u64UntilFastMonoClock))){
+			return true;
+		}
+		LockBucket(pBucket);
+		// If we are no longer in the queue, we have been released. If we have been requeued, the timeout no longer applies.
+		// Our key has to be checked, as the bucket of the new key may be the same as the old one.
+		const bool bTimedOut = (pSelf->pKey == pKey) && Dequeue(pBucket, pSelf);
+		if(bTimedOut && bConditional){
+			__atomic_fetch_sub(&(pBucket->uConditionalCount), 1, __ATOMIC_RELAXED);
+		}
+		UnlockBucket(pBucket);
+		if(bTimedOut){
+			return false;
+		}
+	}
+	const bool bWoken = __MCFCRT_ParkNativeSleep(&(pSelf->nSleepWord), false, UINT64_MAX);
+	_MCFCRT_ASSERT(bWoken);
+	return true;
+}
+
+static bool Park(const volatile void *pKey, bool bMayTimeOut, uint64_t u64UntilFastMonoClock, const volatile void *pRequeueKey, __MCFCRT_ParkRequeueCallback pfnRequeueCallback, intptr_t nRequeueContext){
+	Bucket *const pBucket = GetBucket(pKey);
+	LockBucket(pBucket);
+	Waiter *const pReleaser = DequeueCounterpart(pBucket, pKey, false);
+	if(pReleaser){
+		UnlockBucket(pBucket);
+		const bool bRequeued = pfnRequeueCallback && (*pfnRequeueCallback)(nRequeueContext, false);
+		WakeWaiter(pReleaser);
+		if(bRequeued){
+			Park(pRequeueKey, false, UINT64_MAX, _MCFCRT_NULLPTR, _MCFCRT_NULLPTR, 0);
+		}
+		return true;
+	}
+	if(bMayTimeOut && (_MCFCRT_GetFastMonoClock() >= u64UntilFastMonoClock)){
+		UnlockBucket(pBucket);
+		return false;
+	}
+	Waiter vSelf;
+	vSelf.pKey = pKey;
+	vSelf.bReleasing = false;
+	vSelf.pRequeueKey = pRequeueKey;
+	vSelf.pfnRequeueCallback = pfnRequeueCallback;
+	vSelf.nRequeueContext = nRequeueContext;
+	vSelf.nSleepWord = 0;
+	Enqueue(pBucket, &vSelf);
+	UnlockBucket(pBucket);
+
+	return SleepQueued(pBucket, pKey, &vSelf, false, bMayTimeOut, u64UntilFastMonoClock);
+}
+static bool ParkIf(const volatile void *pKey, bool bMayTimeOut, uint64_t u64UntilFastMonoClock, __MCFCRT_ParkValidateCallback pfnValidateCallback, intptr_t nContext){
+	Bucket *const pBucket = GetBucket(pKey);
+	LockBucket(pBucket);
+	// Wakers that find the count non-zero take the same lock, so no wakeup can be missed between the validation and queueing.
+	// Wakers that find it zero must have modified the object before the count was incremented, which will be seen by the callback.
+	__atomic_fetch_add(&(pBucket->uConditionalCount), 1, __ATOMIC_SEQ_CST);
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	if(!(*pfnValidateCallback)(nContext)){
+		__atomic_fetch_sub(&(pBucket->uConditionalCount), 1, __ATOMIC_RELAXED);
+		UnlockBucket(pBucket);
+		return true;
+	}
+	if(bMayTimeOut && (_MCFCRT_GetFastMonoClock() >= u64UntilFastMonoClock)){
+		__atomic_fetch_sub(&(pBucket->uConditionalCount), 1, __ATOMIC_RELAXED);
+		UnlockBucket(pBucket);
+		return false;
+	}
+	Waiter vSelf;
+	vSelf.pKey = pKey;
+	vSelf.bReleasing = false;
+	vSelf.pRequeueKey = _MCFCRT_NULLPTR;
+	vSelf.pfnRequeueCallback = _MCFCRT_NULLPTR;
+	vSelf.nRequeueContext = 0;
+	vSelf.nSleepWord = 0;
+	Enqueue(pBucket, &vSelf);
+	UnlockBucket(pBucket);
+
+	return SleepQueued(pBucket, pKey, &vSelf, true, bMayTimeOut, u64UntilFastMonoClock);
+}
+static void ReleaseOne(const volatile void *pKey){
+	Bucket *const pBucket = GetBucket(pKey);
+	LockBucket(pBucket);
+	Waiter *const pParked = DequeueCounterpart(pBucket, pKey, true);
+	if(pParked){
+		const bool bRequeued = ShouldBeRequeued(pParked, false);
+		UnlockBucket(pBucket);
+		if(bRequeued){
+			MoveParkedWaiter(pParked);
+		} else {
+			WakeWaiter(pParked);
+		}
+		return;
+	}
+	Waiter vSelf;
+	vSelf.pKey = pKey;
+	vSelf.bReleasing = true;
+	vSelf.pRequeueKey = _MCFCRT_NULLPTR;
+	vSelf.pfnRequeueCallback = _MCFCRT_NULLPTR;
+	vSelf.nRequeueContext = 0;
+	vSelf.nSleepWord = 0;
+	Enqueue(pBucket, &vSelf);
+	UnlockBucket(pBucket);
+
+	const bool bWoken = __MCFCRT_ParkNativeSleep(&(vSelf.nSleepWord), false, UINT64_MAX);
+	_MCFCRT_ASSERT(bWoken);
+}
+
+bool __MCFCRT_ParkThread(const volatile void *pKey, uint64_t u64UntilFastMonoClock){
+	return Park(pKey, true, u64UntilFastMonoClock, _MCFCRT_NULLPTR, _MCFCRT_NULLPTR, 0);
+}
+void __MCFCRT_ParkThreadForever(const volatile void *pKey){
+	const bool bReleased = Park(pKey, false, UINT64_MAX, _MCFCRT_NULLPTR, _MCFCRT_NULLPTR, 0);
+	_MCFCRT_ASSERT(bReleased);
+}
+void __MCFCRT_UnparkThreads(const volatile void *pKey, size_t uCount){
+	// If `__MCFCRT_ParkNativeIsShuttingDown()` is `true`, other threads will have been terminated.
+	// Waking up a thread that no longer exists results in deadlocks. Don't do that.
+	if(_MCFCRT_EXPECT_NOT(__MCFCRT_ParkNativeIsShuttingDown())){
+		return;
+	}
+	if(uCount == 0){
+		return;
+	}
+	// Take as many parked threads as possible at once. Those that are to be woken up and those that are to be requeued are linked into two lists respectively.
+	Waiter *pWakeList = _MCFCRT_NULLPTR;
+	Waiter *pRequeueList = _MCFCRT_NULLPTR;
+	Waiter **ppRequeueLast = &pRequeueList;
+	const volatile void *pWokenRequeueKey = _MCFCRT_NULLPTR;
+	size_t uReleased = 0;
+	{
+		Bucket *const pBucket = GetBucket(pKey);
+		LockBucket(pBucket);
+		while(uReleased < uCount){
+			Waiter *const pParked = DequeueCounterpart(pBucket, pKey, true);
+			if(!pParked){
+				break;
+			}
+			++uReleased;
+			// Requeue threads unconditionally if one of their peers is going to be woken up. Keep them in order.
+			const bool bPeerWoken = pWokenRequeueKey && (pParked->pRequeueKey == pWokenRequeueKey);
+			if(ShouldBeRequeued(pParked, bPeerWoken)){
+				pParked->pNext = _MCFCRT_NULLPTR;
+				*ppRequeueLast = pParked;
+				ppRequeueLast = &(pParked->pNext);
+			} else {
+				if(!pWokenRequeueKey){
+					pWokenRequeueKey = pParked->pRequeueKey;
+				}
+				pParked->pNext = pWakeList;
+				pWakeList = pParked;
+			}
+		}
+		UnlockBucket(pBucket);
+	}
+	// Requeue threads before waking up their peers, so the latter won't have to wait for the former when releasing them.
+	while(pRequeueList){
+		Waiter *const pParked = pRequeueList;
+		pRequeueList = pParked->pNext;
+		MoveParkedWaiter(pParked);
+	}
+	while(pWakeList){
+		Waiter *const pParked = pWakeList;
+		pWakeList = pParked->pNext;
+		WakeWaiter(pParked);
+	}
+	// Wait for the rest to arrive.
+	while(uReleased < uCount){
+		ReleaseOne(pKey);
+		++uReleased;
+	}
+}
+
+bool __MCFCRT_ParkThreadRequeueable(const volatile void *pKey, uint64_t u64UntilFastMonoClock, const volatile void *pRequeueKey, __MCFCRT_ParkRequeueCallback pfnRequeueCallback, intptr_t nContext){
+	return Park(pKey, true, u64UntilFastMonoClock, pRequeueKey, pfnRequeueCallback, nContext);
+}
+void __MCFCRT_ParkThreadRequeueableForever(const volatile void *pKey, const volatile void *pRequeueKey, __MCFCRT_ParkRequeueCallback pfnRequeueCallback, intptr_t nContext){
+	const bool bReleased = Park(pKey, false, UINT64_MAX, pRequeueKey, pfnRequeueCallback, nContext);
+	_MCFCRT_ASSERT(bReleased);
+}
+
+bool __MCFCRT_ParkThreadIf(const volatile void *pKey, uint64_t u64UntilFastMonoClock, __MCFCRT_ParkValidateCallback pfnValidateCallback, intptr_t nContext){
+	return ParkIf(pKey, true, u64UntilFastMonoClock, pfnValidateCallback, nContext);
+}
+void __MCFCRT_ParkThreadIfForever(const volatile void *pKey, __MCFCRT_ParkValidateCallback pfnValidateCallback, intptr_t nContext){
+	const bool bReleased = ParkIf(pKey, false, UINT64_MAX, pfnValidateCallback, nContext);
+	_MCFCRT_ASSERT(bReleased);
+}
+size_t __MCFCRT_WakeParkedThreads(const volatile void *pKey, size_t uMaxCount){
+	if(_MCFCRT_EXPECT_NOT(__MCFCRT_ParkNativeIsShuttingDown())){
+		return 0;
+	}
+	Bucket *const pBucket = GetBucket(pKey);
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	if(__atomic_load_n(&(pBucket->uConditionalCount), __ATOMIC_RELAXED) == 0){
+		return 0;
+	}
+	Waiter *pWakeList = _MCFCRT_NULLPTR;
+	size_t uWoken = 0;
+	LockBucket(pBucket);
+	while(uWoken < uMaxCount){
+		Waiter *const pParked = DequeueCounterpart(pBucket, pKey, true);
+		if(!pParked){
+			break;
+		}
+		__atomic_fetch_sub(&(pBucket->uConditionalCount), 1, __ATOMIC_RELAXED);
+		++uWoken;
+		pParked->pNext = pWakeList;
+		pWakeList = pParked;
+	}
+	UnlockBucket(pBucket);
+	while(pWakeList){
+		Waiter *const pParked = pWakeList;
+		pWakeList = pParked->pNext;
+		WakeWaiter(pParked);
+	}
+	return uWoken;
+}
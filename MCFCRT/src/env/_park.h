@@ -0,0 +1,44 @@
+// 这个文件是 MCF 的一部分。
+// 有关具体授权说明，请参阅 MCFLicense.txt。
+// Copyleft 2013 - 2018, LH_Mouse. All wrongs reserved.
+
+#ifndef __MCFCRT_ENV_PARK_H_
+#define __MCFCRT_ENV_PARK_H_
+
+#include "_crtdef.h"
+
+_MCFCRT_EXTERN_C_BEGIN
+
+// These functions put threads to sleep and wake them up by address. They underlie mutexes, condition variables and once flags.
+// They have the semantics of keyed events: Every thread released by `__MCFCRT_UnparkThreads()` is matched with exactly one call to `__MCFCRT_ParkThread()` or `__MCFCRT_ParkThreadForever()` on the same key.
+// If no thread is parked on that key, `__MCFCRT_UnparkThreads()` blocks until one arrives. Hence the callers must count threads that are going to be parked and release no more than that.
+// A thread that has timed out must try to take itself off the count. If it fails, it has been released by another thread and shall park again (with a timeout of zero, for example) to consume the release.
+// Parked threads are kept in hashed wait queues, so they can be moved from one key to another. See `_park_native.h` for how threads actually sleep.
+
+// This function returns `true` if the calling thread has been released, and `false` if it has timed out. A time point in the past results in a timeout of zero.
+extern bool __MCFCRT_ParkThread(const volatile void *__pKey, _MCFCRT_STD uint64_t __u64UntilFastMonoClock) _MCFCRT_NOEXCEPT;
+extern void __MCFCRT_ParkThreadForever(const volatile void *__pKey) _MCFCRT_NOEXCEPT;
+// This function does nothing if the process is shutting down, as other threads will have been terminated.
+extern void __MCFCRT_UnparkThreads(const volatile void *__pKey, _MCFCRT_STD size_t __uCount) _MCFCRT_NOEXCEPT;
+
+// When a thread parked by one of the functions below is released, the callback is invoked first. If it returns `true`, instead of being woken up, the thread is moved onto `__pRequeueKey`, where it is parked forever.
+// The callback must count the thread as one that is going to be parked on `__pRequeueKey`, so it will be released from there later. It shall not block, as it may be called with internal locks held.
+// Its second argument is `true` if another thread that had the same `__pRequeueKey` has been woken up by the same call to `__MCFCRT_UnparkThreads()`.
+typedef bool (*__MCFCRT_ParkRequeueCallback)(_MCFCRT_STD intptr_t __nContext, bool __bPeerWoken);
+
+extern bool __MCFCRT_ParkThreadRequeueable(const volatile void *__pKey, _MCFCRT_STD uint64_t __u64UntilFastMonoClock, const volatile void *__pRequeueKey, __MCFCRT_ParkRequeueCallback __pfnRequeueCallback, _MCFCRT_STD intptr_t __nContext) _MCFCRT_NOEXCEPT;
+extern void __MCFCRT_ParkThreadRequeueableForever(const volatile void *__pKey, const volatile void *__pRequeueKey, __MCFCRT_ParkRequeueCallback __pfnRequeueCallback, _MCFCRT_STD intptr_t __nContext) _MCFCRT_NOEXCEPT;
+
+// These functions do not have the semantics of keyed events. A thread is parked only if the callback returns `true`, which is called with internal locks held.
+// `__MCFCRT_WakeParkedThreads()` wakes up at most `__uMaxCount` threads that have been parked by these functions, and returns the number of them. It never blocks.
+// Any thread that might make the callback return `false` must call `__MCFCRT_WakeParkedThreads()` afterwards. A key shall not be used with both these functions and the ones above.
+typedef bool (*__MCFCRT_ParkValidateCallback)(_MCFCRT_STD intptr_t __nContext);
+
+// This function returns `false` if the calling thread has timed out, and `true` otherwise, including the case where it isn't parked at all.
+extern bool __MCFCRT_ParkThreadIf(const volatile void *__pKey, _MCFCRT_STD uint64_t __u64UntilFastMonoClock, __MCFCRT_ParkValidateCallback __pfnValidateCallback, _MCFCRT_STD intptr_t __nContext) _MCFCRT_NOEXCEPT;
+extern void __MCFCRT_ParkThreadIfForever(const volatile void *__pKey, __MCFCRT_ParkValidateCallback __pfnValidateCallback, _MCFCRT_STD intptr_t __nContext) _MCFCRT_NOEXCEPT;
+extern _MCFCRT_STD size_t __MCFCRT_WakeParkedThreads(const volatile void *__pKey, _MCFCRT_STD size_t __uMaxCount) _MCFCRT_NOEXCEPT;
+
+_MCFCRT_EXTERN_C_END
+
+#endif
@@ -0,0 +1,76 @@
+// 这个文件是 MCF 的一部分。
+// 有关具体授权说明，请参阅 MCFLicense.txt。
+// Copyleft 2013 - 2018, LH_Mouse. All wrongs reserved.
+
+// This file is not a part of the CRT. It implements `_park_native.h` on Linux, so lock algorithms can be built and tested natively there.
+// See `Projects/LockBenchmarkLinux` for an example.
+
+#ifndef __linux__
+#  error This file is meant to be compiled on Linux.
+#endif
+
+#define _GNU_SOURCE 1
+#include "_park_native.h"
+#include "clocks.h"
+#include "expect.h"
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <time.h>
+
+static inline long FutexWait(volatile int *pnWord, int nExpected, const struct timespec *pTimeout){
+	return syscall(SYS_futex, pnWord, FUTEX_WAIT | FUTEX_PRIVATE_FLAG, nExpected, pTimeout, _MCFCRT_NULLPTR, 0);
+}
+static inline void FutexWake(volatile int *pnWord, int nCount){
+	syscall(SYS_futex, pnWord, FUTEX_WAKE | FUTEX_PRIVATE_FLAG, nCount, _MCFCRT_NULLPTR, _MCFCRT_NULLPTR, 0);
+}
+
+// A sleep word is set to one when the thread is woken up. The sleeping thread may return and reuse the memory before `FutexWake()` is called, which only causes spurious wakeups.
+bool __MCFCRT_ParkNativeSleep(volatile int *pnWord, bool bMayTimeOut, uint64_t u64UntilFastMonoClock){
+	for(;;){
+		if(__atomic_load_n(pnWord, __ATOMIC_ACQUIRE)){
+			return true;
+		}
+		if(bMayTimeOut){
+			const uint64_t u64Now = _MCFCRT_GetFastMonoClock();
+			if(u64Now >= u64UntilFastMonoClock){
+				return false;
+			}
+			const uint64_t u64DeltaMs = u64UntilFastMonoClock - u64Now;
+			struct timespec vTimeout;
+			vTimeout.tv_sec = (time_t)(u64DeltaMs / 1000);
+			vTimeout.tv_nsec = (long)(u64DeltaMs % 1000 * 1000000);
+			FutexWait(pnWord, 0, &vTimeout);
+		} else {
+			FutexWait(pnWord, 0, _MCFCRT_NULLPTR);
+		}
+	}
+}
+void __MCFCRT_ParkNativeWake(volatile int *pnWord){
+	__atomic_store_n(pnWord, 1, __ATOMIC_RELEASE);
+	FutexWake(pnWord, 1);
+}
+
+// Lock words are three-state futex locks: 0 means unlocked, 1 means locked, 2 means locked with contention.
+void __MCFCRT_ParkNativeLock(volatile int *pnLock){
+	int nOld = 0;
+	if(_MCFCRT_EXPECT(__atomic_compare_exchange_n(pnLock, &nOld, 1, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))){
+		return;
+	}
+	if(nOld != 2){
+		nOld = __atomic_exchange_n(pnLock, 2, __ATOMIC_ACQUIRE);
+	}
+	while(nOld != 0){
+		FutexWait(pnLock, 2, _MCFCRT_NULLPTR);
+		nOld = __atomic_exchange_n(pnLock, 2, __ATOMIC_ACQUIRE);
+	}
+}
+void __MCFCRT_ParkNativeUnlock(volatile int *pnLock){
+	if(_MCFCRT_EXPECT_NOT(__atomic_exchange_n(pnLock, 0, __ATOMIC_RELEASE) == 2)){
+		FutexWake(pnLock, 1);
+	}
+}
+
+bool __MCFCRT_ParkNativeIsShuttingDown(void){
+	return false;
+}
@@ -0,0 +1,29 @@
+// 这个文件是 MCF 的一部分。
+// 有关具体授权说明，请参阅 MCFLicense.txt。
+// Copyleft 2013 - 2018, LH_Mouse. All wrongs reserved.
+
+#ifndef __MCFCRT_ENV_PARK_NATIVE_H_
+#define __MCFCRT_ENV_PARK_NATIVE_H_
+
+#include "_crtdef.h"
+
+_MCFCRT_EXTERN_C_BEGIN
+
+// These functions are what `_park.c` needs from the operating system.
+// The Windows implementation in `_park_nt.c` is backed by `NtWaitForKeyedEvent()` and `NtReleaseKeyedEvent()`.
+// There is also a Linux implementation in `_park_futex.c` backed by `futex()`, which is not a part of the CRT but allows the lock algorithms to be built and tested natively.
+
+// A sleep word shall be initialized to zero. It belongs to a single thread that sleeps on it, and is woken up exactly once by another thread.
+// `__MCFCRT_ParkNativeWake()` may block until the thread goes to sleep. If the thread has timed out, it shall sleep again without a timeout to consume the wakeup.
+extern bool __MCFCRT_ParkNativeSleep(volatile int *__pnWord, bool __bMayTimeOut, _MCFCRT_STD uint64_t __u64UntilFastMonoClock) _MCFCRT_NOEXCEPT;
+extern void __MCFCRT_ParkNativeWake(volatile int *__pnWord) _MCFCRT_NOEXCEPT;
+
+// A lock word shall be initialized to zero. Locks are not recursive and are held for very short periods.
+extern void __MCFCRT_ParkNativeLock(volatile int *__pnLock) _MCFCRT_NOEXCEPT;
+extern void __MCFCRT_ParkNativeUnlock(volatile int *__pnLock) _MCFCRT_NOEXCEPT;
+
+extern bool __MCFCRT_ParkNativeIsShuttingDown(void) _MCFCRT_NOEXCEPT;
+
+_MCFCRT_EXTERN_C_END
+
+#endif
@@ -0,0 +1,94 @@
+// 这个文件是 MCF 的一部分。
+// 有关具体授权说明，请参阅 MCFLicense.txt。
+// Copyleft 2013 - 2018, LH_Mouse. All wrongs reserved.
+
+#include "_park_native.h"
+#include "_nt_timeout.h"
+#include "xassert.h"
+#include "expect.h"
+#include <ntdef.h>
+
+__attribute__((__dllimport__, __stdcall__))
+extern NTSTATUS NtWaitForKeyedEvent(HANDLE hKeyedEvent, void *pKey, BOOLEAN bAlertable, const LARGE_INTEGER *pliTimeout);
+__attribute__((__dllimport__, __stdcall__))
+extern NTSTATUS NtReleaseKeyedEvent(HANDLE hKeyedEvent, void *pKey, BOOLEAN bAlertable, const LARGE_INTEGER *pliTimeout);
+
+__attribute__((__dllimport__, __stdcall__, __const__))
+extern BOOLEAN RtlDllShutdownInProgress(void);
+
+// Sleep words are used as keys. The keyed event makes `NtReleaseKeyedEvent()` block until the sleeping thread arrives.
+bool __MCFCRT_ParkNativeSleep(volatile int *pnWord, bool bMayTimeOut, uint64_t u64UntilFastMonoClock){
+	if(bMayTimeOut){
+		LARGE_INTEGER liTimeout;
+		__MCFCRT_InitializeNtTimeout(&liTimeout, u64UntilFastMonoClock);
+		const NTSTATUS lStatus = NtWaitForKeyedEvent(_MCFCRT_NULLPTR, (void *)pnWord, false, &liTimeout);
+		_MCFCRT_ASSERT_MSG(NT_SUCCESS(lStatus), L"NtWaitForKeyedEvent() 失败。");
+		return lStatus != STATUS_TIMEOUT;
+	}
+	const NTSTATUS lStatus = NtWaitForKeyedEvent(_MCFCRT_NULLPTR, (void *)pnWord, false, _MCFCRT_NULLPTR);
+	_MCFCRT_ASSERT_MSG(NT_SUCCESS(lStatus), L"NtWaitForKeyedEvent() 失败。");
+	_MCFCRT_ASSERT(lStatus != STATUS_TIMEOUT);
+	return true;
+}
+void __MCFCRT_ParkNativeWake(volatile int *pnWord){
+	const NTSTATUS lStatus = NtReleaseKeyedEvent(_MCFCRT_NULLPTR, (void *)pnWord, false, _MCFCRT_NULLPTR);
+	_MCFCRT_ASSERT_MSG(NT_SUCCESS(lStatus), L"NtReleaseKeyedEvent() 失败。");
+	_MCFCRT_ASSERT(lStatus != STATUS_TIMEOUT);
+}
+
+// The lowest bit of a lock word is the lock bit. The other bits are the number of threads waiting on the keyed event.
+// Threads that have been woken up have to compete for the lock again.
+#define LOCK_MASK_LOCKED            1
+#define LOCK_THREADS_TRAPPED_ONE    2
+
+#define LOCK_SPIN_COUNT             100u
+
+void __MCFCRT_ParkNativeLock(volatile int *pnLock){
+	for(;;){
+		for(unsigned uSpinIndex = 0; _MCFCRT_EXPECT(uSpinIndex < LOCK_SPIN_COUNT); ++uSpinIndex){
+			int nOld = __atomic_load_n(pnLock, __ATOMIC_RELAXED);
+			if(_MCFCRT_EXPECT(!(nOld & LOCK_MASK_LOCKED) && __atomic_compare_exchange_n(pnLock, &nOld, nOld | LOCK_MASK_LOCKED, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))){
+				return;
+			}
+			__builtin_ia32_pause();
+		}
+		bool bTaken;
+		{
+			int nOld, nNew;
+			nOld = __atomic_load_n(pnLock, __ATOMIC_RELAXED);
+			do {
+				bTaken = !(nOld & LOCK_MASK_LOCKED);
+				if(!bTaken){
+					nNew = nOld + LOCK_THREADS_TRAPPED_ONE;
+				} else {
+					nNew = nOld | LOCK_MASK_LOCKED;
+				}
+			} while(_MCFCRT_EXPECT_NOT(!__atomic_compare_exchange_n(pnLock, &nOld, nNew, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)));
+		}
+		if(_MCFCRT_EXPECT(bTaken)){
+			return;
+		}
+		const NTSTATUS lStatus = NtWaitForKeyedEvent(_MCFCRT_NULLPTR, (void *)pnLock, false, _MCFCRT_NULLPTR);
+		_MCFCRT_ASSERT_MSG(NT_SUCCESS(lStatus), L"NtWaitForKeyedEvent() 失败。");
+	}
+}
+void __MCFCRT_ParkNativeUnlock(volatile int *pnLock){
+	bool bSignalOne;
+	{
+		int nOld, nNew;
+		nOld = __atomic_load_n(pnLock, __ATOMIC_RELAXED);
+		do {
+			_MCFCRT_ASSERT(nOld & LOCK_MASK_LOCKED);
+			bSignalOne = nOld >= LOCK_THREADS_TRAPPED_ONE;
+			nNew = (nOld & ~LOCK_MASK_LOCKED) - bSignalOne * LOCK_THREADS_TRAPPED_ONE;
+		} while(_MCFCRT_EXPECT_NOT(!__atomic_compare_exchange_n(pnLock, &nOld, nNew, false, __ATOMIC_RELEASE, __ATOMIC_RELAXED)));
+	}
+	if(_MCFCRT_EXPECT_NOT(bSignalOne)){
+		const NTSTATUS lStatus = NtReleaseKeyedEvent(_MCFCRT_NULLPTR, (void *)pnLock, false, _MCFCRT_NULLPTR);
+		_MCFCRT_ASSERT_MSG(NT_SUCCESS(lStatus), L"NtReleaseKeyedEvent() 失败。");
+	}
+}
+
+bool __MCFCRT_ParkNativeIsShuttingDown(void){
+	return RtlDllShutdownInProgress();
+}
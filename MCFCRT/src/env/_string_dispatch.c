@@ -0,0 +1,170 @@
+// 这个文件是 MCF 的一部分。
+// 有关具体授权说明，请参阅 MCFLicense.txt。
+// Copyleft 2013 - 2018, LH_Mouse. All wrongs reserved.
+
+#include "_string_dispatch.h"
+#include "cpu.h"
+#include "expect.h"
+#include "mcfwin.h"
+
+#define TABLE_FOR_(isa_)	\
+	{	\
+		.__memcpy      = &__MCFCRT_memcpy_##isa_,	\
+		.__memmove     = &__MCFCRT_memmove_##isa_,	\
+		.__memset32    = &__MCFCRT_memset32_##isa_,	\
+		.__memcmp      = &__MCFCRT_memcmp_##isa_,	\
+		.__memeq       = &__MCFCRT_memeq_##isa_,	\
+		.__memmismatch = &__MCFCRT_memmismatch_##isa_,	\
+		.__memchr      = &__MCFCRT_memchr_##isa_,	\
+		.__rawmemchr   = &__MCFCRT_rawmemchr_##isa_,	\
+		.__memrchr     = &__MCFCRT_memrchr_##isa_,	\
+		.__memmem      = &__MCFCRT_memmem_##isa_,	\
+		.__strlen      = &__MCFCRT_strlen_##isa_,	\
+		.__strnlen     = &__MCFCRT_strnlen_##isa_,	\
+		.__strchr      = &__MCFCRT_strchr_##isa_,	\
+		.__strrchr     = &__MCFCRT_strrchr_##isa_,	\
+		.__strcmp      = &__MCFCRT_strcmp_##isa_,	\
+		.__strncmp     = &__MCFCRT_strncmp_##isa_,	\
+		.__strmismatch = &__MCFCRT_strmismatch_##isa_,	\
+		.__strstr      = &__MCFCRT_strstr_##isa_,	\
+		.__wmemcmp     = &__MCFCRT_wmemcmp_##isa_,	\
+		.__wmemchr     = &__MCFCRT_wmemchr_##isa_,	\
+		.__rawwmemchr  = &__MCFCRT_rawwmemchr_##isa_,	\
+		.__wmemmem     = &__MCFCRT_wmemmem_##isa_,	\
+		.__wcslen      = &__MCFCRT_wcslen_##isa_,	\
+		.__wcschr      = &__MCFCRT_wcschr_##isa_,	\
+		.__wcsrchr     = &__MCFCRT_wcsrchr_##isa_,	\
+		.__wcscmp      = &__MCFCRT_wcscmp_##isa_,	\
+		.__wcsncmp     = &__MCFCRT_wcsncmp_##isa_,	\
+		.__wcsmismatch = &__MCFCRT_wcsmismatch_##isa_,	\
+		.__wcsstr      = &__MCFCRT_wcsstr_##isa_,	\
+	}
+
+static const __MCFCRT_StringDispatchTable g_tables[__MCFCRT_kStringIsaEnd] = {
+	[__MCFCRT_kStringIsaSse2]   = TABLE_FOR_(sse2),
+	[__MCFCRT_kStringIsaAvx2]   = TABLE_FOR_(avx2),
+	[__MCFCRT_kStringIsaAvx512] = TABLE_FOR_(avx512),
+};
+
+static const wchar_t *const g_isa_names[__MCFCRT_kStringIsaEnd] = {
+	[__MCFCRT_kStringIsaSse2]   = L"sse2",
+	[__MCFCRT_kStringIsaAvx2]   = L"avx2",
+	[__MCFCRT_kStringIsaAvx512] = L"avx512",
+};
+
+// Functions may be called before the CRT is initialized, so this table must be usable without any initialization.
+__MCFCRT_StringDispatchTable __MCFCRT_string_dispatch_table = TABLE_FOR_(sse2);
+
+static __MCFCRT_StringIsa g_isa = __MCFCRT_kStringIsaSse2;
+
+static bool IsIsaSupported(__MCFCRT_StringIsa isa){
+	switch(isa){
+	case __MCFCRT_kStringIsaAvx512:
+		if(!_MCFCRT_CpuHasFeature(_MCFCRT_kCpuFeatureAvx512f) || !_MCFCRT_CpuHasFeature(_MCFCRT_kCpuFeatureAvx512bw) ||
+		   !_MCFCRT_CpuHasFeature(_MCFCRT_kCpuFeatureAvx512dq) || !_MCFCRT_CpuHasFeature(_MCFCRT_kCpuFeatureAvx512vl))
+		{
+			return false;
+		}
+		// Fallthrough.
+	case __MCFCRT_kStringIsaAvx2:
+		if(!_MCFCRT_CpuHasFeature(_MCFCRT_kCpuFeatureAvx2) || !_MCFCRT_CpuHasFeature(_MCFCRT_kCpuFeatureBmi1) ||
+		   !_MCFCRT_CpuHasFeature(_MCFCRT_kCpuFeatureBmi2) || !_MCFCRT_CpuHasFeature(_MCFCRT_kCpuFeatureLzcnt) ||
+		   !_MCFCRT_CpuHasFeature(_MCFCRT_kCpuFeaturePopcnt))
+		{
+			return false;
+		}
+		// Fallthrough.
+	case __MCFCRT_kStringIsaSse2:
+		return true;
+	default:
+		return false;
+	}
+}
+
+static void InstallTable(__MCFCRT_StringIsa isa){
+	const __MCFCRT_StringDispatchTable *const table = g_tables + isa;
+	__MCFCRT_StringDispatchTable *const live = &__MCFCRT_string_dispatch_table;
+	// Store pointers one by one. Do not let the compiler turn this into a call to `memcpy()`.
+#define INSTALL_(field_)	\
+	__atomic_store_n(&(live->field_), table->field_, __ATOMIC_RELAXED)
+	INSTALL_(__memcpy);
+	INSTALL_(__memmove);
+	INSTALL_(__memset32);
+	INSTALL_(__memcmp);
+	INSTALL_(__memeq);
+	INSTALL_(__memmismatch);
+	INSTALL_(__memchr);
+	INSTALL_(__rawmemchr);
+	INSTALL_(__memrchr);
+	INSTALL_(__memmem);
+	INSTALL_(__strlen);
+	INSTALL_(__strnlen);
+	INSTALL_(__strchr);
+	INSTALL_(__strrchr);
+	INSTALL_(__strcmp);
+	INSTALL_(__strncmp);
+	INSTALL_(__strmismatch);
+	INSTALL_(__strstr);
+	INSTALL_(__wmemcmp);
+	INSTALL_(__wmemchr);
+	INSTALL_(__rawwmemchr);
+	INSTALL_(__wmemmem);
+	INSTALL_(__wcslen);
+	INSTALL_(__wcschr);
+	INSTALL_(__wcsrchr);
+	INSTALL_(__wcscmp);
+	INSTALL_(__wcsncmp);
+	INSTALL_(__wcsmismatch);
+	INSTALL_(__wcsstr);
+#undef INSTALL_
+	__atomic_store_n(&g_isa, isa, __ATOMIC_RELAXED);
+}
+
+static bool AreNamesEqual(const wchar_t *s1, const wchar_t *s2){
+	for(;;){
+		if(*s1 != *s2){
+			return false;
+		}
+		if(*s1 == 0){
+			return true;
+		}
+		++s1;
+		++s2;
+	}
+}
+
+bool __MCFCRT_StringDispatchInit(void){
+	__MCFCRT_StringIsa isa = __MCFCRT_kStringIsaSse2;
+	for(unsigned i = __MCFCRT_kStringIsaEnd - 1; i > __MCFCRT_kStringIsaSse2; --i){
+		if(IsIsaSupported((__MCFCRT_StringIsa)i)){
+			isa = (__MCFCRT_StringIsa)i;
+			break;
+		}
+	}
+	// Allow users to select a lower instruction set for benchmarking.
+	wchar_t name[16];
+	const DWORD length = GetEnvironmentVariableW(L"MCFCRT_ISA", name, sizeof(name) / sizeof(name[0]));
+	if((length != 0) && (length < sizeof(name) / sizeof(name[0]))){
+		for(unsigned i = __MCFCRT_kStringIsaSse2; i < __MCFCRT_kStringIsaEnd; ++i){
+			if(AreNamesEqual(name, g_isa_names[i])){
+				if(IsIsaSupported((__MCFCRT_StringIsa)i)){
+					isa = (__MCFCRT_StringIsa)i;
+				}
+				break;
+			}
+		}
+	}
+	InstallTable(isa);
+	return true;
+}
+
+__MCFCRT_StringIsa __MCFCRT_StringDispatchGetIsa(void){
+	return __atomic_load_n(&g_isa, __ATOMIC_RELAXED);
+}
+bool __MCFCRT_StringDispatchSetIsa(__MCFCRT_StringIsa isa){
+	if(_MCFCRT_EXPECT_NOT(!IsIsaSupported(isa))){
+		return false;
+	}
+	InstallTable(isa);
+	return true;
+}
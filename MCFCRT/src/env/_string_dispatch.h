@@ -0,0 +1,109 @@
+// 这个文件是 MCF 的一部分。
+// 有关具体授权说明，请参阅 MCFLicense.txt。
+// Copyleft 2013 - 2018, LH_Mouse. All wrongs reserved.
+
+#ifndef __MCFCRT_ENV_STRING_DISPATCH_H_
+#define __MCFCRT_ENV_STRING_DISPATCH_H_
+
+#include "_crtdef.h"
+
+_MCFCRT_EXTERN_C_BEGIN
+
+// The library is compiled for `-march=core2`, so every hot string function is compiled once more for each of the instruction
+// sets below using target attributes. The public functions jump through `__MCFCRT_string_dispatch_table`, which is filled
+// with the SSE2 implementations statically (so they can be called before the CRT is initialized) and replaced with the best
+// ones that the CPU supports during CRT initialization.
+// The environment variable `MCFCRT_ISA` can be set to `sse2`, `avx2` or `avx512` to select a lower instruction set for
+// benchmarking. Instruction sets that the CPU does not support are ignored.
+
+typedef enum __MCFCRT_tagStringIsa {
+	__MCFCRT_kStringIsaSse2   = 0, // SSE2, SSSE3
+	__MCFCRT_kStringIsaAvx2   = 1, // AVX2, BMI1, BMI2, LZCNT, POPCNT
+	__MCFCRT_kStringIsaAvx512 = 2, // AVX-512 F, BW, DQ, VL
+	__MCFCRT_kStringIsaEnd    = 3,
+} __MCFCRT_StringIsa;
+
+#define __MCFCRT_STRING_TARGET_AVX2       __attribute__((__target__("avx2,bmi,bmi2,lzcnt,popcnt")))
+#define __MCFCRT_STRING_TARGET_AVX512     __attribute__((__target__("avx2,bmi,bmi2,lzcnt,popcnt,avx512f,avx512bw,avx512dq,avx512vl")))
+
+typedef struct __MCFCRT_tagStringDispatchTable {
+	void *(*__memcpy)(void *_MCFCRT_RESTRICT __s1, const void *_MCFCRT_RESTRICT __s2, _MCFCRT_STD size_t __n);
+	void *(*__memmove)(void *__s1, const void *__s2, _MCFCRT_STD size_t __n);
+	void *(*__memset32)(void *__s, _MCFCRT_STD uint32_t __c32, _MCFCRT_STD size_t __n);
+	int (*__memcmp)(const void *__s1, const void *__s2, _MCFCRT_STD size_t __n);
+	bool (*__memeq)(const void *__s1, const void *__s2, _MCFCRT_STD size_t __n);
+	_MCFCRT_STD size_t (*__memmismatch)(const void *__s1, const void *__s2, _MCFCRT_STD size_t __n);
+	void *(*__memchr)(const void *__s, int __c, _MCFCRT_STD size_t __n);
+	void *(*__rawmemchr)(const void *__s, int __c);
+	void *(*__memrchr)(const void *__s, int __c, _MCFCRT_STD size_t __n);
+	void *(*__memmem)(const void *__s1, _MCFCRT_STD size_t __n1, const void *__s2, _MCFCRT_STD size_t __n2);
+	_MCFCRT_STD size_t (*__strlen)(const char *__s);
+	_MCFCRT_STD size_t (*__strnlen)(const char *__s, _MCFCRT_STD size_t __n);
+	char *(*__strchr)(const char *__s, int __c);
+	char *(*__strrchr)(const char *__s, int __c);
+	int (*__strcmp)(const char *__s1, const char *__s2);
+	int (*__strncmp)(const char *__s1, const char *__s2, _MCFCRT_STD size_t __n);
+	_MCFCRT_STD size_t (*__strmismatch)(const char *__s1, const char *__s2);
+	char *(*__strstr)(const char *__s1, const char *__s2);
+	int (*__wmemcmp)(const wchar_t *__s1, const wchar_t *__s2, _MCFCRT_STD size_t __n);
+	wchar_t *(*__wmemchr)(const wchar_t *__s, wchar_t __c, _MCFCRT_STD size_t __n);
+	wchar_t *(*__rawwmemchr)(const wchar_t *__s, wchar_t __c);
+	wchar_t *(*__wmemmem)(const wchar_t *__s1, _MCFCRT_STD size_t __n1, const wchar_t *__s2, _MCFCRT_STD size_t __n2);
+	_MCFCRT_STD size_t (*__wcslen)(const wchar_t *__s);
+	wchar_t *(*__wcschr)(const wchar_t *__s, wchar_t __c);
+	wchar_t *(*__wcsrchr)(const wchar_t *__s, wchar_t __c);
+	int (*__wcscmp)(const wchar_t *__s1, const wchar_t *__s2);
+	int (*__wcsncmp)(const wchar_t *__s1, const wchar_t *__s2, _MCFCRT_STD size_t __n);
+	_MCFCRT_STD size_t (*__wcsmismatch)(const wchar_t *__s1, const wchar_t *__s2);
+	wchar_t *(*__wcsstr)(const wchar_t *__s1, const wchar_t *__s2);
+} __MCFCRT_StringDispatchTable;
+
+extern __MCFCRT_StringDispatchTable __MCFCRT_string_dispatch_table;
+
+extern bool __MCFCRT_StringDispatchInit(void) _MCFCRT_NOEXCEPT;
+
+extern __MCFCRT_StringIsa __MCFCRT_StringDispatchGetIsa(void) _MCFCRT_NOEXCEPT;
+// Returns `false` if the CPU does not support `__eIsa`, in which case the table is left intact.
+// The table can be switched while other threads are calling string functions, since all implementations are equivalent.
+extern bool __MCFCRT_StringDispatchSetIsa(__MCFCRT_StringIsa __eIsa) _MCFCRT_NOEXCEPT;
+
+#define __MCFCRT_STRING_DECLARE_ISA_(isa_)	\
+	extern void *__MCFCRT_memcpy_##isa_(void *_MCFCRT_RESTRICT __s1, const void *_MCFCRT_RESTRICT __s2, _MCFCRT_STD size_t __n) _MCFCRT_NOEXCEPT;	\
+	extern void *__MCFCRT_memmove_##isa_(void *__s1, const void *__s2, _MCFCRT_STD size_t __n) _MCFCRT_NOEXCEPT;	\
+	extern void *__MCFCRT_memset32_##isa_(void *__s, _MCFCRT_STD uint32_t __c32, _MCFCRT_STD size_t __n) _MCFCRT_NOEXCEPT;	\
+	extern int __MCFCRT_memcmp_##isa_(const void *__s1, const void *__s2, _MCFCRT_STD size_t __n) _MCFCRT_NOEXCEPT;	\
+	extern bool __MCFCRT_memeq_##isa_(const void *__s1, const void *__s2, _MCFCRT_STD size_t __n) _MCFCRT_NOEXCEPT;	\
+	extern _MCFCRT_STD size_t __MCFCRT_memmismatch_##isa_(const void *__s1, const void *__s2, _MCFCRT_STD size_t __n) _MCFCRT_NOEXCEPT;	\
+	extern void *__MCFCRT_memchr_##isa_(const void *__s, int __c, _MCFCRT_STD size_t __n) _MCFCRT_NOEXCEPT;	\
+	extern void *__MCFCRT_rawmemchr_##isa_(const void *__s, int __c) _MCFCRT_NOEXCEPT;	\
+	extern void *__MCFCRT_memrchr_##isa_(const void *__s, int __c, _MCFCRT_STD size_t __n) _MCFCRT_NOEXCEPT;	\
+	extern void *__MCFCRT_memmem_##isa_(const void *__s1, _MCFCRT_STD size_t __n1, const void *__s2, _MCFCRT_STD size_t __n2) _MCFCRT_NOEXCEPT;	\
+	extern _MCFCRT_STD size_t __MCFCRT_strlen_##isa_(const char *__s) _MCFCRT_NOEXCEPT;	\
+	extern _MCFCRT_STD size_t __MCFCRT_strnlen_##isa_(const char *__s, _MCFCRT_STD size_t __n) _MCFCRT_NOEXCEPT;	\
+	extern char *__MCFCRT_strchr_##isa_(const char *__s, int __c) _MCFCRT_NOEXCEPT;	\
+	extern char *__MCFCRT_strrchr_##isa_(const char *__s, int __c) _MCFCRT_NOEXCEPT;	\
+	extern int __MCFCRT_strcmp_##isa_(const char *__s1, const char *__s2) _MCFCRT_NOEXCEPT;	\
+	extern int __MCFCRT_strncmp_##isa_(const char *__s1, const char *__s2, _MCFCRT_STD size_t __n) _MCFCRT_NOEXCEPT;	\
+	extern _MCFCRT_STD size_t __MCFCRT_strmismatch_##isa_(const char *__s1, const char *__s2) _MCFCRT_NOEXCEPT;	\
+	extern char *__MCFCRT_strstr_##isa_(const char *__s1, const char *__s2) _MCFCRT_NOEXCEPT;	\
+	extern int __MCFCRT_wmemcmp_##isa_(const wchar_t *__s1, const wchar_t *__s2, _MCFCRT_STD size_t __n) _MCFCRT_NOEXCEPT;	\
+	extern wchar_t *__MCFCRT_wmemchr_##isa_(const wchar_t *__s, wchar_t __c, _MCFCRT_STD size_t __n) _MCFCRT_NOEXCEPT;	\
+	extern wchar_t *__MCFCRT_rawwmemchr_##isa_(const wchar_t *__s, wchar_t __c) _MCFCRT_NOEXCEPT;	\
+	extern wchar_t *__MCFCRT_wmemmem_##isa_(const wchar_t *__s1, _MCFCRT_STD size_t __n1, const wchar_t *__s2, _MCFCRT_STD size_t __n2) _MCFCRT_NOEXCEPT;	\
+	extern _MCFCRT_STD size_t __MCFCRT_wcslen_##isa_(const wchar_t *__s) _MCFCRT_NOEXCEPT;	\
+	extern wchar_t *__MCFCRT_wcschr_##isa_(const wchar_t *__s, wchar_t __c) _MCFCRT_NOEXCEPT;	\
+	extern wchar_t *__MCFCRT_wcsrchr_##isa_(const wchar_t *__s, wchar_t __c) _MCFCRT_NOEXCEPT;	\
+	extern int __MCFCRT_wcscmp_##isa_(const wchar_t *__s1, const wchar_t *__s2) _MCFCRT_NOEXCEPT;	\
+	extern int __MCFCRT_wcsncmp_##isa_(const wchar_t *__s1, const wchar_t *__s2, _MCFCRT_STD size_t __n) _MCFCRT_NOEXCEPT;	\
+	extern _MCFCRT_STD size_t __MCFCRT_wcsmismatch_##isa_(const wchar_t *__s1, const wchar_t *__s2) _MCFCRT_NOEXCEPT;	\
+	extern wchar_t *__MCFCRT_wcsstr_##isa_(const wchar_t *__s1, const wchar_t *__s2) _MCFCRT_NOEXCEPT;
+
+__MCFCRT_STRING_DECLARE_ISA_(sse2)
+__MCFCRT_STRING_DECLARE_ISA_(avx2)
+__MCFCRT_STRING_DECLARE_ISA_(avx512)
+
+#undef __MCFCRT_STRING_DECLARE_ISA_
+
+_MCFCRT_EXTERN_C_END
+
+#endif
@@ -4,14 +4,17 @@
 
 #include "_tls_common.h"
 #include "mutex.h"
-#include "avl_tree.h"
 #include "heap.h"
 #include "inline_mem.h"
+#include "xassert.h"
 #include "expect.h"
 #include <winerror.h>
 
+// Every key is given a dense index, which is used to index the slot array of a thread directly. Indices of freed keys are recycled.
+// Every key is also given a unique counter, which is stored in slots along with storage, so slots that were filled for freed keys are never matched by new keys that reuse their indices.
 typedef struct tagTlsKey {
 	uintptr_t uCounter;
+	size_t uIndex;
 
 	size_t uSize;
 	_MCFCRT_TlsConstructor pfnConstructor;
@@ -19,6 +22,60 @@ typedef struct tagTlsKey {
 	intptr_t nContext;
 } TlsKey;
 
+static _MCFCRT_Mutex g_mtxKeyIndexPool          = { 0 };
+static size_t        g_uKeyIndexCount           = 0;
+// The capacity of this array is never less than `g_uKeyIndexCount`, so pushing an index never fails.
+static size_t *      g_puFreeKeyIndices         = _MCFCRT_NULLPTR;
+static size_t        g_uFreeKeyIndexCount       = 0;
+static size_t        g_uFreeKeyIndexCapacity    = 0;
+
+static bool AllocKeyIndex(size_t *puIndex){
+	bool bSucceeded = false;
+	_MCFCRT_WaitForMutexForever(&g_mtxKeyIndexPool, _MCFCRT_MUTEX_SUGGESTED_SPIN_COUNT);
+	{
+		if(g_uFreeKeyIndexCount != 0){
+			*puIndex = g_puFreeKeyIndices[--g_uFreeKeyIndexCount];
+			bSucceeded = true;
+			goto jDone;
+		}
+		if(g_uKeyIndexCount >= g_uFreeKeyIndexCapacity){
+			const size_t uNewCapacity = g_uFreeKeyIndexCapacity * 2 + 64;
+			if(uNewCapacity > SIZE_MAX / sizeof(size_t)){
+				goto jDone;
+			}
+			size_t *const puNewIndices = _MCFCRT_realloc(g_puFreeKeyIndices, uNewCapacity * sizeof(size_t));
+			if(!puNewIndices){
+				goto jDone;
+			}
+			g_puFreeKeyIndices = puNewIndices;
+			g_uFreeKeyIndexCapacity = uNewCapacity;
+		}
+		*puIndex = g_uKeyIndexCount++;
+		bSucceeded = true;
+	}
+jDone:
+	_MCFCRT_SignalMutex(&g_mtxKeyIndexPool);
+	return bSucceeded;
+}
+static void FreeKeyIndex(size_t uIndex){
+	size_t *puIndicesToFree = _MCFCRT_NULLPTR;
+	_MCFCRT_WaitForMutexForever(&g_mtxKeyIndexPool, _MCFCRT_MUTEX_SUGGESTED_SPIN_COUNT);
+	{
+		_MCFCRT_ASSERT(g_uFreeKeyIndexCount < g_uKeyIndexCount);
+		g_puFreeKeyIndices[g_uFreeKeyIndexCount++] = uIndex;
+		// Release the pool once all keys have been freed, so it isn't reported as a leak.
+		if(g_uFreeKeyIndexCount == g_uKeyIndexCount){
+			puIndicesToFree = g_puFreeKeyIndices;
+			g_uKeyIndexCount = 0;
+			g_puFreeKeyIndices = _MCFCRT_NULLPTR;
+			g_uFreeKeyIndexCount = 0;
+			g_uFreeKeyIndexCapacity = 0;
+		}
+	}
+	_MCFCRT_SignalMutex(&g_mtxKeyIndexPool);
+	_MCFCRT_free(puIndicesToFree);
+}
+
 _MCFCRT_TlsKeyHandle _MCFCRT_TlsAllocKey(size_t uSize, _MCFCRT_TlsConstructor pfnConstructor, _MCFCRT_TlsDestructor pfnDestructor, intptr_t nContext){
 	static volatile size_t s_uKeyCounter;
 
@@ -26,6 +83,10 @@ _MCFCRT_TlsKeyHandle _MCFCRT_TlsAllocKey(size_t uSize, _MCFCRT_TlsConstructor pf
 	if(!pKey){
 		return _MCFCRT_NULLPTR;
 	}
+	if(!AllocKeyIndex(&(pKey->uIndex))){
+		_MCFCRT_free(pKey);
+		return _MCFCRT_NULLPTR;
+	}
 	pKey->uCounter       = __atomic_add_fetch(&s_uKeyCounter, 1, __ATOMIC_RELAXED);
 	pKey->uSize          = uSize;
 	pKey->pfnConstructor = pfnConstructor;
@@ -40,6 +101,7 @@ void _MCFCRT_TlsFreeKey(_MCFCRT_TlsKeyHandle hTlsKey){
 		return;
 	}
 
+	FreeKeyIndex(pKey->uIndex);
 	_MCFCRT_free(pKey);
 }
 
@@ -60,54 +122,111 @@ intptr_t _MCFCRT_TlsGetContext(_MCFCRT_TlsKeyHandle hTlsKey){
 	return pKey->nContext;
 }
 
-typedef struct tagTlsObjectKey {
-	struct tagTlsKey *pKey;
-	uintptr_t uCounter;
-} TlsObjectKey;
+// Small objects are packed into chunks, which are aligned to cache lines and belong to a single thread, so objects of different threads never share a cache line.
+// The first chunk is the rest of the block of the thread map itself. Chunks are freed all at once when the thread map is destroyed.
+// Large objects are allocated separately, with their sizes rounded up to multiples of cache lines.
+#define CHUNK_SIZE            4096u
+#define MAX_SIZE_IN_CHUNK     (CHUNK_SIZE / 2)
 
 typedef struct tagTlsObject {
-	_MCFCRT_AvlNodeHeader avlhNodeByKey;
-
 	_MCFCRT_TlsDestructor pfnDestructor;
 	intptr_t nContext;
 
 	struct tagTlsObject *pPrev; // By thread
 	struct tagTlsObject *pNext; // By thread
-	struct tagTlsObjectKey vObjectKey;
+	bool bInChunk;
 
-	unsigned char abyPaddingToAvoidFalseSharing[_MCFCRT_CACHE_LINE_SIZE - alignof(max_align_t)]; // This member is never written into.
 	alignas(max_align_t) unsigned char abyStorage[];
 } TlsObject;
 
-static inline int TlsObjectComparatorNodeKey(const _MCFCRT_AvlNodeHeader *pObjSelf, intptr_t nKeyOther){
-	const TlsObjectKey *const pIndexSelf = &(((const TlsObject *)pObjSelf)->vObjectKey);
-	const TlsObjectKey *const pIndexOther = (const TlsObjectKey *)nKeyOther;
-	if(pIndexSelf->pKey != pIndexOther->pKey){
-		return (pIndexSelf->pKey < pIndexOther->pKey) ? -1 : 1;
-	}
-	if(pIndexSelf->uCounter != pIndexOther->uCounter){
-		return (pIndexSelf->uCounter < pIndexOther->uCounter) ? -1 : 1;
-	}
-	return 0;
-}
-static inline int TlsObjectComparatorNodes(const _MCFCRT_AvlNodeHeader *pObjSelf, const _MCFCRT_AvlNodeHeader *pObjOther){
-	return TlsObjectComparatorNodeKey(pObjSelf, (intptr_t)&((const TlsObject *)pObjOther)->vObjectKey);
-}
+typedef struct tagTlsChunk {
+	struct tagTlsChunk *pNext;
+
+	alignas(max_align_t) unsigned char abyData[];
+} TlsChunk;
+
+// A slot whose counter is zero is empty. Objects of freed keys are not removed from slots, but they are no longer matched.
+typedef struct tagTlsSlot {
+	uintptr_t uCounter;
+	void *pStorage;
+} TlsSlot;
+
+#define MIN_SLOT_COUNT        16u
 
 typedef struct tagTlsThreadMap {
-	_MCFCRT_AvlRoot avlObjects;
+	struct tagTlsSlot *pSlots;
+	size_t uSlotCount;
 	struct tagTlsObject *pLast; // By thread
 	struct tagTlsObject *pFirst; // By thread
+
+	struct tagTlsChunk *pChunks; // Not including the first one
+	unsigned char *pbyChunkFree;
+	unsigned char *pbyChunkEnd;
+
+	alignas(max_align_t) unsigned char abyFirstChunk[];
 } TlsThreadMap;
 
+_Static_assert(sizeof(TlsThreadMap) + MAX_SIZE_IN_CHUNK <= CHUNK_SIZE, "The first chunk is too small.");
+
+static TlsObject *AllocObject(TlsThreadMap *pThreadMap, size_t uSize){
+	const size_t uSizeToAlloc = sizeof(TlsObject) + uSize;
+	if(uSizeToAlloc < sizeof(TlsObject)){
+		return _MCFCRT_NULLPTR;
+	}
+	TlsObject *pObject;
+	bool bInChunk;
+	if(uSizeToAlloc <= MAX_SIZE_IN_CHUNK){
+		const size_t uSizeInChunk = (uSizeToAlloc + alignof(max_align_t) - 1) & ~(alignof(max_align_t) - 1);
+		if((size_t)(pThreadMap->pbyChunkEnd - pThreadMap->pbyChunkFree) < uSizeInChunk){
+			TlsChunk *const pChunk = _MCFCRT_aligned_alloc(_MCFCRT_CACHE_LINE_SIZE, CHUNK_SIZE);
+			if(!pChunk){
+				return _MCFCRT_NULLPTR;
+			}
+			pChunk->pNext = pThreadMap->pChunks;
+			pThreadMap->pChunks      = pChunk;
+			pThreadMap->pbyChunkFree = pChunk->abyData;
+			pThreadMap->pbyChunkEnd  = (unsigned char *)pChunk + CHUNK_SIZE;
+		}
+		pObject = (TlsObject *)pThreadMap->pbyChunkFree;
+		pThreadMap->pbyChunkFree += uSizeInChunk;
+		bInChunk = true;
+	} else {
+		const size_t uSizeRounded = (uSizeToAlloc + _MCFCRT_CACHE_LINE_SIZE - 1) & ~(size_t)(_MCFCRT_CACHE_LINE_SIZE - 1);
+		if(uSizeRounded < uSizeToAlloc){
+			return _MCFCRT_NULLPTR;
+		}
+		pObject = _MCFCRT_aligned_alloc(_MCFCRT_CACHE_LINE_SIZE, uSizeRounded);
+		if(!pObject){
+			return _MCFCRT_NULLPTR;
+		}
+		bInChunk = false;
+	}
+#ifndef NDEBUG
+	_MCFCRT_inline_mempset_fwd(pObject, 0xAA, sizeof(TlsObject));
+#endif
+	pObject->bInChunk = bInChunk;
+	return pObject;
+}
+// Space of objects in chunks is not reused. It is reclaimed along with the chunks.
+static void FreeObject(TlsObject *pObject){
+	if(pObject->bInChunk){
+		return;
+	}
+	_MCFCRT_free(pObject);
+}
+
 __MCFCRT_TlsThreadMapHandle __MCFCRT_InternalTlsCreateThreadMap(void){
-	TlsThreadMap *const pThreadMap = _MCFCRT_malloc(sizeof(TlsThreadMap));
+	TlsThreadMap *const pThreadMap = _MCFCRT_aligned_alloc(_MCFCRT_CACHE_LINE_SIZE, CHUNK_SIZE);
 	if(!pThreadMap){
 		return _MCFCRT_NULLPTR;
 	}
-	pThreadMap->avlObjects = _MCFCRT_NULLPTR;
-	pThreadMap->pLast      = _MCFCRT_NULLPTR;
-	pThreadMap->pFirst     = _MCFCRT_NULLPTR;
+	pThreadMap->pSlots       = _MCFCRT_NULLPTR;
+	pThreadMap->uSlotCount   = 0;
+	pThreadMap->pLast        = _MCFCRT_NULLPTR;
+	pThreadMap->pFirst       = _MCFCRT_NULLPTR;
+	pThreadMap->pChunks      = _MCFCRT_NULLPTR;
+	pThreadMap->pbyChunkFree = pThreadMap->abyFirstChunk;
+	pThreadMap->pbyChunkEnd  = (unsigned char *)pThreadMap + CHUNK_SIZE;
 
 	return (__MCFCRT_TlsThreadMapHandle)pThreadMap;
 }
@@ -141,10 +260,19 @@ void __MCFCRT_InternalTlsDestroyThreadMap(__MCFCRT_TlsThreadMapHandle hThreadMap
 		if(pfnDestructor){
 			(*pfnDestructor)(pObject->nContext, pObject->abyStorage);
 		}
-		_MCFCRT_free(pObject);
+		FreeObject(pObject);
 	}
 
-	_MCFCRT_free(pThreadMap);
+	for(;;){
+		TlsChunk *const pChunk = pThreadMap->pChunks;
+		if(!pChunk){
+			break;
+		}
+		pThreadMap->pChunks = pChunk->pNext;
+		_MCFCRT_free_aligned_sized(pChunk, _MCFCRT_CACHE_LINE_SIZE, CHUNK_SIZE);
+	}
+	_MCFCRT_free(pThreadMap->pSlots);
+	_MCFCRT_free_aligned_sized(pThreadMap, _MCFCRT_CACHE_LINE_SIZE, CHUNK_SIZE);
 }
 
 unsigned long __MCFCRT_InternalTlsGet(__MCFCRT_TlsThreadMapHandle hThreadMap, _MCFCRT_TlsKeyHandle hTlsKey, void **restrict ppStorage){
@@ -153,12 +281,15 @@ unsigned long __MCFCRT_InternalTlsGet(__MCFCRT_TlsThreadMapHandle hThreadMap, _M
 	TlsKey *const pKey = (TlsKey *)hTlsKey;
 	_MCFCRT_ASSERT(pKey);
 
-	const TlsObjectKey vObjectKey = { pKey, pKey->uCounter };
-	TlsObject *pObject = (TlsObject *)_MCFCRT_AvlFind(&(pThreadMap->avlObjects), (intptr_t)&vObjectKey, &TlsObjectComparatorNodeKey);
-	if(_MCFCRT_EXPECT_NOT(!pObject)){
+	const size_t uIndex = pKey->uIndex;
+	if(_MCFCRT_EXPECT_NOT(uIndex >= pThreadMap->uSlotCount)){
 		return ERROR_NOT_FOUND;
 	}
-	*ppStorage = pObject->abyStorage;
+	const TlsSlot *const pSlot = pThreadMap->pSlots + uIndex;
+	if(_MCFCRT_EXPECT_NOT(pSlot->uCounter != pKey->uCounter)){
+		return ERROR_NOT_FOUND;
+	}
+	*ppStorage = pSlot->pStorage;
 	return 0;
 }
 unsigned long __MCFCRT_InternalTlsRequire(__MCFCRT_TlsThreadMapHandle hThreadMap, _MCFCRT_TlsKeyHandle hTlsKey, void **restrict ppStorage){
@@ -171,49 +302,69 @@ unsigned long __MCFCRT_InternalTlsRequire(__MCFCRT_TlsThreadMapHandle hThreadMap
 	*ppStorage = (void *)0xDEADBEEF;
 #endif
 
-	const TlsObjectKey vObjectKey = { pKey, pKey->uCounter };
-	TlsObject *pObject = (TlsObject *)_MCFCRT_AvlFind(&(pThreadMap->avlObjects), (intptr_t)&vObjectKey, &TlsObjectComparatorNodeKey);
-	if(_MCFCRT_EXPECT_NOT(!pObject)){
-		const size_t uSizeToAlloc = sizeof(TlsObject) + pKey->uSize;
-		if(uSizeToAlloc < sizeof(TlsObject)){
-			return ERROR_NOT_ENOUGH_MEMORY;
+	const size_t uIndex = pKey->uIndex;
+	if(_MCFCRT_EXPECT(uIndex < pThreadMap->uSlotCount)){
+		const TlsSlot *const pSlot = pThreadMap->pSlots + uIndex;
+		if(_MCFCRT_EXPECT(pSlot->uCounter == pKey->uCounter)){
+			*ppStorage = pSlot->pStorage;
+			return 0;
 		}
-		pObject = _MCFCRT_malloc(uSizeToAlloc);
-		if(!pObject){
-			return ERROR_NOT_ENOUGH_MEMORY;
+	} else {
+		// Grow the slot array before the object is constructed, so it needn't be destroyed on failure.
+		size_t uNewSlotCount = pThreadMap->uSlotCount * 2;
+		if(uNewSlotCount < MIN_SLOT_COUNT){
+			uNewSlotCount = MIN_SLOT_COUNT;
 		}
-#ifndef NDEBUG
-		_MCFCRT_inline_mempset_fwd(pObject, 0xAA, sizeof(TlsObject));
-#endif
-		_MCFCRT_inline_mempset_fwd(pObject->abyStorage, 0, pKey->uSize);
-		if(pKey->pfnConstructor){
-			const unsigned long ulErrorCode = (*(pKey->pfnConstructor))(pKey->nContext, pObject->abyStorage);
-			if(ulErrorCode != 0){
-				_MCFCRT_free(pObject);
-				return ulErrorCode;
-			}
+		if(uNewSlotCount <= uIndex){
+			uNewSlotCount = uIndex + 1;
 		}
-		pObject->pfnDestructor = pKey->pfnDestructor;
-		pObject->nContext      = pKey->nContext;
-
-		TlsObject *const pPrev = pThreadMap->pLast;
-		TlsObject *const pNext = _MCFCRT_NULLPTR;
-		if(pPrev){
-			pPrev->pNext = pObject;
-		} else {
-			pThreadMap->pFirst = pObject;
+		if(uNewSlotCount > SIZE_MAX / sizeof(TlsSlot)){
+			return ERROR_NOT_ENOUGH_MEMORY;
 		}
-		if(pNext){
-			pNext->pPrev = pObject;
-		} else {
-			pThreadMap->pLast = pObject;
+		TlsSlot *const pNewSlots = _MCFCRT_realloc(pThreadMap->pSlots, uNewSlotCount * sizeof(TlsSlot));
+		if(!pNewSlots){
+			return ERROR_NOT_ENOUGH_MEMORY;
 		}
-		pObject->pPrev = pPrev;
-		pObject->pNext = pNext;
+		memset(pNewSlots + pThreadMap->uSlotCount, 0, (uNewSlotCount - pThreadMap->uSlotCount) * sizeof(TlsSlot));
+		pThreadMap->pSlots     = pNewSlots;
+		pThreadMap->uSlotCount = uNewSlotCount;
+	}
 
-		pObject->vObjectKey = vObjectKey;
-		_MCFCRT_AvlAttach(&(pThreadMap->avlObjects), (_MCFCRT_AvlNodeHeader *)pObject, &TlsObjectComparatorNodes);
+	TlsObject *const pObject = AllocObject(pThreadMap, pKey->uSize);
+	if(!pObject){
+		return ERROR_NOT_ENOUGH_MEMORY;
+	}
+	memset(pObject->abyStorage, 0, pKey->uSize);
+	if(pKey->pfnConstructor){
+		const unsigned long ulErrorCode = (*(pKey->pfnConstructor))(pKey->nContext, pObject->abyStorage);
+		if(ulErrorCode != 0){
+			FreeObject(pObject);
+			return ulErrorCode;
+		}
+	}
+	pObject->pfnDestructor = pKey->pfnDestructor;
+	pObject->nContext      = pKey->nContext;
+
+	TlsObject *const pPrev = pThreadMap->pLast;
+	TlsObject *const pNext = _MCFCRT_NULLPTR;
+	if(pPrev){
+		pPrev->pNext = pObject;
+	} else {
+		pThreadMap->pFirst = pObject;
+	}
+	if(pNext){
+		pNext->pPrev = pObject;
+	} else {
+		pThreadMap->pLast = pObject;
 	}
+	pObject->pPrev = pPrev;
+	pObject->pNext = pNext;
+
+	// The constructor may have required other keys and reallocated the slot array.
+	TlsSlot *const pSlot = pThreadMap->pSlots + uIndex;
+	pSlot->uCounter = pKey->uCounter;
+	pSlot->pStorage = pObject->abyStorage;
+
 	*ppStorage = pObject->abyStorage;
 	return 0;
 }
@@ -249,13 +400,10 @@ unsigned long __MCFCRT_InternalAtThreadExit(__MCFCRT_TlsThreadMapHandle hThreadM
 		pBlock = (void *)pObject->abyStorage;
 	}
 	if(!pBlock || (pBlock->uSize >= CALLBACKS_PER_BLOCK)){
-		pObject = _MCFCRT_malloc(sizeof(TlsObject) + sizeof(AtExitBlock));
+		pObject = AllocObject(pThreadMap, sizeof(AtExitBlock));
 		if(!pObject){
 			return ERROR_NOT_ENOUGH_MEMORY;
 		}
-#ifndef NDEBUG
-		_MCFCRT_inline_mempset_fwd(pObject, 0xAA, sizeof(TlsObject));
-#endif
 		pBlock = (void *)pObject->abyStorage;
 		pBlock->uSize = 0;
 		pObject->pfnDestructor = &CrtAtThreadExitDestructor;
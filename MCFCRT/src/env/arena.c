@@ -0,0 +1,137 @@
+// 这个文件是 MCF 的一部分。
+// 有关具体授权说明，请参阅 MCFLicense.txt。
+// Copyleft 2013 - 2018, LH_Mouse. All wrongs reserved.
+
+#define __MCFCRT_ARENA_INLINE_OR_EXTERN     extern inline
+#include "arena.h"
+#include "heap.h"
+#include "xassert.h"
+#include "expect.h"
+
+// Chunks smaller than this are not worth the overhead.
+#define CHUNK_SIZE_MIN          ((size_t)0x400)
+// Blocks larger than a quarter of the chunk capacity get chunks of their own, so the current chunk is not wasted.
+#define LARGE_BLOCK_RATIO       4u
+
+typedef struct __MCFCRT_tagArenaChunk {
+	struct __MCFCRT_tagArenaChunk *pNext;
+	size_t uCapacity;
+	alignas(max_align_t) unsigned char abyData[];
+} Chunk;
+
+static inline size_t GetStandardCapacity(const _MCFCRT_Arena *pArena){
+	return pArena->__uChunkSize - offsetof(Chunk, abyData);
+}
+
+static Chunk *AllocChunk(size_t uCapacity){
+	size_t uSizeToAlloc;
+	if(__builtin_add_overflow(offsetof(Chunk, abyData), uCapacity, &uSizeToAlloc)){
+		return _MCFCRT_NULLPTR;
+	}
+	Chunk *const pChunk = _MCFCRT_malloc(uSizeToAlloc);
+	if(!pChunk){
+		return _MCFCRT_NULLPTR;
+	}
+	pChunk->pNext     = _MCFCRT_NULLPTR;
+	pChunk->uCapacity = uCapacity;
+	return pChunk;
+}
+static Chunk *TakeStandardChunk(_MCFCRT_Arena *pArena){
+	Chunk *const pChunk = pArena->__pSpare;
+	if(pChunk){
+		pArena->__pSpare = pChunk->pNext;
+		pChunk->pNext = _MCFCRT_NULLPTR;
+		return pChunk;
+	}
+	return AllocChunk(GetStandardCapacity(pArena));
+}
+static void FreeChunkList(Chunk *pChunk){
+	while(pChunk){
+		Chunk *const pNext = pChunk->pNext;
+		_MCFCRT_free(pChunk);
+		pChunk = pNext;
+	}
+}
+
+_MCFCRT_Arena *_MCFCRT_ArenaCreate(size_t uChunkSize){
+	if(uChunkSize == 0){
+		uChunkSize = _MCFCRT_ARENA_DEFAULT_CHUNK_SIZE;
+	} else if(uChunkSize < CHUNK_SIZE_MIN){
+		uChunkSize = CHUNK_SIZE_MIN;
+	}
+	_MCFCRT_Arena *const pArena = _MCFCRT_malloc(sizeof(_MCFCRT_Arena));
+	if(!pArena){
+		return _MCFCRT_NULLPTR;
+	}
+	pArena->__uNext      = 0;
+	pArena->__uEnd       = 0;
+	pArena->__pUsed      = _MCFCRT_NULLPTR;
+	pArena->__pSpare     = _MCFCRT_NULLPTR;
+	pArena->__uChunkSize = uChunkSize;
+	return pArena;
+}
+void _MCFCRT_ArenaDestroy(_MCFCRT_Arena *pArena){
+	if(!pArena){
+		return;
+	}
+	FreeChunkList(pArena->__pUsed);
+	FreeChunkList(pArena->__pSpare);
+	_MCFCRT_free(pArena);
+}
+void _MCFCRT_ArenaReset(_MCFCRT_Arena *pArena){
+	const size_t uStandardCapacity = GetStandardCapacity(pArena);
+	Chunk *pChunk = pArena->__pUsed;
+	while(pChunk){
+		Chunk *const pNext = pChunk->pNext;
+		if(pChunk->uCapacity == uStandardCapacity){
+			pChunk->pNext = pArena->__pSpare;
+			pArena->__pSpare = pChunk;
+		} else {
+			_MCFCRT_free(pChunk);
+		}
+		pChunk = pNext;
+	}
+	pArena->__uNext = 0;
+	pArena->__uEnd  = 0;
+	pArena->__pUsed = _MCFCRT_NULLPTR;
+}
+
+void *__MCFCRT_ArenaReallyAlloc(_MCFCRT_Arena *pArena, size_t uSize, size_t uAlignment){
+	_MCFCRT_ASSERT((uAlignment != 0) && ((uAlignment & (uAlignment - 1)) == 0));
+
+	// Reserve space for the worst-case alignment adjustment.
+	size_t uCapacityNeeded;
+	if(__builtin_add_overflow(uSize, uAlignment - 1, &uCapacityNeeded)){
+		return _MCFCRT_NULLPTR;
+	}
+	const size_t uStandardCapacity = GetStandardCapacity(pArena);
+	if(uCapacityNeeded > uStandardCapacity / LARGE_BLOCK_RATIO){
+		// Allocate a dedicated chunk and put it after the current one, which remains current.
+		Chunk *const pChunk = _MCFCRT_EXPECT_NOT(uCapacityNeeded > uStandardCapacity) ? AllocChunk(uCapacityNeeded) : TakeStandardChunk(pArena);
+		if(!pChunk){
+			return _MCFCRT_NULLPTR;
+		}
+		Chunk *const pCurrent = pArena->__pUsed;
+		if(pCurrent){
+			pChunk->pNext = pCurrent->pNext;
+			pCurrent->pNext = pChunk;
+		} else {
+			pArena->__pUsed = pChunk;
+			pArena->__uNext = (uintptr_t)(pChunk->abyData + pChunk->uCapacity);
+			pArena->__uEnd  = pArena->__uNext;
+		}
+		return (void *)(((uintptr_t)pChunk->abyData + uAlignment - 1) & ~(uintptr_t)(uAlignment - 1));
+	}
+	// Start a new chunk. The rest of the current one is wasted.
+	Chunk *const pChunk = TakeStandardChunk(pArena);
+	if(!pChunk){
+		return _MCFCRT_NULLPTR;
+	}
+	pChunk->pNext = pArena->__pUsed;
+	pArena->__pUsed = pChunk;
+
+	const uintptr_t uBegin = ((uintptr_t)pChunk->abyData + uAlignment - 1) & ~(uintptr_t)(uAlignment - 1);
+	pArena->__uNext = uBegin + uSize;
+	pArena->__uEnd  = (uintptr_t)(pChunk->abyData + pChunk->uCapacity);
+	return (void *)uBegin;
+}
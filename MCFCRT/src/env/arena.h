@@ -0,0 +1,54 @@
+// 这个文件是 MCF 的一部分。
+// 有关具体授权说明，请参阅 MCFLicense.txt。
+// Copyleft 2013 - 2018, LH_Mouse. All wrongs reserved.
+
+#ifndef __MCFCRT_ENV_ARENA_H_
+#define __MCFCRT_ENV_ARENA_H_
+
+#include "_crtdef.h"
+
+#ifndef __MCFCRT_ARENA_INLINE_OR_EXTERN
+#  define __MCFCRT_ARENA_INLINE_OR_EXTERN     __attribute__((__gnu_inline__)) extern inline
+#endif
+
+_MCFCRT_EXTERN_C_BEGIN
+
+// An arena allocates blocks by bumping a pointer within chunks, which are allocated from the heap.
+// Blocks cannot be freed individually. `_MCFCRT_ArenaReset()` frees all blocks at once and keeps chunks for reuse.
+// Arenas are not thread-safe.
+
+#define _MCFCRT_ARENA_DEFAULT_ALIGNMENT      16u
+#define _MCFCRT_ARENA_DEFAULT_CHUNK_SIZE     0x10000u
+
+typedef struct __MCFCRT_tagArena {
+	_MCFCRT_STD uintptr_t __uNext;
+	_MCFCRT_STD uintptr_t __uEnd;
+	struct __MCFCRT_tagArenaChunk *__pUsed; // The first chunk is the one that `__uNext` and `__uEnd` point into.
+	struct __MCFCRT_tagArenaChunk *__pSpare;
+	_MCFCRT_STD size_t __uChunkSize;
+} _MCFCRT_Arena;
+
+// If `__uChunkSize` is zero, `_MCFCRT_ARENA_DEFAULT_CHUNK_SIZE` is used.
+extern _MCFCRT_Arena *_MCFCRT_ArenaCreate(_MCFCRT_STD size_t __uChunkSize) _MCFCRT_NOEXCEPT;
+extern void _MCFCRT_ArenaDestroy(_MCFCRT_Arena *__pArena) _MCFCRT_NOEXCEPT;
+// Chunks of the default size are kept for reuse. Those allocated for large blocks are freed.
+extern void _MCFCRT_ArenaReset(_MCFCRT_Arena *__pArena) _MCFCRT_NOEXCEPT;
+
+__attribute__((__malloc__))
+extern void *__MCFCRT_ArenaReallyAlloc(_MCFCRT_Arena *__pArena, _MCFCRT_STD size_t __uSize, _MCFCRT_STD size_t __uAlignment) _MCFCRT_NOEXCEPT;
+
+// `__uAlignment` shall be a power of two. A null pointer is returned if the allocation fails.
+// Blocks of zero bytes are not null pointers, but they are not necessarily distinct.
+__attribute__((__malloc__))
+__MCFCRT_ARENA_INLINE_OR_EXTERN void *_MCFCRT_ArenaAlloc(_MCFCRT_Arena *__pArena, _MCFCRT_STD size_t __uSize, _MCFCRT_STD size_t __uAlignment) _MCFCRT_NOEXCEPT {
+	const _MCFCRT_STD uintptr_t __uBegin = (__pArena->__uNext + __uAlignment - 1) & ~(_MCFCRT_STD uintptr_t)(__uAlignment - 1);
+	if(__builtin_expect((__uBegin != 0) && (__uBegin <= __pArena->__uEnd) && (__pArena->__uEnd - __uBegin >= __uSize), true)){
+		__pArena->__uNext = __uBegin + __uSize;
+		return (void *)__uBegin;
+	}
+	return __MCFCRT_ArenaReallyAlloc(__pArena, __uSize, __uAlignment);
+}
+
+_MCFCRT_EXTERN_C_END
+
+#endif
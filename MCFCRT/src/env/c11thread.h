@@ -117,14 +117,14 @@ __MCFCRT_C11THREAD_INLINE_OR_EXTERN _MCFCRT_STD uint64_t __MCFCRT_c11thread_tran
 
 __MCFCRT_C11THREAD_INLINE_OR_EXTERN int __MCFCRT_cnd_timedwait(cnd_t *_MCFCRT_RESTRICT __cond, mtx_t *_MCFCRT_RESTRICT __mutex, const struct timespec *_MCFCRT_RESTRICT __timeout) _MCFCRT_NOEXCEPT {
 	const _MCFCRT_STD uint64_t __mono_timeout_ms = __MCFCRT_c11thread_translate_timeout(__timeout);
-	if(!_MCFCRT_WaitForConditionVariable(&(__cond->__cond), &__MCFCRT_c11thread_unlock_callback_mutex, &__MCFCRT_c11thread_relock_callback_mutex, (_MCFCRT_STD intptr_t)__mutex, _MCFCRT_CONDITION_VARIABLE_SUGGESTED_SPIN_COUNT, __mono_timeout_ms)){
+	if(!_MCFCRT_WaitForConditionVariableOnMutex(&(__cond->__cond), &__MCFCRT_c11thread_unlock_callback_mutex, &__MCFCRT_c11thread_relock_callback_mutex, (_MCFCRT_STD intptr_t)__mutex, &(__mutex->__mutex), _MCFCRT_CONDITION_VARIABLE_SUGGESTED_SPIN_COUNT, __mono_timeout_ms)){
 		return thrd_timedout;
 	}
 	return thrd_success;
 }
 
 __MCFCRT_C11THREAD_INLINE_OR_EXTERN int __MCFCRT_cnd_wait(cnd_t *_MCFCRT_RESTRICT __cond, mtx_t *_MCFCRT_RESTRICT __mutex) _MCFCRT_NOEXCEPT {
-	_MCFCRT_WaitForConditionVariableForever(&(__cond->__cond), &__MCFCRT_c11thread_unlock_callback_mutex, &__MCFCRT_c11thread_relock_callback_mutex, (_MCFCRT_STD intptr_t)__mutex, _MCFCRT_CONDITION_VARIABLE_SUGGESTED_SPIN_COUNT);
+	_MCFCRT_WaitForConditionVariableOnMutexForever(&(__cond->__cond), &__MCFCRT_c11thread_unlock_callback_mutex, &__MCFCRT_c11thread_relock_callback_mutex, (_MCFCRT_STD intptr_t)__mutex, &(__mutex->__mutex), _MCFCRT_CONDITION_VARIABLE_SUGGESTED_SPIN_COUNT);
 	return thrd_success;
 }
 __MCFCRT_C11THREAD_INLINE_OR_EXTERN int __MCFCRT_cnd_signal(cnd_t *__cond) _MCFCRT_NOEXCEPT {
@@ -4,18 +4,10 @@
 
 #define __MCFCRT_CONDITION_VARIABLE_INLINE_OR_EXTERN     extern inline
 #include "condition_variable.h"
-#include "_nt_timeout.h"
+#include "mutex.h"
+#include "_park.h"
 #include "xassert.h"
 #include "expect.h"
-#include <ntdef.h>
-
-__attribute__((__dllimport__, __stdcall__))
-extern NTSTATUS NtWaitForKeyedEvent(HANDLE hKeyedEvent, void *pKey, BOOLEAN bAlertable, const LARGE_INTEGER *pliTimeout);
-__attribute__((__dllimport__, __stdcall__))
-extern NTSTATUS NtReleaseKeyedEvent(HANDLE hKeyedEvent, void *pKey, BOOLEAN bAlertable, const LARGE_INTEGER *pliTimeout);
-
-__attribute__((__dllimport__, __stdcall__, __const__))
-extern BOOLEAN RtlDllShutdownInProgress(void);
 
 #ifndef __BYTE_ORDER__
 #  error Byte order is unknown.
@@ -55,8 +47,30 @@ static inline size_t Min(size_t uSelf, size_t uOther){
 	return (uSelf <= uOther) ? uSelf : uOther;
 }
 
+// If the mutex is known, a thread that is signaled while it is trapped is moved onto the mutex instead of being woken up, provided that the mutex is locked.
+// It will be woken up when the mutex is unlocked, then it will try locking the mutex in the relock callback. This saves a context switch for every thread that would fail to lock the mutex otherwise.
+// If one of its peers has been woken up, which will lock the mutex in the relock callback, it is moved onto the mutex even if the mutex is not locked.
+static bool RequeueOntoMutex(intptr_t nContext, bool bPeerWoken){
+	_MCFCRT_Mutex *const pMutex = (_MCFCRT_Mutex *)nContext;
+	return __MCFCRT_TrapThreadOnMutex(pMutex, bPeerWoken);
+}
+
+static inline bool ParkThread(volatile uintptr_t *puControl, _MCFCRT_Mutex *pMutex, uint64_t u64UntilFastMonoClock){
+	if(pMutex){
+		return __MCFCRT_ParkThreadRequeueable(puControl, u64UntilFastMonoClock, &(pMutex->__u), &RequeueOntoMutex, (intptr_t)pMutex);
+	}
+	return __MCFCRT_ParkThread(puControl, u64UntilFastMonoClock);
+}
+static inline void ParkThreadForever(volatile uintptr_t *puControl, _MCFCRT_Mutex *pMutex){
+	if(pMutex){
+		__MCFCRT_ParkThreadRequeueableForever(puControl, &(pMutex->__u), &RequeueOntoMutex, (intptr_t)pMutex);
+		return;
+	}
+	__MCFCRT_ParkThreadForever(puControl);
+}
+
 __attribute__((__always_inline__))
-static inline bool ReallyWaitForConditionVariable(volatile uintptr_t *puControl, _MCFCRT_ConditionVariableUnlockCallback pfnUnlockCallback, _MCFCRT_ConditionVariableRelockCallback pfnRelockCallback, intptr_t nContext, size_t uMaxSpinCountInitial, bool bMayTimeOut, uint64_t u64UntilFastMonoClock, bool bRelockIfTimeOut){
+static inline bool ReallyWaitForConditionVariable(volatile uintptr_t *puControl, _MCFCRT_ConditionVariableUnlockCallback pfnUnlockCallback, _MCFCRT_ConditionVariableRelockCallback pfnRelockCallback, intptr_t nContext, _MCFCRT_Mutex *pMutex, size_t uMaxSpinCountInitial, bool bMayTimeOut, uint64_t u64UntilFastMonoClock, bool bRelockIfTimeOut){
 	size_t uMaxSpinCount, uSpinMultiplier;
 	bool bSignaled, bSpinnable;
 	{
@@ -157,11 +171,8 @@ static inline bool ReallyWaitForConditionVariable(volatile uintptr_t *puControl,
 		nUnlocked = (*pfnUnlockCallback)(nContext);
 	}
 	if(bMayTimeOut){
-		LARGE_INTEGER liTimeout;
-		__MCFCRT_InitializeNtTimeout(&liTimeout, u64UntilFastMonoClock);
-		NTSTATUS lStatus = NtWaitForKeyedEvent(_MCFCRT_NULLPTR, (void *)puControl, false, &liTimeout);
-		_MCFCRT_ASSERT_MSG(NT_SUCCESS(lStatus), L"NtWaitForKeyedEvent() 失败。");
-		while(_MCFCRT_EXPECT(lStatus == STATUS_TIMEOUT)){
+		bool bReleased = ParkThread(puControl, pMutex, u64UntilFastMonoClock);
+		while(_MCFCRT_EXPECT(!bReleased)){
 			bool bDecremented;
 			{
 				uintptr_t uOld, uNew;
@@ -181,14 +192,10 @@ static inline bool ReallyWaitForConditionVariable(volatile uintptr_t *puControl,
 				}
 				return false;
 			}
-			liTimeout.QuadPart = 0;
-			lStatus = NtWaitForKeyedEvent(_MCFCRT_NULLPTR, (void *)puControl, false, &liTimeout);
-			_MCFCRT_ASSERT_MSG(NT_SUCCESS(lStatus), L"NtWaitForKeyedEvent() 失败。");
+			bReleased = ParkThread(puControl, pMutex, 0);
 		}
 	} else {
-		NTSTATUS lStatus = NtWaitForKeyedEvent(_MCFCRT_NULLPTR, (void *)puControl, false, _MCFCRT_NULLPTR);
-		_MCFCRT_ASSERT_MSG(NT_SUCCESS(lStatus), L"NtWaitForKeyedEvent() 失败。");
-		_MCFCRT_ASSERT(lStatus != STATUS_TIMEOUT);
+		ParkThreadForever(puControl, pMutex);
 	}
 	(*pfnRelockCallback)(nContext, nUnlocked);
 	return true;
@@ -212,28 +219,34 @@ static inline size_t ReallySignalConditionVariable(volatile uintptr_t *puControl
 			}
 		} while(_MCFCRT_EXPECT_NOT(!__atomic_compare_exchange_n(puControl, &uOld, uNew, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED)));
 	}
-	// If `RtlDllShutdownInProgress()` is `true`, other threads will have been terminated.
-	// Calling `NtReleaseKeyedEvent()` when no thread is waiting results in deadlocks. Don't do that.
-	if(_MCFCRT_EXPECT_NOT((uCountToSignal > 0) && !RtlDllShutdownInProgress())){
-		for(size_t uIndex = 0; uIndex < uCountToSignal; ++uIndex){
-			NTSTATUS lStatus = NtReleaseKeyedEvent(_MCFCRT_NULLPTR, (void *)puControl, false, _MCFCRT_NULLPTR);
-			_MCFCRT_ASSERT_MSG(NT_SUCCESS(lStatus), L"NtReleaseKeyedEvent() 失败。");
-			_MCFCRT_ASSERT(lStatus != STATUS_TIMEOUT);
-		}
+	if(_MCFCRT_EXPECT_NOT(uCountToSignal > 0)){
+		__MCFCRT_UnparkThreads(puControl, uCountToSignal);
 	}
 	return uCountToRelease + uCountToSignal;
 }
 
 bool __MCFCRT_ReallyWaitForConditionVariable(_MCFCRT_ConditionVariable *pConditionVariable, _MCFCRT_ConditionVariableUnlockCallback pfnUnlockCallback, _MCFCRT_ConditionVariableRelockCallback pfnRelockCallback, intptr_t nContext, size_t uMaxSpinCount, uint64_t u64UntilFastMonoClock){
-	const bool bSignaled = ReallyWaitForConditionVariable(&(pConditionVariable->__u), pfnUnlockCallback, pfnRelockCallback, nContext, uMaxSpinCount, true, u64UntilFastMonoClock, true);
+	const bool bSignaled = ReallyWaitForConditionVariable(&(pConditionVariable->__u), pfnUnlockCallback, pfnRelockCallback, nContext, _MCFCRT_NULLPTR, uMaxSpinCount, true, u64UntilFastMonoClock, true);
 	return bSignaled;
 }
 bool __MCFCRT_ReallyWaitForConditionVariableOrAbandon(_MCFCRT_ConditionVariable *pConditionVariable, _MCFCRT_ConditionVariableUnlockCallback pfnUnlockCallback, _MCFCRT_ConditionVariableRelockCallback pfnRelockCallback, intptr_t nContext, size_t uMaxSpinCount, uint64_t u64UntilFastMonoClock){
-	const bool bSignaled = ReallyWaitForConditionVariable(&(pConditionVariable->__u), pfnUnlockCallback, pfnRelockCallback, nContext, uMaxSpinCount, true, u64UntilFastMonoClock, false);
+	const bool bSignaled = ReallyWaitForConditionVariable(&(pConditionVariable->__u), pfnUnlockCallback, pfnRelockCallback, nContext, _MCFCRT_NULLPTR, uMaxSpinCount, true, u64UntilFastMonoClock, false);
 	return bSignaled;
 }
 void __MCFCRT_ReallyWaitForConditionVariableForever(_MCFCRT_ConditionVariable *pConditionVariable, _MCFCRT_ConditionVariableUnlockCallback pfnUnlockCallback, _MCFCRT_ConditionVariableRelockCallback pfnRelockCallback, intptr_t nContext, size_t uMaxSpinCount){
-	const bool bSignaled = ReallyWaitForConditionVariable(&(pConditionVariable->__u), pfnUnlockCallback, pfnRelockCallback, nContext, uMaxSpinCount, false, UINT64_MAX, true);
+	const bool bSignaled = ReallyWaitForConditionVariable(&(pConditionVariable->__u), pfnUnlockCallback, pfnRelockCallback, nContext, _MCFCRT_NULLPTR, uMaxSpinCount, false, UINT64_MAX, true);
+	_MCFCRT_ASSERT(bSignaled);
+}
+bool __MCFCRT_ReallyWaitForConditionVariableOnMutex(_MCFCRT_ConditionVariable *pConditionVariable, _MCFCRT_ConditionVariableUnlockCallback pfnUnlockCallback, _MCFCRT_ConditionVariableRelockCallback pfnRelockCallback, intptr_t nContext, _MCFCRT_Mutex *pMutex, size_t uMaxSpinCount, uint64_t u64UntilFastMonoClock){
+	const bool bSignaled = ReallyWaitForConditionVariable(&(pConditionVariable->__u), pfnUnlockCallback, pfnRelockCallback, nContext, pMutex, uMaxSpinCount, true, u64UntilFastMonoClock, true);
+	return bSignaled;
+}
+bool __MCFCRT_ReallyWaitForConditionVariableOnMutexOrAbandon(_MCFCRT_ConditionVariable *pConditionVariable, _MCFCRT_ConditionVariableUnlockCallback pfnUnlockCallback, _MCFCRT_ConditionVariableRelockCallback pfnRelockCallback, intptr_t nContext, _MCFCRT_Mutex *pMutex, size_t uMaxSpinCount, uint64_t u64UntilFastMonoClock){
+	const bool bSignaled = ReallyWaitForConditionVariable(&(pConditionVariable->__u), pfnUnlockCallback, pfnRelockCallback, nContext, pMutex, uMaxSpinCount, true, u64UntilFastMonoClock, false);
+	return bSignaled;
+}
+void __MCFCRT_ReallyWaitForConditionVariableOnMutexForever(_MCFCRT_ConditionVariable *pConditionVariable, _MCFCRT_ConditionVariableUnlockCallback pfnUnlockCallback, _MCFCRT_ConditionVariableRelockCallback pfnRelockCallback, intptr_t nContext, _MCFCRT_Mutex *pMutex, size_t uMaxSpinCount){
+	const bool bSignaled = ReallyWaitForConditionVariable(&(pConditionVariable->__u), pfnUnlockCallback, pfnRelockCallback, nContext, pMutex, uMaxSpinCount, false, UINT64_MAX, true);
 	_MCFCRT_ASSERT(bSignaled);
 }
 size_t __MCFCRT_ReallySignalConditionVariable(_MCFCRT_ConditionVariable *pConditionVariable, size_t uMaxCountToSignal){
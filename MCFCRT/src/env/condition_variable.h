@@ -6,6 +6,7 @@
 #define __MCFCRT_ENV_CONDITION_VARIABLE_H_
 
 #include "_crtdef.h"
+#include "mutex.h"
 
 #ifndef __MCFCRT_CONDITION_VARIABLE_INLINE_OR_EXTERN
 #  define __MCFCRT_CONDITION_VARIABLE_INLINE_OR_EXTERN     __attribute__((__gnu_inline__)) extern inline
@@ -30,6 +31,9 @@ __MCFCRT_CONDITION_VARIABLE_INLINE_OR_EXTERN void _MCFCRT_InitializeConditionVar
 extern bool __MCFCRT_ReallyWaitForConditionVariable(_MCFCRT_ConditionVariable *__pConditionVariable, _MCFCRT_ConditionVariableUnlockCallback __pfnUnlockCallback, _MCFCRT_ConditionVariableRelockCallback __pfnRelockCallback, _MCFCRT_STD intptr_t __nContext, _MCFCRT_STD size_t __uMaxSpinCount, _MCFCRT_STD uint64_t __u64UntilFastMonoClock) _MCFCRT_NOEXCEPT;
 extern bool __MCFCRT_ReallyWaitForConditionVariableOrAbandon(_MCFCRT_ConditionVariable *__pConditionVariable, _MCFCRT_ConditionVariableUnlockCallback __pfnUnlockCallback, _MCFCRT_ConditionVariableRelockCallback __pfnRelockCallback, _MCFCRT_STD intptr_t __nContext, _MCFCRT_STD size_t __uMaxSpinCount, _MCFCRT_STD uint64_t __u64UntilFastMonoClock) _MCFCRT_NOEXCEPT;
 extern void __MCFCRT_ReallyWaitForConditionVariableForever(_MCFCRT_ConditionVariable *__pConditionVariable, _MCFCRT_ConditionVariableUnlockCallback __pfnUnlockCallback, _MCFCRT_ConditionVariableRelockCallback __pfnRelockCallback, _MCFCRT_STD intptr_t __nContext, _MCFCRT_STD size_t __uMaxSpinCount) _MCFCRT_NOEXCEPT;
+extern bool __MCFCRT_ReallyWaitForConditionVariableOnMutex(_MCFCRT_ConditionVariable *__pConditionVariable, _MCFCRT_ConditionVariableUnlockCallback __pfnUnlockCallback, _MCFCRT_ConditionVariableRelockCallback __pfnRelockCallback, _MCFCRT_STD intptr_t __nContext, _MCFCRT_Mutex *__pMutex, _MCFCRT_STD size_t __uMaxSpinCount, _MCFCRT_STD uint64_t __u64UntilFastMonoClock) _MCFCRT_NOEXCEPT;
+extern bool __MCFCRT_ReallyWaitForConditionVariableOnMutexOrAbandon(_MCFCRT_ConditionVariable *__pConditionVariable, _MCFCRT_ConditionVariableUnlockCallback __pfnUnlockCallback, _MCFCRT_ConditionVariableRelockCallback __pfnRelockCallback, _MCFCRT_STD intptr_t __nContext, _MCFCRT_Mutex *__pMutex, _MCFCRT_STD size_t __uMaxSpinCount, _MCFCRT_STD uint64_t __u64UntilFastMonoClock) _MCFCRT_NOEXCEPT;
+extern void __MCFCRT_ReallyWaitForConditionVariableOnMutexForever(_MCFCRT_ConditionVariable *__pConditionVariable, _MCFCRT_ConditionVariableUnlockCallback __pfnUnlockCallback, _MCFCRT_ConditionVariableRelockCallback __pfnRelockCallback, _MCFCRT_STD intptr_t __nContext, _MCFCRT_Mutex *__pMutex, _MCFCRT_STD size_t __uMaxSpinCount) _MCFCRT_NOEXCEPT;
 extern _MCFCRT_STD size_t __MCFCRT_ReallySignalConditionVariable(_MCFCRT_ConditionVariable *__pConditionVariable, _MCFCRT_STD size_t __uMaxCountToSignal) _MCFCRT_NOEXCEPT;
 extern _MCFCRT_STD size_t __MCFCRT_ReallyBroadcastConditionVariable(_MCFCRT_ConditionVariable *__pConditionVariable) _MCFCRT_NOEXCEPT;
 
@@ -42,6 +46,20 @@ __MCFCRT_CONDITION_VARIABLE_INLINE_OR_EXTERN bool _MCFCRT_WaitForConditionVariab
 __MCFCRT_CONDITION_VARIABLE_INLINE_OR_EXTERN void _MCFCRT_WaitForConditionVariableForever(_MCFCRT_ConditionVariable *__pConditionVariable, _MCFCRT_ConditionVariableUnlockCallback __pfnUnlockCallback, _MCFCRT_ConditionVariableRelockCallback __pfnRelockCallback, _MCFCRT_STD intptr_t __nContext, _MCFCRT_STD size_t __uMaxSpinCount) _MCFCRT_NOEXCEPT {
 	__MCFCRT_ReallyWaitForConditionVariableForever(__pConditionVariable, __pfnUnlockCallback, __pfnRelockCallback, __nContext, __uMaxSpinCount);
 }
+
+// These functions are the same as above, except that the relock callback shall lock `*__pMutex`, possibly among other things, and the unlock callback shall unlock it.
+// Signaled threads that have been put into sleep are moved onto the mutex if it is locked, then woken up one by one as it is unlocked, rather than all at once.
+// All threads that are waiting on the same condition variable at the same time should pass the same mutex.
+__MCFCRT_CONDITION_VARIABLE_INLINE_OR_EXTERN bool _MCFCRT_WaitForConditionVariableOnMutex(_MCFCRT_ConditionVariable *__pConditionVariable, _MCFCRT_ConditionVariableUnlockCallback __pfnUnlockCallback, _MCFCRT_ConditionVariableRelockCallback __pfnRelockCallback, _MCFCRT_STD intptr_t __nContext, _MCFCRT_Mutex *__pMutex, _MCFCRT_STD size_t __uMaxSpinCount, _MCFCRT_STD uint64_t __u64UntilFastMonoClock) _MCFCRT_NOEXCEPT {
+	return __MCFCRT_ReallyWaitForConditionVariableOnMutex(__pConditionVariable, __pfnUnlockCallback, __pfnRelockCallback, __nContext, __pMutex, __uMaxSpinCount, __u64UntilFastMonoClock);
+}
+__MCFCRT_CONDITION_VARIABLE_INLINE_OR_EXTERN bool _MCFCRT_WaitForConditionVariableOnMutexOrAbandon(_MCFCRT_ConditionVariable *__pConditionVariable, _MCFCRT_ConditionVariableUnlockCallback __pfnUnlockCallback, _MCFCRT_ConditionVariableRelockCallback __pfnRelockCallback, _MCFCRT_STD intptr_t __nContext, _MCFCRT_Mutex *__pMutex, _MCFCRT_STD size_t __uMaxSpinCount, _MCFCRT_STD uint64_t __u64UntilFastMonoClock) _MCFCRT_NOEXCEPT {
+	return __MCFCRT_ReallyWaitForConditionVariableOnMutexOrAbandon(__pConditionVariable, __pfnUnlockCallback, __pfnRelockCallback, __nContext, __pMutex, __uMaxSpinCount, __u64UntilFastMonoClock);
+}
+__MCFCRT_CONDITION_VARIABLE_INLINE_OR_EXTERN void _MCFCRT_WaitForConditionVariableOnMutexForever(_MCFCRT_ConditionVariable *__pConditionVariable, _MCFCRT_ConditionVariableUnlockCallback __pfnUnlockCallback, _MCFCRT_ConditionVariableRelockCallback __pfnRelockCallback, _MCFCRT_STD intptr_t __nContext, _MCFCRT_Mutex *__pMutex, _MCFCRT_STD size_t __uMaxSpinCount) _MCFCRT_NOEXCEPT {
+	__MCFCRT_ReallyWaitForConditionVariableOnMutexForever(__pConditionVariable, __pfnUnlockCallback, __pfnRelockCallback, __nContext, __pMutex, __uMaxSpinCount);
+}
+
 __MCFCRT_CONDITION_VARIABLE_INLINE_OR_EXTERN _MCFCRT_STD size_t _MCFCRT_SignalConditionVariable(_MCFCRT_ConditionVariable *__pConditionVariable, _MCFCRT_STD size_t __uMaxCountToSignal) _MCFCRT_NOEXCEPT {
 	return __MCFCRT_ReallySignalConditionVariable(__pConditionVariable, __uMaxCountToSignal);
 }
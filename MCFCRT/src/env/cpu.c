@@ -7,6 +7,7 @@
 #include "once_flag.h"
 #include "bail.h"
 #include "xassert.h"
+#include "mcfwin.h"
 #include <cpuid.h>
 
 #define RND_NEAREST     (0u)            // 四舍六入五凑双。
@@ -39,7 +40,95 @@ void __MCFCRT_CpuResetFloatingPointEnvironment(void){
 }
 
 static _MCFCRT_OnceFlag g_once;
-static unsigned g_cache_sizes[_MCFCRT_kCpuCacheLevelMax + 1];
+static size_t   g_cache_sizes[_MCFCRT_kCpuCacheLevelMax + 1];
+static size_t   g_line_size;
+static uint32_t g_features;
+static size_t   g_logical_count;
+static size_t   g_core_count;
+static size_t   g_package_count;
+
+static inline void SetFeature(_MCFCRT_CpuFeature feature, unsigned reg, unsigned bit){
+	g_features |= ((reg >> bit) & 1u) << feature;
+}
+
+// Reference:
+//   Intel® 64 and IA-32 Architectures Software Developer’s Manual, Volume 2 (2A, 2B & 2C):
+//     Table 3-8. Information Returned by CPUID Instruction
+//   AMD64 Architecture Programmer's Manual, Volume 3:
+//     E.4.15 Function 8000_001Dh—Cache Topology Information
+// Both leaves return information about one cache per subleaf in the same format.
+// Returns the number of caches found.
+static unsigned EnumerateCaches(unsigned leaf){
+	unsigned count = 0;
+	for(unsigned index = 0; index < 64; ++index){
+		unsigned eax, ebx, ecx, edx;
+		__cpuid_count(leaf, index, eax, ebx, ecx, edx);
+		const unsigned type = eax & 0x1F;
+		if(type == 0){
+			// No more caches. Stop.
+			break;
+		}
+		++count;
+		if(type == 2){
+			// Ignore instruction caches.
+			continue;
+		}
+		const unsigned level = (eax >> 5) & 0x07;
+		if((level < _MCFCRT_kCpuCacheLevel1) || (level >= _MCFCRT_kCpuCacheLevelMax)){
+			continue;
+		}
+		const unsigned ways = ((ebx >> 22) & 0x3FF) + 1;
+		const unsigned partitions = ((ebx >> 12) & 0x3FF) + 1;
+		const unsigned line_size = (ebx & 0xFFF) + 1;
+		const unsigned sets = ecx + 1;
+		g_cache_sizes[level] = (size_t)ways * partitions * line_size * sets;
+		if(level == _MCFCRT_kCpuCacheLevel1){
+			g_line_size = line_size;
+		}
+	}
+	return count;
+}
+
+static void FetchTopology(void){
+	// Reference:
+	//   https://docs.microsoft.com/en-us/windows/desktop/api/sysinfoapi/nf-sysinfoapi-getlogicalprocessorinformationex
+	// The buffer is not allocated from our heap, which may call `memcpy()`, which calls us.
+	DWORD size = 0;
+	if(!GetLogicalProcessorInformationEx(RelationAll, _MCFCRT_NULLPTR, &size) && (GetLastError() == ERROR_INSUFFICIENT_BUFFER)){
+		char *const buffer = VirtualAlloc(_MCFCRT_NULLPTR, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+		if(buffer){
+			if(GetLogicalProcessorInformationEx(RelationAll, (void *)buffer, &size)){
+				for(DWORD offset = 0; offset < size; offset += ((SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX *)(buffer + offset))->Size){
+					const SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX *const info = (void *)(buffer + offset);
+					switch(info->Relationship){
+					case RelationProcessorCore:
+						++g_core_count;
+						for(WORD group = 0; group < info->Processor.GroupCount; ++group){
+							g_logical_count += (size_t)__builtin_popcountll(info->Processor.GroupMask[group].Mask);
+						}
+						break;
+					case RelationProcessorPackage:
+						++g_package_count;
+						break;
+					default:
+						break;
+					}
+				}
+			}
+			VirtualFree(buffer, 0, MEM_RELEASE);
+		}
+	}
+	if(g_logical_count == 0){
+		// Assume there is no SMT.
+		SYSTEM_INFO system_info;
+		GetSystemInfo(&system_info);
+		g_logical_count = system_info.dwNumberOfProcessors;
+		g_core_count = g_logical_count;
+	}
+	if(g_package_count == 0){
+		g_package_count = 1;
+	}
+}
 
 static void FetchCpuInfoOnce(void){
 	const _MCFCRT_OnceResult result = _MCFCRT_WaitForOnceFlagForever(&g_once);
@@ -48,29 +137,84 @@ static void FetchCpuInfoOnce(void){
 	}
 	_MCFCRT_ASSERT(result == _MCFCRT_kOnceResultInitial);
 
-	// Reference:
-	//   Intel® 64 and IA-32 Architectures Software Developer’s Manual, Volume 2 (2A, 2B & 2C):
-	//     Table 3-17. Information Returned by CPUID Instruction
-	// Iterate from cache level 1, until there are no more levels.
-	unsigned level = 1;
-	do {
-		unsigned eax, ebx, ecx, edx;
-		if(!__get_cpuid_count(0x04, level, &eax, &ebx, &ecx, &edx)){
-			_MCFCRT_Bail(L"__get_cpuid_count() 失败。");
+	unsigned eax, ebx, ecx, edx;
+	const unsigned max_leaf = __get_cpuid_max(0, _MCFCRT_NULLPTR);
+	const unsigned max_ext_leaf = __get_cpuid_max(0x80000000, _MCFCRT_NULLPTR);
+
+	// Check instruction set extensions.
+	bool os_saves_ymm = false, os_saves_zmm = false;
+	if(max_leaf >= 0x01){
+		__cpuid(0x01, eax, ebx, ecx, edx);
+		SetFeature(_MCFCRT_kCpuFeatureSse3,    ecx,  0);
+		SetFeature(_MCFCRT_kCpuFeaturePclmul,  ecx,  1);
+		SetFeature(_MCFCRT_kCpuFeatureSsse3,   ecx,  9);
+		SetFeature(_MCFCRT_kCpuFeatureSse41,   ecx, 19);
+		SetFeature(_MCFCRT_kCpuFeatureSse42,   ecx, 20);
+		SetFeature(_MCFCRT_kCpuFeatureMovbe,   ecx, 22);
+		SetFeature(_MCFCRT_kCpuFeaturePopcnt,  ecx, 23);
+		SetFeature(_MCFCRT_kCpuFeatureAes,     ecx, 25);
+		SetFeature(_MCFCRT_kCpuFeatureRdrand,  ecx, 30);
+		// CLFLUSH line size, in units of 8 bytes.
+		g_line_size = ((ebx >> 8) & 0xFF) * 8;
+		// If OSXSAVE is set, check which register states are enabled by the OS in XCR0.
+		if((ecx >> 27) & 1){
+			unsigned xcr0_lo, xcr0_hi;
+			__asm__ volatile ("xgetbv" : "=a"(xcr0_lo), "=d"(xcr0_hi) : "c"(0));
+			(void)xcr0_hi;
+			os_saves_ymm = (xcr0_lo & 0x06) == 0x06;
+			os_saves_zmm = (xcr0_lo & 0xE6) == 0xE6;
 		}
-		if((eax & 0x1F) == 0){
-			// No more cache levels. Stop.
-			break;
+		if(os_saves_ymm){
+			SetFeature(_MCFCRT_kCpuFeatureAvx,     ecx, 28);
+			SetFeature(_MCFCRT_kCpuFeatureFma,     ecx, 12);
+			SetFeature(_MCFCRT_kCpuFeatureF16c,    ecx, 29);
 		}
-		const unsigned ways = ((ebx >> 22) & 0x3FF) + 1;
-		const unsigned partitions = ((ebx >> 12) & 0x3FF) + 1;
-		const unsigned line_size = (ebx & 0xFFF) + 1;
-		const unsigned sets = ecx + 1;
-		g_cache_sizes[level] = ways * partitions * line_size * sets;
-	} while(++level < _MCFCRT_kCpuCacheLevelMax);
+	}
+	if(max_leaf >= 0x07){
+		__cpuid_count(0x07, 0, eax, ebx, ecx, edx);
+		SetFeature(_MCFCRT_kCpuFeatureBmi1,    ebx,  3);
+		SetFeature(_MCFCRT_kCpuFeatureBmi2,    ebx,  8);
+		SetFeature(_MCFCRT_kCpuFeatureErms,    ebx,  9);
+		SetFeature(_MCFCRT_kCpuFeatureRdseed,  ebx, 18);
+		SetFeature(_MCFCRT_kCpuFeatureAdx,     ebx, 19);
+		SetFeature(_MCFCRT_kCpuFeatureSha,     ebx, 29);
+		SetFeature(_MCFCRT_kCpuFeatureFsrm,    edx,  4);
+		if(os_saves_ymm){
+			SetFeature(_MCFCRT_kCpuFeatureAvx2,    ebx,  5);
+		}
+		if(os_saves_zmm){
+			SetFeature(_MCFCRT_kCpuFeatureAvx512f,   ebx, 16);
+			SetFeature(_MCFCRT_kCpuFeatureAvx512dq,  ebx, 17);
+			SetFeature(_MCFCRT_kCpuFeatureAvx512bw,  ebx, 30);
+			SetFeature(_MCFCRT_kCpuFeatureAvx512vl,  ebx, 31);
+		}
+	}
+	if(max_ext_leaf >= 0x80000001){
+		__cpuid(0x80000001, eax, ebx, ecx, edx);
+		SetFeature(_MCFCRT_kCpuFeatureLzcnt,   ecx,  5);
+	}
+
+	// Check caches. Intel uses leaf 4 and AMD uses leaf 0x8000001D.
+	unsigned cache_count = 0;
+	if(max_leaf >= 0x04){
+		cache_count = EnumerateCaches(0x04);
+	}
+	if((cache_count == 0) && (max_ext_leaf >= 0x8000001D)){
+		cache_count = EnumerateCaches(0x8000001D);
+	}
 	// Set up boundary values.
 	g_cache_sizes[_MCFCRT_kCpuCacheLevelMin] = g_cache_sizes[_MCFCRT_kCpuCacheLevel1];
-	g_cache_sizes[_MCFCRT_kCpuCacheLevelMax] = g_cache_sizes[level - 1];
+	for(unsigned level = _MCFCRT_kCpuCacheLevelMax - 1; level >= _MCFCRT_kCpuCacheLevel1; --level){
+		if(g_cache_sizes[level] != 0){
+			g_cache_sizes[_MCFCRT_kCpuCacheLevelMax] = g_cache_sizes[level];
+			break;
+		}
+	}
+	if(g_line_size == 0){
+		g_line_size = 64;
+	}
+
+	FetchTopology();
 
 	_MCFCRT_SignalOnceFlagAsFinished(&g_once);
 }
@@ -82,3 +226,28 @@ size_t _MCFCRT_CpuGetCacheSize(_MCFCRT_CpuCacheLevel level){
 	FetchCpuInfoOnce();
 	return g_cache_sizes[level];
 }
+size_t _MCFCRT_CpuGetLineSize(void){
+	FetchCpuInfoOnce();
+	return g_line_size;
+}
+
+bool _MCFCRT_CpuHasFeature(_MCFCRT_CpuFeature feature){
+	if(_MCFCRT_EXPECT_NOT((unsigned)feature >= _MCFCRT_kCpuFeatureEnd)){
+		return false;
+	}
+	FetchCpuInfoOnce();
+	return (g_features >> feature) & 1;
+}
+
+size_t _MCFCRT_CpuGetLogicalCount(void){
+	FetchCpuInfoOnce();
+	return g_logical_count;
+}
+size_t _MCFCRT_CpuGetCoreCount(void){
+	FetchCpuInfoOnce();
+	return g_core_count;
+}
+size_t _MCFCRT_CpuGetPackageCount(void){
+	FetchCpuInfoOnce();
+	return g_package_count;
+}
@@ -20,9 +20,52 @@ typedef enum __MCFCRT_tagCpuCacheLevel {
 } _MCFCRT_CpuCacheLevel;
 
 // For `_MCFCRT_kCpuCacheLevelMin`: Returns the size of the first level of cache.
-// For `_MCFCRT_kCpuCacheLevel{1,2,3,4}` : Returns the size of the specified level of cache.
+// For `_MCFCRT_kCpuCacheLevel{1,2,3,4}` : Returns the size of the specified level of data or unified cache.
 // For `_MCFCRT_kCpuCacheLevelMax` : Returns the size of the last level of cache.
+// Returns zero if the specified level of cache does not exist.
 extern _MCFCRT_STD size_t _MCFCRT_CpuGetCacheSize(_MCFCRT_CpuCacheLevel __level) _MCFCRT_NOEXCEPT;
+// Returns the size of a line of the first level of data cache, which is 64 if it cannot be determined.
+extern _MCFCRT_STD size_t _MCFCRT_CpuGetLineSize(void) _MCFCRT_NOEXCEPT;
+
+typedef enum __MCFCRT_tagCpuFeature {
+	_MCFCRT_kCpuFeatureSse3      =  0,
+	_MCFCRT_kCpuFeatureSsse3     =  1,
+	_MCFCRT_kCpuFeatureSse41     =  2,
+	_MCFCRT_kCpuFeatureSse42     =  3,
+	_MCFCRT_kCpuFeaturePopcnt    =  4,
+	_MCFCRT_kCpuFeaturePclmul    =  5,
+	_MCFCRT_kCpuFeatureAes       =  6,
+	_MCFCRT_kCpuFeatureMovbe     =  7,
+	_MCFCRT_kCpuFeatureRdrand    =  8,
+	_MCFCRT_kCpuFeatureRdseed    =  9,
+	_MCFCRT_kCpuFeatureLzcnt     = 10,
+	_MCFCRT_kCpuFeatureBmi1      = 11,
+	_MCFCRT_kCpuFeatureBmi2      = 12,
+	_MCFCRT_kCpuFeatureAdx       = 13,
+	_MCFCRT_kCpuFeatureSha       = 14,
+	_MCFCRT_kCpuFeatureErms      = 15, // Enhanced `rep movsb` and `rep stosb`.
+	_MCFCRT_kCpuFeatureFsrm      = 16, // Fast short `rep movsb`.
+	_MCFCRT_kCpuFeatureAvx       = 17,
+	_MCFCRT_kCpuFeatureFma       = 18,
+	_MCFCRT_kCpuFeatureF16c      = 19,
+	_MCFCRT_kCpuFeatureAvx2      = 20,
+	_MCFCRT_kCpuFeatureAvx512f   = 21,
+	_MCFCRT_kCpuFeatureAvx512dq  = 22,
+	_MCFCRT_kCpuFeatureAvx512bw  = 23,
+	_MCFCRT_kCpuFeatureAvx512vl  = 24,
+	_MCFCRT_kCpuFeatureEnd       = 25,
+} _MCFCRT_CpuFeature;
+
+// AVX and AVX-512 features are reported only if the OS saves the corresponding registers on context switches.
+// Returns `false` for unknown features.
+extern bool _MCFCRT_CpuHasFeature(_MCFCRT_CpuFeature __feature) _MCFCRT_NOEXCEPT;
+
+// Returns the number of logical processors, counting all processor groups.
+extern _MCFCRT_STD size_t _MCFCRT_CpuGetLogicalCount(void) _MCFCRT_NOEXCEPT;
+// Returns the number of physical cores. This is less than the number of logical processors if SMT is enabled.
+extern _MCFCRT_STD size_t _MCFCRT_CpuGetCoreCount(void) _MCFCRT_NOEXCEPT;
+// Returns the number of processor packages (sockets).
+extern _MCFCRT_STD size_t _MCFCRT_CpuGetPackageCount(void) _MCFCRT_NOEXCEPT;
 
 _MCFCRT_EXTERN_C_END
 
@@ -183,11 +183,11 @@ __MCFCRT_GTHREAD_INLINE_OR_EXTERN int __MCFCRT_gthread_cond_destroy(__gthread_co
 }
 
 __MCFCRT_GTHREAD_INLINE_OR_EXTERN int __MCFCRT_gthread_cond_wait(__gthread_cond_t *_MCFCRT_RESTRICT __cond, __gthread_mutex_t *_MCFCRT_RESTRICT __mutex) _MCFCRT_NOEXCEPT {
-	_MCFCRT_WaitForConditionVariableForever(__cond, &__MCFCRT_gthread_unlock_callback_mutex, &__MCFCRT_gthread_relock_callback_mutex, (_MCFCRT_STD intptr_t)__mutex, _MCFCRT_CONDITION_VARIABLE_SUGGESTED_SPIN_COUNT);
+	_MCFCRT_WaitForConditionVariableOnMutexForever(__cond, &__MCFCRT_gthread_unlock_callback_mutex, &__MCFCRT_gthread_relock_callback_mutex, (_MCFCRT_STD intptr_t)__mutex, __mutex, _MCFCRT_CONDITION_VARIABLE_SUGGESTED_SPIN_COUNT);
 	return 0;
 }
 __MCFCRT_GTHREAD_INLINE_OR_EXTERN int __MCFCRT_gthread_cond_wait_recursive(__gthread_cond_t *_MCFCRT_RESTRICT __cond, __gthread_recursive_mutex_t *_MCFCRT_RESTRICT __recur_mutex) _MCFCRT_NOEXCEPT {
-	_MCFCRT_WaitForConditionVariableForever(__cond, &__MCFCRT_gthread_unlock_callback_recursive_mutex, &__MCFCRT_gthread_relock_callback_recursive_mutex, (_MCFCRT_STD intptr_t)__recur_mutex, _MCFCRT_CONDITION_VARIABLE_SUGGESTED_SPIN_COUNT);
+	_MCFCRT_WaitForConditionVariableOnMutexForever(__cond, &__MCFCRT_gthread_unlock_callback_recursive_mutex, &__MCFCRT_gthread_relock_callback_recursive_mutex, (_MCFCRT_STD intptr_t)__recur_mutex, &(__recur_mutex->__mutex), _MCFCRT_CONDITION_VARIABLE_SUGGESTED_SPIN_COUNT);
 	return 0;
 }
 __MCFCRT_GTHREAD_INLINE_OR_EXTERN int __MCFCRT_gthread_cond_signal(__gthread_cond_t *__cond) _MCFCRT_NOEXCEPT {
@@ -326,7 +326,7 @@ __MCFCRT_GTHREAD_INLINE_OR_EXTERN int __MCFCRT_gthread_recursive_mutex_timedlock
 }
 __MCFCRT_GTHREAD_INLINE_OR_EXTERN int __MCFCRT_gthread_cond_timedwait(__gthread_cond_t *_MCFCRT_RESTRICT __cond, __gthread_mutex_t *_MCFCRT_RESTRICT __mutex, const __gthread_time_t *_MCFCRT_RESTRICT __timeout) _MCFCRT_NOEXCEPT {
 	const _MCFCRT_STD uint64_t __mono_timeout_ms = __MCFCRT_gthread_translate_timeout(__timeout);
-	if(!_MCFCRT_WaitForConditionVariable(__cond, &__MCFCRT_gthread_unlock_callback_mutex, &__MCFCRT_gthread_relock_callback_mutex, (_MCFCRT_STD intptr_t)__mutex, _MCFCRT_CONDITION_VARIABLE_SUGGESTED_SPIN_COUNT, __mono_timeout_ms)){
+	if(!_MCFCRT_WaitForConditionVariableOnMutex(__cond, &__MCFCRT_gthread_unlock_callback_mutex, &__MCFCRT_gthread_relock_callback_mutex, (_MCFCRT_STD intptr_t)__mutex, __mutex, _MCFCRT_CONDITION_VARIABLE_SUGGESTED_SPIN_COUNT, __mono_timeout_ms)){
 		return ETIMEDOUT;
 	}
 	return 0;
@@ -3,25 +3,41 @@
 // Copyleft 2013 - 2018, LH_Mouse. All wrongs reserved.
 
 #include "heap.h"
+#include "_heap_impl.h"
 #include "mcfwin.h"
-#include "mutex.h"
 #include "heap_debug.h"
 #include "inline_mem.h"
 #include "bail.h"
+#include "mutex.h"
+#include "standard_streams.h"
+#include "../ext/wcpcpy.h"
+#include "../ext/itow.h"
 
 #ifndef NDEBUG
 #  undef __MCFCRT_HEAP_DEBUG
 #  define __MCFCRT_HEAP_DEBUG     1
 #endif
 
-static inline void *Underlying_malloc_zf(size_t size, bool zero_fill){
-	return LocalAlloc(zero_fill ? LPTR : LMEM_FIXED, size);
+static inline void *Underlying_malloc_zf(size_t size, bool zero_fill, const void *ret_outer, const void *ret_inner){
+	return __MCFCRT_HeapImplAlloc(size, zero_fill, ret_outer, ret_inner);
 }
-static inline void *Underlying_realloc_zf(void *ptr, size_t size, bool zero_fill){
-	return LocalReAlloc(ptr, size, zero_fill ? LPTR : LMEM_FIXED);
+static inline void *Underlying_realloc_zf(void *ptr, size_t size, bool zero_fill, const void *ret_outer, const void *ret_inner){
+	return __MCFCRT_HeapImplRealloc(ptr, size, zero_fill, ret_outer, ret_inner);
 }
 static inline void Underlying_free(void *ptr){
-	LocalFree(ptr);
+	__MCFCRT_HeapImplFree(ptr);
+}
+static inline void *Underlying_aligned_malloc_zf(size_t size, size_t alignment, bool zero_fill, const void *ret_outer, const void *ret_inner){
+	return __MCFCRT_HeapImplAllocAligned(size, alignment, zero_fill, ret_outer, ret_inner);
+}
+static inline void Underlying_free_sized(void *ptr, size_t size, size_t alignment){
+	__MCFCRT_HeapImplFreeSized(ptr, size, alignment);
+}
+static inline size_t Underlying_usable_size(const void *ptr){
+	return __MCFCRT_HeapImplGetUsableSize(ptr);
+}
+static inline bool Underlying_resize_in_place(void *ptr, size_t size, const void *ret_outer, const void *ret_inner){
+	return __MCFCRT_HeapImplResizeInPlace(ptr, size, ret_outer, ret_inner);
 }
 
 static inline void InvokeHeapCallback(void *pBlockNew, size_t uSizeNew, void *pBlockOld, const void *pRetAddrOuter, const void *pRetAddrInner){
@@ -40,21 +56,21 @@ void *__MCFCRT_HeapAlloc(size_t uSizeNew, bool bFillsWithZero, const void *pRetA
 	// Clobber the per-thread error code unconditionally in debug mode.
 	SetLastError(0xDEADBEEF);
 	// Include the size of additional debug information if requested.
-	uSizeToAlloc = __MCFCRT_HeapDebugCalculateSizeToAlloc(uSizeNew);
+	uSizeToAlloc = __MCFCRT_HeapDebugCalculateSizeToAlloc(uSizeNew, 1);
 #else
 	uSizeToAlloc = uSizeNew;
 #endif
 	// Perform the allocation.
-	pStorageNew = Underlying_malloc_zf(uSizeToAlloc, bFillsWithZero);
+	pStorageNew = Underlying_malloc_zf(uSizeToAlloc, bFillsWithZero, pRetAddrOuter, __builtin_return_address(0));
 	if(!pStorageNew){
 		return _MCFCRT_NULLPTR;
 	}
 #ifdef __MCFCRT_HEAP_DEBUG
 	// Register it and adjust the pointer.
-	__MCFCRT_HeapDebugRegister(&pBlockNew, uSizeNew, pStorageNew, pRetAddrOuter, __builtin_return_address(0));
+	__MCFCRT_HeapDebugRegister(&pBlockNew, uSizeNew, 1, pStorageNew, pRetAddrOuter, __builtin_return_address(0));
 	if(!bFillsWithZero && (uSizeNew > 0)){
 		// If any bytes have been allocated, poison those that are considered uninitialized.
-		_MCFCRT_inline_mempset_fwd(pBlockNew, 0xCA, uSizeNew);
+		memset(pBlockNew, 0xCA, uSizeNew);
 	}
 #else
 	pBlockNew = pStorageNew;
@@ -65,42 +81,44 @@ void *__MCFCRT_HeapAlloc(size_t uSizeNew, bool bFillsWithZero, const void *pRetA
 	return pBlockNew;
 }
 void *__MCFCRT_HeapRealloc(void *pBlockOld, size_t uSizeNew, bool bFillsWithZero, const void *pRetAddrOuter){
-	size_t uSizeOld, uSizeToAlloc;
+	size_t uSizeOld, uAlignmentOld, uSizeToAlloc;
 	void *pStorageOld, *pStorageNew, *pBlockNew;
 
 #ifdef __MCFCRT_HEAP_DEBUG
 	// Clobber the per-thread error code unconditionally in debug mode.
 	SetLastError(0xDEADBEEF);
 	// Make sure the old block is not corrupted.
-	if(!__MCFCRT_HeapDebugValidateAndUnregister(&uSizeOld, &pStorageOld, pBlockOld)){
+	if(!__MCFCRT_HeapDebugValidateAndUnregister(&uSizeOld, &uAlignmentOld, &pStorageOld, pBlockOld)){
 		_MCFCRT_Bail(L"__MCFCRT_HeapRealloc() 检测到堆损坏，这通常是错误的内存写入操作导致的。");
 	}
 	if(uSizeOld > uSizeNew){
 		// If the block is to be shrinked, poison bytes that are to be discarded.
-		_MCFCRT_inline_mempset_fwd((unsigned char *)pBlockOld + uSizeNew, 0xDB, uSizeOld - uSizeNew);
+		memset((unsigned char *)pBlockOld + uSizeNew, 0xDB, uSizeOld - uSizeNew);
 	}
 	// Include the size of additional debug information if requested.
-	uSizeToAlloc = __MCFCRT_HeapDebugCalculateSizeToAlloc(uSizeNew);
+	// The padding before the header is preserved, since the underlying storage is copied as a whole. The new block is not necessarily over-aligned, though.
+	uSizeToAlloc = __MCFCRT_HeapDebugCalculateSizeToAlloc(uSizeNew, uAlignmentOld);
 #else
 	(void)uSizeOld;
+	(void)uAlignmentOld;
 	pStorageOld = pBlockOld;
 	uSizeToAlloc = uSizeNew;
 #endif
 	// Perform the reallocation.
-	pStorageNew = Underlying_realloc_zf(pStorageOld, uSizeToAlloc, bFillsWithZero);
+	pStorageNew = Underlying_realloc_zf(pStorageOld, uSizeToAlloc, bFillsWithZero, pRetAddrOuter, __builtin_return_address(0));
 	if(!pStorageNew){
 #ifdef __MCFCRT_HEAP_DEBUG
 		// Stuff it back...
-		__MCFCRT_HeapDebugUndoUnregister(pStorageOld);
+		__MCFCRT_HeapDebugUndoUnregister(pBlockOld);
 #endif
 		return _MCFCRT_NULLPTR;
 	}
 #ifdef __MCFCRT_HEAP_DEBUG
 	// Register it and adjust the pointer.
-	__MCFCRT_HeapDebugRegister(&pBlockNew, uSizeNew, pStorageNew, pRetAddrOuter, __builtin_return_address(0));
+	__MCFCRT_HeapDebugRegister(&pBlockNew, uSizeNew, uAlignmentOld, pStorageNew, pRetAddrOuter, __builtin_return_address(0));
 	if(!bFillsWithZero && (uSizeNew > uSizeOld)){
 		// If the block has been extended, poison bytes that are considered uninitialized.
-		_MCFCRT_inline_mempset_fwd((unsigned char *)pBlockNew + uSizeOld, 0xCC, uSizeNew - uSizeOld);
+		memset((unsigned char *)pBlockNew + uSizeOld, 0xCC, uSizeNew - uSizeOld);
 	}
 #else
 	pBlockNew = pStorageNew;
@@ -111,30 +129,154 @@ void *__MCFCRT_HeapRealloc(void *pBlockOld, size_t uSizeNew, bool bFillsWithZero
 	return pBlockNew;
 }
 void __MCFCRT_HeapFree(void *pBlockOld, const void *pRetAddrOuter){
-	size_t uSizeOld;
+	size_t uSizeOld, uAlignmentOld;
 	void *pStorageOld;
 
 #ifdef __MCFCRT_HEAP_DEBUG
 	// Clobber the per-thread error code unconditionally in debug mode.
 	SetLastError(0xDEADBEEF);
 	// Make sure the old block is not corrupted.
-	if(!__MCFCRT_HeapDebugValidateAndUnregister(&uSizeOld, &pStorageOld, pBlockOld)){
+	if(!__MCFCRT_HeapDebugValidateAndUnregister(&uSizeOld, &uAlignmentOld, &pStorageOld, pBlockOld)){
 		_MCFCRT_Bail(L"__MCFCRT_HeapFree() 检测到堆损坏，这通常是错误的内存写入操作导致的。");
 	}
 	if(uSizeOld > 0){
 		// If any bytes are to be freed, poison those that are to be discarded.
-		_MCFCRT_inline_mempset_fwd(pBlockOld, 0xDD, uSizeOld);
+		memset(pBlockOld, 0xDD, uSizeOld);
+	}
+#else
+	(void)uSizeOld;
+	(void)uAlignmentOld;
+	pStorageOld = pBlockOld;
+#endif
+	// Perform the deallocation.
+	Underlying_free(pStorageOld);
+
+	// Invoke the heap callback in the end, if any.
+	InvokeHeapCallback(_MCFCRT_NULLPTR, 0, pBlockOld, pRetAddrOuter, __builtin_return_address(0));
+}
+bool __MCFCRT_HeapResizeInPlace(void *pBlockOld, size_t uSizeNew, const void *pRetAddrOuter){
+	size_t uSizeOld, uAlignmentOld, uSizeToAlloc;
+	void *pStorageOld, *pBlockNew;
+
+#ifdef __MCFCRT_HEAP_DEBUG
+	// Clobber the per-thread error code unconditionally in debug mode.
+	SetLastError(0xDEADBEEF);
+	// Make sure the old block is not corrupted.
+	if(!__MCFCRT_HeapDebugValidateAndUnregister(&uSizeOld, &uAlignmentOld, &pStorageOld, pBlockOld)){
+		_MCFCRT_Bail(L"__MCFCRT_HeapResizeInPlace() 检测到堆损坏，这通常是错误的内存写入操作导致的。");
 	}
+	// Include the size of additional debug information if requested.
+	uSizeToAlloc = __MCFCRT_HeapDebugCalculateSizeToAlloc(uSizeNew, uAlignmentOld);
 #else
 	(void)uSizeOld;
+	(void)uAlignmentOld;
 	pStorageOld = pBlockOld;
+	uSizeToAlloc = uSizeNew;
+#endif
+	// Perform the resizing.
+	if(!Underlying_resize_in_place(pStorageOld, uSizeToAlloc, pRetAddrOuter, __builtin_return_address(0))){
+#ifdef __MCFCRT_HEAP_DEBUG
+		// Stuff it back...
+		__MCFCRT_HeapDebugUndoUnregister(pBlockOld);
+#endif
+		return false;
+	}
+#ifdef __MCFCRT_HEAP_DEBUG
+	// Register it again. The trailer is moved to the new end of the block.
+	__MCFCRT_HeapDebugRegister(&pBlockNew, uSizeNew, uAlignmentOld, pStorageOld, pRetAddrOuter, __builtin_return_address(0));
+	if(uSizeNew > uSizeOld){
+		// If the block has been extended, poison bytes that are considered uninitialized.
+		memset((unsigned char *)pBlockNew + uSizeOld, 0xCC, uSizeNew - uSizeOld);
+	}
+#else
+	pBlockNew = pStorageOld;
+#endif
+
+	// Invoke the heap callback in the end, if any.
+	InvokeHeapCallback(pBlockNew, uSizeNew, pBlockOld, pRetAddrOuter, __builtin_return_address(0));
+	return true;
+}
+
+void *__MCFCRT_HeapAllocAligned(size_t uSizeNew, size_t uAlignment, bool bFillsWithZero, const void *pRetAddrOuter){
+	size_t uSizeToAlloc;
+	void *pStorageNew, *pBlockNew;
+
+#ifdef __MCFCRT_HEAP_DEBUG
+	// Clobber the per-thread error code unconditionally in debug mode.
+	SetLastError(0xDEADBEEF);
+	// Include the size of additional debug information if requested.
+	// The header is preceded by padding bytes, so the payload is aligned as well as the underlying storage.
+	uSizeToAlloc = __MCFCRT_HeapDebugCalculateSizeToAlloc(uSizeNew, uAlignment);
+#else
+	uSizeToAlloc = uSizeNew;
 #endif
+	// Perform the allocation.
+	pStorageNew = Underlying_aligned_malloc_zf(uSizeToAlloc, uAlignment, bFillsWithZero, pRetAddrOuter, __builtin_return_address(0));
+	if(!pStorageNew){
+		return _MCFCRT_NULLPTR;
+	}
+#ifdef __MCFCRT_HEAP_DEBUG
+	// Register it and adjust the pointer.
+	__MCFCRT_HeapDebugRegister(&pBlockNew, uSizeNew, uAlignment, pStorageNew, pRetAddrOuter, __builtin_return_address(0));
+	if(!bFillsWithZero && (uSizeNew > 0)){
+		// If any bytes have been allocated, poison those that are considered uninitialized.
+		memset(pBlockNew, 0xCA, uSizeNew);
+	}
+#else
+	pBlockNew = pStorageNew;
+#endif
+
+	// Invoke the heap callback in the end, if any.
+	InvokeHeapCallback(pBlockNew, uSizeNew, _MCFCRT_NULLPTR, pRetAddrOuter, __builtin_return_address(0));
+	return pBlockNew;
+}
+void __MCFCRT_HeapFreeSized(void *pBlockOld, size_t uSizeOld, size_t uAlignment, const void *pRetAddrOuter){
+	size_t uSizeRecorded, uAlignmentRecorded;
+	void *pStorageOld;
+
+#ifdef __MCFCRT_HEAP_DEBUG
+	// Clobber the per-thread error code unconditionally in debug mode.
+	SetLastError(0xDEADBEEF);
+	// Make sure the old block is not corrupted.
+	if(!__MCFCRT_HeapDebugValidateAndUnregister(&uSizeRecorded, &uAlignmentRecorded, &pStorageOld, pBlockOld)){
+		_MCFCRT_Bail(L"__MCFCRT_HeapFreeSized() 检测到堆损坏，这通常是错误的内存写入操作导致的。");
+	}
+	// Make sure the caller knows what it is freeing.
+	if(uSizeRecorded != uSizeOld){
+		_MCFCRT_Bail(L"__MCFCRT_HeapFreeSized() 检测到内存块大小不匹配，这通常是释放内存时传入了错误的大小导致的。");
+	}
+	if(uSizeOld > 0){
+		// If any bytes are to be freed, poison those that are to be discarded.
+		memset(pBlockOld, 0xDD, uSizeOld);
+	}
+	// The block may have been reallocated, in which case its alignment no longer tells which kind of block it is. Don't take the shortcut.
+	(void)uAlignment;
+	(void)uAlignmentRecorded;
 	// Perform the deallocation.
 	Underlying_free(pStorageOld);
+#else
+	(void)uSizeRecorded;
+	(void)uAlignmentRecorded;
+	pStorageOld = pBlockOld;
+	// Perform the deallocation. The size saves the underlying allocator from examining the block.
+	Underlying_free_sized(pStorageOld, uSizeOld, uAlignment);
+#endif
 
 	// Invoke the heap callback in the end, if any.
 	InvokeHeapCallback(_MCFCRT_NULLPTR, 0, pBlockOld, pRetAddrOuter, __builtin_return_address(0));
 }
+size_t __MCFCRT_HeapGetUsableSize(const void *pBlock){
+#ifdef __MCFCRT_HEAP_DEBUG
+	// Bytes after the payload belong to the trailer.
+	size_t uSize;
+	if(!__MCFCRT_HeapDebugGetSize(&uSize, pBlock)){
+		_MCFCRT_Bail(L"__MCFCRT_HeapGetUsableSize() 检测到堆损坏，这通常是错误的内存写入操作导致的。");
+	}
+	return uSize;
+#else
+	return Underlying_usable_size(pBlock);
+#endif
+}
 
 static volatile _MCFCRT_HeapCallback g_pfnHeapCallback = _MCFCRT_NULLPTR;
 
@@ -144,3 +286,64 @@ _MCFCRT_HeapCallback _MCFCRT_GetHeapCallback(void){
 _MCFCRT_HeapCallback _MCFCRT_SetHeapCallback(_MCFCRT_HeapCallback pfnNewCallback){
 	return __atomic_exchange_n(&g_pfnHeapCallback, pfnNewCallback, __ATOMIC_RELEASE);
 }
+
+void _MCFCRT_HeapGetStatistics(_MCFCRT_HeapStatistics *pStatistics){
+	__MCFCRT_HeapImplGetStatistics(pStatistics);
+}
+
+size_t _MCFCRT_HeapGetSamplingInterval(void){
+	return __MCFCRT_HeapImplGetSamplingInterval();
+}
+size_t _MCFCRT_HeapSetSamplingInterval(size_t uNewInterval){
+	return __MCFCRT_HeapImplSetSamplingInterval(uNewInterval);
+}
+size_t _MCFCRT_HeapGetProfile(_MCFCRT_HeapProfileEntry *pEntries, size_t uMaxCount){
+	return __MCFCRT_HeapImplGetProfile(pEntries, uMaxCount);
+}
+
+static _MCFCRT_Mutex            g_vDumpMutex                                         = { 0 };
+static _MCFCRT_HeapProfileEntry g_aDumpEntries[__MCFCRT_HEAP_PROFILE_SITE_COUNT_MAX] = { { 0 } };
+
+static inline uintptr_t SaturateToUintPtr(uint64_t u64Value){
+	return (u64Value <= UINTPTR_MAX) ? (uintptr_t)u64Value : UINTPTR_MAX;
+}
+
+size_t _MCFCRT_HeapDumpProfile(void){
+	wchar_t awcLine[1024];
+	size_t uCount;
+	_MCFCRT_WaitForMutexForever(&g_vDumpMutex, _MCFCRT_MUTEX_SUGGESTED_SPIN_COUNT);
+	{
+		uCount = _MCFCRT_HeapGetProfile(g_aDumpEntries, __MCFCRT_HEAP_PROFILE_SITE_COUNT_MAX);
+		if(uCount > __MCFCRT_HEAP_PROFILE_SITE_COUNT_MAX){
+			uCount = __MCFCRT_HEAP_PROFILE_SITE_COUNT_MAX;
+		}
+		// Sort entries by estimated bytes in descending order. This is an insertion sort, which is fine for a few thousand entries.
+		for(size_t uIndex = 1; uIndex < uCount; ++uIndex){
+			const _MCFCRT_HeapProfileEntry vEntry = g_aDumpEntries[uIndex];
+			size_t uInsertAt = uIndex;
+			while((uInsertAt != 0) && (g_aDumpEntries[uInsertAt - 1].__u64EstimatedBytes < vEntry.__u64EstimatedBytes)){
+				g_aDumpEntries[uInsertAt] = g_aDumpEntries[uInsertAt - 1];
+				--uInsertAt;
+			}
+			g_aDumpEntries[uInsertAt] = vEntry;
+		}
+		for(size_t uIndex = 0; uIndex < uCount; ++uIndex){
+			const _MCFCRT_HeapProfileEntry *const pEntry = g_aDumpEntries + uIndex;
+			wchar_t *pwcWrite = awcLine;
+			pwcWrite = _MCFCRT_wcpcpy(pwcWrite, L"*** Heap profile ");
+			pwcWrite = _MCFCRT_itow0u(pwcWrite, uIndex + 1, 4);
+			pwcWrite = _MCFCRT_wcpcpy(pwcWrite, L": estimated bytes = ");
+			pwcWrite = _MCFCRT_itow_u(pwcWrite, SaturateToUintPtr(pEntry->__u64EstimatedBytes));
+			pwcWrite = _MCFCRT_wcpcpy(pwcWrite, L", samples = ");
+			pwcWrite = _MCFCRT_itow_u(pwcWrite, SaturateToUintPtr(pEntry->__u64SampleCount));
+			pwcWrite = _MCFCRT_wcpcpy(pwcWrite, L", allocated from 0x");
+			pwcWrite = _MCFCRT_itow0X(pwcWrite, (uintptr_t)(pEntry->__pRetAddrInner), sizeof(void *) * 2);
+			pwcWrite = _MCFCRT_wcpcpy(pwcWrite, L" inside 0x");
+			pwcWrite = _MCFCRT_itow0X(pwcWrite, (uintptr_t)(pEntry->__pRetAddrOuter), sizeof(void *) * 2);
+			pwcWrite = _MCFCRT_wcpcpy(pwcWrite, L" ***");
+			_MCFCRT_WriteStandardErrorText(awcLine, (size_t)(pwcWrite - awcLine), true);
+		}
+	}
+	_MCFCRT_SignalMutex(&g_vDumpMutex);
+	return uCount;
+}
@@ -15,6 +15,18 @@ __attribute__((__nonnull__(1)))
 extern void *__MCFCRT_HeapRealloc(void *__pBlockOld, _MCFCRT_STD size_t __uSizeNew, bool __bFillsWithZero, const void *__pRetAddrOuter) _MCFCRT_NOEXCEPT;
 __attribute__((__nonnull__(1)))
 extern void __MCFCRT_HeapFree(void *__pBlockOld, const void *__pRetAddrOuter) _MCFCRT_NOEXCEPT;
+// This function resizes a block without moving it. If it returns `false`, the block is left intact.
+__attribute__((__nonnull__(1)))
+extern bool __MCFCRT_HeapResizeInPlace(void *__pBlockOld, _MCFCRT_STD size_t __uSizeNew, const void *__pRetAddrOuter) _MCFCRT_NOEXCEPT;
+// `__uAlignment` shall be a power of two. Blocks allocated by this function can be passed to any other functions above.
+__attribute__((__malloc__))
+extern void *__MCFCRT_HeapAllocAligned(_MCFCRT_STD size_t __uSizeNew, _MCFCRT_STD size_t __uAlignment, bool __bFillsWithZero, const void *__pRetAddrOuter) _MCFCRT_NOEXCEPT;
+// `__uSizeOld` shall be the size of the block as requested. `__uAlignment` shall be the one passed to `__MCFCRT_HeapAllocAligned()`, or one if the block was allocated otherwise.
+__attribute__((__nonnull__(1)))
+extern void __MCFCRT_HeapFreeSized(void *__pBlockOld, _MCFCRT_STD size_t __uSizeOld, _MCFCRT_STD size_t __uAlignment, const void *__pRetAddrOuter) _MCFCRT_NOEXCEPT;
+// The usable size of a block is no less than the size requested. All bytes of it can be accessed, as if they had been requested.
+__attribute__((__nonnull__(1)))
+extern _MCFCRT_STD size_t __MCFCRT_HeapGetUsableSize(const void *__pBlock) _MCFCRT_NOEXCEPT;
 
 typedef void (*_MCFCRT_HeapCallback)(void *__pBlockNew, _MCFCRT_STD size_t __uSizeNew, void *__pBlockOld, const void *__pRetAddrOuter, const void *__pRetAddrInner);
 
@@ -53,6 +65,91 @@ static inline void _MCFCRT_free(void *__ptr) _MCFCRT_NOEXCEPT {
 		__builtin_return_address(0));
 }
 
+// `_MCFCRT_aligned_alloc()` behaves like `aligned_alloc()` in ISO C, and blocks it returns can be freed using `_MCFCRT_free()`. The others are extensions.
+// `__alignment` shall be a power of two, otherwise a null pointer is returned. `__size` need not be a multiple of `__alignment`.
+__attribute__((__always_inline__, __malloc__))
+static inline void *_MCFCRT_aligned_alloc(_MCFCRT_STD size_t __alignment, _MCFCRT_STD size_t __size) _MCFCRT_NOEXCEPT {
+	if((__alignment == 0) || ((__alignment & (__alignment - 1)) != 0)){
+		return _MCFCRT_NULLPTR;
+	}
+	return __MCFCRT_HeapAllocAligned(__size, __alignment, false,
+		__builtin_return_address(0));
+}
+// `__size` shall be the size passed to the allocation function. Passing the size saves the allocator from looking it up.
+__attribute__((__always_inline__))
+static inline void _MCFCRT_free_sized(void *__ptr, _MCFCRT_STD size_t __size) _MCFCRT_NOEXCEPT {
+	if(!__ptr){
+		return;
+	}
+	__MCFCRT_HeapFreeSized(__ptr, __size, 1,
+		__builtin_return_address(0));
+}
+__attribute__((__always_inline__))
+static inline void _MCFCRT_free_aligned_sized(void *__ptr, _MCFCRT_STD size_t __alignment, _MCFCRT_STD size_t __size) _MCFCRT_NOEXCEPT {
+	if(!__ptr){
+		return;
+	}
+	__MCFCRT_HeapFreeSized(__ptr, __size, __alignment,
+		__builtin_return_address(0));
+}
+__attribute__((__always_inline__))
+static inline _MCFCRT_STD size_t _MCFCRT_malloc_usable_size(const void *__ptr) _MCFCRT_NOEXCEPT {
+	if(!__ptr){
+		return 0;
+	}
+	return __MCFCRT_HeapGetUsableSize(__ptr);
+}
+
+// Statistics are collected per thread and merged when `_MCFCRT_HeapGetStatistics()` is called.
+// Sizes are usable sizes of blocks, which may be larger than the sizes requested.
+// The peak is approximate, since every thread flushes its changes of live bytes to the global counter in batches.
+// Bucket `i` of the histogram counts allocations of [2^i, 2^(i+1)) bytes. The last bucket also counts larger ones.
+#define _MCFCRT_HEAP_HISTOGRAM_SIZE            32u
+
+typedef struct __MCFCRT_tagHeapStatistics {
+	_MCFCRT_STD uint64_t __u64AllocCount;
+	_MCFCRT_STD uint64_t __u64ReallocCount;
+	_MCFCRT_STD uint64_t __u64FreeCount;
+	_MCFCRT_STD uint64_t __u64BytesAllocated;
+	_MCFCRT_STD uint64_t __u64BytesFreed;
+	_MCFCRT_STD uint64_t __u64LiveBytes;
+	_MCFCRT_STD uint64_t __u64PeakBytes;
+	_MCFCRT_STD uint64_t __u64SampleCount;
+	_MCFCRT_STD uint64_t __u64DroppedSampleCount;
+	_MCFCRT_STD uint64_t __au64Histogram[_MCFCRT_HEAP_HISTOGRAM_SIZE];
+} _MCFCRT_HeapStatistics;
+
+extern void _MCFCRT_HeapGetStatistics(_MCFCRT_HeapStatistics *__pStatistics) _MCFCRT_NOEXCEPT;
+
+// Allocations are sampled once every N bytes on average and aggregated by call site. Sampling is disabled if N is zero.
+// Every sample represents N bytes, so `__u64EstimatedBytes` estimates the total number of bytes allocated from that call site.
+#define __MCFCRT_HEAP_PROFILE_SITE_COUNT_MAX   1024u
+
+typedef struct __MCFCRT_tagHeapProfileEntry {
+	const void *__pRetAddrOuter;
+	const void *__pRetAddrInner;
+	_MCFCRT_STD uint64_t __u64SampleCount;
+	_MCFCRT_STD uint64_t __u64EstimatedBytes;
+} _MCFCRT_HeapProfileEntry;
+
+extern _MCFCRT_STD size_t _MCFCRT_HeapGetSamplingInterval(void) _MCFCRT_NOEXCEPT;
+extern _MCFCRT_STD size_t _MCFCRT_HeapSetSamplingInterval(_MCFCRT_STD size_t __uNewInterval) _MCFCRT_NOEXCEPT;
+// This function copies at most `__uMaxCount` entries into `__pEntries` in no particular order, and returns the number of all call sites.
+extern _MCFCRT_STD size_t _MCFCRT_HeapGetProfile(_MCFCRT_HeapProfileEntry *__pEntries, _MCFCRT_STD size_t __uMaxCount) _MCFCRT_NOEXCEPT;
+// This function writes the profile to standard error, sorted by estimated bytes in descending order, and returns the number of call sites written.
+extern _MCFCRT_STD size_t _MCFCRT_HeapDumpProfile(void) _MCFCRT_NOEXCEPT;
+
+// This function is not a part of ISO C. Containers can call it to grow their storage without moving elements.
+// It returns `true` if the block has been resized to at least `__size` bytes in place, and `false` otherwise, in which case the block is left intact.
+__attribute__((__always_inline__))
+static inline bool _MCFCRT_TryExpandInPlace(void *__ptr, _MCFCRT_STD size_t __size) _MCFCRT_NOEXCEPT {
+	if(!__ptr){
+		return false;
+	}
+	return __MCFCRT_HeapResizeInPlace(__ptr, __size,
+		__builtin_return_address(0));
+}
+
 _MCFCRT_EXTERN_C_END
 
 #endif
@@ -18,8 +18,8 @@ typedef struct tagBlockHeader {
 	const void *pRetAddrOuter;
 	const void *pRetAddrInner;
 	uintptr_t uCookie;
-	uintptr_t uReserved;
-	unsigned char abySentry[16];
+	size_t uAlignment;
+	uint64_t au64Sentry[2];
 } BlockHeader;
 
 static_assert(sizeof(BlockHeader) % alignof(max_align_t) == 0, "??");
@@ -36,62 +36,83 @@ static inline int BlockHeaderComparatorNodes(const _MCFCRT_AvlNodeHeader *pInfoS
 	return BlockHeaderComparatorNodeHeader(pInfoSelf, (intptr_t)(uintptr_t)(BlockHeader *)pInfoOther);
 }
 
+// The trailer immediately follows the payload, so it may be misaligned.
 typedef struct tagBlockTrailer {
-	unsigned char abySentry[64];
+	uint64_t au64Sentry[8];
 } BlockTrailer;
 
 static_assert(sizeof(BlockTrailer) % alignof(max_align_t) == 0, "??");
 
-static inline unsigned char LcgGetByte(unsigned long *pulSeed){
-	unsigned long ulSeed = *pulSeed;
-	ulSeed = ulSeed * 1664525u + 1013904223u;
-	*pulSeed = ulSeed;
-	return (unsigned char)(ulSeed >> 24);
+static inline uint64_t LcgGetWord(uint64_t *pu64Seed){
+	uint64_t u64Seed = *pu64Seed;
+	u64Seed = u64Seed * 6364136223846793005u + 1442695040888963407u;
+	*pu64Seed = u64Seed;
+	return u64Seed ^ (u64Seed >> 29);
 }
 
+// Sentries are generated and checked one word at a time. The words of the trailer are accessed using `memcpy()`, which copes with misalignment.
 __attribute__((__noinline__, __noclone__))
-static void MakeSentry(unsigned char *pbyData, size_t uSize, uintptr_t uCookie){
-	unsigned long ulSeed = (unsigned long)uCookie;
-	for(size_t uIndex = 0; uIndex < uSize; ++uIndex){
-		pbyData[uIndex] = LcgGetByte(&ulSeed);
+static void MakeSentry(void *pData, size_t uWordCount, uintptr_t uCookie){
+	uint64_t u64Seed = (uint64_t)uCookie;
+	for(size_t uIndex = 0; uIndex < uWordCount; ++uIndex){
+		const uint64_t u64Word = LcgGetWord(&u64Seed);
+		__builtin_memcpy((unsigned char *)pData + uIndex * sizeof(uint64_t), &u64Word, sizeof(uint64_t));
 	}
 }
 __attribute__((__noinline__, __noclone__))
-static bool CheckSentry(uintptr_t uCookie, const unsigned char *pbyData, size_t uSize){
-	unsigned long ulSeed = (unsigned long)uCookie;
-	for(size_t uIndex = 0; uIndex < uSize; ++uIndex){
-		if(pbyData[uIndex] != LcgGetByte(&ulSeed)){
-			return false;
-		}
+static bool CheckSentry(uintptr_t uCookie, const void *pData, size_t uWordCount){
+	uint64_t u64Seed = (uint64_t)uCookie;
+	uint64_t u64Difference = 0;
+	for(size_t uIndex = 0; uIndex < uWordCount; ++uIndex){
+		uint64_t u64Word;
+		__builtin_memcpy(&u64Word, (const unsigned char *)pData + uIndex * sizeof(uint64_t), sizeof(uint64_t));
+		u64Difference |= u64Word ^ LcgGetWord(&u64Seed);
 	}
-	return true;
+	return u64Difference == 0;
+}
+
+// Blocks are distributed into shards by address, each of which has its own mutex.
+#define SHARD_COUNT   64u
+
+typedef struct tagShard {
+	alignas(_MCFCRT_CACHE_LINE_SIZE) _MCFCRT_Mutex vMutex;
+	_MCFCRT_AvlRoot avlBlocks;
+} Shard;
+
+static Shard g_aShards[SHARD_COUNT];
+
+static inline Shard *GetShard(const BlockHeader *pHeader){
+	// Discard the lower bits, which are always zero due to alignment, then take the higher bits of the product.
+	const uint32_t u32Hash = (uint32_t)(((uintptr_t)pHeader >> 4) * 0x9E3779B1u);
+	return g_aShards + (u32Hash >> 26);
 }
 
-static _MCFCRT_Mutex   g_vMutex    = { 0 };
-static _MCFCRT_AvlRoot g_avlBlocks = _MCFCRT_NULLPTR;
+static_assert(SHARD_COUNT == (1u << (32 - 26)), "Please update `GetShard()`.");
 
 static void CheckForMemoryLeaksUnlocked(void){
 	wchar_t awcLine[1024];
 	uintptr_t uCount = 0;
-	const BlockHeader *pHeader = (BlockHeader *)_MCFCRT_AvlFront(&g_avlBlocks);
-	while(pHeader){
-		++uCount;
-		if(uCount <= 9999){
-			wchar_t *pwcWrite = awcLine;
-			pwcWrite = _MCFCRT_wcpcpy(pwcWrite, L"*** Memory leak ");
-			pwcWrite = _MCFCRT_itow0u(pwcWrite, uCount, 4);
-			pwcWrite = _MCFCRT_wcpcpy(pwcWrite, L": address = 0x");
-			pwcWrite = _MCFCRT_itow0X(pwcWrite, (uintptr_t)((char *)pHeader + sizeof(BlockHeader)), sizeof(void *) * 2);
-			pwcWrite = _MCFCRT_wcpcpy(pwcWrite, L", size = 0x");
-			pwcWrite = _MCFCRT_itow0X(pwcWrite, (uintptr_t)(pHeader->uSize), sizeof(size_t) * 2);
-			pwcWrite = _MCFCRT_wcpcpy(pwcWrite, L", allocated from 0x");
-			pwcWrite = _MCFCRT_itow0X(pwcWrite, (uintptr_t)(pHeader->pRetAddrInner), sizeof(void *) * 2);
-			pwcWrite = _MCFCRT_wcpcpy(pwcWrite, L" inside 0x");
-			pwcWrite = _MCFCRT_itow0X(pwcWrite, (uintptr_t)(pHeader->pRetAddrOuter), sizeof(void *) * 2);
-			pwcWrite = _MCFCRT_wcpcpy(pwcWrite, L" ***");
-			_MCFCRT_WriteStandardErrorText(awcLine, (size_t)(pwcWrite - awcLine), true);
+	for(size_t uShard = 0; uShard < SHARD_COUNT; ++uShard){
+		const BlockHeader *pHeader = (BlockHeader *)_MCFCRT_AvlFront(&(g_aShards[uShard].avlBlocks));
+		while(pHeader){
+			++uCount;
+			if(uCount <= 9999){
+				wchar_t *pwcWrite = awcLine;
+				pwcWrite = _MCFCRT_wcpcpy(pwcWrite, L"*** Memory leak ");
+				pwcWrite = _MCFCRT_itow0u(pwcWrite, uCount, 4);
+				pwcWrite = _MCFCRT_wcpcpy(pwcWrite, L": address = 0x");
+				pwcWrite = _MCFCRT_itow0X(pwcWrite, (uintptr_t)((char *)pHeader + sizeof(BlockHeader)), sizeof(void *) * 2);
+				pwcWrite = _MCFCRT_wcpcpy(pwcWrite, L", size = 0x");
+				pwcWrite = _MCFCRT_itow0X(pwcWrite, (uintptr_t)(pHeader->uSize), sizeof(size_t) * 2);
+				pwcWrite = _MCFCRT_wcpcpy(pwcWrite, L", allocated from 0x");
+				pwcWrite = _MCFCRT_itow0X(pwcWrite, (uintptr_t)(pHeader->pRetAddrInner), sizeof(void *) * 2);
+				pwcWrite = _MCFCRT_wcpcpy(pwcWrite, L" inside 0x");
+				pwcWrite = _MCFCRT_itow0X(pwcWrite, (uintptr_t)(pHeader->pRetAddrOuter), sizeof(void *) * 2);
+				pwcWrite = _MCFCRT_wcpcpy(pwcWrite, L" ***");
+				_MCFCRT_WriteStandardErrorText(awcLine, (size_t)(pwcWrite - awcLine), true);
+			}
+			pHeader = (BlockHeader *)_MCFCRT_AvlNext((_MCFCRT_AvlNodeHeader *)pHeader);
 		}
-		pHeader = (BlockHeader *)_MCFCRT_AvlNext((_MCFCRT_AvlNodeHeader *)pHeader);
 	}
 	if(uCount > 9999){
 		wchar_t *pwcWrite = awcLine;
@@ -114,15 +135,20 @@ void __MCFCRT_HeapDebugUninit(void){
 	CheckForMemoryLeaksUnlocked();
 }
 
-size_t __MCFCRT_HeapDebugCalculateSizeToAlloc(size_t uSize){
+// Over-aligned blocks have padding bytes before their headers, so their payloads are aligned as long as the underlying storage is.
+static inline size_t GetPaddingSize(size_t uAlignment){
+	return (uAlignment - sizeof(BlockHeader) % uAlignment) % uAlignment;
+}
+
+size_t __MCFCRT_HeapDebugCalculateSizeToAlloc(size_t uSize, size_t uAlignment){
 	size_t uSizeToAlloc;
-	if(__builtin_add_overflow(uSize, sizeof(BlockHeader) + sizeof(BlockTrailer), &uSizeToAlloc)){
+	if(__builtin_add_overflow(uSize, GetPaddingSize(uAlignment) + sizeof(BlockHeader) + sizeof(BlockTrailer), &uSizeToAlloc)){
 		return SIZE_MAX;
 	}
 	return uSizeToAlloc;
 }
-void __MCFCRT_HeapDebugRegister(void **restrict ppBlock, size_t uSize, void *pStorage, const void *pRetAddrOuter, const void *pRetAddrInner){
-	BlockHeader *const pHeader = pStorage;
+void __MCFCRT_HeapDebugRegister(void **restrict ppBlock, size_t uSize, size_t uAlignment, void *pStorage, const void *pRetAddrOuter, const void *pRetAddrInner){
+	BlockHeader *const pHeader = (void *)((char *)pStorage + GetPaddingSize(uAlignment));
 	void *const pBlock = (char *)pHeader + sizeof(BlockHeader);
 	BlockTrailer *const pTrailer = (void *)((char *)pHeader + sizeof(BlockHeader) + uSize);
 
@@ -131,65 +157,78 @@ void __MCFCRT_HeapDebugRegister(void **restrict ppBlock, size_t uSize, void *pSt
 	pHeader->pRetAddrOuter = pRetAddrOuter;
 	pHeader->pRetAddrInner = pRetAddrInner;
 	pHeader->uCookie = (uintptr_t)_MCFCRT_GetFastMonoClock();
-	pHeader->uReserved = 0;
-	MakeSentry(pHeader->abySentry, sizeof(pHeader->abySentry), pHeader->uCookie);
+	pHeader->uAlignment = uAlignment;
+	MakeSentry(pHeader->au64Sentry, sizeof(pHeader->au64Sentry) / sizeof(uint64_t), pHeader->uCookie);
 	// Initialize the trailer.
-	MakeSentry(pTrailer->abySentry, sizeof(pTrailer->abySentry), pHeader->uCookie);
+	MakeSentry(pTrailer, sizeof(BlockTrailer) / sizeof(uint64_t), pHeader->uCookie);
 
 	// Register it.
-	_MCFCRT_WaitForMutexForever(&g_vMutex, _MCFCRT_MUTEX_SUGGESTED_SPIN_COUNT);
-	_MCFCRT_AvlAttach(&g_avlBlocks, (_MCFCRT_AvlNodeHeader *)pStorage, &BlockHeaderComparatorNodes);
-	_MCFCRT_SignalMutex(&g_vMutex);
+	Shard *const pShard = GetShard(pHeader);
+	_MCFCRT_WaitForMutexForever(&(pShard->vMutex), _MCFCRT_MUTEX_SUGGESTED_SPIN_COUNT);
+	_MCFCRT_AvlAttach(&(pShard->avlBlocks), (_MCFCRT_AvlNodeHeader *)pHeader, &BlockHeaderComparatorNodes);
+	_MCFCRT_SignalMutex(&(pShard->vMutex));
 
 	*ppBlock = pBlock;
 }
-bool __MCFCRT_HeapDebugValidateAndUnregister(size_t *restrict puSize, void **restrict ppStorage, void *pBlock){
-	void *const pStorage = (char *)pBlock - sizeof(BlockHeader);
-	BlockHeader *const pHeader = pStorage;
+bool __MCFCRT_HeapDebugValidateAndUnregister(size_t *restrict puSize, size_t *restrict puAlignment, void **restrict ppStorage, void *pBlock){
+	BlockHeader *const pHeader = (void *)((char *)pBlock - sizeof(BlockHeader));
 	const size_t uSize = pHeader->uSize;
 	BlockTrailer *const pTrailer = (void *)((char *)pHeader + sizeof(BlockHeader) + uSize);
 
 	// Check the header.
-	if(!CheckSentry(pHeader->uCookie, pHeader->abySentry, sizeof(pHeader->abySentry))){
+	if(!CheckSentry(pHeader->uCookie, pHeader->au64Sentry, sizeof(pHeader->au64Sentry) / sizeof(uint64_t))){
 		return false;
 	}
 	// Check the trailer.
-	if(!CheckSentry(pHeader->uCookie, pTrailer->abySentry, sizeof(pTrailer->abySentry))){
+	if(!CheckSentry(pHeader->uCookie, pTrailer, sizeof(BlockTrailer) / sizeof(uint64_t))){
 		return false;
 	}
 
-	// Search for it in all registered blocks. Detach it if one is found.
-	_MCFCRT_WaitForMutexForever(&g_vMutex, _MCFCRT_MUTEX_SUGGESTED_SPIN_COUNT);
-	BlockHeader *const pHeaderFound = (BlockHeader *)_MCFCRT_AvlFind(&g_avlBlocks, (intptr_t)pHeader, &BlockHeaderComparatorNodeHeader);
+	// Search for it in registered blocks. Detach it if one is found.
+	Shard *const pShard = GetShard(pHeader);
+	_MCFCRT_WaitForMutexForever(&(pShard->vMutex), _MCFCRT_MUTEX_SUGGESTED_SPIN_COUNT);
+	BlockHeader *const pHeaderFound = (BlockHeader *)_MCFCRT_AvlFind(&(pShard->avlBlocks), (intptr_t)pHeader, &BlockHeaderComparatorNodeHeader);
 	if(pHeaderFound != pHeader){
-		_MCFCRT_SignalMutex(&g_vMutex);
+		_MCFCRT_SignalMutex(&(pShard->vMutex));
 		return false;
 	}
-	_MCFCRT_AvlDetach((_MCFCRT_AvlNodeHeader *)pStorage);
-	_MCFCRT_SignalMutex(&g_vMutex);
+	_MCFCRT_AvlDetach((_MCFCRT_AvlNodeHeader *)pHeader);
+	_MCFCRT_SignalMutex(&(pShard->vMutex));
 
 	// Leave the header alone in order to enable the unregistration to be reverted.
 	// Zero out the trailer so the storage can be passed to `HeapReAlloc()` with the `HEAP_ZERO_MEMORY` option without causing confusion.
 	_MCFCRT_inline_mempset_fwd(pTrailer, 0, sizeof(*pTrailer));
 
-	*ppStorage = pStorage;
+	*ppStorage = (char *)pHeader - GetPaddingSize(pHeader->uAlignment);
 	*puSize = uSize;
+	*puAlignment = pHeader->uAlignment;
 	return true;
 }
-void __MCFCRT_HeapDebugUndoUnregister(void *pStorage){
-	BlockHeader *const pHeader = pStorage;
+void __MCFCRT_HeapDebugUndoUnregister(void *pBlock){
+	BlockHeader *const pHeader = (void *)((char *)pBlock - sizeof(BlockHeader));
 	const size_t uSize = pHeader->uSize;
 
 	// Generate a new cookie and update the header sentry.
 	pHeader->uCookie = (uintptr_t)_MCFCRT_GetFastMonoClock();
-	pHeader->uReserved = 0;
-	MakeSentry(pHeader->abySentry, sizeof(pHeader->abySentry), pHeader->uCookie);
+	MakeSentry(pHeader->au64Sentry, sizeof(pHeader->au64Sentry) / sizeof(uint64_t), pHeader->uCookie);
 	// Reinitialize the trailer.
 	BlockTrailer *const pTrailer = (void *)((char *)pHeader + sizeof(BlockHeader) + uSize);
-	MakeSentry(pTrailer->abySentry, sizeof(pTrailer->abySentry), pHeader->uCookie);
+	MakeSentry(pTrailer, sizeof(BlockTrailer) / sizeof(uint64_t), pHeader->uCookie);
 
 	// Re-register it.
-	_MCFCRT_WaitForMutexForever(&g_vMutex, _MCFCRT_MUTEX_SUGGESTED_SPIN_COUNT);
-	_MCFCRT_AvlAttach(&g_avlBlocks, (_MCFCRT_AvlNodeHeader *)pStorage, &BlockHeaderComparatorNodes);
-	_MCFCRT_SignalMutex(&g_vMutex);
+	Shard *const pShard = GetShard(pHeader);
+	_MCFCRT_WaitForMutexForever(&(pShard->vMutex), _MCFCRT_MUTEX_SUGGESTED_SPIN_COUNT);
+	_MCFCRT_AvlAttach(&(pShard->avlBlocks), (_MCFCRT_AvlNodeHeader *)pHeader, &BlockHeaderComparatorNodes);
+	_MCFCRT_SignalMutex(&(pShard->vMutex));
+}
+bool __MCFCRT_HeapDebugGetSize(size_t *restrict puSize, const void *pBlock){
+	const BlockHeader *const pHeader = (const void *)((const char *)pBlock - sizeof(BlockHeader));
+
+	// Check the header. The trailer will be checked when the block is freed.
+	if(!CheckSentry(pHeader->uCookie, pHeader->au64Sentry, sizeof(pHeader->au64Sentry) / sizeof(uint64_t))){
+		return false;
+	}
+
+	*puSize = pHeader->uSize;
+	return true;
 }
@@ -13,21 +13,25 @@ extern bool __MCFCRT_HeapDebugInit(void) _MCFCRT_NOEXCEPT;
 extern void __MCFCRT_HeapDebugUninit(void) _MCFCRT_NOEXCEPT;
 
 // This function returns the number of bytes that should be passed to underlying heap allocation functions.
+// `__uAlignment` shall be a power of two. If the underlying storage is aligned to it, so is the payload. Pass `1` for blocks that are not over-aligned.
 // This function returns `SIZE_MAX` if the size would overflow.
-extern _MCFCRT_STD size_t __MCFCRT_HeapDebugCalculateSizeToAlloc(_MCFCRT_STD size_t __uSize) _MCFCRT_NOEXCEPT;
+extern _MCFCRT_STD size_t __MCFCRT_HeapDebugCalculateSizeToAlloc(_MCFCRT_STD size_t __uSize, _MCFCRT_STD size_t __uAlignment) _MCFCRT_NOEXCEPT;
 // After the underlying allocation succeeds, this function creates a record for that memory block which is used for validation should the memory block be freed.
 // `*__ppBlock` is set to a pointer to the payload, which is at least `__uSize` bytes large.
-// The `__uSize` parameter shall be equal to (or less than, if you like) the one passed to the corresponding `__MCFCRT_HeapDebugCalculateSizeToAlloc()`.
+// The `__uSize` and `__uAlignment` parameters shall be equal to those passed to the corresponding `__MCFCRT_HeapDebugCalculateSizeToAlloc()` (`__uSize` may be less, if you like).
 // This function will not fail. If `__pStorage` is a null pointer, the behavior is undefined.
-extern void __MCFCRT_HeapDebugRegister(void **_MCFCRT_RESTRICT __ppBlock, _MCFCRT_STD size_t __uSize, void *__pStorage, const void *__pRetAddrOuter, const void *__pRetAddrInner) _MCFCRT_NOEXCEPT;
+extern void __MCFCRT_HeapDebugRegister(void **_MCFCRT_RESTRICT __ppBlock, _MCFCRT_STD size_t __uSize, _MCFCRT_STD size_t __uAlignment, void *__pStorage, const void *__pRetAddrOuter, const void *__pRetAddrInner) _MCFCRT_NOEXCEPT;
 // This function checks and removes the record for a memory block.
-// `*__puSize` and `*__ppStorage` are set to `__uSize` and `__pStorage` that were passed to the corresponding `__MCFCRT_HeapDebugRegister()`, respectively.
+// `*__puSize`, `*__puAlignment` and `*__ppStorage` are set to `__uSize`, `__uAlignment` and `__pStorage` that were passed to the corresponding `__MCFCRT_HeapDebugRegister()`, respectively.
 // The bytes in the underlying storage that follow the payload are zeroed before the function returns successfully.
 // This function returns `false` if the memory block is corrupted, in which case the record is not removed. The memory block MUST NOT be freed thereafter.
 // If `__pBlock` is a null pointer, the behavior is undefined.
-extern bool __MCFCRT_HeapDebugValidateAndUnregister(_MCFCRT_STD size_t *_MCFCRT_RESTRICT __puSize, void **_MCFCRT_RESTRICT __ppStorage, void *__pBlock) _MCFCRT_NOEXCEPT;
+extern bool __MCFCRT_HeapDebugValidateAndUnregister(_MCFCRT_STD size_t *_MCFCRT_RESTRICT __puSize, _MCFCRT_STD size_t *_MCFCRT_RESTRICT __puAlignment, void **_MCFCRT_RESTRICT __ppStorage, void *__pBlock) _MCFCRT_NOEXCEPT;
 // This function reverts the effects of the previous `__MCFCRT_HeapDebugValidateAndUnregister()`.
-extern void __MCFCRT_HeapDebugUndoUnregister(void *__pStorage) _MCFCRT_NOEXCEPT;
+extern void __MCFCRT_HeapDebugUndoUnregister(void *__pBlock) _MCFCRT_NOEXCEPT;
+// This function checks the header of a memory block without removing its record. `*__puSize` is set to the `__uSize` that was passed to `__MCFCRT_HeapDebugRegister()`.
+// This function returns `false` if the header is corrupted. If `__pBlock` is a null pointer, the behavior is undefined.
+extern bool __MCFCRT_HeapDebugGetSize(_MCFCRT_STD size_t *_MCFCRT_RESTRICT __puSize, const void *__pBlock) _MCFCRT_NOEXCEPT;
 
 _MCFCRT_EXTERN_C_END
 
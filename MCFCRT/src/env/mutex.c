@@ -4,18 +4,10 @@
 
 #define __MCFCRT_MUTEX_INLINE_OR_EXTERN     extern inline
 #include "mutex.h"
-#include "_nt_timeout.h"
+#include "_park.h"
+#include "_mutex_profile.h"
 #include "xassert.h"
 #include "expect.h"
-#include <ntdef.h>
-
-__attribute__((__dllimport__, __stdcall__))
-extern NTSTATUS NtWaitForKeyedEvent(HANDLE hKeyedEvent, void *pKey, BOOLEAN bAlertable, const LARGE_INTEGER *pliTimeout);
-__attribute__((__dllimport__, __stdcall__))
-extern NTSTATUS NtReleaseKeyedEvent(HANDLE hKeyedEvent, void *pKey, BOOLEAN bAlertable, const LARGE_INTEGER *pliTimeout);
-
-__attribute__((__dllimport__, __stdcall__, __const__))
-extern BOOLEAN RtlDllShutdownInProgress(void);
 
 #ifndef __BYTE_ORDER__
 #  error Byte order is unknown.
@@ -47,10 +39,11 @@ extern BOOLEAN RtlDllShutdownInProgress(void);
 #define MAX_SPIN_MULTIPLIER     ((uintptr_t)32)
 
 __attribute__((__always_inline__))
-static inline bool ReallyWaitForMutex(volatile uintptr_t *puControl, size_t uMaxSpinCountInitial, bool bMayTimeOut, uint64_t u64UntilFastMonoClock){
+static inline bool ReallyWaitForMutex(volatile uintptr_t *puControl, size_t uMaxSpinCountInitial, bool bMayTimeOut, uint64_t u64UntilFastMonoClock, __MCFCRT_MutexWaitRecord *pRecord){
 	for(;;){
 		size_t uMaxSpinCount, uSpinMultiplier;
 		bool bTaken, bSpinnable;
+		size_t uTrappedCount = 0;
 		{
 			uintptr_t uOld, uNew;
 			uOld = __atomic_load_n(puControl, __ATOMIC_RELAXED);
@@ -85,6 +78,9 @@ static inline bool ReallyWaitForMutex(volatile uintptr_t *puControl, size_t uMax
 		}
 		if(_MCFCRT_EXPECT(bSpinnable)){
 			for(size_t uSpinIndex = 0; _MCFCRT_EXPECT(uSpinIndex < uMaxSpinCount); ++uSpinIndex){
+				if(pRecord){
+					++(pRecord->__u64SpinCount);
+				}
 				register size_t uMultiplierIndex = uSpinMultiplier + 1;
 				__atomic_thread_fence(__ATOMIC_SEQ_CST);
 				do {
@@ -122,6 +118,7 @@ static inline bool ReallyWaitForMutex(volatile uintptr_t *puControl, size_t uMax
 						uNew = uOld - THREADS_SPINNING_ONE + MASK_LOCKED - bSpinFailureCountDecremented * SPIN_FAILURE_COUNT_ONE;
 					}
 				} while(_MCFCRT_EXPECT_NOT(!__atomic_compare_exchange_n(puControl, &uOld, uNew, false, __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE)));
+				uTrappedCount = (uNew & MASK_THREADS_TRAPPED) / THREADS_TRAPPED_ONE;
 			}
 			if(_MCFCRT_EXPECT(bTaken)){
 				return true;
@@ -138,17 +135,19 @@ static inline bool ReallyWaitForMutex(volatile uintptr_t *puControl, size_t uMax
 						uNew = uOld + MASK_LOCKED;
 					}
 				} while(_MCFCRT_EXPECT_NOT(!__atomic_compare_exchange_n(puControl, &uOld, uNew, false, __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE)));
+				uTrappedCount = (uNew & MASK_THREADS_TRAPPED) / THREADS_TRAPPED_ONE;
 			}
 			if(_MCFCRT_EXPECT(bTaken)){
 				return true;
 			}
 		}
+		double dParkBeginTime = 0;
+		if(pRecord){
+			dParkBeginTime = __MCFCRT_MutexProfileBeginPark(pRecord, uTrappedCount);
+		}
 		if(bMayTimeOut){
-			LARGE_INTEGER liTimeout;
-			__MCFCRT_InitializeNtTimeout(&liTimeout, u64UntilFastMonoClock);
-			NTSTATUS lStatus = NtWaitForKeyedEvent(_MCFCRT_NULLPTR, (void *)puControl, false, &liTimeout);
-			_MCFCRT_ASSERT_MSG(NT_SUCCESS(lStatus), L"NtWaitForKeyedEvent() 失败。");
-			while(_MCFCRT_EXPECT(lStatus == STATUS_TIMEOUT)){
+			bool bReleased = __MCFCRT_ParkThread(puControl, u64UntilFastMonoClock);
+			while(_MCFCRT_EXPECT(!bReleased)){
 				bool bDecremented;
 				{
 					uintptr_t uOld, uNew;
@@ -163,16 +162,18 @@ static inline bool ReallyWaitForMutex(volatile uintptr_t *puControl, size_t uMax
 					} while(_MCFCRT_EXPECT_NOT(!__atomic_compare_exchange_n(puControl, &uOld, uNew, false, __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE)));
 				}
 				if(bDecremented){
+					if(pRecord){
+						__MCFCRT_MutexProfileEndPark(pRecord, dParkBeginTime);
+					}
 					return false;
 				}
-				liTimeout.QuadPart = 0;
-				lStatus = NtWaitForKeyedEvent(_MCFCRT_NULLPTR, (void *)puControl, false, &liTimeout);
-				_MCFCRT_ASSERT_MSG(NT_SUCCESS(lStatus), L"NtWaitForKeyedEvent() 失败。");
+				bReleased = __MCFCRT_ParkThread(puControl, 0);
 			}
 		} else {
-			NTSTATUS lStatus = NtWaitForKeyedEvent(_MCFCRT_NULLPTR, (void *)puControl, false, _MCFCRT_NULLPTR);
-			_MCFCRT_ASSERT_MSG(NT_SUCCESS(lStatus), L"NtWaitForKeyedEvent() 失败。");
-			_MCFCRT_ASSERT(lStatus != STATUS_TIMEOUT);
+			__MCFCRT_ParkThreadForever(puControl);
+		}
+		if(pRecord){
+			__MCFCRT_MutexProfileEndPark(pRecord, dParkBeginTime);
 		}
 	}
 }
@@ -188,23 +189,67 @@ static inline void ReallySignalMutex(volatile uintptr_t *puControl){
 			uNew = (uOld & ~MASK_LOCKED) - bSignalOne * THREADS_TRAPPED_ONE;
 		} while(_MCFCRT_EXPECT_NOT(!__atomic_compare_exchange_n(puControl, &uOld, uNew, false, __ATOMIC_RELEASE, __ATOMIC_RELAXED)));
 	}
-	// If `RtlDllShutdownInProgress()` is `true`, other threads will have been terminated.
-	// Calling `NtReleaseKeyedEvent()` when no thread is waiting results in deadlocks. Don't do that.
-	if(_MCFCRT_EXPECT_NOT(bSignalOne && !RtlDllShutdownInProgress())){
-		NTSTATUS lStatus = NtReleaseKeyedEvent(_MCFCRT_NULLPTR, (void *)puControl, false, _MCFCRT_NULLPTR);
-		_MCFCRT_ASSERT_MSG(NT_SUCCESS(lStatus), L"NtReleaseKeyedEvent() 失败。");
-		_MCFCRT_ASSERT(lStatus != STATUS_TIMEOUT);
+	if(_MCFCRT_EXPECT_NOT(bSignalOne)){
+		__MCFCRT_UnparkThreads(puControl, 1);
 	}
 }
 
+// These functions are called from the inline fast paths in `mutex.h`, so `__builtin_return_address(0)` is the call site in user code.
 bool __MCFCRT_ReallyWaitForMutex(_MCFCRT_Mutex *pMutex, size_t uMaxSpinCount, uint64_t u64UntilFastMonoClock){
-	const bool bLocked = ReallyWaitForMutex(&(pMutex->__u), uMaxSpinCount, true, u64UntilFastMonoClock);
+	if(_MCFCRT_EXPECT_NOT(__MCFCRT_MutexProfileIsEnabled())){
+		__MCFCRT_MutexWaitRecord vRecord;
+		__MCFCRT_MutexProfileBeginWait(&vRecord);
+		const bool bLocked = ReallyWaitForMutex(&(pMutex->__u), uMaxSpinCount, true, u64UntilFastMonoClock, &vRecord);
+		__MCFCRT_MutexProfileEndWait(&vRecord, pMutex, __builtin_return_address(0), bLocked);
+		return bLocked;
+	}
+	const bool bLocked = ReallyWaitForMutex(&(pMutex->__u), uMaxSpinCount, true, u64UntilFastMonoClock, _MCFCRT_NULLPTR);
 	return bLocked;
 }
 void __MCFCRT_ReallyWaitForMutexForever(_MCFCRT_Mutex *pMutex, size_t uMaxSpinCount){
-	const bool bLocked = ReallyWaitForMutex(&(pMutex->__u), uMaxSpinCount, false, UINT64_MAX);
+	if(_MCFCRT_EXPECT_NOT(__MCFCRT_MutexProfileIsEnabled())){
+		__MCFCRT_MutexWaitRecord vRecord;
+		__MCFCRT_MutexProfileBeginWait(&vRecord);
+		const bool bLocked = ReallyWaitForMutex(&(pMutex->__u), uMaxSpinCount, false, UINT64_MAX, &vRecord);
+		_MCFCRT_ASSERT(bLocked);
+		__MCFCRT_MutexProfileEndWait(&vRecord, pMutex, __builtin_return_address(0), bLocked);
+		return;
+	}
+	const bool bLocked = ReallyWaitForMutex(&(pMutex->__u), uMaxSpinCount, false, UINT64_MAX, _MCFCRT_NULLPTR);
 	_MCFCRT_ASSERT(bLocked);
 }
 void __MCFCRT_ReallySignalMutex(_MCFCRT_Mutex *pMutex){
 	ReallySignalMutex(&(pMutex->__u));
 }
+bool __MCFCRT_TrapThreadOnMutex(_MCFCRT_Mutex *pMutex, bool bEvenIfUnlocked){
+	volatile uintptr_t *const puControl = &(pMutex->__u);
+	bool bTrapped;
+	{
+		uintptr_t uOld, uNew;
+		uOld = __atomic_load_n(puControl, __ATOMIC_RELAXED);
+		do {
+			bTrapped = bEvenIfUnlocked || (uOld & MASK_LOCKED);
+			if(!bTrapped){
+				break;
+			}
+			uNew = uOld + THREADS_TRAPPED_ONE;
+		} while(_MCFCRT_EXPECT_NOT(!__atomic_compare_exchange_n(puControl, &uOld, uNew, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED)));
+	}
+	return bTrapped;
+}
+
+bool _MCFCRT_GetMutexProfilingEnabled(void){
+	return __MCFCRT_MutexProfileIsEnabled();
+}
+bool _MCFCRT_SetMutexProfilingEnabled(bool bEnabled){
+	return __MCFCRT_MutexProfileSetEnabled(bEnabled);
+}
+size_t _MCFCRT_GetMutexProfileByMutex(_MCFCRT_MutexProfileEntry *pEntries, size_t uMaxCount){
+	return __MCFCRT_MutexProfileSnapshot(pEntries, uMaxCount, false);
+}
+size_t _MCFCRT_GetMutexProfileByCallSite(_MCFCRT_MutexProfileEntry *pEntries, size_t uMaxCount){
+	return __MCFCRT_MutexProfileSnapshot(pEntries, uMaxCount, true);
+}
+void _MCFCRT_ResetMutexProfile(void){
+	__MCFCRT_MutexProfileReset();
+}
@@ -27,6 +27,9 @@ __MCFCRT_MUTEX_INLINE_OR_EXTERN void _MCFCRT_InitializeMutex(_MCFCRT_Mutex *__pM
 extern bool __MCFCRT_ReallyWaitForMutex(_MCFCRT_Mutex *__pMutex, _MCFCRT_STD size_t __uMaxSpinCount, _MCFCRT_STD uint64_t __u64UntilFastMonoClock) _MCFCRT_NOEXCEPT;
 extern void __MCFCRT_ReallyWaitForMutexForever(_MCFCRT_Mutex *__pMutex, _MCFCRT_STD size_t __uMaxSpinCount) _MCFCRT_NOEXCEPT;
 extern void __MCFCRT_ReallySignalMutex(_MCFCRT_Mutex *__pMutex) _MCFCRT_NOEXCEPT;
+// This function counts one more thread that is going to be parked on the mutex, which will be woken up by the next call to `_MCFCRT_SignalMutex()`.
+// If `__bEvenIfUnlocked` is `false` and the mutex is not locked, it does nothing and returns `false`. Otherwise the caller must make sure that some thread will lock the mutex.
+extern bool __MCFCRT_TrapThreadOnMutex(_MCFCRT_Mutex *__pMutex, bool __bEvenIfUnlocked) _MCFCRT_NOEXCEPT;
 
 __MCFCRT_MUTEX_INLINE_OR_EXTERN bool _MCFCRT_WaitForMutex(_MCFCRT_Mutex *__pMutex, _MCFCRT_STD size_t __uMaxSpinCount, _MCFCRT_STD uint64_t __u64UntilFastMonoClock) _MCFCRT_NOEXCEPT {
 	unsigned char *const __pbyGuard = (unsigned char *)(void *)&(__pMutex->__u);
@@ -48,6 +51,34 @@ __MCFCRT_MUTEX_INLINE_OR_EXTERN void _MCFCRT_SignalMutex(_MCFCRT_Mutex *__pMutex
 	__MCFCRT_ReallySignalMutex(__pMutex);
 }
 
+// Contention profiling is disabled by default. Once enabled, every wait that leaves the inline fast path above is recorded, and uncontended locking costs nothing.
+// Waits are aggregated by the mutex and the call site into per-thread tables, which are merged on demand.
+// Bucket `i` of the histogram counts waits of [2^i, 2^(i+1)) microseconds. The first bucket also counts shorter ones, and the last bucket also counts longer ones.
+#define _MCFCRT_MUTEX_PROFILE_HISTOGRAM_SIZE   24u
+
+typedef struct __MCFCRT_tagMutexProfileEntry {
+	const void *__pMutex;                   // This is a null pointer if entries are aggregated by call site.
+	const void *__pRetAddr;                 // This is a null pointer if entries are aggregated by mutex.
+	_MCFCRT_STD uint64_t __u64WaitCount;
+	_MCFCRT_STD uint64_t __u64TimeoutCount;
+	_MCFCRT_STD uint64_t __u64SpinCount;    // This is the total number of spin iterations.
+	_MCFCRT_STD uint64_t __u64ParkCount;    // This is the total number of times that threads were put into sleep.
+	_MCFCRT_STD uint64_t __u64TrappedSum;   // This is the total number of threads that were sleeping, including the current one, each time a thread went to sleep.
+	_MCFCRT_STD uint64_t __u64TrappedMax;
+	_MCFCRT_STD uint64_t __u64WaitMicroseconds;
+	_MCFCRT_STD uint64_t __u64ParkMicroseconds;
+	_MCFCRT_STD uint64_t __au64Histogram[_MCFCRT_MUTEX_PROFILE_HISTOGRAM_SIZE];
+} _MCFCRT_MutexProfileEntry;
+
+extern bool _MCFCRT_GetMutexProfilingEnabled(void) _MCFCRT_NOEXCEPT;
+extern bool _MCFCRT_SetMutexProfilingEnabled(bool __bEnabled) _MCFCRT_NOEXCEPT;
+// These functions copy at most `__uMaxCount` entries with the longest total wait times into `__pEntries`, sorted in descending order, and return the number of all mutexes or call sites.
+extern _MCFCRT_STD size_t _MCFCRT_GetMutexProfileByMutex(_MCFCRT_MutexProfileEntry *__pEntries, _MCFCRT_STD size_t __uMaxCount) _MCFCRT_NOEXCEPT;
+extern _MCFCRT_STD size_t _MCFCRT_GetMutexProfileByCallSite(_MCFCRT_MutexProfileEntry *__pEntries, _MCFCRT_STD size_t __uMaxCount) _MCFCRT_NOEXCEPT;
+// This function discards all records. Waits that are being recorded concurrently may be lost or counted partially.
+// Waits of new mutexes and call sites are dropped once the tables are full, so call this function every now and then if mutexes come and go.
+extern void _MCFCRT_ResetMutexProfile(void) _MCFCRT_NOEXCEPT;
+
 _MCFCRT_EXTERN_C_END
 
 #endif
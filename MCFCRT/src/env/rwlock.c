@@ -0,0 +1,346 @@
+// 这个文件是 MCF 的一部分。
+// 有关具体授权说明，请参阅 MCFLicense.txt。
+// Copyleft 2013 - 2018, LH_Mouse. All wrongs reserved.
+
+#define __MCFCRT_RWLOCK_INLINE_OR_EXTERN     extern inline
+#include "rwlock.h"
+#include "_park.h"
+#include "thread.h"
+#include "xassert.h"
+#include "expect.h"
+
+// The lock word is laid out as follows:
+//   bit 0       the lock is owned by a writer, which may be waiting for readers to leave
+//   bit 1       a writer is sleeping until readers leave
+//   bits 2-21   number of readers that are counted in the lock word
+//   bits 22-41  number of readers that are sleeping
+//   bits 42-61  number of writers that are sleeping
+// Readers and writers sleep on different keys. The writer that waits for readers to leave sleeps on a third key.
+#define MASK_LOCKED             ((uint64_t)0x0000000000000001)
+#define MASK_DRAINING           ((uint64_t)0x0000000000000002)
+#define MASK_READERS            ((uint64_t)0x00000000003FFFFC)
+#define MASK_READERS_TRAPPED    ((uint64_t)0x000003FFFFC00000)
+#define MASK_WRITERS_TRAPPED    ((uint64_t)0x3FFFFC0000000000)
+
+#define READERS_ONE             ((uint64_t)(MASK_READERS & -MASK_READERS))
+#define READERS_MAX             ((uint64_t)(MASK_READERS / READERS_ONE))
+
+#define READERS_TRAPPED_ONE     ((uint64_t)(MASK_READERS_TRAPPED & -MASK_READERS_TRAPPED))
+#define READERS_TRAPPED_MAX     ((uint64_t)(MASK_READERS_TRAPPED / READERS_TRAPPED_ONE))
+
+#define WRITERS_TRAPPED_ONE     ((uint64_t)(MASK_WRITERS_TRAPPED & -MASK_WRITERS_TRAPPED))
+#define WRITERS_TRAPPED_MAX     ((uint64_t)(MASK_WRITERS_TRAPPED / WRITERS_TRAPPED_ONE))
+
+static_assert(MASK_LOCKED == __MCFCRT_RWLOCK_MASK_LOCKED, "Please update `rwlock.h`.");
+static_assert(READERS_ONE == __MCFCRT_RWLOCK_READERS_ONE, "Please update `rwlock.h`.");
+
+static inline const volatile void *GetReaderKey(volatile uint64_t *pu64Control){
+	return pu64Control;
+}
+static inline const volatile void *GetWriterKey(volatile uint64_t *pu64Control){
+	return (const volatile char *)pu64Control + 2;
+}
+static inline const volatile void *GetDrainKey(volatile uint64_t *pu64Control){
+	return (const volatile char *)pu64Control + 4;
+}
+
+static inline volatile uintptr_t *GetReaderSlot(_MCFCRT_RwLockReaderSlots *pSlots){
+	// Thread IDs are multiples of four on Windows, so don't take the lower bits directly.
+	const uint32_t u32Hash = (uint32_t)_MCFCRT_GetCurrentThreadId() * 0x9E3779B1u;
+	return &(pSlots->__aSlots[u32Hash >> 28].__u);
+}
+
+static_assert(_MCFCRT_RWLOCK_READER_SLOT_COUNT == (1u << (32 - 28)), "Please update `GetReaderSlot()`.");
+
+static inline bool AreReaderSlotsEmpty(const _MCFCRT_RwLockReaderSlots *pSlots){
+	if(!pSlots){
+		return true;
+	}
+	// This may be called while other readers are arriving and leaving. A reader that arrives after the lock has been locked by a writer leaves at once, from the same slot.
+	// Hence the sum never drops below the number of readers that are really holding the lock, even if slots are not read in a single atomic operation.
+	uintptr_t uSum = 0;
+	for(unsigned uIndex = 0; uIndex < _MCFCRT_RWLOCK_READER_SLOT_COUNT; ++uIndex){
+		uSum += __atomic_load_n(&(pSlots->__aSlots[uIndex].__u), __ATOMIC_SEQ_CST);
+	}
+	return uSum == 0;
+}
+
+static inline void SpinWhileLocked(volatile uint64_t *pu64Control, size_t uMaxSpinCount){
+	for(size_t uSpinIndex = 0; _MCFCRT_EXPECT(uSpinIndex < uMaxSpinCount); ++uSpinIndex){
+		if(!(__atomic_load_n(pu64Control, __ATOMIC_RELAXED) & MASK_LOCKED)){
+			break;
+		}
+		__builtin_ia32_pause();
+	}
+}
+
+// This function shall be called after a reader has left, which wakes up the writer that is waiting for it, if any.
+static void WakeDrainingWriter(volatile uint64_t *pu64Control, const _MCFCRT_RwLockReaderSlots *pSlots){
+	uint64_t u64Old, u64New;
+	u64Old = __atomic_load_n(pu64Control, __ATOMIC_SEQ_CST);
+	do {
+		if(!(u64Old & MASK_DRAINING) || (u64Old & MASK_READERS) || !AreReaderSlotsEmpty(pSlots)){
+			return;
+		}
+		u64New = u64Old & ~MASK_DRAINING;
+	} while(_MCFCRT_EXPECT_NOT(!__atomic_compare_exchange_n(pu64Control, &u64Old, u64New, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST)));
+	__MCFCRT_UnparkThreads(GetDrainKey(pu64Control), 1);
+}
+
+// Readers that are woken up have been counted in the lock word by the writer that wakes them up.
+__attribute__((__always_inline__))
+static inline bool ReallyWaitForReaderCentral(volatile uint64_t *pu64Control, size_t uMaxSpinCount, bool bMayTimeOut, uint64_t u64UntilFastMonoClock){
+	SpinWhileLocked(pu64Control, uMaxSpinCount);
+	bool bTaken;
+	{
+		uint64_t u64Old, u64New;
+		u64Old = __atomic_load_n(pu64Control, __ATOMIC_RELAXED);
+		do {
+			bTaken = !(u64Old & MASK_LOCKED);
+			if(bTaken){
+				_MCFCRT_ASSERT_MSG((u64Old & MASK_READERS) / READERS_ONE < READERS_MAX, L"读者数量过多。");
+				u64New = u64Old + READERS_ONE;
+			} else {
+				_MCFCRT_ASSERT_MSG((u64Old & MASK_READERS_TRAPPED) / READERS_TRAPPED_ONE < READERS_TRAPPED_MAX, L"等待中的读者数量过多。");
+				u64New = u64Old + READERS_TRAPPED_ONE;
+			}
+		} while(_MCFCRT_EXPECT_NOT(!__atomic_compare_exchange_n(pu64Control, &u64Old, u64New, false, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)));
+	}
+	if(_MCFCRT_EXPECT(bTaken)){
+		return true;
+	}
+	if(bMayTimeOut){
+		bool bReleased = __MCFCRT_ParkThread(GetReaderKey(pu64Control), u64UntilFastMonoClock);
+		while(_MCFCRT_EXPECT(!bReleased)){
+			bool bDecremented;
+			{
+				uint64_t u64Old, u64New;
+				u64Old = __atomic_load_n(pu64Control, __ATOMIC_RELAXED);
+				do {
+					bDecremented = (u64Old & MASK_READERS_TRAPPED) != 0;
+					if(!bDecremented){
+						break;
+					}
+					u64New = u64Old - READERS_TRAPPED_ONE;
+				} while(_MCFCRT_EXPECT_NOT(!__atomic_compare_exchange_n(pu64Control, &u64Old, u64New, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED)));
+			}
+			if(bDecremented){
+				return false;
+			}
+			bReleased = __MCFCRT_ParkThread(GetReaderKey(pu64Control), 0);
+		}
+	} else {
+		__MCFCRT_ParkThreadForever(GetReaderKey(pu64Control));
+	}
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	return true;
+}
+__attribute__((__always_inline__))
+static inline bool ReallyWaitForReader(_MCFCRT_RwLock *pLock, size_t uMaxSpinCount, bool bMayTimeOut, uint64_t u64UntilFastMonoClock){
+	volatile uint64_t *const pu64Control = &(pLock->__u);
+	_MCFCRT_RwLockReaderSlots *const pSlots = pLock->__pSlots;
+	if(!pSlots){
+		return ReallyWaitForReaderCentral(pu64Control, uMaxSpinCount, bMayTimeOut, u64UntilFastMonoClock);
+	}
+	volatile uintptr_t *const puSlot = GetReaderSlot(pSlots);
+	// Announce ourselves, then check for writers. A writer does these in the opposite order, so at least one of us sees the other.
+	__atomic_fetch_add(puSlot, 1, __ATOMIC_SEQ_CST);
+	if(_MCFCRT_EXPECT(!(__atomic_load_n(pu64Control, __ATOMIC_SEQ_CST) & MASK_LOCKED))){
+		return true;
+	}
+	__atomic_fetch_sub(puSlot, 1, __ATOMIC_SEQ_CST);
+	WakeDrainingWriter(pu64Control, pSlots);
+	// Wait in the lock word, then move ourselves into our slot.
+	if(!ReallyWaitForReaderCentral(pu64Control, uMaxSpinCount, bMayTimeOut, u64UntilFastMonoClock)){
+		return false;
+	}
+	__atomic_fetch_add(puSlot, 1, __ATOMIC_SEQ_CST);
+	__atomic_fetch_sub(pu64Control, READERS_ONE, __ATOMIC_SEQ_CST);
+	return true;
+}
+__attribute__((__always_inline__))
+static inline void ReallySignalReader(_MCFCRT_RwLock *pLock){
+	volatile uint64_t *const pu64Control = &(pLock->__u);
+	_MCFCRT_RwLockReaderSlots *const pSlots = pLock->__pSlots;
+	if(pSlots){
+		volatile uintptr_t *const puSlot = GetReaderSlot(pSlots);
+		const uintptr_t uOld = __atomic_fetch_sub(puSlot, 1, __ATOMIC_SEQ_CST);
+		_MCFCRT_ASSERT_MSG(uOld != 0, L"读写锁没有被当前线程以读者身份锁定。");
+		WakeDrainingWriter(pu64Control, pSlots);
+		return;
+	}
+	bool bSignalWriter;
+	{
+		uint64_t u64Old, u64New;
+		u64Old = __atomic_load_n(pu64Control, __ATOMIC_RELAXED);
+		do {
+			_MCFCRT_ASSERT_MSG(u64Old & MASK_READERS, L"读写锁没有被任何线程以读者身份锁定。");
+			u64New = u64Old - READERS_ONE;
+			bSignalWriter = (u64New & MASK_DRAINING) && !(u64New & MASK_READERS);
+			u64New &= ~(bSignalWriter * MASK_DRAINING);
+		} while(_MCFCRT_EXPECT_NOT(!__atomic_compare_exchange_n(pu64Control, &u64Old, u64New, false, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)));
+	}
+	if(_MCFCRT_EXPECT_NOT(bSignalWriter)){
+		__MCFCRT_UnparkThreads(GetDrainKey(pu64Control), 1);
+	}
+}
+
+static void ReallySignalWriter(_MCFCRT_RwLock *pLock);
+
+// The caller owns the lock bit, which stops more readers from coming in. Wait for the others to leave.
+static bool DrainReaders(_MCFCRT_RwLock *pLock, size_t uMaxSpinCount, bool bMayTimeOut, uint64_t u64UntilFastMonoClock){
+	volatile uint64_t *const pu64Control = &(pLock->__u);
+	_MCFCRT_RwLockReaderSlots *const pSlots = pLock->__pSlots;
+	for(size_t uSpinIndex = 0; _MCFCRT_EXPECT(uSpinIndex < uMaxSpinCount); ++uSpinIndex){
+		if(!(__atomic_load_n(pu64Control, __ATOMIC_SEQ_CST) & MASK_READERS) && AreReaderSlotsEmpty(pSlots)){
+			return true;
+		}
+		__builtin_ia32_pause();
+	}
+	for(;;){
+		// Set the draining bit, then check for readers. A reader does these in the opposite order, so at least one of us sees the other.
+		__atomic_fetch_or(pu64Control, MASK_DRAINING, __ATOMIC_SEQ_CST);
+		bool bDrained, bCleared;
+		{
+			uint64_t u64Old, u64New;
+			u64Old = __atomic_load_n(pu64Control, __ATOMIC_SEQ_CST);
+			do {
+				bDrained = !(u64Old & MASK_READERS) && AreReaderSlotsEmpty(pSlots);
+				// If the bit has been cleared by a reader, that reader will wake us up.
+				bCleared = !(u64Old & MASK_DRAINING);
+				if(!bDrained || bCleared){
+					break;
+				}
+				u64New = u64Old & ~MASK_DRAINING;
+			} while(_MCFCRT_EXPECT_NOT(!__atomic_compare_exchange_n(pu64Control, &u64Old, u64New, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST)));
+		}
+		if(bDrained && !bCleared){
+			return true;
+		}
+		if(bMayTimeOut && !bCleared){
+			bool bReleased = __MCFCRT_ParkThread(GetDrainKey(pu64Control), u64UntilFastMonoClock);
+			while(_MCFCRT_EXPECT(!bReleased)){
+				bool bWithdrawn;
+				{
+					uint64_t u64Old, u64New;
+					u64Old = __atomic_load_n(pu64Control, __ATOMIC_RELAXED);
+					do {
+						bWithdrawn = (u64Old & MASK_DRAINING) != 0;
+						if(!bWithdrawn){
+							break;
+						}
+						u64New = u64Old & ~MASK_DRAINING;
+					} while(_MCFCRT_EXPECT_NOT(!__atomic_compare_exchange_n(pu64Control, &u64Old, u64New, false, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)));
+				}
+				if(bWithdrawn){
+					// Give up the lock. Other threads that are waiting for it are handed over as usual.
+					ReallySignalWriter(pLock);
+					return false;
+				}
+				bReleased = __MCFCRT_ParkThread(GetDrainKey(pu64Control), 0);
+			}
+		} else {
+			__MCFCRT_ParkThreadForever(GetDrainKey(pu64Control));
+		}
+	}
+}
+
+__attribute__((__always_inline__))
+static inline bool ReallyWaitForWriter(_MCFCRT_RwLock *pLock, size_t uMaxSpinCount, bool bMayTimeOut, uint64_t u64UntilFastMonoClock){
+	volatile uint64_t *const pu64Control = &(pLock->__u);
+	for(;;){
+		SpinWhileLocked(pu64Control, uMaxSpinCount);
+		bool bTaken;
+		{
+			uint64_t u64Old, u64New;
+			u64Old = __atomic_load_n(pu64Control, __ATOMIC_RELAXED);
+			do {
+				bTaken = !(u64Old & MASK_LOCKED);
+				if(bTaken){
+					u64New = u64Old + MASK_LOCKED;
+				} else {
+					_MCFCRT_ASSERT_MSG((u64Old & MASK_WRITERS_TRAPPED) / WRITERS_TRAPPED_ONE < WRITERS_TRAPPED_MAX, L"等待中的写者数量过多。");
+					u64New = u64Old + WRITERS_TRAPPED_ONE;
+				}
+			} while(_MCFCRT_EXPECT_NOT(!__atomic_compare_exchange_n(pu64Control, &u64Old, u64New, false, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)));
+		}
+		if(_MCFCRT_EXPECT(bTaken)){
+			break;
+		}
+		if(bMayTimeOut){
+			bool bReleased = __MCFCRT_ParkThread(GetWriterKey(pu64Control), u64UntilFastMonoClock);
+			while(_MCFCRT_EXPECT(!bReleased)){
+				bool bDecremented;
+				{
+					uint64_t u64Old, u64New;
+					u64Old = __atomic_load_n(pu64Control, __ATOMIC_RELAXED);
+					do {
+						bDecremented = (u64Old & MASK_WRITERS_TRAPPED) != 0;
+						if(!bDecremented){
+							break;
+						}
+						u64New = u64Old - WRITERS_TRAPPED_ONE;
+					} while(_MCFCRT_EXPECT_NOT(!__atomic_compare_exchange_n(pu64Control, &u64Old, u64New, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED)));
+				}
+				if(bDecremented){
+					return false;
+				}
+				bReleased = __MCFCRT_ParkThread(GetWriterKey(pu64Control), 0);
+			}
+		} else {
+			__MCFCRT_ParkThreadForever(GetWriterKey(pu64Control));
+		}
+	}
+	// New readers can't come in now. Wait for the others to leave.
+	return DrainReaders(pLock, uMaxSpinCount, bMayTimeOut, u64UntilFastMonoClock);
+}
+static void ReallySignalWriter(_MCFCRT_RwLock *pLock){
+	volatile uint64_t *const pu64Control = &(pLock->__u);
+	uint64_t u64ReadersToSignal;
+	bool bSignalWriter;
+	{
+		uint64_t u64Old, u64New;
+		u64Old = __atomic_load_n(pu64Control, __ATOMIC_RELAXED);
+		do {
+			_MCFCRT_ASSERT_MSG(u64Old & MASK_LOCKED, L"读写锁没有被任何线程以写者身份锁定。");
+			_MCFCRT_ASSERT(!(u64Old & MASK_DRAINING));
+			// Let all sleeping readers in. They are counted in the lock word here.
+			u64ReadersToSignal = (u64Old & MASK_READERS_TRAPPED) / READERS_TRAPPED_ONE;
+			_MCFCRT_ASSERT_MSG((u64Old & MASK_READERS) / READERS_ONE + u64ReadersToSignal <= READERS_MAX, L"读者数量过多。");
+			u64New = u64Old - u64ReadersToSignal * READERS_TRAPPED_ONE + u64ReadersToSignal * READERS_ONE;
+			// Wake up the next writer, if any, which has to compete for the lock bit with writers that are not sleeping, like `_MCFCRT_Mutex`.
+			// Handing the lock bit over would cause lock convoys when threads outnumber processors.
+			bSignalWriter = (u64Old & MASK_WRITERS_TRAPPED) != 0;
+			u64New = (u64New & ~MASK_LOCKED) - bSignalWriter * WRITERS_TRAPPED_ONE;
+		} while(_MCFCRT_EXPECT_NOT(!__atomic_compare_exchange_n(pu64Control, &u64Old, u64New, false, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)));
+	}
+	if(_MCFCRT_EXPECT_NOT(u64ReadersToSignal != 0)){
+		__MCFCRT_UnparkThreads(GetReaderKey(pu64Control), (size_t)u64ReadersToSignal);
+	}
+	if(_MCFCRT_EXPECT_NOT(bSignalWriter)){
+		__MCFCRT_UnparkThreads(GetWriterKey(pu64Control), 1);
+	}
+}
+
+bool __MCFCRT_ReallyWaitForRwLockAsReader(_MCFCRT_RwLock *pLock, size_t uMaxSpinCount, uint64_t u64UntilFastMonoClock){
+	const bool bLocked = ReallyWaitForReader(pLock, uMaxSpinCount, true, u64UntilFastMonoClock);
+	return bLocked;
+}
+void __MCFCRT_ReallyWaitForRwLockAsReaderForever(_MCFCRT_RwLock *pLock, size_t uMaxSpinCount){
+	const bool bLocked = ReallyWaitForReader(pLock, uMaxSpinCount, false, UINT64_MAX);
+	_MCFCRT_ASSERT(bLocked);
+}
+void __MCFCRT_ReallySignalRwLockAsReader(_MCFCRT_RwLock *pLock){
+	ReallySignalReader(pLock);
+}
+bool __MCFCRT_ReallyWaitForRwLockAsWriter(_MCFCRT_RwLock *pLock, size_t uMaxSpinCount, uint64_t u64UntilFastMonoClock){
+	const bool bLocked = ReallyWaitForWriter(pLock, uMaxSpinCount, true, u64UntilFastMonoClock);
+	return bLocked;
+}
+void __MCFCRT_ReallyWaitForRwLockAsWriterForever(_MCFCRT_RwLock *pLock, size_t uMaxSpinCount){
+	const bool bLocked = ReallyWaitForWriter(pLock, uMaxSpinCount, false, UINT64_MAX);
+	_MCFCRT_ASSERT(bLocked);
+}
+void __MCFCRT_ReallySignalRwLockAsWriter(_MCFCRT_RwLock *pLock){
+	ReallySignalWriter(pLock);
+}
@@ -0,0 +1,104 @@
+// 这个文件是 MCF 的一部分。
+// 有关具体授权说明，请参阅 MCFLicense.txt。
+// Copyleft 2013 - 2018, LH_Mouse. All wrongs reserved.
+
+#ifndef __MCFCRT_ENV_RWLOCK_H_
+#define __MCFCRT_ENV_RWLOCK_H_
+
+#include "_crtdef.h"
+
+#ifndef __MCFCRT_RWLOCK_INLINE_OR_EXTERN
+#  define __MCFCRT_RWLOCK_INLINE_OR_EXTERN     __attribute__((__gnu_inline__)) extern inline
+#endif
+
+_MCFCRT_EXTERN_C_BEGIN
+
+// Readers are counted in the lock word by default, which is a point of contention if there are many readers.
+// In the distributed mode, every reader is counted in one of the reader slots, chosen by its thread ID, and merely reads the lock word. Writers have to scan all slots.
+// A reader lock acquired in the distributed mode must be released by the thread that acquired it.
+#define _MCFCRT_RWLOCK_READER_SLOT_COUNT   16u
+
+typedef struct __MCFCRT_tagRwLockReaderSlots {
+	struct {
+		__attribute__((__aligned__(_MCFCRT_CACHE_LINE_SIZE))) _MCFCRT_STD uintptr_t __u;
+	} __aSlots[_MCFCRT_RWLOCK_READER_SLOT_COUNT];
+} _MCFCRT_RwLockReaderSlots;
+
+// In the case of static initialization, please initialize it with { 0 }, or { 0, &slots } for the distributed mode, where `slots` shall be zero-initialized as well.
+// Writers are preferred: Once a writer has taken the lock bit, no more readers may acquire the lock until it is released, and the writer waits for the other readers to leave.
+// When a writer releases the lock, all readers that are waiting are granted the lock at once, so they can't be starved by writers either.
+typedef struct __MCFCRT_tagRwLock {
+	_MCFCRT_STD uint64_t __u;
+	_MCFCRT_RwLockReaderSlots *__pSlots;
+} _MCFCRT_RwLock;
+
+#define _MCFCRT_RWLOCK_SUGGESTED_SPIN_COUNT   100u
+
+#define __MCFCRT_RWLOCK_MASK_LOCKED           ((_MCFCRT_STD uint64_t)0x0000000000000001)
+#define __MCFCRT_RWLOCK_READERS_ONE           ((_MCFCRT_STD uint64_t)0x0000000000000004)
+
+// `__pSlots` may be a null pointer. Otherwise the distributed mode is enabled, and the slots are reset to zero.
+__MCFCRT_RWLOCK_INLINE_OR_EXTERN void _MCFCRT_InitializeRwLock(_MCFCRT_RwLock *__pLock, _MCFCRT_RwLockReaderSlots *__pSlots) _MCFCRT_NOEXCEPT {
+	if(__pSlots){
+		for(unsigned __uIndex = 0; __uIndex < _MCFCRT_RWLOCK_READER_SLOT_COUNT; ++__uIndex){
+			__atomic_store_n(&(__pSlots->__aSlots[__uIndex].__u), 0, __ATOMIC_RELAXED);
+		}
+	}
+	__pLock->__pSlots = __pSlots;
+	__atomic_store_n(&(__pLock->__u), 0, __ATOMIC_RELEASE);
+}
+
+extern bool __MCFCRT_ReallyWaitForRwLockAsReader(_MCFCRT_RwLock *__pLock, _MCFCRT_STD size_t __uMaxSpinCount, _MCFCRT_STD uint64_t __u64UntilFastMonoClock) _MCFCRT_NOEXCEPT;
+extern void __MCFCRT_ReallyWaitForRwLockAsReaderForever(_MCFCRT_RwLock *__pLock, _MCFCRT_STD size_t __uMaxSpinCount) _MCFCRT_NOEXCEPT;
+extern void __MCFCRT_ReallySignalRwLockAsReader(_MCFCRT_RwLock *__pLock) _MCFCRT_NOEXCEPT;
+extern bool __MCFCRT_ReallyWaitForRwLockAsWriter(_MCFCRT_RwLock *__pLock, _MCFCRT_STD size_t __uMaxSpinCount, _MCFCRT_STD uint64_t __u64UntilFastMonoClock) _MCFCRT_NOEXCEPT;
+extern void __MCFCRT_ReallyWaitForRwLockAsWriterForever(_MCFCRT_RwLock *__pLock, _MCFCRT_STD size_t __uMaxSpinCount) _MCFCRT_NOEXCEPT;
+extern void __MCFCRT_ReallySignalRwLockAsWriter(_MCFCRT_RwLock *__pLock) _MCFCRT_NOEXCEPT;
+
+__MCFCRT_RWLOCK_INLINE_OR_EXTERN bool _MCFCRT_WaitForRwLockAsReader(_MCFCRT_RwLock *__pLock, _MCFCRT_STD size_t __uMaxSpinCount, _MCFCRT_STD uint64_t __u64UntilFastMonoClock) _MCFCRT_NOEXCEPT {
+	if(!__pLock->__pSlots){
+		_MCFCRT_STD uint64_t __u64Old = __atomic_load_n(&(__pLock->__u), __ATOMIC_RELAXED);
+		if(__builtin_expect(!(__u64Old & __MCFCRT_RWLOCK_MASK_LOCKED) && __atomic_compare_exchange_n(&(__pLock->__u), &__u64Old, __u64Old + __MCFCRT_RWLOCK_READERS_ONE, true, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED), true)){
+			return true;
+		}
+	}
+	return __MCFCRT_ReallyWaitForRwLockAsReader(__pLock, __uMaxSpinCount, __u64UntilFastMonoClock);
+}
+__MCFCRT_RWLOCK_INLINE_OR_EXTERN void _MCFCRT_WaitForRwLockAsReaderForever(_MCFCRT_RwLock *__pLock, _MCFCRT_STD size_t __uMaxSpinCount) _MCFCRT_NOEXCEPT {
+	if(!__pLock->__pSlots){
+		_MCFCRT_STD uint64_t __u64Old = __atomic_load_n(&(__pLock->__u), __ATOMIC_RELAXED);
+		if(__builtin_expect(!(__u64Old & __MCFCRT_RWLOCK_MASK_LOCKED) && __atomic_compare_exchange_n(&(__pLock->__u), &__u64Old, __u64Old + __MCFCRT_RWLOCK_READERS_ONE, true, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED), true)){
+			return;
+		}
+	}
+	__MCFCRT_ReallyWaitForRwLockAsReaderForever(__pLock, __uMaxSpinCount);
+}
+__MCFCRT_RWLOCK_INLINE_OR_EXTERN void _MCFCRT_SignalRwLockAsReader(_MCFCRT_RwLock *__pLock) _MCFCRT_NOEXCEPT {
+	__MCFCRT_ReallySignalRwLockAsReader(__pLock);
+}
+
+__MCFCRT_RWLOCK_INLINE_OR_EXTERN bool _MCFCRT_WaitForRwLockAsWriter(_MCFCRT_RwLock *__pLock, _MCFCRT_STD size_t __uMaxSpinCount, _MCFCRT_STD uint64_t __u64UntilFastMonoClock) _MCFCRT_NOEXCEPT {
+	if(!__pLock->__pSlots){
+		_MCFCRT_STD uint64_t __u64Old = 0;
+		if(__builtin_expect(__atomic_compare_exchange_n(&(__pLock->__u), &__u64Old, __MCFCRT_RWLOCK_MASK_LOCKED, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED), true)){
+			return true;
+		}
+	}
+	return __MCFCRT_ReallyWaitForRwLockAsWriter(__pLock, __uMaxSpinCount, __u64UntilFastMonoClock);
+}
+__MCFCRT_RWLOCK_INLINE_OR_EXTERN void _MCFCRT_WaitForRwLockAsWriterForever(_MCFCRT_RwLock *__pLock, _MCFCRT_STD size_t __uMaxSpinCount) _MCFCRT_NOEXCEPT {
+	if(!__pLock->__pSlots){
+		_MCFCRT_STD uint64_t __u64Old = 0;
+		if(__builtin_expect(__atomic_compare_exchange_n(&(__pLock->__u), &__u64Old, __MCFCRT_RWLOCK_MASK_LOCKED, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED), true)){
+			return;
+		}
+	}
+	__MCFCRT_ReallyWaitForRwLockAsWriterForever(__pLock, __uMaxSpinCount);
+}
+__MCFCRT_RWLOCK_INLINE_OR_EXTERN void _MCFCRT_SignalRwLockAsWriter(_MCFCRT_RwLock *__pLock) _MCFCRT_NOEXCEPT {
+	__MCFCRT_ReallySignalRwLockAsWriter(__pLock);
+}
+
+_MCFCRT_EXTERN_C_END
+
+#endif
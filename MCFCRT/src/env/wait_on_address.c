@@ -0,0 +1,72 @@
+// 这个文件是 MCF 的一部分。
+// 有关具体授权说明，请参阅 MCFLicense.txt。
+// Copyleft 2013 - 2018, LH_Mouse. All wrongs reserved.
+
+#include "wait_on_address.h"
+#include "_park.h"
+#include "xassert.h"
+
+typedef struct tagComparand {
+	const volatile void *pAddress;
+	const void *pExpected;
+	size_t uSize;
+} Comparand;
+
+static bool CompareObject(intptr_t nContext){
+	const Comparand *const pComparand = (const Comparand *)nContext;
+	switch(pComparand->uSize){
+	case 1: {
+		uint8_t u8Expected;
+		__builtin_memcpy(&u8Expected, pComparand->pExpected, sizeof(u8Expected));
+		return __atomic_load_n((const volatile uint8_t *)pComparand->pAddress, __ATOMIC_ACQUIRE) == u8Expected; }
+	case 2: {
+		uint16_t u16Expected;
+		__builtin_memcpy(&u16Expected, pComparand->pExpected, sizeof(u16Expected));
+		return __atomic_load_n((const volatile uint16_t *)pComparand->pAddress, __ATOMIC_ACQUIRE) == u16Expected; }
+	case 4: {
+		uint32_t u32Expected;
+		__builtin_memcpy(&u32Expected, pComparand->pExpected, sizeof(u32Expected));
+		return __atomic_load_n((const volatile uint32_t *)pComparand->pAddress, __ATOMIC_ACQUIRE) == u32Expected; }
+	case 8: {
+		uint64_t u64Expected;
+		__builtin_memcpy(&u64Expected, pComparand->pExpected, sizeof(u64Expected));
+		return __atomic_load_n((const volatile uint64_t *)pComparand->pAddress, __ATOMIC_ACQUIRE) == u64Expected; }
+	default: {
+		const volatile unsigned char *const pbyObject = pComparand->pAddress;
+		const unsigned char *const pbyExpected = pComparand->pExpected;
+		for(size_t i = 0; i < pComparand->uSize; ++i){
+			if(pbyObject[i] != pbyExpected[i]){
+				return false;
+			}
+		}
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+		return true; }
+	}
+}
+
+bool _MCFCRT_WaitOnAddress(const volatile void *pAddress, const void *pExpected, size_t uSize, uint64_t u64UntilFastMonoClock){
+	Comparand vComparand = { pAddress, pExpected, uSize };
+	return __MCFCRT_ParkThreadIf(pAddress, u64UntilFastMonoClock, &CompareObject, (intptr_t)&vComparand);
+}
+void _MCFCRT_WaitOnAddressForever(const volatile void *pAddress, const void *pExpected, size_t uSize){
+	Comparand vComparand = { pAddress, pExpected, uSize };
+	__MCFCRT_ParkThreadIfForever(pAddress, &CompareObject, (intptr_t)&vComparand);
+}
+
+bool _MCFCRT_WaitOnAddressIf(const volatile void *pAddress, _MCFCRT_WaitOnAddressValidateCallback pfnValidateCallback, intptr_t nContext, uint64_t u64UntilFastMonoClock){
+	_MCFCRT_ASSERT(pfnValidateCallback);
+
+	return __MCFCRT_ParkThreadIf(pAddress, u64UntilFastMonoClock, pfnValidateCallback, nContext);
+}
+void _MCFCRT_WaitOnAddressIfForever(const volatile void *pAddress, _MCFCRT_WaitOnAddressValidateCallback pfnValidateCallback, intptr_t nContext){
+	_MCFCRT_ASSERT(pfnValidateCallback);
+
+	__MCFCRT_ParkThreadIfForever(pAddress, pfnValidateCallback, nContext);
+}
+
+size_t _MCFCRT_WakeByAddressSingle(const volatile void *pAddress){
+	return __MCFCRT_WakeParkedThreads(pAddress, 1);
+}
+size_t _MCFCRT_WakeByAddressAll(const volatile void *pAddress){
+	return __MCFCRT_WakeParkedThreads(pAddress, SIZE_MAX);
+}
@@ -0,0 +1,35 @@
+// 这个文件是 MCF 的一部分。
+// 有关具体授权说明，请参阅 MCFLicense.txt。
+// Copyleft 2013 - 2018, LH_Mouse. All wrongs reserved.
+
+#ifndef __MCFCRT_ENV_WAIT_ON_ADDRESS_H_
+#define __MCFCRT_ENV_WAIT_ON_ADDRESS_H_
+
+#include "_crtdef.h"
+
+_MCFCRT_EXTERN_C_BEGIN
+
+// These functions allow threads to sleep on any object and be woken up by its address. No storage is required other than the object itself.
+// A thread goes to sleep only if the object compares equal to the expected value, or the callback returns `true`. This is checked with internal locks held,
+// so a thread that modifies the object then wakes up threads by its address never misses one that is going to sleep.
+// Spurious wakeups are possible, hence the object shall be checked again after these functions return.
+// The address shall not be that of a mutex, condition variable, once flag or readers-writer lock.
+
+// Objects of 1, 2, 4 or 8 bytes shall be aligned to their sizes, which are read atomically. Objects of other sizes are compared byte by byte.
+// These functions return `false` if the calling thread has timed out, and `true` otherwise, including the case where the object didn't compare equal.
+extern bool _MCFCRT_WaitOnAddress(const volatile void *__pAddress, const void *__pExpected, _MCFCRT_STD size_t __uSize, _MCFCRT_STD uint64_t __u64UntilFastMonoClock) _MCFCRT_NOEXCEPT;
+extern void _MCFCRT_WaitOnAddressForever(const volatile void *__pAddress, const void *__pExpected, _MCFCRT_STD size_t __uSize) _MCFCRT_NOEXCEPT;
+
+// The callback is called with internal locks held. It shall neither block nor call any of the functions in this file.
+typedef bool (*_MCFCRT_WaitOnAddressValidateCallback)(_MCFCRT_STD intptr_t __nContext);
+
+extern bool _MCFCRT_WaitOnAddressIf(const volatile void *__pAddress, _MCFCRT_WaitOnAddressValidateCallback __pfnValidateCallback, _MCFCRT_STD intptr_t __nContext, _MCFCRT_STD uint64_t __u64UntilFastMonoClock) _MCFCRT_NOEXCEPT;
+extern void _MCFCRT_WaitOnAddressIfForever(const volatile void *__pAddress, _MCFCRT_WaitOnAddressValidateCallback __pfnValidateCallback, _MCFCRT_STD intptr_t __nContext) _MCFCRT_NOEXCEPT;
+
+// These functions return the number of threads that have been woken up. They never block, and are cheap if no thread is sleeping on the address.
+extern _MCFCRT_STD size_t _MCFCRT_WakeByAddressSingle(const volatile void *__pAddress) _MCFCRT_NOEXCEPT;
+extern _MCFCRT_STD size_t _MCFCRT_WakeByAddressAll(const volatile void *__pAddress) _MCFCRT_NOEXCEPT;
+
+_MCFCRT_EXTERN_C_END
+
+#endif
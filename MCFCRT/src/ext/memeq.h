@@ -0,0 +1,17 @@
+// 这个文件是 MCF 的一部分。
+// 有关具体授权说明，请参阅 MCFLicense.txt。
+// Copyleft 2013 - 2018, LH_Mouse. All wrongs reserved.
+
+#ifndef __MCFCRT_EXT_MEMEQ_H_
+#define __MCFCRT_EXT_MEMEQ_H_
+
+#include "../env/_crtdef.h"
+
+_MCFCRT_EXTERN_C_BEGIN
+
+// Equivalent to `memcmp(__s1, __s2, __n) == 0`, but faster, since it does not have to find out which byte differs.
+extern bool _MCFCRT_memeq(const void *__s1, const void *__s2, _MCFCRT_STD size_t __n) _MCFCRT_NOEXCEPT;
+
+_MCFCRT_EXTERN_C_END
+
+#endif
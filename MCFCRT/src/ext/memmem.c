@@ -0,0 +1,10 @@
+// 这个文件是 MCF 的一部分。
+// 有关具体授权说明，请参阅 MCFLicense.txt。
+// Copyleft 2013 - 2018, LH_Mouse. All wrongs reserved.
+
+#include "memmem.h"
+#include "../env/_string_dispatch.h"
+
+void *_MCFCRT_memmem(const void *s1, size_t n1, const void *s2, size_t n2){
+	return (*__MCFCRT_string_dispatch_table.__memmem)(s1, n1, s2, n2);
+}
@@ -0,0 +1,16 @@
+// 这个文件是 MCF 的一部分。
+// 有关具体授权说明，请参阅 MCFLicense.txt。
+// Copyleft 2013 - 2018, LH_Mouse. All wrongs reserved.
+
+#ifndef __MCFCRT_EXT_MEMMEM_H_
+#define __MCFCRT_EXT_MEMMEM_H_
+
+#include "../env/_crtdef.h"
+
+_MCFCRT_EXTERN_C_BEGIN
+
+extern void *_MCFCRT_memmem(const void *__s1, _MCFCRT_STD size_t __n1, const void *__s2, _MCFCRT_STD size_t __n2) _MCFCRT_NOEXCEPT;
+
+_MCFCRT_EXTERN_C_END
+
+#endif
@@ -0,0 +1,17 @@
+// 这个文件是 MCF 的一部分。
+// 有关具体授权说明，请参阅 MCFLicense.txt。
+// Copyleft 2013 - 2018, LH_Mouse. All wrongs reserved.
+
+#ifndef __MCFCRT_EXT_MEMMISMATCH_H_
+#define __MCFCRT_EXT_MEMMISMATCH_H_
+
+#include "../env/_crtdef.h"
+
+_MCFCRT_EXTERN_C_BEGIN
+
+// Returns the offset of the first byte that differs between the two blocks, or `__n` if they are equal.
+extern _MCFCRT_STD size_t _MCFCRT_memmismatch(const void *__s1, const void *__s2, _MCFCRT_STD size_t __n) _MCFCRT_NOEXCEPT;
+
+_MCFCRT_EXTERN_C_END
+
+#endif
@@ -0,0 +1,66 @@
+// 这个文件是 MCF 的一部分。
+// 有关具体授权说明，请参阅 MCFLicense.txt。
+// Copyleft 2013 - 2018, LH_Mouse. All wrongs reserved.
+
+#include "memrchr.h"
+#include "../env/expect.h"
+#include "../stdc/string/_sse2.h"
+#include "../env/_string_dispatch.h"
+
+__attribute__((__always_inline__))
+static inline void *memrchr_generic(const void *s, int c, size_t n){
+	// 如果 arp 是对齐到字的，就不用考虑越界的问题。
+	// 因为内存按页分配的，也自然对齐到页，并且也对齐到字。
+	// 每个字内的字节的权限必然一致。
+	const unsigned char *const brp = s;
+	const unsigned char *const erp = brp + n;
+	const unsigned char *arp = (const unsigned char *)(((uintptr_t)erp + 31) & (uintptr_t)-32);
+	__m128i xc[1];
+	__MCFCRT_xmmsetb(xc, (uint8_t)c);
+
+	__m128i xw[2];
+	uint32_t mask;
+	ptrdiff_t dist;
+//=============================================================================
+#define BEGIN	\
+	arp -= 32;	\
+	__MCFCRT_xmmload_2(xw, arp, _mm_load_si128);	\
+	mask = __MCFCRT_xmmcmp_21b(xw, xc);
+#define END	\
+	dist = brp - arp;	\
+	if(_MCFCRT_EXPECT_NOT(dist >= 0)){	\
+		goto end_trunc;	\
+	}	\
+	dist = 0;	\
+	if(_MCFCRT_EXPECT_NOT(mask != 0)){	\
+		goto end;	\
+	}
+//=============================================================================
+	if(_MCFCRT_EXPECT_NOT(n == 0)){
+		goto end_null;
+	}
+	BEGIN
+	dist = (arp + 32) - erp;
+	mask &= (uint32_t)-1 >> dist;
+	for(;;){
+		END
+		BEGIN
+	}
+end_trunc:
+	mask &= (uint32_t)-1 << dist;
+end:
+	if(mask != 0){
+		arp = arp + 31 - (unsigned)__builtin_clz(mask);
+		return (unsigned char *)arp;
+	}
+end_null:
+	return _MCFCRT_NULLPTR;
+}
+
+void *__MCFCRT_memrchr_sse2(const void *s, int c, size_t n){
+	return memrchr_generic(s, c, n);
+}
+
+void *_MCFCRT_memrchr(const void *s, int c, size_t n){
+	return (*__MCFCRT_string_dispatch_table.__memrchr)(s, c, n);
+}
@@ -0,0 +1,14 @@
+// 这个文件是 MCF 的一部分。
+// 有关具体授权说明，请参阅 MCFLicense.txt。
+// Copyleft 2013 - 2018, LH_Mouse. All wrongs reserved.
+
+#include "memzero_explicit.h"
+#include "../env/_string_dispatch.h"
+
+void _MCFCRT_memzero_explicit(void *s, size_t n){
+	// The call goes through a function pointer, which cannot be proven to have no side effects. Then the empty
+	// assembly statement tells the compiler that the zeroed bytes might be read, so the stores cannot be dropped
+	// even if this function is inlined by LTO.
+	(*__MCFCRT_string_dispatch_table.__memset32)(s, 0, n);
+	__asm__ volatile ("" : : "r"(s) : "memory");
+}
@@ -0,0 +1,18 @@
+// 这个文件是 MCF 的一部分。
+// 有关具体授权说明，请参阅 MCFLicense.txt。
+// Copyleft 2013 - 2018, LH_Mouse. All wrongs reserved.
+
+#ifndef __MCFCRT_EXT_MEMZERO_EXPLICIT_H_
+#define __MCFCRT_EXT_MEMZERO_EXPLICIT_H_
+
+#include "../env/_crtdef.h"
+
+_MCFCRT_EXTERN_C_BEGIN
+
+// Zeroes `__n` bytes at `__s`. Unlike `memset()`, this function will not be optimized away even if the block is not
+// read afterwards, so it can be used to erase sensitive data such as keys and passwords.
+extern void _MCFCRT_memzero_explicit(void *__s, _MCFCRT_STD size_t __n) _MCFCRT_NOEXCEPT;
+
+_MCFCRT_EXTERN_C_END
+
+#endif
@@ -5,8 +5,10 @@
 #include "rawmemchr.h"
 #include "../env/expect.h"
 #include "../stdc/string/_sse2.h"
+#include "../env/_string_dispatch.h"
 
-void *_MCFCRT_rawmemchr(const void *s, int c){
+__attribute__((__always_inline__))
+static inline void *rawmemchr_generic(const void *s, int c){
 	// 如果 arp 是对齐到字的，就不用考虑越界的问题。
 	// 因为内存按页分配的，也自然对齐到页，并且也对齐到字。
 	// 每个字内的字节的权限必然一致。
@@ -37,3 +39,11 @@ end:
 	arp = arp - 32 + (unsigned)__builtin_ctzl(mask);
 	return (char *)arp;
 }
+
+void *__MCFCRT_rawmemchr_sse2(const void *s, int c){
+	return rawmemchr_generic(s, c);
+}
+
+void *_MCFCRT_rawmemchr(const void *s, int c){
+	return (*__MCFCRT_string_dispatch_table.__rawmemchr)(s, c);
+}
@@ -5,8 +5,10 @@
 #include "rawwmemchr.h"
 #include "../env/expect.h"
 #include "../stdc/string/_sse2.h"
+#include "../env/_string_dispatch.h"
 
-wchar_t *_MCFCRT_rawwmemchr(const wchar_t *s, wchar_t c){
+__attribute__((__always_inline__))
+static inline wchar_t *rawwmemchr_generic(const wchar_t *s, wchar_t c){
 	// 如果 arp 是对齐到字的，就不用考虑越界的问题。
 	// 因为内存按页分配的，也自然对齐到页，并且也对齐到字。
 	// 每个字内的字节的权限必然一致。
@@ -37,3 +39,11 @@ end:
 	arp = arp - 32 + (unsigned)__builtin_ctzl(mask);
 	return (wchar_t *)arp;
 }
+
+wchar_t *__MCFCRT_rawwmemchr_sse2(const wchar_t *s, wchar_t c){
+	return rawwmemchr_generic(s, c);
+}
+
+wchar_t *_MCFCRT_rawwmemchr(const wchar_t *s, wchar_t c){
+	return (*__MCFCRT_string_dispatch_table.__rawwmemchr)(s, c);
+}
@@ -0,0 +1,10 @@
+// 这个文件是 MCF 的一部分。
+// 有关具体授权说明，请参阅 MCFLicense.txt。
+// Copyleft 2013 - 2018, LH_Mouse. All wrongs reserved.
+
+#include "strmismatch.h"
+#include "../env/_string_dispatch.h"
+
+size_t _MCFCRT_strmismatch(const char *s1, const char *s2){
+	return (*__MCFCRT_string_dispatch_table.__strmismatch)(s1, s2);
+}
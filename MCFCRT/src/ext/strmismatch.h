@@ -0,0 +1,18 @@
+// 这个文件是 MCF 的一部分。
+// 有关具体授权说明，请参阅 MCFLicense.txt。
+// Copyleft 2013 - 2018, LH_Mouse. All wrongs reserved.
+
+#ifndef __MCFCRT_EXT_STRMISMATCH_H_
+#define __MCFCRT_EXT_STRMISMATCH_H_
+
+#include "../env/_crtdef.h"
+
+_MCFCRT_EXTERN_C_BEGIN
+
+// Returns the index of the first character that differs between the two strings, or of their null terminator if they are
+// equal. Comparing the characters at the index as `unsigned char` gives the result of `strcmp()`.
+extern _MCFCRT_STD size_t _MCFCRT_strmismatch(const char *__s1, const char *__s2) _MCFCRT_NOEXCEPT;
+
+_MCFCRT_EXTERN_C_END
+
+#endif
@@ -0,0 +1,10 @@
+// 这个文件是 MCF 的一部分。
+// 有关具体授权说明，请参阅 MCFLicense.txt。
+// Copyleft 2013 - 2018, LH_Mouse. All wrongs reserved.
+
+#include "wcsmismatch.h"
+#include "../env/_string_dispatch.h"
+
+size_t _MCFCRT_wcsmismatch(const wchar_t *s1, const wchar_t *s2){
+	return (*__MCFCRT_string_dispatch_table.__wcsmismatch)(s1, s2);
+}
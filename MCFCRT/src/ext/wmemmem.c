@@ -0,0 +1,10 @@
+// 这个文件是 MCF 的一部分。
+// 有关具体授权说明，请参阅 MCFLicense.txt。
+// Copyleft 2013 - 2018, LH_Mouse. All wrongs reserved.
+
+#include "wmemmem.h"
+#include "../env/_string_dispatch.h"
+
+wchar_t *_MCFCRT_wmemmem(const wchar_t *s1, size_t n1, const wchar_t *s2, size_t n2){
+	return (*__MCFCRT_string_dispatch_table.__wmemmem)(s1, n1, s2, n2);
+}
@@ -8,12 +8,16 @@
 #include "env/heap_debug.h"
 #include "env/_mopthread.h"
 #include "env/crt_module.h"
+#include "env/_string_dispatch.h"
 
 static ptrdiff_t g_nCounter = 0;
 
 bool __MCFCRT_InitRecursive(void){
 	ptrdiff_t nCounter = g_nCounter;
 	if(nCounter == 0){
+		if(!__MCFCRT_StringDispatchInit()){
+			return false;
+		}
 		if(!__MCFCRT_StandardStreamsInit()){
 			return false;
 		}
@@ -9,6 +9,7 @@
 
 #ifndef __MCFCRT_NO_GENERAL_INCLUDES
 // ------------------------------ env ------------------------------
+#  include "env/arena.h"
 #  include "env/avl_tree.h"
 #  include "env/bail.h"
 #  include "env/clocks.h"
@@ -35,6 +36,14 @@
 #  include "ext/random.h"
 #  include "ext/rawmemchr.h"
 #  include "ext/rawwmemchr.h"
+#  include "ext/memrchr.h"
+#  include "ext/memzero_explicit.h"
+#  include "ext/memeq.h"
+#  include "ext/memmismatch.h"
+#  include "ext/strmismatch.h"
+#  include "ext/wcsmismatch.h"
+#  include "ext/memmem.h"
+#  include "ext/wmemmem.h"
 #  include "ext/rep_movs.h"
 #  include "ext/rep_stos.h"
 #  include "ext/rep_cmps.h"
@@ -7,6 +7,7 @@
 #include "tls.h"
 #include "../mcfcrt.h"
 #include "../env/cpu.h"
+#include "../env/_heap_impl.h"
 #include "../env/xassert.h"
 #include "../env/standard_streams.h"
 #include "../env/crt_module.h"
@@ -73,6 +74,7 @@ static unsigned long WrappedTlsCallback(void *pOpaque){
 
 	case DLL_THREAD_DETACH:
 		__MCFCRT_TlsCleanup();
+		__MCFCRT_HeapImplThreadCleanup();
 		return true;
 
 	default:
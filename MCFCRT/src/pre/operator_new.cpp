@@ -0,0 +1,116 @@
+// 这个文件是 MCF 的一部分。
+// 有关具体授权说明，请参阅 MCFLicense.txt。
+// Copyleft 2013 - 2018, LH_Mouse. All wrongs reserved.
+
+#include "../env/_crtdef.h"
+#include "../env/heap.h"
+#include "../env/expect.h"
+#include <new>
+
+// These replace the global allocation and deallocation functions in libsupc++, which end up in `malloc()` and `free()` and know nothing about sizes or alignments.
+// Sized deallocation functions pass sizes down to the heap, which saves it from looking them up.
+
+namespace {
+
+__attribute__((__always_inline__))
+inline void *Allocate(std::size_t uSize, std::size_t uAlignment, const void *pRetAddrOuter){
+	for(;;){
+		// Every block is aligned to this boundary anyway.
+		const auto pBlock = (uAlignment <= __STDCPP_DEFAULT_NEW_ALIGNMENT__) ? ::__MCFCRT_HeapAlloc(uSize, false, pRetAddrOuter)
+		                                                                     : ::__MCFCRT_HeapAllocAligned(uSize, uAlignment, false, pRetAddrOuter);
+		if(_MCFCRT_EXPECT(pBlock)){
+			return pBlock;
+		}
+		const auto pfnHandler = std::get_new_handler();
+		if(!pfnHandler){
+			throw std::bad_alloc();
+		}
+		(*pfnHandler)();
+	}
+}
+__attribute__((__always_inline__))
+inline void *AllocateNoThrow(std::size_t uSize, std::size_t uAlignment, const void *pRetAddrOuter) noexcept {
+	try {
+		return Allocate(uSize, uAlignment, pRetAddrOuter);
+	} catch(std::bad_alloc &){
+		return nullptr;
+	}
+}
+__attribute__((__always_inline__))
+inline void Deallocate(void *pBlock, const void *pRetAddrOuter) noexcept {
+	if(!pBlock){
+		return;
+	}
+	::__MCFCRT_HeapFree(pBlock, pRetAddrOuter);
+}
+__attribute__((__always_inline__))
+inline void DeallocateSized(void *pBlock, std::size_t uSize, std::size_t uAlignment, const void *pRetAddrOuter) noexcept {
+	if(!pBlock){
+		return;
+	}
+	::__MCFCRT_HeapFreeSized(pBlock, uSize, uAlignment, pRetAddrOuter);
+}
+
+}
+
+void *operator new(std::size_t uSize){
+	return Allocate(uSize, 1, __builtin_return_address(0));
+}
+void *operator new[](std::size_t uSize){
+	return Allocate(uSize, 1, __builtin_return_address(0));
+}
+void *operator new(std::size_t uSize, const std::nothrow_t &) noexcept {
+	return AllocateNoThrow(uSize, 1, __builtin_return_address(0));
+}
+void *operator new[](std::size_t uSize, const std::nothrow_t &) noexcept {
+	return AllocateNoThrow(uSize, 1, __builtin_return_address(0));
+}
+void *operator new(std::size_t uSize, std::align_val_t eAlignment){
+	return Allocate(uSize, static_cast<std::size_t>(eAlignment), __builtin_return_address(0));
+}
+void *operator new[](std::size_t uSize, std::align_val_t eAlignment){
+	return Allocate(uSize, static_cast<std::size_t>(eAlignment), __builtin_return_address(0));
+}
+void *operator new(std::size_t uSize, std::align_val_t eAlignment, const std::nothrow_t &) noexcept {
+	return AllocateNoThrow(uSize, static_cast<std::size_t>(eAlignment), __builtin_return_address(0));
+}
+void *operator new[](std::size_t uSize, std::align_val_t eAlignment, const std::nothrow_t &) noexcept {
+	return AllocateNoThrow(uSize, static_cast<std::size_t>(eAlignment), __builtin_return_address(0));
+}
+
+void operator delete(void *pBlock) noexcept {
+	Deallocate(pBlock, __builtin_return_address(0));
+}
+void operator delete[](void *pBlock) noexcept {
+	Deallocate(pBlock, __builtin_return_address(0));
+}
+void operator delete(void *pBlock, const std::nothrow_t &) noexcept {
+	Deallocate(pBlock, __builtin_return_address(0));
+}
+void operator delete[](void *pBlock, const std::nothrow_t &) noexcept {
+	Deallocate(pBlock, __builtin_return_address(0));
+}
+void operator delete(void *pBlock, std::size_t uSize) noexcept {
+	DeallocateSized(pBlock, uSize, 1, __builtin_return_address(0));
+}
+void operator delete[](void *pBlock, std::size_t uSize) noexcept {
+	DeallocateSized(pBlock, uSize, 1, __builtin_return_address(0));
+}
+void operator delete(void *pBlock, std::align_val_t /* eAlignment */) noexcept {
+	Deallocate(pBlock, __builtin_return_address(0));
+}
+void operator delete[](void *pBlock, std::align_val_t /* eAlignment */) noexcept {
+	Deallocate(pBlock, __builtin_return_address(0));
+}
+void operator delete(void *pBlock, std::align_val_t /* eAlignment */, const std::nothrow_t &) noexcept {
+	Deallocate(pBlock, __builtin_return_address(0));
+}
+void operator delete[](void *pBlock, std::align_val_t /* eAlignment */, const std::nothrow_t &) noexcept {
+	Deallocate(pBlock, __builtin_return_address(0));
+}
+void operator delete(void *pBlock, std::size_t uSize, std::align_val_t eAlignment) noexcept {
+	DeallocateSized(pBlock, uSize, static_cast<std::size_t>(eAlignment), __builtin_return_address(0));
+}
+void operator delete[](void *pBlock, std::size_t uSize, std::align_val_t eAlignment) noexcept {
+	DeallocateSized(pBlock, uSize, static_cast<std::size_t>(eAlignment), __builtin_return_address(0));
+}
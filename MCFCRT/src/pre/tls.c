@@ -4,6 +4,7 @@
 
 #include "tls.h"
 #include "../env/mcfwin.h"
+#include "../env/_mopthread.h"
 #include "../env/xassert.h"
 
 static DWORD g_dwTlsIndex = TLS_OUT_OF_INDEXES;
@@ -15,9 +16,17 @@ bool __MCFCRT_TlsInit(void){
 	}
 
 	g_dwTlsIndex = dwTlsIndex;
+
+	// Threads that are going to be cached must get rid of thread-local objects of this module, too.
+	if(!__MCFCRT_MopthreadRegisterCleanupCallback(&__MCFCRT_TlsCleanup)){
+		g_dwTlsIndex = TLS_OUT_OF_INDEXES;
+		TlsFree(dwTlsIndex);
+		return false;
+	}
 	return true;
 }
 void __MCFCRT_TlsUninit(void){
+	__MCFCRT_MopthreadUnregisterCleanupCallback(&__MCFCRT_TlsCleanup);
 	__MCFCRT_TlsCleanup();
 
 	const DWORD dwTlsIndex = g_dwTlsIndex;
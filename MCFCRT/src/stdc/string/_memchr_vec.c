@@ -0,0 +1,183 @@
+// 这个文件是 MCF 的一部分。
+// 有关具体授权说明，请参阅 MCFLicense.txt。
+// Copyleft 2013 - 2018, LH_Mouse. All wrongs reserved.
+
+#include "../../env/_crtdef.h"
+#include "../../env/expect.h"
+#include "../../env/_string_dispatch.h"
+#include <immintrin.h>
+
+#define VEC_CONCAT_2_(x_, y_)   x_##_##y_
+#define VEC_CONCAT_(x_, y_)     VEC_CONCAT_2_(x_, y_)
+
+//=============================================================================
+// AVX2, char
+//=============================================================================
+#define VEC_TARGET_             __MCFCRT_STRING_TARGET_AVX2
+#define VEC_NAME_(name_)        VEC_CONCAT_(name_, avx2_b)
+#define VEC_EXPORT_(name_)      VEC_CONCAT_(name_, avx2)
+#define VEC_WIDE_               0
+#define VEC_CHAR_               uint8_t
+#define VEC_                    __m256i
+#define VEC_SIZE_               32
+#define VEC_CMP_                __m256i
+#define VEC_MASK_               uint32_t
+#define VEC_MASK_UNIT_          1
+#define VEC_LOAD_(p_)           _mm256_load_si256((const __m256i *)(p_))
+#define VEC_SET1_(c_)           _mm256_set1_epi8((char)(c_))
+#define VEC_ZERO_()             _mm256_setzero_si256()
+#define VEC_EQ_(v1_, v2_)       _mm256_cmpeq_epi8((v1_), (v2_))
+#define VEC_OR_(r1_, r2_)       _mm256_or_si256((r1_), (r2_))
+#define VEC_BITS_(r_)           ((uint32_t)_mm256_movemask_epi8(r_))
+#define VEC_XOR_(v1_, v2_)      _mm256_xor_si256((v1_), (v2_))
+#define VEC_MINU_(v1_, v2_)     _mm256_min_epu8((v1_), (v2_))
+
+#include "_memchr_vec.h"
+
+#undef VEC_TARGET_
+#undef VEC_NAME_
+#undef VEC_EXPORT_
+#undef VEC_WIDE_
+#undef VEC_CHAR_
+#undef VEC_
+#undef VEC_SIZE_
+#undef VEC_CMP_
+#undef VEC_MASK_
+#undef VEC_MASK_UNIT_
+#undef VEC_LOAD_
+#undef VEC_SET1_
+#undef VEC_ZERO_
+#undef VEC_EQ_
+#undef VEC_OR_
+#undef VEC_BITS_
+#undef VEC_XOR_
+#undef VEC_MINU_
+
+//=============================================================================
+// AVX2, wchar_t
+//=============================================================================
+#define VEC_TARGET_             __MCFCRT_STRING_TARGET_AVX2
+#define VEC_NAME_(name_)        VEC_CONCAT_(name_, avx2_w)
+#define VEC_EXPORT_(name_)      VEC_CONCAT_(name_, avx2)
+#define VEC_WIDE_               1
+#define VEC_CHAR_               uint16_t
+#define VEC_                    __m256i
+#define VEC_SIZE_               32
+#define VEC_CMP_                __m256i
+#define VEC_MASK_               uint32_t
+#define VEC_MASK_UNIT_          1
+#define VEC_LOAD_(p_)           _mm256_load_si256((const __m256i *)(p_))
+#define VEC_SET1_(c_)           _mm256_set1_epi16((short)(c_))
+#define VEC_ZERO_()             _mm256_setzero_si256()
+#define VEC_EQ_(v1_, v2_)       _mm256_cmpeq_epi16((v1_), (v2_))
+#define VEC_OR_(r1_, r2_)       _mm256_or_si256((r1_), (r2_))
+#define VEC_BITS_(r_)           ((uint32_t)_mm256_movemask_epi8(r_))
+#define VEC_XOR_(v1_, v2_)      _mm256_xor_si256((v1_), (v2_))
+#define VEC_MINU_(v1_, v2_)     _mm256_min_epu16((v1_), (v2_))
+
+#include "_memchr_vec.h"
+
+#undef VEC_TARGET_
+#undef VEC_NAME_
+#undef VEC_EXPORT_
+#undef VEC_WIDE_
+#undef VEC_CHAR_
+#undef VEC_
+#undef VEC_SIZE_
+#undef VEC_CMP_
+#undef VEC_MASK_
+#undef VEC_MASK_UNIT_
+#undef VEC_LOAD_
+#undef VEC_SET1_
+#undef VEC_ZERO_
+#undef VEC_EQ_
+#undef VEC_OR_
+#undef VEC_BITS_
+#undef VEC_XOR_
+#undef VEC_MINU_
+
+//=============================================================================
+// AVX-512, char
+//=============================================================================
+#define VEC_TARGET_             __MCFCRT_STRING_TARGET_AVX512
+#define VEC_NAME_(name_)        VEC_CONCAT_(name_, avx512_b)
+#define VEC_EXPORT_(name_)      VEC_CONCAT_(name_, avx512)
+#define VEC_WIDE_               0
+#define VEC_CHAR_               uint8_t
+#define VEC_                    __m512i
+#define VEC_SIZE_               64
+#define VEC_CMP_                __mmask64
+#define VEC_MASK_               uint64_t
+#define VEC_MASK_UNIT_          1
+#define VEC_LOAD_(p_)           _mm512_load_si512((const void *)(p_))
+#define VEC_SET1_(c_)           _mm512_set1_epi8((char)(c_))
+#define VEC_ZERO_()             _mm512_setzero_si512()
+#define VEC_EQ_(v1_, v2_)       _mm512_cmpeq_epi8_mask((v1_), (v2_))
+#define VEC_OR_(r1_, r2_)       ((r1_) | (r2_))
+#define VEC_BITS_(r_)           ((uint64_t)(r_))
+#define VEC_XOR_(v1_, v2_)      _mm512_xor_si512((v1_), (v2_))
+#define VEC_MINU_(v1_, v2_)     _mm512_min_epu8((v1_), (v2_))
+
+#include "_memchr_vec.h"
+
+#undef VEC_TARGET_
+#undef VEC_NAME_
+#undef VEC_EXPORT_
+#undef VEC_WIDE_
+#undef VEC_CHAR_
+#undef VEC_
+#undef VEC_SIZE_
+#undef VEC_CMP_
+#undef VEC_MASK_
+#undef VEC_MASK_UNIT_
+#undef VEC_LOAD_
+#undef VEC_SET1_
+#undef VEC_ZERO_
+#undef VEC_EQ_
+#undef VEC_OR_
+#undef VEC_BITS_
+#undef VEC_XOR_
+#undef VEC_MINU_
+
+//=============================================================================
+// AVX-512, wchar_t
+//=============================================================================
+#define VEC_TARGET_             __MCFCRT_STRING_TARGET_AVX512
+#define VEC_NAME_(name_)        VEC_CONCAT_(name_, avx512_w)
+#define VEC_EXPORT_(name_)      VEC_CONCAT_(name_, avx512)
+#define VEC_WIDE_               1
+#define VEC_CHAR_               uint16_t
+#define VEC_                    __m512i
+#define VEC_SIZE_               64
+#define VEC_CMP_                __mmask32
+#define VEC_MASK_               uint32_t
+#define VEC_MASK_UNIT_          2
+#define VEC_LOAD_(p_)           _mm512_load_si512((const void *)(p_))
+#define VEC_SET1_(c_)           _mm512_set1_epi16((short)(c_))
+#define VEC_ZERO_()             _mm512_setzero_si512()
+#define VEC_EQ_(v1_, v2_)       _mm512_cmpeq_epi16_mask((v1_), (v2_))
+#define VEC_OR_(r1_, r2_)       ((r1_) | (r2_))
+#define VEC_BITS_(r_)           ((uint32_t)(r_))
+#define VEC_XOR_(v1_, v2_)      _mm512_xor_si512((v1_), (v2_))
+#define VEC_MINU_(v1_, v2_)     _mm512_min_epu16((v1_), (v2_))
+
+#include "_memchr_vec.h"
+
+#undef VEC_TARGET_
+#undef VEC_NAME_
+#undef VEC_EXPORT_
+#undef VEC_WIDE_
+#undef VEC_CHAR_
+#undef VEC_
+#undef VEC_SIZE_
+#undef VEC_CMP_
+#undef VEC_MASK_
+#undef VEC_MASK_UNIT_
+#undef VEC_LOAD_
+#undef VEC_SET1_
+#undef VEC_ZERO_
+#undef VEC_EQ_
+#undef VEC_OR_
+#undef VEC_BITS_
+#undef VEC_XOR_
+#undef VEC_MINU_
@@ -0,0 +1,409 @@
+// 这个文件是 MCF 的一部分。
+// 有关具体授权说明，请参阅 MCFLicense.txt。
+// Copyleft 2013 - 2018, LH_Mouse. All wrongs reserved.
+
+// This file is a template, which is included once for each instruction set and character width by `_memchr_vec.c` with
+// these macros defined:
+//   VEC_TARGET_            the `__target__` attribute of all functions.
+//   VEC_NAME_(name_)       the name of an internal function for this instruction set and character width.
+//   VEC_EXPORT_(name_)     the name of an exported function for this instruction set.
+//   VEC_WIDE_              1 to define functions for `wchar_t`, or 0 to define functions for `char`.
+//   VEC_CHAR_              the unsigned character type, which is `uint16_t` if `VEC_WIDE_` is 1 and `uint8_t` otherwise.
+//   VEC_                   the vector type.
+//   VEC_SIZE_              the size of `VEC_` in bytes.
+//   VEC_CMP_               the type of results of `VEC_EQ_()`.
+//   VEC_MASK_              an unsigned integer type to hold results of `VEC_BITS_()`.
+//   VEC_MASK_UNIT_         the number of bytes that each bit in a `VEC_MASK_` stands for.
+//   VEC_LOAD_(p_)          loads a vector from an aligned address.
+//   VEC_SET1_(c_)          broadcasts a character to all elements of a vector.
+//   VEC_ZERO_()            returns a vector of zeroes.
+//   VEC_EQ_(v1_, v2_)      compares characters in two vectors for equality.
+//   VEC_OR_(r1_, r2_)      merges the results of two `VEC_EQ_()`.
+//   VEC_XOR_(v1_, v2_)     returns the bitwise exclusive OR of two vectors.
+//   VEC_MINU_(v1_, v2_)    returns the unsigned minimum of characters in two vectors.
+//   VEC_BITS_(r_)          converts the result of `VEC_EQ_()` to a `VEC_MASK_`.
+// All loads are aligned to vectors, and a block of four vectors is only loaded if it is aligned to its size, so it is
+// safe to read beyond the end of a string: The page containing the last character is always readable.
+
+// Convert the index of a set bit in a `VEC_MASK_` to an offset in bytes.
+#define VEC_FIRST_(m_)          ((size_t)(unsigned)__builtin_ctzll(m_) * VEC_MASK_UNIT_)
+#define VEC_LAST_(m_)           (((size_t)(63 - (unsigned)__builtin_clzll(m_)) * VEC_MASK_UNIT_) & (size_t)-sizeof(VEC_CHAR_))
+// Get a `VEC_MASK_` in which bits for the first `n_` bytes are set. `n_` shall be less than `VEC_SIZE_`.
+#define VEC_LOW_(n_)            (((VEC_MASK_)1 << (n_) / VEC_MASK_UNIT_) - 1)
+
+// Characters that match `c` (or null characters if `null_too` is `true`) become zeroes, so four vectors can be merged
+// using `VEC_MINU_()` and then compared with zero once. If `c` is a constant zero the exclusive OR is optimized away.
+VEC_TARGET_ __attribute__((__always_inline__))
+static inline VEC_ VEC_NAME_(key)(VEC_ v, VEC_ vc, bool null_too){
+	VEC_ k = VEC_XOR_(v, vc);
+	if(null_too){
+		k = VEC_MINU_(k, v);
+	}
+	return k;
+}
+
+// Returns the offset in bytes of the first match in a block of four vectors, one of which must have a match.
+VEC_TARGET_ __attribute__((__always_inline__))
+static inline size_t VEC_NAME_(block_first)(VEC_CMP_ r0, VEC_CMP_ r1, VEC_CMP_ r2, VEC_CMP_ r3){
+	VEC_MASK_ bits = VEC_BITS_(r0);
+	if(bits != 0){
+		return VEC_FIRST_(bits);
+	}
+	bits = VEC_BITS_(r1);
+	if(bits != 0){
+		return 1 * VEC_SIZE_ + VEC_FIRST_(bits);
+	}
+	bits = VEC_BITS_(r2);
+	if(bits != 0){
+		return 2 * VEC_SIZE_ + VEC_FIRST_(bits);
+	}
+	bits = VEC_BITS_(r3);
+	return 3 * VEC_SIZE_ + VEC_FIRST_(bits);
+}
+// Returns the offset in bytes of the last match in a block of four vectors, one of which must have a match.
+VEC_TARGET_ __attribute__((__always_inline__))
+static inline size_t VEC_NAME_(block_last)(VEC_CMP_ r0, VEC_CMP_ r1, VEC_CMP_ r2, VEC_CMP_ r3){
+	VEC_MASK_ bits = VEC_BITS_(r3);
+	if(bits != 0){
+		return 3 * VEC_SIZE_ + VEC_LAST_(bits);
+	}
+	bits = VEC_BITS_(r2);
+	if(bits != 0){
+		return 2 * VEC_SIZE_ + VEC_LAST_(bits);
+	}
+	bits = VEC_BITS_(r1);
+	if(bits != 0){
+		return 1 * VEC_SIZE_ + VEC_LAST_(bits);
+	}
+	bits = VEC_BITS_(r0);
+	return VEC_LAST_(bits);
+}
+
+// Finds the first `c` (or null character if `null_too` is `true`), which must exist.
+VEC_TARGET_ __attribute__((__always_inline__))
+static inline const VEC_CHAR_ *VEC_NAME_(find_fwd)(const VEC_CHAR_ *s, VEC_CHAR_ c, bool null_too){
+	const VEC_ vc = VEC_SET1_(c);
+	const VEC_ vz = VEC_ZERO_();
+	const unsigned char *arp = (const unsigned char *)((uintptr_t)s & (uintptr_t)-VEC_SIZE_);
+	VEC_MASK_ bits = VEC_BITS_(VEC_EQ_(VEC_NAME_(key)(VEC_LOAD_(arp), vc, null_too), vz));
+	bits >>= (size_t)((const unsigned char *)s - arp) / VEC_MASK_UNIT_;
+	if(bits != 0){
+		return (const VEC_CHAR_ *)((const unsigned char *)s + VEC_FIRST_(bits));
+	}
+	arp += VEC_SIZE_;
+	// Scan single vectors until `arp` is aligned to a block.
+	while((uintptr_t)arp % (4 * VEC_SIZE_) != 0){
+		bits = VEC_BITS_(VEC_EQ_(VEC_NAME_(key)(VEC_LOAD_(arp), vc, null_too), vz));
+		if(bits != 0){
+			return (const VEC_CHAR_ *)(arp + VEC_FIRST_(bits));
+		}
+		arp += VEC_SIZE_;
+	}
+	for(;;){
+		const VEC_ k0 = VEC_NAME_(key)(VEC_LOAD_(arp                ), vc, null_too);
+		const VEC_ k1 = VEC_NAME_(key)(VEC_LOAD_(arp + 1 * VEC_SIZE_), vc, null_too);
+		const VEC_ k2 = VEC_NAME_(key)(VEC_LOAD_(arp + 2 * VEC_SIZE_), vc, null_too);
+		const VEC_ k3 = VEC_NAME_(key)(VEC_LOAD_(arp + 3 * VEC_SIZE_), vc, null_too);
+		if(_MCFCRT_EXPECT_NOT(VEC_BITS_(VEC_EQ_(VEC_MINU_(VEC_MINU_(k0, k1), VEC_MINU_(k2, k3)), vz)) != 0)){
+			return (const VEC_CHAR_ *)(arp + VEC_NAME_(block_first)(VEC_EQ_(k0, vz), VEC_EQ_(k1, vz), VEC_EQ_(k2, vz), VEC_EQ_(k3, vz)));
+		}
+		arp += 4 * VEC_SIZE_;
+	}
+}
+
+// Finds the first `c` in the first `n` bytes.
+VEC_TARGET_ __attribute__((__always_inline__))
+static inline const VEC_CHAR_ *VEC_NAME_(find_fwd_n)(const VEC_CHAR_ *s, VEC_CHAR_ c, size_t n){
+	if(_MCFCRT_EXPECT_NOT(n == 0)){
+		return _MCFCRT_NULLPTR;
+	}
+	const VEC_ vc = VEC_SET1_(c);
+	const unsigned char *arp = (const unsigned char *)((uintptr_t)s & (uintptr_t)-VEC_SIZE_);
+	const size_t skip = (size_t)((const unsigned char *)s - arp);
+	VEC_MASK_ bits = VEC_BITS_(VEC_EQ_(VEC_LOAD_(arp), vc)) >> skip / VEC_MASK_UNIT_;
+	if(n <= VEC_SIZE_ - skip){
+		if(n < VEC_SIZE_ - skip){
+			bits &= VEC_LOW_(n);
+		}
+		if(bits == 0){
+			return _MCFCRT_NULLPTR;
+		}
+		return (const VEC_CHAR_ *)((const unsigned char *)s + VEC_FIRST_(bits));
+	}
+	if(bits != 0){
+		return (const VEC_CHAR_ *)((const unsigned char *)s + VEC_FIRST_(bits));
+	}
+	arp += VEC_SIZE_;
+	// This is the number of bytes from `arp` to the end.
+	size_t rem = n - (VEC_SIZE_ - skip);
+	// Scan single vectors until `arp` is aligned to a block.
+	while((uintptr_t)arp % (4 * VEC_SIZE_) != 0){
+		bits = VEC_BITS_(VEC_EQ_(VEC_LOAD_(arp), vc));
+		if(rem <= VEC_SIZE_){
+			goto end_trunc;
+		}
+		if(bits != 0){
+			return (const VEC_CHAR_ *)(arp + VEC_FIRST_(bits));
+		}
+		arp += VEC_SIZE_;
+		rem -= VEC_SIZE_;
+	}
+	while(_MCFCRT_EXPECT(rem > 4 * VEC_SIZE_)){
+		const VEC_CMP_ r0 = VEC_EQ_(VEC_LOAD_(arp                ), vc);
+		const VEC_CMP_ r1 = VEC_EQ_(VEC_LOAD_(arp + 1 * VEC_SIZE_), vc);
+		const VEC_CMP_ r2 = VEC_EQ_(VEC_LOAD_(arp + 2 * VEC_SIZE_), vc);
+		const VEC_CMP_ r3 = VEC_EQ_(VEC_LOAD_(arp + 3 * VEC_SIZE_), vc);
+		if(_MCFCRT_EXPECT_NOT(VEC_BITS_(VEC_OR_(VEC_OR_(r0, r1), VEC_OR_(r2, r3))) != 0)){
+			return (const VEC_CHAR_ *)(arp + VEC_NAME_(block_first)(r0, r1, r2, r3));
+		}
+		arp += 4 * VEC_SIZE_;
+		rem -= 4 * VEC_SIZE_;
+	}
+	// The remaining bytes are in the next block, which is in the same page as the last byte.
+	for(;;){
+		bits = VEC_BITS_(VEC_EQ_(VEC_LOAD_(arp), vc));
+		if(rem <= VEC_SIZE_){
+			goto end_trunc;
+		}
+		if(bits != 0){
+			return (const VEC_CHAR_ *)(arp + VEC_FIRST_(bits));
+		}
+		arp += VEC_SIZE_;
+		rem -= VEC_SIZE_;
+	}
+end_trunc:
+	if(rem < VEC_SIZE_){
+		bits &= VEC_LOW_(rem);
+	}
+	if(bits == 0){
+		return _MCFCRT_NULLPTR;
+	}
+	return (const VEC_CHAR_ *)(arp + VEC_FIRST_(bits));
+}
+
+// Finds the last `c` in the first `n` bytes.
+VEC_TARGET_ __attribute__((__always_inline__))
+static inline const VEC_CHAR_ *VEC_NAME_(find_bwd_n)(const VEC_CHAR_ *s, VEC_CHAR_ c, size_t n){
+	if(_MCFCRT_EXPECT_NOT(n == 0)){
+		return _MCFCRT_NULLPTR;
+	}
+	const VEC_ vc = VEC_SET1_(c);
+	const unsigned char *const brp = (const unsigned char *)s;
+	const unsigned char *const erp = brp + n;
+	// `arp` points to the vector containing the last byte. Bytes from `arp` onwards have been scanned.
+	const unsigned char *arp = (const unsigned char *)((uintptr_t)(erp - 1) & (uintptr_t)-VEC_SIZE_);
+	VEC_MASK_ bits = VEC_BITS_(VEC_EQ_(VEC_LOAD_(arp), vc));
+	if((size_t)(erp - arp) < VEC_SIZE_){
+		bits &= VEC_LOW_((size_t)(erp - arp));
+	}
+	if(arp <= brp){
+		goto end_trunc;
+	}
+	if(bits != 0){
+		return (const VEC_CHAR_ *)(arp + VEC_LAST_(bits));
+	}
+	// Scan single vectors until `arp` is aligned to a block.
+	while((uintptr_t)arp % (4 * VEC_SIZE_) != 0){
+		arp -= VEC_SIZE_;
+		bits = VEC_BITS_(VEC_EQ_(VEC_LOAD_(arp), vc));
+		if(arp <= brp){
+			goto end_trunc;
+		}
+		if(bits != 0){
+			return (const VEC_CHAR_ *)(arp + VEC_LAST_(bits));
+		}
+	}
+	while(_MCFCRT_EXPECT((size_t)(arp - brp) > 4 * VEC_SIZE_)){
+		arp -= 4 * VEC_SIZE_;
+		const VEC_CMP_ r0 = VEC_EQ_(VEC_LOAD_(arp                ), vc);
+		const VEC_CMP_ r1 = VEC_EQ_(VEC_LOAD_(arp + 1 * VEC_SIZE_), vc);
+		const VEC_CMP_ r2 = VEC_EQ_(VEC_LOAD_(arp + 2 * VEC_SIZE_), vc);
+		const VEC_CMP_ r3 = VEC_EQ_(VEC_LOAD_(arp + 3 * VEC_SIZE_), vc);
+		if(_MCFCRT_EXPECT_NOT(VEC_BITS_(VEC_OR_(VEC_OR_(r0, r1), VEC_OR_(r2, r3))) != 0)){
+			return (const VEC_CHAR_ *)(arp + VEC_NAME_(block_last)(r0, r1, r2, r3));
+		}
+	}
+	// The remaining bytes are in the previous block, which is in the same page as the first byte.
+	for(;;){
+		arp -= VEC_SIZE_;
+		bits = VEC_BITS_(VEC_EQ_(VEC_LOAD_(arp), vc));
+		if(arp <= brp){
+			goto end_trunc;
+		}
+		if(bits != 0){
+			return (const VEC_CHAR_ *)(arp + VEC_LAST_(bits));
+		}
+	}
+end_trunc:
+	// Discard bytes before `s`.
+	bits &= ~VEC_LOW_((size_t)(brp - arp));
+	if(bits == 0){
+		return _MCFCRT_NULLPTR;
+	}
+	return (const VEC_CHAR_ *)(arp + VEC_LAST_(bits));
+}
+
+// Finds the last `c` before the first null character. If `c` is zero, the null character is returned.
+VEC_TARGET_ __attribute__((__always_inline__))
+static inline const VEC_CHAR_ *VEC_NAME_(find_last)(const VEC_CHAR_ *s, VEC_CHAR_ c){
+	const VEC_ vc = VEC_SET1_(c);
+	const VEC_ vz = VEC_ZERO_();
+	// The last vector in which `c` has been found, and the bits of `c` in it.
+	const unsigned char *found = _MCFCRT_NULLPTR;
+	VEC_MASK_ found_bits = 0;
+	// The last block in which `c` has been found. This takes precedence over `found`.
+	const unsigned char *found_block = _MCFCRT_NULLPTR;
+
+	const unsigned char *arp = (const unsigned char *)((uintptr_t)s & (uintptr_t)-VEC_SIZE_);
+	const size_t shift = (size_t)((const unsigned char *)s - arp) / VEC_MASK_UNIT_;
+	VEC_ v = VEC_LOAD_(arp);
+	VEC_MASK_ zbits = VEC_BITS_(VEC_EQ_(v, vz)) >> shift;
+	VEC_MASK_ cbits = VEC_BITS_(VEC_EQ_(v, vc)) >> shift;
+	if(zbits != 0){
+		// Discard bits after the null character.
+		cbits &= zbits ^ (zbits - 1);
+		if(cbits == 0){
+			return _MCFCRT_NULLPTR;
+		}
+		return (const VEC_CHAR_ *)((const unsigned char *)s + VEC_LAST_(cbits));
+	}
+	if(cbits != 0){
+		found = (const unsigned char *)s;
+		found_bits = cbits;
+	}
+	arp += VEC_SIZE_;
+	// Scan single vectors until `arp` is aligned to a block.
+	while((uintptr_t)arp % (4 * VEC_SIZE_) != 0){
+		v = VEC_LOAD_(arp);
+		zbits = VEC_BITS_(VEC_EQ_(v, vz));
+		cbits = VEC_BITS_(VEC_EQ_(v, vc));
+		if(zbits != 0){
+			goto end_null;
+		}
+		if(cbits != 0){
+			found = arp;
+			found_bits = cbits;
+		}
+		arp += VEC_SIZE_;
+	}
+	for(;;){
+		const VEC_ v0 = VEC_LOAD_(arp                );
+		const VEC_ v1 = VEC_LOAD_(arp + 1 * VEC_SIZE_);
+		const VEC_ v2 = VEC_LOAD_(arp + 2 * VEC_SIZE_);
+		const VEC_ v3 = VEC_LOAD_(arp + 3 * VEC_SIZE_);
+		const VEC_CMP_ z = VEC_OR_(VEC_OR_(VEC_EQ_(v0, vz), VEC_EQ_(v1, vz)), VEC_OR_(VEC_EQ_(v2, vz), VEC_EQ_(v3, vz)));
+		if(_MCFCRT_EXPECT_NOT(VEC_BITS_(z) != 0)){
+			break;
+		}
+		const VEC_CMP_ m = VEC_OR_(VEC_OR_(VEC_EQ_(v0, vc), VEC_EQ_(v1, vc)), VEC_OR_(VEC_EQ_(v2, vc), VEC_EQ_(v3, vc)));
+		if(VEC_BITS_(m) != 0){
+			found_block = arp;
+		}
+		arp += 4 * VEC_SIZE_;
+	}
+	// The null character is in this block.
+	for(;;){
+		v = VEC_LOAD_(arp);
+		zbits = VEC_BITS_(VEC_EQ_(v, vz));
+		cbits = VEC_BITS_(VEC_EQ_(v, vc));
+		if(zbits != 0){
+			goto end_null;
+		}
+		if(cbits != 0){
+			found = arp;
+			found_bits = cbits;
+			found_block = _MCFCRT_NULLPTR;
+		}
+		arp += VEC_SIZE_;
+	}
+end_null:
+	cbits &= zbits ^ (zbits - 1);
+	if(cbits != 0){
+		return (const VEC_CHAR_ *)(arp + VEC_LAST_(cbits));
+	}
+	if(found_block){
+		const VEC_CMP_ r0 = VEC_EQ_(VEC_LOAD_(found_block                ), vc);
+		const VEC_CMP_ r1 = VEC_EQ_(VEC_LOAD_(found_block + 1 * VEC_SIZE_), vc);
+		const VEC_CMP_ r2 = VEC_EQ_(VEC_LOAD_(found_block + 2 * VEC_SIZE_), vc);
+		const VEC_CMP_ r3 = VEC_EQ_(VEC_LOAD_(found_block + 3 * VEC_SIZE_), vc);
+		return (const VEC_CHAR_ *)(found_block + VEC_NAME_(block_last)(r0, r1, r2, r3));
+	}
+	if(found){
+		return (const VEC_CHAR_ *)(found + VEC_LAST_(found_bits));
+	}
+	return _MCFCRT_NULLPTR;
+}
+
+#if VEC_WIDE_
+
+VEC_TARGET_
+wchar_t *VEC_EXPORT_(__MCFCRT_rawwmemchr)(const wchar_t *s, wchar_t c){
+	return (wchar_t *)VEC_NAME_(find_fwd)((const VEC_CHAR_ *)s, (VEC_CHAR_)c, false);
+}
+VEC_TARGET_
+wchar_t *VEC_EXPORT_(__MCFCRT_wmemchr)(const wchar_t *s, wchar_t c, size_t n){
+	// Saturate the number of bytes. Scanning stops at the end of the address space anyway.
+	const size_t bytes = (n <= SIZE_MAX / sizeof(wchar_t)) ? (n * sizeof(wchar_t)) : SIZE_MAX;
+	return (wchar_t *)VEC_NAME_(find_fwd_n)((const VEC_CHAR_ *)s, (VEC_CHAR_)c, bytes);
+}
+VEC_TARGET_
+size_t VEC_EXPORT_(__MCFCRT_wcslen)(const wchar_t *s){
+	return (size_t)((const wchar_t *)VEC_NAME_(find_fwd)((const VEC_CHAR_ *)s, 0, false) - s);
+}
+VEC_TARGET_
+wchar_t *VEC_EXPORT_(__MCFCRT_wcschr)(const wchar_t *s, wchar_t c){
+	const VEC_CHAR_ *const p = VEC_NAME_(find_fwd)((const VEC_CHAR_ *)s, (VEC_CHAR_)c, true);
+	if(*p != (VEC_CHAR_)c){
+		return _MCFCRT_NULLPTR;
+	}
+	return (wchar_t *)p;
+}
+VEC_TARGET_
+wchar_t *VEC_EXPORT_(__MCFCRT_wcsrchr)(const wchar_t *s, wchar_t c){
+	return (wchar_t *)VEC_NAME_(find_last)((const VEC_CHAR_ *)s, (VEC_CHAR_)c);
+}
+
+#else
+
+VEC_TARGET_
+void *VEC_EXPORT_(__MCFCRT_rawmemchr)(const void *s, int c){
+	return (void *)VEC_NAME_(find_fwd)(s, (VEC_CHAR_)c, false);
+}
+VEC_TARGET_
+void *VEC_EXPORT_(__MCFCRT_memchr)(const void *s, int c, size_t n){
+	return (void *)VEC_NAME_(find_fwd_n)(s, (VEC_CHAR_)c, n);
+}
+VEC_TARGET_
+void *VEC_EXPORT_(__MCFCRT_memrchr)(const void *s, int c, size_t n){
+	return (void *)VEC_NAME_(find_bwd_n)(s, (VEC_CHAR_)c, n);
+}
+VEC_TARGET_
+size_t VEC_EXPORT_(__MCFCRT_strlen)(const char *s){
+	return (size_t)((const char *)VEC_NAME_(find_fwd)((const VEC_CHAR_ *)s, 0, false) - s);
+}
+VEC_TARGET_
+size_t VEC_EXPORT_(__MCFCRT_strnlen)(const char *s, size_t n){
+	const char *const p = (const char *)VEC_NAME_(find_fwd_n)((const VEC_CHAR_ *)s, 0, n);
+	if(!p){
+		return n;
+	}
+	return (size_t)(p - s);
+}
+VEC_TARGET_
+char *VEC_EXPORT_(__MCFCRT_strchr)(const char *s, int c){
+	const VEC_CHAR_ *const p = VEC_NAME_(find_fwd)((const VEC_CHAR_ *)s, (VEC_CHAR_)c, true);
+	if(*p != (VEC_CHAR_)c){
+		return _MCFCRT_NULLPTR;
+	}
+	return (char *)p;
+}
+VEC_TARGET_
+char *VEC_EXPORT_(__MCFCRT_strrchr)(const char *s, int c){
+	return (char *)VEC_NAME_(find_last)((const VEC_CHAR_ *)s, (VEC_CHAR_)c);
+}
+
+#endif
+
+#undef VEC_FIRST_
+#undef VEC_LAST_
+#undef VEC_LOW_
@@ -0,0 +1,96 @@
+// 这个文件是 MCF 的一部分。
+// 有关具体授权说明，请参阅 MCFLicense.txt。
+// Copyleft 2013 - 2018, LH_Mouse. All wrongs reserved.
+
+#include "../../env/_crtdef.h"
+#include "../../env/expect.h"
+#include "../../env/_string_dispatch.h"
+#include <immintrin.h>
+
+// Reading `size` bytes from `p` cannot fault if they are in the same page as `p`.
+static inline bool IsOverReadSafe(const void *p, size_t size){
+	return (uintptr_t)p % 0x1000 <= 0x1000 - size;
+}
+
+#define VEC_CONCAT_2_(x_, y_)   x_##_##y_
+#define VEC_CONCAT_(x_, y_)     VEC_CONCAT_2_(x_, y_)
+
+//=============================================================================
+// SSE2
+//=============================================================================
+#define VEC_TARGET_
+#define VEC_NAME_(name_)        VEC_CONCAT_(name_, sse2)
+#define VEC_                    __m128i
+#define VEC_SIZE_               16
+#define VEC_MASK_               uint32_t
+#define VEC_LOADU_(p_)          _mm_loadu_si128((const __m128i *)(p_))
+#define VEC_DELTA_(v1_, v2_)    _mm_cmpeq_epi8((v1_), (v2_))
+#define VEC_MERGE_(d1_, d2_)    _mm_and_si128((d1_), (d2_))
+#define VEC_BITS_(d_)           ((uint32_t)_mm_movemask_epi8(d_) ^ 0xFFFFu)
+
+#include "_memcmp_vec.h"
+
+#undef VEC_TARGET_
+#undef VEC_NAME_
+#undef VEC_
+#undef VEC_SIZE_
+#undef VEC_MASK_
+#undef VEC_LOADU_
+#undef VEC_DELTA_
+#undef VEC_MERGE_
+#undef VEC_BITS_
+
+//=============================================================================
+// AVX2
+//=============================================================================
+#define VEC_TARGET_             __MCFCRT_STRING_TARGET_AVX2
+#define VEC_NAME_(name_)        VEC_CONCAT_(name_, avx2)
+#define VEC_                    __m256i
+#define VEC_SIZE_               32
+#define VEC_MASK_               uint32_t
+#define VEC_LOADU_(p_)          _mm256_loadu_si256((const __m256i *)(p_))
+#define VEC_DELTA_(v1_, v2_)    _mm256_cmpeq_epi8((v1_), (v2_))
+#define VEC_MERGE_(d1_, d2_)    _mm256_and_si256((d1_), (d2_))
+#define VEC_BITS_(d_)           (~(uint32_t)_mm256_movemask_epi8(d_))
+
+#include "_memcmp_vec.h"
+
+#undef VEC_TARGET_
+#undef VEC_NAME_
+#undef VEC_
+#undef VEC_SIZE_
+#undef VEC_MASK_
+#undef VEC_LOADU_
+#undef VEC_DELTA_
+#undef VEC_MERGE_
+#undef VEC_BITS_
+
+//=============================================================================
+// AVX-512
+//=============================================================================
+// Masked loads do not fault on masked-out bytes, so the tail can be read without checking page boundaries.
+#define VEC_TARGET_             __MCFCRT_STRING_TARGET_AVX512
+#define VEC_NAME_(name_)        VEC_CONCAT_(name_, avx512)
+#define VEC_                    __m512i
+#define VEC_SIZE_               64
+#define VEC_MASK_               uint64_t
+#define VEC_LOADU_(p_)          _mm512_loadu_si512((const void *)(p_))
+#define VEC_DELTA_(v1_, v2_)    _mm512_xor_si512((v1_), (v2_))
+#define VEC_MERGE_(d1_, d2_)    _mm512_or_si512((d1_), (d2_))
+#define VEC_BITS_(d_)           ((uint64_t)_mm512_test_epi8_mask((d_), (d_)))
+#define VEC_BITS_PARTIAL_(p1_, p2_, n_)	\
+	((uint64_t)_mm512_cmpneq_epu8_mask(_mm512_maskz_loadu_epi8(((__mmask64)1 << (n_)) - 1, (p1_)),	\
+	                                   _mm512_maskz_loadu_epi8(((__mmask64)1 << (n_)) - 1, (p2_))))
+
+#include "_memcmp_vec.h"
+
+#undef VEC_TARGET_
+#undef VEC_NAME_
+#undef VEC_
+#undef VEC_SIZE_
+#undef VEC_MASK_
+#undef VEC_LOADU_
+#undef VEC_DELTA_
+#undef VEC_MERGE_
+#undef VEC_BITS_
+#undef VEC_BITS_PARTIAL_
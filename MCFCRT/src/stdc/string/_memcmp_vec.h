@@ -0,0 +1,171 @@
+// 这个文件是 MCF 的一部分。
+// 有关具体授权说明，请参阅 MCFLicense.txt。
+// Copyleft 2013 - 2018, LH_Mouse. All wrongs reserved.
+
+// This file is a template, which is included once for each instruction set by `_memcmp_vec.c` with these macros defined:
+//   VEC_TARGET_            the `__target__` attribute of all functions.
+//   VEC_NAME_(name_)       the name of a function for this instruction set.
+//   VEC_                   the vector type.
+//   VEC_SIZE_              the size of `VEC_` in bytes.
+//   VEC_MASK_              an unsigned integer type having at least `VEC_SIZE_` bits.
+//   VEC_LOADU_(p_)         loads a vector from an unaligned address.
+//   VEC_DELTA_(v1_, v2_)   compares two vectors and returns a vector which can be passed to `VEC_MERGE_()` and `VEC_BITS_()`.
+//   VEC_MERGE_(d1_, d2_)   merges the results of two `VEC_DELTA_()`, so a byte differs in the result if it differs in either.
+//   VEC_BITS_(d_)          returns a `VEC_MASK_` in which each bit is set if the corresponding bytes differ.
+// This macro is optional:
+//   VEC_BITS_PARTIAL_(p1_, p2_, n_)
+//                          compares the first `n_` bytes (`n_` < `VEC_SIZE_`) without touching any byte beyond them, and
+//                          returns a `VEC_MASK_` like `VEC_BITS_()`. If it is not defined, bytes beyond `n_` are read if
+//                          they are in the same page, otherwise bytes are compared one by one.
+
+#define VEC_DIFF_(p1_, p2_)     VEC_BITS_(VEC_DELTA_(VEC_LOADU_(p1_), VEC_LOADU_(p2_)))
+
+// Returns the offset of the first differing byte, or `n` if there is no such byte. `n` shall be less than `VEC_SIZE_`.
+VEC_TARGET_ __attribute__((__always_inline__))
+static inline size_t VEC_NAME_(mismatch_small)(const unsigned char *p1, const unsigned char *p2, size_t n){
+#ifdef VEC_BITS_PARTIAL_
+	const VEC_MASK_ bits = VEC_BITS_PARTIAL_(p1, p2, n);
+	if(bits == 0){
+		return n;
+	}
+	return (unsigned)__builtin_ctzll(bits);
+#else
+	// If `n` is zero, the page containing `p1` or `p2` might not be readable at all.
+	if(n == 0){
+		return 0;
+	}
+	if(_MCFCRT_EXPECT(IsOverReadSafe(p1, VEC_SIZE_) && IsOverReadSafe(p2, VEC_SIZE_))){
+		const VEC_MASK_ bits = VEC_DIFF_(p1, p2) & (((VEC_MASK_)1 << n) - 1);
+		if(bits == 0){
+			return n;
+		}
+		return (unsigned)__builtin_ctzll(bits);
+	}
+	for(size_t i = 0; i < n; ++i){
+		if(p1[i] != p2[i]){
+			return i;
+		}
+	}
+	return n;
+#endif
+}
+
+// Returns the offset of the first differing byte, or `n` if there is no such byte.
+// The first vector is compared unaligned. After that, reads from `p1` are aligned. The last vector is compared unaligned
+// again and overlaps bytes that have been compared, which is fine since they are known to be equal.
+VEC_TARGET_ __attribute__((__always_inline__))
+static inline size_t VEC_NAME_(mismatch)(const unsigned char *p1, const unsigned char *p2, size_t n){
+	if(_MCFCRT_EXPECT_NOT(n < VEC_SIZE_)){
+		return VEC_NAME_(mismatch_small)(p1, p2, n);
+	}
+	VEC_MASK_ bits = VEC_DIFF_(p1, p2);
+	if(bits != 0){
+		return (unsigned)__builtin_ctzll(bits);
+	}
+	size_t off = VEC_SIZE_ - (uintptr_t)p1 % VEC_SIZE_;
+	while(_MCFCRT_EXPECT((size_t)(n - off) > 4 * VEC_SIZE_)){
+		const VEC_ d0 = VEC_DELTA_(VEC_LOADU_(p1 + off                ), VEC_LOADU_(p2 + off                ));
+		const VEC_ d1 = VEC_DELTA_(VEC_LOADU_(p1 + off + 1 * VEC_SIZE_), VEC_LOADU_(p2 + off + 1 * VEC_SIZE_));
+		const VEC_ d2 = VEC_DELTA_(VEC_LOADU_(p1 + off + 2 * VEC_SIZE_), VEC_LOADU_(p2 + off + 2 * VEC_SIZE_));
+		const VEC_ d3 = VEC_DELTA_(VEC_LOADU_(p1 + off + 3 * VEC_SIZE_), VEC_LOADU_(p2 + off + 3 * VEC_SIZE_));
+		if(_MCFCRT_EXPECT_NOT(VEC_BITS_(VEC_MERGE_(VEC_MERGE_(d0, d1), VEC_MERGE_(d2, d3))) != 0)){
+			bits = VEC_BITS_(d0);
+			if(bits != 0){
+				return off + (unsigned)__builtin_ctzll(bits);
+			}
+			bits = VEC_BITS_(d1);
+			if(bits != 0){
+				return off + 1 * VEC_SIZE_ + (unsigned)__builtin_ctzll(bits);
+			}
+			bits = VEC_BITS_(d2);
+			if(bits != 0){
+				return off + 2 * VEC_SIZE_ + (unsigned)__builtin_ctzll(bits);
+			}
+			bits = VEC_BITS_(d3);
+			return off + 3 * VEC_SIZE_ + (unsigned)__builtin_ctzll(bits);
+		}
+		off += 4 * VEC_SIZE_;
+	}
+	while((size_t)(n - off) > VEC_SIZE_){
+		bits = VEC_DIFF_(p1 + off, p2 + off);
+		if(bits != 0){
+			return off + (unsigned)__builtin_ctzll(bits);
+		}
+		off += VEC_SIZE_;
+	}
+	bits = VEC_DIFF_(p1 + n - VEC_SIZE_, p2 + n - VEC_SIZE_);
+	if(bits != 0){
+		return n - VEC_SIZE_ + (unsigned)__builtin_ctzll(bits);
+	}
+	return n;
+}
+
+VEC_TARGET_
+int VEC_NAME_(__MCFCRT_memcmp)(const void *s1, const void *s2, size_t n){
+	const unsigned char *const p1 = s1;
+	const unsigned char *const p2 = s2;
+	const size_t off = VEC_NAME_(mismatch)(p1, p2, n);
+	if(off == n){
+		return 0;
+	}
+	return (p1[off] < p2[off]) ? -1 : 1;
+}
+
+VEC_TARGET_
+int VEC_NAME_(__MCFCRT_wmemcmp)(const wchar_t *s1, const wchar_t *s2, size_t n){
+	// Locate the first differing byte, then compare the characters containing it.
+	const size_t off = VEC_NAME_(mismatch)((const unsigned char *)s1, (const unsigned char *)s2, n * sizeof(wchar_t)) / sizeof(wchar_t);
+	if(off == n){
+		return 0;
+	}
+	return (s1[off] < s2[off]) ? -1 : 1;
+}
+
+VEC_TARGET_
+size_t VEC_NAME_(__MCFCRT_memmismatch)(const void *s1, const void *s2, size_t n){
+	return VEC_NAME_(mismatch)(s1, s2, n);
+}
+
+// Only tells whether the blocks are equal, so the loop does not need to find out which byte differs.
+VEC_TARGET_
+bool VEC_NAME_(__MCFCRT_memeq)(const void *s1, const void *s2, size_t n){
+	const unsigned char *const p1 = s1;
+	const unsigned char *const p2 = s2;
+	if(_MCFCRT_EXPECT_NOT(n < VEC_SIZE_)){
+		return VEC_NAME_(mismatch_small)(p1, p2, n) == n;
+	}
+	if(n <= 2 * VEC_SIZE_){
+		const VEC_ d0 = VEC_DELTA_(VEC_LOADU_(p1), VEC_LOADU_(p2));
+		const VEC_ d1 = VEC_DELTA_(VEC_LOADU_(p1 + n - VEC_SIZE_), VEC_LOADU_(p2 + n - VEC_SIZE_));
+		return VEC_BITS_(VEC_MERGE_(d0, d1)) == 0;
+	}
+	if(n <= 4 * VEC_SIZE_){
+		const VEC_ d0 = VEC_DELTA_(VEC_LOADU_(p1), VEC_LOADU_(p2));
+		const VEC_ d1 = VEC_DELTA_(VEC_LOADU_(p1 + VEC_SIZE_), VEC_LOADU_(p2 + VEC_SIZE_));
+		const VEC_ d2 = VEC_DELTA_(VEC_LOADU_(p1 + n - 2 * VEC_SIZE_), VEC_LOADU_(p2 + n - 2 * VEC_SIZE_));
+		const VEC_ d3 = VEC_DELTA_(VEC_LOADU_(p1 + n - 1 * VEC_SIZE_), VEC_LOADU_(p2 + n - 1 * VEC_SIZE_));
+		return VEC_BITS_(VEC_MERGE_(VEC_MERGE_(d0, d1), VEC_MERGE_(d2, d3))) == 0;
+	}
+	if(VEC_DIFF_(p1, p2) != 0){
+		return false;
+	}
+	size_t off = VEC_SIZE_ - (uintptr_t)p1 % VEC_SIZE_;
+	while(_MCFCRT_EXPECT((size_t)(n - off) > 4 * VEC_SIZE_)){
+		const VEC_ d0 = VEC_DELTA_(VEC_LOADU_(p1 + off                ), VEC_LOADU_(p2 + off                ));
+		const VEC_ d1 = VEC_DELTA_(VEC_LOADU_(p1 + off + 1 * VEC_SIZE_), VEC_LOADU_(p2 + off + 1 * VEC_SIZE_));
+		const VEC_ d2 = VEC_DELTA_(VEC_LOADU_(p1 + off + 2 * VEC_SIZE_), VEC_LOADU_(p2 + off + 2 * VEC_SIZE_));
+		const VEC_ d3 = VEC_DELTA_(VEC_LOADU_(p1 + off + 3 * VEC_SIZE_), VEC_LOADU_(p2 + off + 3 * VEC_SIZE_));
+		if(VEC_BITS_(VEC_MERGE_(VEC_MERGE_(d0, d1), VEC_MERGE_(d2, d3))) != 0){
+			return false;
+		}
+		off += 4 * VEC_SIZE_;
+	}
+	// Compare the last four vectors, which may overlap bytes that have been compared.
+	const VEC_ d0 = VEC_DELTA_(VEC_LOADU_(p1 + n - 4 * VEC_SIZE_), VEC_LOADU_(p2 + n - 4 * VEC_SIZE_));
+	const VEC_ d1 = VEC_DELTA_(VEC_LOADU_(p1 + n - 3 * VEC_SIZE_), VEC_LOADU_(p2 + n - 3 * VEC_SIZE_));
+	const VEC_ d2 = VEC_DELTA_(VEC_LOADU_(p1 + n - 2 * VEC_SIZE_), VEC_LOADU_(p2 + n - 2 * VEC_SIZE_));
+	const VEC_ d3 = VEC_DELTA_(VEC_LOADU_(p1 + n - 1 * VEC_SIZE_), VEC_LOADU_(p2 + n - 1 * VEC_SIZE_));
+	return VEC_BITS_(VEC_MERGE_(VEC_MERGE_(d0, d1), VEC_MERGE_(d2, d3))) == 0;
+}
+
+#undef VEC_DIFF_
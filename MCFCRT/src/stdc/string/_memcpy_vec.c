@@ -0,0 +1,79 @@
+// 这个文件是 MCF 的一部分。
+// 有关具体授权说明，请参阅 MCFLicense.txt。
+// Copyleft 2013 - 2018, LH_Mouse. All wrongs reserved.
+
+#include "../../env/_crtdef.h"
+#include "../../env/expect.h"
+#include "../../env/cpu.h"
+#include "../../env/_string_dispatch.h"
+#include "_memset_impl.h"
+#include <immintrin.h>
+
+// Copies bigger than this would evict most of the last level cache, so write them around caches.
+static size_t GetNonTemporalThreshold(void){
+	return _MCFCRT_CpuGetCacheSize(_MCFCRT_kCpuCacheLevelMax) / 4;
+}
+
+// Reference:
+//   Intel® 64 and IA-32 Architectures Optimization Reference Manual
+//     3.7.6 Enhanced REP MOVSB and STOSB Operation (ERMSB)
+static bool IsRepMovsbFast(void){
+	return _MCFCRT_CpuHasFeature(_MCFCRT_kCpuFeatureErms) || _MCFCRT_CpuHasFeature(_MCFCRT_kCpuFeatureFsrm);
+}
+static void CopyRepMovsb(unsigned char *dst, const unsigned char *src, size_t n){
+	__asm__ volatile (
+		"rep movsb \n"
+		: "+D"(dst), "+S"(src), "+c"(n)
+		:
+		: "memory"
+	);
+}
+
+#define VEC_CONCAT_2_(x_, y_)   x_##_##y_
+#define VEC_CONCAT_(x_, y_)     VEC_CONCAT_2_(x_, y_)
+
+//=============================================================================
+// AVX2
+//=============================================================================
+#define VEC_TARGET_             __MCFCRT_STRING_TARGET_AVX2
+#define VEC_NAME_(name_)        VEC_CONCAT_(name_, avx2)
+#define VEC_                    __m256i
+#define VEC_SIZE_               32
+#define VEC_LOADU_(p_)          _mm256_loadu_si256((const __m256i *)(p_))
+#define VEC_STOREU_(p_, v_)     _mm256_storeu_si256((__m256i *)(p_), (v_))
+#define VEC_STORE_(p_, v_)      _mm256_store_si256((__m256i *)(p_), (v_))
+#define VEC_STREAM_(p_, v_)     _mm256_stream_si256((__m256i *)(p_), (v_))
+
+#include "_memcpy_vec.h"
+
+#undef VEC_TARGET_
+#undef VEC_NAME_
+#undef VEC_
+#undef VEC_SIZE_
+#undef VEC_LOADU_
+#undef VEC_STOREU_
+#undef VEC_STORE_
+#undef VEC_STREAM_
+
+//=============================================================================
+// AVX-512
+//=============================================================================
+#define VEC_TARGET_             __MCFCRT_STRING_TARGET_AVX512
+#define VEC_NAME_(name_)        VEC_CONCAT_(name_, avx512)
+#define VEC_                    __m512i
+#define VEC_SIZE_               64
+#define VEC_LOADU_(p_)          _mm512_loadu_si512((const void *)(p_))
+#define VEC_STOREU_(p_, v_)     _mm512_storeu_si512((void *)(p_), (v_))
+#define VEC_STORE_(p_, v_)      _mm512_store_si512((void *)(p_), (v_))
+#define VEC_STREAM_(p_, v_)     _mm512_stream_si512((void *)(p_), (v_))
+
+#include "_memcpy_vec.h"
+
+#undef VEC_TARGET_
+#undef VEC_NAME_
+#undef VEC_
+#undef VEC_SIZE_
+#undef VEC_LOADU_
+#undef VEC_STOREU_
+#undef VEC_STORE_
+#undef VEC_STREAM_
@@ -0,0 +1,217 @@
+// 这个文件是 MCF 的一部分。
+// 有关具体授权说明，请参阅 MCFLicense.txt。
+// Copyleft 2013 - 2018, LH_Mouse. All wrongs reserved.
+
+// This file is a template, which is included once for each instruction set by `_memcpy_vec.c` with these macros defined:
+//   VEC_TARGET_            the `__target__` attribute of all functions.
+//   VEC_NAME_(name_)       the name of a function for this instruction set.
+//   VEC_                   the vector type.
+//   VEC_SIZE_              the size of `VEC_` in bytes.
+//   VEC_LOADU_(p_)         loads a vector from an unaligned address.
+//   VEC_STOREU_(p_, v_)    stores a vector to an unaligned address.
+//   VEC_STORE_(p_, v_)     stores a vector to an aligned address.
+//   VEC_STREAM_(p_, v_)    stores a vector to an aligned address using non-temporal semantics.
+
+// Copies blocks no larger than four vectors. All source bytes are loaded before any of them is stored,
+// so these may be used for overlapping ranges in both directions. Each range is copied using two overlapping pieces.
+VEC_TARGET_ __attribute__((__always_inline__))
+static inline void VEC_NAME_(copy_small)(unsigned char *dst, const unsigned char *src, size_t n){
+	if(n >= 2 * VEC_SIZE_){
+		const VEC_ h0 = VEC_LOADU_(src);
+		const VEC_ h1 = VEC_LOADU_(src + VEC_SIZE_);
+		const VEC_ t1 = VEC_LOADU_(src + n - 2 * VEC_SIZE_);
+		const VEC_ t0 = VEC_LOADU_(src + n - VEC_SIZE_);
+		VEC_STOREU_(dst, h0);
+		VEC_STOREU_(dst + VEC_SIZE_, h1);
+		VEC_STOREU_(dst + n - 2 * VEC_SIZE_, t1);
+		VEC_STOREU_(dst + n - VEC_SIZE_, t0);
+		return;
+	}
+	if(n >= VEC_SIZE_){
+		const VEC_ h0 = VEC_LOADU_(src);
+		const VEC_ t0 = VEC_LOADU_(src + n - VEC_SIZE_);
+		VEC_STOREU_(dst, h0);
+		VEC_STOREU_(dst + n - VEC_SIZE_, t0);
+		return;
+	}
+#if VEC_SIZE_ > 32
+	if(n >= 32){
+		const __m256i h0 = _mm256_loadu_si256((const __m256i *)src);
+		const __m256i t0 = _mm256_loadu_si256((const __m256i *)(src + n - 32));
+		_mm256_storeu_si256((__m256i *)dst, h0);
+		_mm256_storeu_si256((__m256i *)(dst + n - 32), t0);
+		return;
+	}
+#endif
+	if(n >= 16){
+		const __m128i h0 = _mm_loadu_si128((const __m128i *)src);
+		const __m128i t0 = _mm_loadu_si128((const __m128i *)(src + n - 16));
+		_mm_storeu_si128((__m128i *)dst, h0);
+		_mm_storeu_si128((__m128i *)(dst + n - 16), t0);
+		return;
+	}
+	if(n >= 8){
+		const uint64_t h0 = *(const uint64_t *)src;
+		const uint64_t t0 = *(const uint64_t *)(src + n - 8);
+		*(uint64_t *)dst = h0;
+		*(uint64_t *)(dst + n - 8) = t0;
+		return;
+	}
+	if(n >= 4){
+		const uint32_t h0 = *(const uint32_t *)src;
+		const uint32_t t0 = *(const uint32_t *)(src + n - 4);
+		*(uint32_t *)dst = h0;
+		*(uint32_t *)(dst + n - 4) = t0;
+		return;
+	}
+	if(n >= 2){
+		const uint16_t h0 = *(const uint16_t *)src;
+		const uint16_t t0 = *(const uint16_t *)(src + n - 2);
+		*(uint16_t *)dst = h0;
+		*(uint16_t *)(dst + n - 2) = t0;
+		return;
+	}
+	if(n != 0){
+		*dst = *src;
+	}
+}
+
+// Copies blocks larger than four vectors from the beginning to the end. This may be used if `dst` precedes `src`.
+// The first vector and the last four vectors are stashed in registers, in case they get clobbered, and are stored last.
+// Writes in the middle are aligned.
+VEC_TARGET_
+static void VEC_NAME_(copy_large_fwd)(unsigned char *dst, const unsigned char *src, size_t n){
+	const VEC_ h0 = VEC_LOADU_(src);
+	const VEC_ t3 = VEC_LOADU_(src + n - 4 * VEC_SIZE_);
+	const VEC_ t2 = VEC_LOADU_(src + n - 3 * VEC_SIZE_);
+	const VEC_ t1 = VEC_LOADU_(src + n - 2 * VEC_SIZE_);
+	const VEC_ t0 = VEC_LOADU_(src + n - 1 * VEC_SIZE_);
+	unsigned char *const ewp = dst + n;
+	unsigned char *wp = (unsigned char *)(((uintptr_t)dst + VEC_SIZE_) & (uintptr_t)-VEC_SIZE_);
+	const unsigned char *rp = src + (wp - dst);
+	while(_MCFCRT_EXPECT((size_t)(ewp - wp) > 4 * VEC_SIZE_)){
+		const VEC_ v0 = VEC_LOADU_(rp);
+		const VEC_ v1 = VEC_LOADU_(rp + 1 * VEC_SIZE_);
+		const VEC_ v2 = VEC_LOADU_(rp + 2 * VEC_SIZE_);
+		const VEC_ v3 = VEC_LOADU_(rp + 3 * VEC_SIZE_);
+		VEC_STORE_(wp, v0);
+		VEC_STORE_(wp + 1 * VEC_SIZE_, v1);
+		VEC_STORE_(wp + 2 * VEC_SIZE_, v2);
+		VEC_STORE_(wp + 3 * VEC_SIZE_, v3);
+		wp += 4 * VEC_SIZE_;
+		rp += 4 * VEC_SIZE_;
+	}
+	VEC_STOREU_(ewp - 4 * VEC_SIZE_, t3);
+	VEC_STOREU_(ewp - 3 * VEC_SIZE_, t2);
+	VEC_STOREU_(ewp - 2 * VEC_SIZE_, t1);
+	VEC_STOREU_(ewp - 1 * VEC_SIZE_, t0);
+	VEC_STOREU_(dst, h0);
+}
+
+// Copies blocks larger than four vectors from the end to the beginning. This may be used if `src` precedes `dst`.
+VEC_TARGET_
+static void VEC_NAME_(copy_large_bwd)(unsigned char *dst, const unsigned char *src, size_t n){
+	const VEC_ h0 = VEC_LOADU_(src);
+	const VEC_ h1 = VEC_LOADU_(src + 1 * VEC_SIZE_);
+	const VEC_ h2 = VEC_LOADU_(src + 2 * VEC_SIZE_);
+	const VEC_ h3 = VEC_LOADU_(src + 3 * VEC_SIZE_);
+	const VEC_ t0 = VEC_LOADU_(src + n - VEC_SIZE_);
+	unsigned char *const ewp = dst + n;
+	unsigned char *wp = (unsigned char *)(((uintptr_t)ewp - 1) & (uintptr_t)-VEC_SIZE_);
+	const unsigned char *rp = src + (wp - dst);
+	while(_MCFCRT_EXPECT((size_t)(wp - dst) > 4 * VEC_SIZE_)){
+		wp -= 4 * VEC_SIZE_;
+		rp -= 4 * VEC_SIZE_;
+		const VEC_ v3 = VEC_LOADU_(rp + 3 * VEC_SIZE_);
+		const VEC_ v2 = VEC_LOADU_(rp + 2 * VEC_SIZE_);
+		const VEC_ v1 = VEC_LOADU_(rp + 1 * VEC_SIZE_);
+		const VEC_ v0 = VEC_LOADU_(rp);
+		VEC_STORE_(wp + 3 * VEC_SIZE_, v3);
+		VEC_STORE_(wp + 2 * VEC_SIZE_, v2);
+		VEC_STORE_(wp + 1 * VEC_SIZE_, v1);
+		VEC_STORE_(wp, v0);
+	}
+	VEC_STOREU_(dst, h0);
+	VEC_STOREU_(dst + 1 * VEC_SIZE_, h1);
+	VEC_STOREU_(dst + 2 * VEC_SIZE_, h2);
+	VEC_STOREU_(dst + 3 * VEC_SIZE_, h3);
+	VEC_STOREU_(ewp - VEC_SIZE_, t0);
+}
+
+// Copies blocks larger than four vectors that do not overlap, bypassing caches for the destination.
+VEC_TARGET_
+static void VEC_NAME_(copy_huge_fwd)(unsigned char *dst, const unsigned char *src, size_t n){
+	const VEC_ h0 = VEC_LOADU_(src);
+	unsigned char *const ewp = dst + n;
+	unsigned char *wp = (unsigned char *)(((uintptr_t)dst + VEC_SIZE_) & (uintptr_t)-VEC_SIZE_);
+	const unsigned char *rp = src + (wp - dst);
+	while(_MCFCRT_EXPECT((size_t)(ewp - wp) > 4 * VEC_SIZE_)){
+		const VEC_ v0 = VEC_LOADU_(rp);
+		const VEC_ v1 = VEC_LOADU_(rp + 1 * VEC_SIZE_);
+		const VEC_ v2 = VEC_LOADU_(rp + 2 * VEC_SIZE_);
+		const VEC_ v3 = VEC_LOADU_(rp + 3 * VEC_SIZE_);
+		VEC_STREAM_(wp, v0);
+		VEC_STREAM_(wp + 1 * VEC_SIZE_, v1);
+		VEC_STREAM_(wp + 2 * VEC_SIZE_, v2);
+		VEC_STREAM_(wp + 3 * VEC_SIZE_, v3);
+		wp += 4 * VEC_SIZE_;
+		rp += 4 * VEC_SIZE_;
+	}
+	// Don't forget the store fence.
+	_mm_sfence();
+	VEC_STOREU_(ewp - 4 * VEC_SIZE_, VEC_LOADU_(src + n - 4 * VEC_SIZE_));
+	VEC_STOREU_(ewp - 3 * VEC_SIZE_, VEC_LOADU_(src + n - 3 * VEC_SIZE_));
+	VEC_STOREU_(ewp - 2 * VEC_SIZE_, VEC_LOADU_(src + n - 2 * VEC_SIZE_));
+	VEC_STOREU_(ewp - 1 * VEC_SIZE_, VEC_LOADU_(src + n - 1 * VEC_SIZE_));
+	VEC_STOREU_(dst, h0);
+}
+
+// Copies blocks larger than four vectors that do not overlap.
+VEC_TARGET_
+static void VEC_NAME_(copy_disjoint)(unsigned char *dst, const unsigned char *src, size_t n){
+	if(_MCFCRT_EXPECT_NOT(n >= GetNonTemporalThreshold())){
+		VEC_NAME_(copy_huge_fwd)(dst, src, n);
+		return;
+	}
+	if((n >= VEC_SIZE_ * 64) && IsRepMovsbFast()){
+		CopyRepMovsb(dst, src, n);
+		return;
+	}
+	VEC_NAME_(copy_large_fwd)(dst, src, n);
+}
+
+VEC_TARGET_
+void *VEC_NAME_(__MCFCRT_memcpy)(void *restrict s1, const void *restrict s2, size_t n){
+	unsigned char *const dst = s1;
+	const unsigned char *const src = s2;
+#ifndef NDEBUG
+	__MCFCRT_memset_impl_bwd(dst, dst + n, 0xDEADBEEF);
+#endif
+	if(_MCFCRT_EXPECT(n <= 4 * VEC_SIZE_)){
+		VEC_NAME_(copy_small)(dst, src, n);
+		return s1;
+	}
+	VEC_NAME_(copy_disjoint)(dst, src, n);
+	return s1;
+}
+
+VEC_TARGET_
+void *VEC_NAME_(__MCFCRT_memmove)(void *s1, const void *s2, size_t n){
+	unsigned char *const dst = s1;
+	const unsigned char *const src = s2;
+	if(_MCFCRT_EXPECT(n <= 4 * VEC_SIZE_)){
+		VEC_NAME_(copy_small)(dst, src, n);
+		return s1;
+	}
+	const size_t dist = (uintptr_t)dst - (uintptr_t)src;
+	if(_MCFCRT_EXPECT((dist >= n) && ((size_t)-dist >= n))){
+		VEC_NAME_(copy_disjoint)(dst, src, n);
+	} else if(dist >= n){
+		// `dst` precedes `src`.
+		VEC_NAME_(copy_large_fwd)(dst, src, n);
+	} else if(dist != 0){
+		// `src` precedes `dst`.
+		VEC_NAME_(copy_large_bwd)(dst, src, n);
+	}
+	return s1;
+}
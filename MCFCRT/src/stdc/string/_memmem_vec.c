@@ -0,0 +1,365 @@
+// 这个文件是 MCF 的一部分。
+// 有关具体授权说明，请参阅 MCFLicense.txt。
+// Copyleft 2013 - 2018, LH_Mouse. All wrongs reserved.
+
+#include "../../env/_crtdef.h"
+#include "../../env/expect.h"
+#include "../../env/_string_dispatch.h"
+#include <immintrin.h>
+
+// Needles longer than this (in bytes) are always searched using Two-Way. Shorter needles are filtered with vectors first,
+// which is faster unless there are too many candidates, in which case they fall back to Two-Way anyway. Candidates are
+// only counted after a whole vector, so this also limits the work that can be done before falling back.
+#define LONG_NEEDLE_SIZE_       4096
+
+__attribute__((__always_inline__))
+static inline uint32_t CharAt(const unsigned char *p, size_t i, bool wide){
+	if(wide){
+		return ((const uint16_t *)p)[i];
+	}
+	return p[i];
+}
+
+// Reference:
+//   Maxime Crochemore and Dominique Perrin, Two-way string-matching, Journal of the ACM 38(3), 1991.
+// Like musl, a table of skips for the last character of each window is used, which makes searching for long needles
+// sublinear in most cases. Wide characters are hashed into the table by their low bytes, which only makes skips shorter.
+// `hb` and `nb` are in bytes. `nb` shall not be greater than `hb`.
+__attribute__((__always_inline__))
+static inline const unsigned char *TwoWaySearchImpl(const unsigned char *h, size_t hb, const unsigned char *n, size_t nb, bool wide){
+	const size_t size = wide ? 2 : 1;
+	const size_t hn = hb / size;
+	const size_t nn = nb / size;
+
+	uint16_t skips[256];
+	const uint16_t max_skip = (nn < 0xFFFF) ? (uint16_t)nn : 0xFFFF;
+	for(unsigned i = 0; i < 256; ++i){
+		skips[i] = max_skip;
+	}
+	for(size_t i = 0; i < nn; ++i){
+		const size_t skip = nn - 1 - i;
+		skips[CharAt(n, i, wide) & 0xFF] = (skip < 0xFFFF) ? (uint16_t)skip : 0xFFFF;
+	}
+
+	// Compute the maximal suffix for both orders. `ip` starts from -1, which wraps around.
+	size_t ip = (size_t)-1, jp = 0, k = 1, p = 1;
+	while(jp + k < nn){
+		const uint32_t a = CharAt(n, ip + k, wide);
+		const uint32_t b = CharAt(n, jp + k, wide);
+		if(a == b){
+			if(k == p){
+				jp += p;
+				k = 1;
+			} else {
+				++k;
+			}
+		} else if(a > b){
+			jp += k;
+			k = 1;
+			p = jp - ip;
+		} else {
+			ip = jp++;
+			k = p = 1;
+		}
+	}
+	size_t ms = ip;
+	const size_t p0 = p;
+	ip = (size_t)-1, jp = 0, k = 1, p = 1;
+	while(jp + k < nn){
+		const uint32_t a = CharAt(n, ip + k, wide);
+		const uint32_t b = CharAt(n, jp + k, wide);
+		if(a == b){
+			if(k == p){
+				jp += p;
+				k = 1;
+			} else {
+				++k;
+			}
+		} else if(a < b){
+			jp += k;
+			k = 1;
+			p = jp - ip;
+		} else {
+			ip = jp++;
+			k = p = 1;
+		}
+	}
+	if(ip + 1 > ms + 1){
+		ms = ip;
+	} else {
+		p = p0;
+	}
+
+	// If the needle is not periodic, nothing can be remembered after a match of the left half fails.
+	size_t mem0;
+	if(memcmp(n, n + p * size, (ms + 1) * size) != 0){
+		mem0 = 0;
+		p = ((ms > nn - ms - 1) ? ms : (nn - ms - 1)) + 1;
+	} else {
+		mem0 = nn - p;
+	}
+	size_t mem = 0;
+
+	size_t pos = 0;
+	for(;;){
+		if(hn - pos < nn){
+			return _MCFCRT_NULLPTR;
+		}
+		k = skips[CharAt(h, pos + nn - 1, wide) & 0xFF];
+		if(k != 0){
+			if(k < mem){
+				k = mem;
+			}
+			pos += k;
+			mem = 0;
+			continue;
+		}
+		// Compare the right half.
+		for(k = (ms + 1 > mem) ? (ms + 1) : mem; (k < nn) && (CharAt(n, k, wide) == CharAt(h, pos + k, wide)); ++k){
+			// Nothing to do.
+		}
+		if(k < nn){
+			pos += k - ms;
+			mem = 0;
+			continue;
+		}
+		// Compare the left half.
+		for(k = ms + 1; (k > mem) && (CharAt(n, k - 1, wide) == CharAt(h, pos + k - 1, wide)); --k){
+			// Nothing to do.
+		}
+		if(k <= mem){
+			return h + pos * size;
+		}
+		pos += p;
+		mem = mem0;
+	}
+}
+
+static const unsigned char *TwoWaySearch(const unsigned char *h, size_t hb, const unsigned char *n, size_t nb, bool wide){
+	if(wide){
+		return TwoWaySearchImpl(h, hb, n, nb, true);
+	}
+	return TwoWaySearchImpl(h, hb, n, nb, false);
+}
+
+#define VEC_CONCAT_2_(x_, y_)   x_##_##y_
+#define VEC_CONCAT_(x_, y_)     VEC_CONCAT_2_(x_, y_)
+
+//=============================================================================
+// SSE2, char
+//=============================================================================
+#define VEC_TARGET_             
+#define VEC_NAME_(name_)        VEC_CONCAT_(name_, sse2_b)
+#define VEC_EXPORT_(name_)      VEC_CONCAT_(name_, sse2)
+#define VEC_WIDE_               0
+#define VEC_CHAR_               uint8_t
+#define VEC_                    __m128i
+#define VEC_SIZE_               16
+#define VEC_MASK_               uint32_t
+#define VEC_MASK_UNIT_          1
+#define VEC_LOADU_(p_)          _mm_loadu_si128((const __m128i *)(p_))
+#define VEC_SET1_(c_)           _mm_set1_epi8((char)(c_))
+#define VEC_EQ_(v1_, v2_)       _mm_cmpeq_epi8((v1_), (v2_))
+#define VEC_AND_(r1_, r2_)      _mm_and_si128((r1_), (r2_))
+#define VEC_BITS_(r_)           ((uint32_t)_mm_movemask_epi8(r_))
+
+#include "_memmem_vec.h"
+
+#undef VEC_TARGET_
+#undef VEC_NAME_
+#undef VEC_EXPORT_
+#undef VEC_WIDE_
+#undef VEC_CHAR_
+#undef VEC_
+#undef VEC_SIZE_
+#undef VEC_MASK_
+#undef VEC_MASK_UNIT_
+#undef VEC_LOADU_
+#undef VEC_SET1_
+#undef VEC_EQ_
+#undef VEC_AND_
+#undef VEC_BITS_
+
+//=============================================================================
+// SSE2, wchar_t
+//=============================================================================
+#define VEC_TARGET_             
+#define VEC_NAME_(name_)        VEC_CONCAT_(name_, sse2_w)
+#define VEC_EXPORT_(name_)      VEC_CONCAT_(name_, sse2)
+#define VEC_WIDE_               1
+#define VEC_CHAR_               uint16_t
+#define VEC_                    __m128i
+#define VEC_SIZE_               16
+#define VEC_MASK_               uint32_t
+#define VEC_MASK_UNIT_          1
+#define VEC_LOADU_(p_)          _mm_loadu_si128((const __m128i *)(p_))
+#define VEC_SET1_(c_)           _mm_set1_epi16((short)(c_))
+#define VEC_EQ_(v1_, v2_)       _mm_cmpeq_epi16((v1_), (v2_))
+#define VEC_AND_(r1_, r2_)      _mm_and_si128((r1_), (r2_))
+#define VEC_BITS_(r_)           ((uint32_t)_mm_movemask_epi8(r_) & 0x5555u)
+
+#include "_memmem_vec.h"
+
+#undef VEC_TARGET_
+#undef VEC_NAME_
+#undef VEC_EXPORT_
+#undef VEC_WIDE_
+#undef VEC_CHAR_
+#undef VEC_
+#undef VEC_SIZE_
+#undef VEC_MASK_
+#undef VEC_MASK_UNIT_
+#undef VEC_LOADU_
+#undef VEC_SET1_
+#undef VEC_EQ_
+#undef VEC_AND_
+#undef VEC_BITS_
+
+//=============================================================================
+// AVX2, char
+//=============================================================================
+#define VEC_TARGET_             __MCFCRT_STRING_TARGET_AVX2
+#define VEC_NAME_(name_)        VEC_CONCAT_(name_, avx2_b)
+#define VEC_EXPORT_(name_)      VEC_CONCAT_(name_, avx2)
+#define VEC_WIDE_               0
+#define VEC_CHAR_               uint8_t
+#define VEC_                    __m256i
+#define VEC_SIZE_               32
+#define VEC_MASK_               uint32_t
+#define VEC_MASK_UNIT_          1
+#define VEC_LOADU_(p_)          _mm256_loadu_si256((const __m256i *)(p_))
+#define VEC_SET1_(c_)           _mm256_set1_epi8((char)(c_))
+#define VEC_EQ_(v1_, v2_)       _mm256_cmpeq_epi8((v1_), (v2_))
+#define VEC_AND_(r1_, r2_)      _mm256_and_si256((r1_), (r2_))
+#define VEC_BITS_(r_)           ((uint32_t)_mm256_movemask_epi8(r_))
+
+#include "_memmem_vec.h"
+
+#undef VEC_TARGET_
+#undef VEC_NAME_
+#undef VEC_EXPORT_
+#undef VEC_WIDE_
+#undef VEC_CHAR_
+#undef VEC_
+#undef VEC_SIZE_
+#undef VEC_MASK_
+#undef VEC_MASK_UNIT_
+#undef VEC_LOADU_
+#undef VEC_SET1_
+#undef VEC_EQ_
+#undef VEC_AND_
+#undef VEC_BITS_
+
+//=============================================================================
+// AVX2, wchar_t
+//=============================================================================
+#define VEC_TARGET_             __MCFCRT_STRING_TARGET_AVX2
+#define VEC_NAME_(name_)        VEC_CONCAT_(name_, avx2_w)
+#define VEC_EXPORT_(name_)      VEC_CONCAT_(name_, avx2)
+#define VEC_WIDE_               1
+#define VEC_CHAR_               uint16_t
+#define VEC_                    __m256i
+#define VEC_SIZE_               32
+#define VEC_MASK_               uint32_t
+#define VEC_MASK_UNIT_          1
+#define VEC_LOADU_(p_)          _mm256_loadu_si256((const __m256i *)(p_))
+#define VEC_SET1_(c_)           _mm256_set1_epi16((short)(c_))
+#define VEC_EQ_(v1_, v2_)       _mm256_cmpeq_epi16((v1_), (v2_))
+#define VEC_AND_(r1_, r2_)      _mm256_and_si256((r1_), (r2_))
+#define VEC_BITS_(r_)           ((uint32_t)_mm256_movemask_epi8(r_) & 0x55555555u)
+
+#include "_memmem_vec.h"
+
+#undef VEC_TARGET_
+#undef VEC_NAME_
+#undef VEC_EXPORT_
+#undef VEC_WIDE_
+#undef VEC_CHAR_
+#undef VEC_
+#undef VEC_SIZE_
+#undef VEC_MASK_
+#undef VEC_MASK_UNIT_
+#undef VEC_LOADU_
+#undef VEC_SET1_
+#undef VEC_EQ_
+#undef VEC_AND_
+#undef VEC_BITS_
+
+//=============================================================================
+// AVX-512, char
+//=============================================================================
+// Masked loads do not fault on masked-out bytes, so short haystacks can be searched using vectors, too.
+#define VEC_TARGET_             __MCFCRT_STRING_TARGET_AVX512
+#define VEC_NAME_(name_)        VEC_CONCAT_(name_, avx512_b)
+#define VEC_EXPORT_(name_)      VEC_CONCAT_(name_, avx512)
+#define VEC_WIDE_               0
+#define VEC_CHAR_               uint8_t
+#define VEC_                    __m512i
+#define VEC_SIZE_               64
+#define VEC_MASK_               uint64_t
+#define VEC_MASK_UNIT_          1
+#define VEC_LOADU_(p_)          _mm512_loadu_si512((const void *)(p_))
+#define VEC_SET1_(c_)           _mm512_set1_epi8((char)(c_))
+#define VEC_EQ_(v1_, v2_)       _mm512_cmpeq_epi8_mask((v1_), (v2_))
+#define VEC_AND_(r1_, r2_)      ((r1_) & (r2_))
+#define VEC_BITS_(r_)           ((uint64_t)(r_))
+#define VEC_LOADU_PARTIAL_(p_, n_)	\
+	_mm512_maskz_loadu_epi8(((__mmask64)1 << (n_)) - 1, (p_))
+
+#include "_memmem_vec.h"
+
+#undef VEC_TARGET_
+#undef VEC_NAME_
+#undef VEC_EXPORT_
+#undef VEC_WIDE_
+#undef VEC_CHAR_
+#undef VEC_
+#undef VEC_SIZE_
+#undef VEC_MASK_
+#undef VEC_MASK_UNIT_
+#undef VEC_LOADU_
+#undef VEC_SET1_
+#undef VEC_EQ_
+#undef VEC_AND_
+#undef VEC_BITS_
+#undef VEC_LOADU_PARTIAL_
+
+//=============================================================================
+// AVX-512, wchar_t
+//=============================================================================
+#define VEC_TARGET_             __MCFCRT_STRING_TARGET_AVX512
+#define VEC_NAME_(name_)        VEC_CONCAT_(name_, avx512_w)
+#define VEC_EXPORT_(name_)      VEC_CONCAT_(name_, avx512)
+#define VEC_WIDE_               1
+#define VEC_CHAR_               uint16_t
+#define VEC_                    __m512i
+#define VEC_SIZE_               64
+#define VEC_MASK_               uint32_t
+#define VEC_MASK_UNIT_          2
+#define VEC_LOADU_(p_)          _mm512_loadu_si512((const void *)(p_))
+#define VEC_SET1_(c_)           _mm512_set1_epi16((short)(c_))
+#define VEC_EQ_(v1_, v2_)       _mm512_cmpeq_epi16_mask((v1_), (v2_))
+#define VEC_AND_(r1_, r2_)      ((r1_) & (r2_))
+#define VEC_BITS_(r_)           ((uint32_t)(r_))
+#define VEC_LOADU_PARTIAL_(p_, n_)	\
+	_mm512_maskz_loadu_epi16(((__mmask32)1 << (n_) / 2) - 1, (p_))
+
+#include "_memmem_vec.h"
+
+#undef VEC_TARGET_
+#undef VEC_NAME_
+#undef VEC_EXPORT_
+#undef VEC_WIDE_
+#undef VEC_CHAR_
+#undef VEC_
+#undef VEC_SIZE_
+#undef VEC_MASK_
+#undef VEC_MASK_UNIT_
+#undef VEC_LOADU_
+#undef VEC_SET1_
+#undef VEC_EQ_
+#undef VEC_AND_
+#undef VEC_BITS_
+#undef VEC_LOADU_PARTIAL_
+
+#undef LONG_NEEDLE_SIZE_
@@ -0,0 +1,184 @@
+// 这个文件是 MCF 的一部分。
+// 有关具体授权说明，请参阅 MCFLicense.txt。
+// Copyleft 2013 - 2018, LH_Mouse. All wrongs reserved.
+
+// This file is a template, which is included once for each instruction set and character width by `_memmem_vec.c` with
+// these macros defined:
+//   VEC_TARGET_            the `__target__` attribute of all functions.
+//   VEC_NAME_(name_)       the name of an internal function for this instruction set and character width.
+//   VEC_EXPORT_(name_)     the name of an exported function for this instruction set.
+//   VEC_WIDE_              1 to define functions for `wchar_t`, or 0 to define functions for `char`.
+//   VEC_CHAR_              the unsigned character type, which is `uint16_t` if `VEC_WIDE_` is 1 and `uint8_t` otherwise.
+//   VEC_                   the vector type.
+//   VEC_SIZE_              the size of `VEC_` in bytes.
+//   VEC_MASK_              an unsigned integer type to hold results of `VEC_BITS_()`.
+//   VEC_MASK_UNIT_         the number of bytes that each bit in a `VEC_MASK_` stands for.
+//   VEC_LOADU_(p_)         loads a vector from an unaligned address.
+//   VEC_SET1_(c_)          broadcasts a character to all elements of a vector.
+//   VEC_EQ_(v1_, v2_)      compares characters in two vectors for equality.
+//   VEC_AND_(r1_, r2_)     merges the results of two `VEC_EQ_()`, so a character matches if it matches in both.
+//   VEC_BITS_(r_)          converts the result of `VEC_EQ_()` to a `VEC_MASK_`, with exactly one bit for each character.
+// This macro is optional:
+//   VEC_LOADU_PARTIAL_(p_, n_)
+//                          loads the first `n_` bytes (`n_` < `VEC_SIZE_`) into a vector without touching any byte beyond
+//                          them. If it is not defined, haystacks having fewer than `VEC_SIZE_` bytes of candidates are
+//                          searched one character by one character.
+// Nothing beyond either string is ever read.
+
+// Convert the index of a set bit in a `VEC_MASK_` to an offset in bytes.
+#define VEC_FIRST_(m_)          ((size_t)(unsigned)__builtin_ctzll(m_) * VEC_MASK_UNIT_)
+// Get a `VEC_MASK_` in which bits for the first `n_` bytes are set. `n_` shall be less than `VEC_SIZE_`.
+#define VEC_LOW_(n_)            (((VEC_MASK_)1 << (n_) / VEC_MASK_UNIT_) - 1)
+
+// Returns a `VEC_MASK_` of candidates at `p`, which are characters that equal the first character of the needle and are
+// followed by the last one at `last_off` bytes after them.
+#define VEC_CANDIDATES_(p_, last_off_, vf_, vl_)	\
+	VEC_BITS_(VEC_AND_(VEC_EQ_(VEC_LOADU_(p_), (vf_)), VEC_EQ_(VEC_LOADU_((p_) + (last_off_)), (vl_))))
+
+// Finds the needle `n` of `nb` bytes in the haystack `h` of `hb` bytes. Both sizes are multiples of the character size.
+// Short needles are located by searching for their first and last characters in parallel, so the rest of a needle is
+// only compared at positions where both match. Because that is slow if there are too many such positions (for example
+// when searching for `aaab` in `aaaaaaaa...`), Two-Way is used once it has compared too many bytes, as well as for long
+// needles, so this function runs in linear time.
+VEC_TARGET_ __attribute__((__always_inline__))
+static inline const unsigned char *VEC_NAME_(find)(const unsigned char *h, size_t hb, const unsigned char *n, size_t nb){
+	if(nb == 0){
+		return h;
+	}
+	if(nb > hb){
+		return _MCFCRT_NULLPTR;
+	}
+#if VEC_WIDE_
+	if(nb == sizeof(VEC_CHAR_)){
+		return (const unsigned char *)VEC_EXPORT_(__MCFCRT_wmemchr)((const wchar_t *)h, *(const wchar_t *)n, hb / sizeof(wchar_t));
+	}
+#else
+	if(nb == sizeof(VEC_CHAR_)){
+		return VEC_EXPORT_(__MCFCRT_memchr)(h, *n, hb);
+	}
+#endif
+	if(nb > LONG_NEEDLE_SIZE_){
+		return TwoWaySearch(h, hb, n, nb, VEC_WIDE_);
+	}
+	const VEC_CHAR_ cf = *(const VEC_CHAR_ *)n;
+	const VEC_CHAR_ cl = *(const VEC_CHAR_ *)(n + nb - sizeof(VEC_CHAR_));
+	const VEC_ vf = VEC_SET1_(cf);
+	const VEC_ vl = VEC_SET1_(cl);
+	// Candidates start in [`h`, `h + count`). The first and the last characters of a candidate are `last_off` bytes apart.
+	const size_t count = hb - nb + sizeof(VEC_CHAR_);
+	const size_t last_off = nb - sizeof(VEC_CHAR_);
+	// This is the number of bytes that have been compared at candidates.
+	size_t work = 0;
+	size_t off = 0;
+	while(off < count){
+		VEC_MASK_ bits;
+		size_t base = off;
+		if(_MCFCRT_EXPECT(count - off >= VEC_SIZE_)){
+			bits = VEC_CANDIDATES_(h + off, last_off, vf, vl);
+			off += VEC_SIZE_;
+		} else if(count >= VEC_SIZE_){
+			// Load the last vector of candidates, which overlaps candidates that have been checked.
+			const size_t last = count - VEC_SIZE_;
+			bits = VEC_CANDIDATES_(h + last, last_off, vf, vl) >> (off - last) / VEC_MASK_UNIT_;
+			off = count;
+		} else {
+#ifdef VEC_LOADU_PARTIAL_
+			const size_t rem = count - off;
+			bits = VEC_BITS_(VEC_AND_(VEC_EQ_(VEC_LOADU_PARTIAL_(h + off, rem), vf), VEC_EQ_(VEC_LOADU_PARTIAL_(h + off + last_off, rem), vl))) & VEC_LOW_(rem);
+			off = count;
+#else
+			// There are fewer candidates than a vector can hold.
+			for(size_t i = off; i < count; i += sizeof(VEC_CHAR_)){
+				if((*(const VEC_CHAR_ *)(h + i) == cf) && (*(const VEC_CHAR_ *)(h + i + last_off) == cl) &&
+					VEC_EXPORT_(__MCFCRT_memeq)(h + i + sizeof(VEC_CHAR_), n + sizeof(VEC_CHAR_), nb - 2 * sizeof(VEC_CHAR_)))
+				{
+					return h + i;
+				}
+			}
+			return _MCFCRT_NULLPTR;
+#endif
+		}
+		while(bits != 0){
+			const size_t pos = base + VEC_FIRST_(bits);
+			if(VEC_EXPORT_(__MCFCRT_memeq)(h + pos + sizeof(VEC_CHAR_), n + sizeof(VEC_CHAR_), nb - 2 * sizeof(VEC_CHAR_))){
+				return h + pos;
+			}
+			work += nb;
+			bits &= bits - 1;
+		}
+		// Allow candidates to cost twice the bytes scanned, plus a constant to amortize the cost of setting up Two-Way.
+		if(_MCFCRT_EXPECT_NOT(work > 2 * off + 4096) && (off < count)){
+			return TwoWaySearch(h + off, hb - off, n, nb, VEC_WIDE_);
+		}
+	}
+	return _MCFCRT_NULLPTR;
+}
+
+// Null-terminated haystacks are searched in chunks, so a match near the beginning of a long haystack is found without
+// measuring the whole haystack first. Adjacent chunks overlap by one character less than the needle.
+VEC_TARGET_ __attribute__((__always_inline__))
+static inline const unsigned char *VEC_NAME_(find_str)(const unsigned char *h, const unsigned char *n, size_t nb){
+	const size_t chunk = 2 * nb + 4096;
+	size_t off = 0;
+	for(;;){
+#if VEC_WIDE_
+		const wchar_t *const end = VEC_EXPORT_(__MCFCRT_wmemchr)((const wchar_t *)(h + off), 0, chunk / sizeof(wchar_t));
+#else
+		const unsigned char *const end = VEC_EXPORT_(__MCFCRT_memchr)(h + off, 0, chunk);
+#endif
+		const size_t hb = end ? (size_t)((const unsigned char *)end - (h + off)) : chunk;
+		const unsigned char *const found = VEC_NAME_(find)(h + off, hb, n, nb);
+		if(found){
+			return found;
+		}
+		if(end){
+			return _MCFCRT_NULLPTR;
+		}
+		off += chunk - nb + sizeof(VEC_CHAR_);
+	}
+}
+
+#if VEC_WIDE_
+
+VEC_TARGET_
+wchar_t *VEC_EXPORT_(__MCFCRT_wmemmem)(const wchar_t *s1, size_t n1, const wchar_t *s2, size_t n2){
+	// Both blocks are in the address space, so their sizes in bytes cannot overflow.
+	return (wchar_t *)VEC_NAME_(find)((const unsigned char *)s1, n1 * sizeof(wchar_t), (const unsigned char *)s2, n2 * sizeof(wchar_t));
+}
+
+VEC_TARGET_
+wchar_t *VEC_EXPORT_(__MCFCRT_wcsstr)(const wchar_t *s1, const wchar_t *s2){
+	const size_t nb = VEC_EXPORT_(__MCFCRT_wcslen)(s2) * sizeof(wchar_t);
+	if(nb == 0){
+		return (wchar_t *)s1;
+	}
+	if(nb == sizeof(wchar_t)){
+		return VEC_EXPORT_(__MCFCRT_wcschr)(s1, *s2);
+	}
+	return (wchar_t *)VEC_NAME_(find_str)((const unsigned char *)s1, (const unsigned char *)s2, nb);
+}
+
+#else
+
+VEC_TARGET_
+void *VEC_EXPORT_(__MCFCRT_memmem)(const void *s1, size_t n1, const void *s2, size_t n2){
+	return (void *)VEC_NAME_(find)(s1, n1, s2, n2);
+}
+
+VEC_TARGET_
+char *VEC_EXPORT_(__MCFCRT_strstr)(const char *s1, const char *s2){
+	const size_t nb = VEC_EXPORT_(__MCFCRT_strlen)(s2);
+	if(nb == 0){
+		return (char *)s1;
+	}
+	if(nb == 1){
+		return VEC_EXPORT_(__MCFCRT_strchr)(s1, *s2);
+	}
+	return (char *)VEC_NAME_(find_str)((const unsigned char *)s1, (const unsigned char *)s2, nb);
+}
+
+#endif
+
+#undef VEC_FIRST_
+#undef VEC_LOW_
+#undef VEC_CANDIDATES_
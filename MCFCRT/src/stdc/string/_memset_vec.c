@@ -0,0 +1,81 @@
+// 这个文件是 MCF 的一部分。
+// 有关具体授权说明，请参阅 MCFLicense.txt。
+// Copyleft 2013 - 2018, LH_Mouse. All wrongs reserved.
+
+#include "../../env/_crtdef.h"
+#include "../../env/expect.h"
+#include "../../env/cpu.h"
+#include "../../env/_string_dispatch.h"
+#include <immintrin.h>
+
+// Unlike copies, fills do not read anything, so only fills bigger than the last level cache are written around caches.
+static size_t GetNonTemporalThreshold(void){
+	return _MCFCRT_CpuGetCacheSize(_MCFCRT_kCpuCacheLevelMax);
+}
+
+// Reference:
+//   Intel® 64 and IA-32 Architectures Optimization Reference Manual
+//     3.7.6 Enhanced REP MOVSB and STOSB Operation (ERMSB)
+static bool IsRepStosbFast(void){
+	return _MCFCRT_CpuHasFeature(_MCFCRT_kCpuFeatureErms);
+}
+static bool IsPatternByte(uint32_t c32){
+	return c32 == (c32 & 0xFF) * 0x01010101u;
+}
+static void FillRepStosb(unsigned char *dst, uint8_t c, size_t n){
+	__asm__ volatile (
+		"rep stosb \n"
+		: "+D"(dst), "+c"(n)
+		: "a"(c)
+		: "memory"
+	);
+}
+
+#define VEC_CONCAT_2_(x_, y_)   x_##_##y_
+#define VEC_CONCAT_(x_, y_)     VEC_CONCAT_2_(x_, y_)
+
+//=============================================================================
+// AVX2
+//=============================================================================
+#define VEC_TARGET_             __MCFCRT_STRING_TARGET_AVX2
+#define VEC_NAME_(name_)        VEC_CONCAT_(name_, avx2)
+#define VEC_                    __m256i
+#define VEC_SIZE_               32
+#define VEC_SET1_(c32_)         _mm256_set1_epi32((int)(c32_))
+#define VEC_STOREU_(p_, v_)     _mm256_storeu_si256((__m256i *)(p_), (v_))
+#define VEC_STORE_(p_, v_)      _mm256_store_si256((__m256i *)(p_), (v_))
+#define VEC_STREAM_(p_, v_)     _mm256_stream_si256((__m256i *)(p_), (v_))
+
+#include "_memset_vec.h"
+
+#undef VEC_TARGET_
+#undef VEC_NAME_
+#undef VEC_
+#undef VEC_SIZE_
+#undef VEC_SET1_
+#undef VEC_STOREU_
+#undef VEC_STORE_
+#undef VEC_STREAM_
+
+//=============================================================================
+// AVX-512
+//=============================================================================
+#define VEC_TARGET_             __MCFCRT_STRING_TARGET_AVX512
+#define VEC_NAME_(name_)        VEC_CONCAT_(name_, avx512)
+#define VEC_                    __m512i
+#define VEC_SIZE_               64
+#define VEC_SET1_(c32_)         _mm512_set1_epi32((int)(c32_))
+#define VEC_STOREU_(p_, v_)     _mm512_storeu_si512((void *)(p_), (v_))
+#define VEC_STORE_(p_, v_)      _mm512_store_si512((void *)(p_), (v_))
+#define VEC_STREAM_(p_, v_)     _mm512_stream_si512((void *)(p_), (v_))
+
+#include "_memset_vec.h"
+
+#undef VEC_TARGET_
+#undef VEC_NAME_
+#undef VEC_
+#undef VEC_SIZE_
+#undef VEC_SET1_
+#undef VEC_STOREU_
+#undef VEC_STORE_
+#undef VEC_STREAM_
@@ -0,0 +1,130 @@
+// 这个文件是 MCF 的一部分。
+// 有关具体授权说明，请参阅 MCFLicense.txt。
+// Copyleft 2013 - 2018, LH_Mouse. All wrongs reserved.
+
+// This file is a template, which is included once for each instruction set by `_memset_vec.c` with these macros defined:
+//   VEC_TARGET_            the `__target__` attribute of all functions.
+//   VEC_NAME_(name_)       the name of a function for this instruction set.
+//   VEC_                   the vector type.
+//   VEC_SIZE_              the size of `VEC_` in bytes.
+//   VEC_SET1_(c32_)        broadcasts a DWORD to all elements of a vector.
+//   VEC_STOREU_(p_, v_)    stores a vector to an unaligned address.
+//   VEC_STORE_(p_, v_)     stores a vector to an aligned address.
+//   VEC_STREAM_(p_, v_)    stores a vector to an aligned address using non-temporal semantics.
+// Like `__MCFCRT_memset_impl_fwd()`, the pattern `c32` is stored as is at aligned addresses. It is only correct for
+// patterns which repeat every byte (`memset()`), or every WORD if both `s` and `n` are even (`wmemset()`).
+
+// Fills blocks no larger than four vectors using two overlapping pieces.
+VEC_TARGET_ __attribute__((__always_inline__))
+static inline void VEC_NAME_(fill_small)(unsigned char *dst, uint32_t c32, size_t n){
+	if(n >= 2 * VEC_SIZE_){
+		const VEC_ v = VEC_SET1_(c32);
+		VEC_STOREU_(dst, v);
+		VEC_STOREU_(dst + VEC_SIZE_, v);
+		VEC_STOREU_(dst + n - 2 * VEC_SIZE_, v);
+		VEC_STOREU_(dst + n - VEC_SIZE_, v);
+		return;
+	}
+	if(n >= VEC_SIZE_){
+		const VEC_ v = VEC_SET1_(c32);
+		VEC_STOREU_(dst, v);
+		VEC_STOREU_(dst + n - VEC_SIZE_, v);
+		return;
+	}
+#if VEC_SIZE_ > 32
+	if(n >= 32){
+		const __m256i v = _mm256_set1_epi32((int)c32);
+		_mm256_storeu_si256((__m256i *)dst, v);
+		_mm256_storeu_si256((__m256i *)(dst + n - 32), v);
+		return;
+	}
+#endif
+	if(n >= 16){
+		const __m128i v = _mm_set1_epi32((int)c32);
+		_mm_storeu_si128((__m128i *)dst, v);
+		_mm_storeu_si128((__m128i *)(dst + n - 16), v);
+		return;
+	}
+	if(n >= 8){
+		const uint64_t c64 = c32 * 0x0000000100000001ull;
+		*(uint64_t *)dst = c64;
+		*(uint64_t *)(dst + n - 8) = c64;
+		return;
+	}
+	if(n >= 4){
+		*(uint32_t *)dst = c32;
+		*(uint32_t *)(dst + n - 4) = c32;
+		return;
+	}
+	if(n >= 2){
+		*(uint16_t *)dst = (uint16_t)c32;
+		*(uint16_t *)(dst + n - 2) = (uint16_t)c32;
+		return;
+	}
+	if(n != 0){
+		*dst = (uint8_t)c32;
+	}
+}
+
+// Fills blocks larger than four vectors. The first vector and the last four vectors are stored unaligned.
+// Writes in the middle are aligned.
+VEC_TARGET_
+static void VEC_NAME_(fill_large)(unsigned char *dst, uint32_t c32, size_t n){
+	const VEC_ v = VEC_SET1_(c32);
+	unsigned char *const ewp = dst + n;
+	VEC_STOREU_(dst, v);
+	unsigned char *wp = (unsigned char *)(((uintptr_t)dst + VEC_SIZE_) & (uintptr_t)-VEC_SIZE_);
+	while(_MCFCRT_EXPECT((size_t)(ewp - wp) > 4 * VEC_SIZE_)){
+		VEC_STORE_(wp, v);
+		VEC_STORE_(wp + 1 * VEC_SIZE_, v);
+		VEC_STORE_(wp + 2 * VEC_SIZE_, v);
+		VEC_STORE_(wp + 3 * VEC_SIZE_, v);
+		wp += 4 * VEC_SIZE_;
+	}
+	VEC_STOREU_(ewp - 4 * VEC_SIZE_, v);
+	VEC_STOREU_(ewp - 3 * VEC_SIZE_, v);
+	VEC_STOREU_(ewp - 2 * VEC_SIZE_, v);
+	VEC_STOREU_(ewp - 1 * VEC_SIZE_, v);
+}
+
+// Fills blocks larger than four vectors, bypassing caches.
+VEC_TARGET_
+static void VEC_NAME_(fill_huge)(unsigned char *dst, uint32_t c32, size_t n){
+	const VEC_ v = VEC_SET1_(c32);
+	unsigned char *const ewp = dst + n;
+	VEC_STOREU_(dst, v);
+	unsigned char *wp = (unsigned char *)(((uintptr_t)dst + VEC_SIZE_) & (uintptr_t)-VEC_SIZE_);
+	while(_MCFCRT_EXPECT((size_t)(ewp - wp) > 4 * VEC_SIZE_)){
+		VEC_STREAM_(wp, v);
+		VEC_STREAM_(wp + 1 * VEC_SIZE_, v);
+		VEC_STREAM_(wp + 2 * VEC_SIZE_, v);
+		VEC_STREAM_(wp + 3 * VEC_SIZE_, v);
+		wp += 4 * VEC_SIZE_;
+	}
+	// Don't forget the store fence.
+	_mm_sfence();
+	VEC_STOREU_(ewp - 4 * VEC_SIZE_, v);
+	VEC_STOREU_(ewp - 3 * VEC_SIZE_, v);
+	VEC_STOREU_(ewp - 2 * VEC_SIZE_, v);
+	VEC_STOREU_(ewp - 1 * VEC_SIZE_, v);
+}
+
+VEC_TARGET_
+void *VEC_NAME_(__MCFCRT_memset32)(void *s, uint32_t c32, size_t n){
+	unsigned char *const dst = s;
+	if(_MCFCRT_EXPECT(n <= 4 * VEC_SIZE_)){
+		VEC_NAME_(fill_small)(dst, c32, n);
+		return s;
+	}
+	if(_MCFCRT_EXPECT_NOT(n >= GetNonTemporalThreshold())){
+		VEC_NAME_(fill_huge)(dst, c32, n);
+		return s;
+	}
+	// `rep stosb` can only store a single byte.
+	if((n >= VEC_SIZE_ * 64) && IsPatternByte(c32) && IsRepStosbFast()){
+		FillRepStosb(dst, (uint8_t)c32, n);
+		return s;
+	}
+	VEC_NAME_(fill_large)(dst, c32, n);
+	return s;
+}
@@ -0,0 +1,216 @@
+// 这个文件是 MCF 的一部分。
+// 有关具体授权说明，请参阅 MCFLicense.txt。
+// Copyleft 2013 - 2018, LH_Mouse. All wrongs reserved.
+
+// This file is a template, which is included once for each instruction set and character width by `_strcmp_vec.c` with
+// these macros defined:
+//   VEC_TARGET_            the `__target__` attribute of all functions.
+//   VEC_NAME_(name_)       the name of an internal function for this instruction set and character width.
+//   VEC_EXPORT_(name_)     the name of an exported function for this instruction set.
+//   VEC_WIDE_              1 to define functions for `wchar_t`, or 0 to define functions for `char`.
+//   VEC_CHAR_              the unsigned character type, which is `uint16_t` if `VEC_WIDE_` is 1 and `uint8_t` otherwise.
+//   VEC_                   the vector type.
+//   VEC_SIZE_              the size of `VEC_` in bytes.
+//   VEC_MASK_              an unsigned integer type to hold results of `VEC_BITS_()`.
+//   VEC_MASK_UNIT_         the number of bytes that each bit in a `VEC_MASK_` stands for.
+//   VEC_LOADU_(p_)         loads a vector from an unaligned address.
+//   VEC_ZERO_()            returns a vector of zeroes.
+//   VEC_KEY_(v1_, v2_)     returns a vector in which characters are zeroes if they differ or are null in `v1_`.
+//   VEC_MINU_(v1_, v2_)    returns the unsigned minimum of characters in two vectors.
+//   VEC_EQ_(v1_, v2_)      compares characters in two vectors for equality.
+//   VEC_BITS_(r_)          converts the result of `VEC_EQ_()` to a `VEC_MASK_`.
+// This macro is optional:
+//   VEC_LOADU_PARTIAL_(p_, n_)
+//                          loads the first `n_` bytes (`n_` < `VEC_SIZE_`) into a vector and zeroes the others, without
+//                          touching any byte beyond them. If it is not defined, the vector ending at the `n_`-th byte is
+//                          loaded if possible, otherwise characters are compared one by one.
+// Both strings are read using unaligned loads, but a page boundary is never crossed before all characters in front of it
+// have been compared, so no page that does not contain a character of both strings is touched.
+
+// Convert the index of a set bit in a `VEC_MASK_` to an offset in bytes.
+#define VEC_FIRST_(m_)          ((size_t)(unsigned)__builtin_ctzll(m_) * VEC_MASK_UNIT_)
+// Get a `VEC_MASK_` in which bits for the first `n_` bytes are set. `n_` shall be less than `VEC_SIZE_`.
+#define VEC_LOW_(n_)            (((VEC_MASK_)1 << (n_) / VEC_MASK_UNIT_) - 1)
+#define VEC_STOPS_(p1_, p2_)    VEC_BITS_(VEC_EQ_(VEC_KEY_(VEC_LOADU_(p1_), VEC_LOADU_(p2_)), VEC_ZERO_()))
+
+// Returns the offset in bytes of the first character that differs or is null in a block of four keys, one of which must
+// have such a character.
+VEC_TARGET_ __attribute__((__always_inline__))
+static inline size_t VEC_NAME_(block_first)(VEC_ k0, VEC_ k1, VEC_ k2, VEC_ k3){
+	const VEC_ vz = VEC_ZERO_();
+	VEC_MASK_ bits = VEC_BITS_(VEC_EQ_(k0, vz));
+	if(bits != 0){
+		return VEC_FIRST_(bits);
+	}
+	bits = VEC_BITS_(VEC_EQ_(k1, vz));
+	if(bits != 0){
+		return 1 * VEC_SIZE_ + VEC_FIRST_(bits);
+	}
+	bits = VEC_BITS_(VEC_EQ_(k2, vz));
+	if(bits != 0){
+		return 2 * VEC_SIZE_ + VEC_FIRST_(bits);
+	}
+	bits = VEC_BITS_(VEC_EQ_(k3, vz));
+	return 3 * VEC_SIZE_ + VEC_FIRST_(bits);
+}
+
+// Compares `n` bytes (0 < `n` < `VEC_SIZE_`) at `off`, which must not cross a page boundary in either string. All bytes
+// before `off` must have been compared. Returns the offset in bytes of the first character that differs or is null in
+// `p1`, or `off + n` if there is no such character.
+VEC_TARGET_ __attribute__((__always_inline__))
+static inline size_t VEC_NAME_(mismatch_partial)(const unsigned char *p1, const unsigned char *p2, size_t off, size_t n){
+#ifdef VEC_LOADU_PARTIAL_
+	const VEC_MASK_ bits = VEC_BITS_(VEC_EQ_(VEC_KEY_(VEC_LOADU_PARTIAL_(p1 + off, n), VEC_LOADU_PARTIAL_(p2 + off, n)), VEC_ZERO_())) & VEC_LOW_(n);
+	if(bits != 0){
+		return off + VEC_FIRST_(bits);
+	}
+	return off + n;
+#else
+	if(_MCFCRT_EXPECT(off + n >= VEC_SIZE_)){
+		// Load the vector ending at `off + n`. Bytes before `off` have been compared and are discarded.
+		const size_t base = off + n - VEC_SIZE_;
+		const VEC_MASK_ bits = VEC_STOPS_(p1 + base, p2 + base) >> (VEC_SIZE_ - n) / VEC_MASK_UNIT_;
+		if(bits != 0){
+			return off + VEC_FIRST_(bits);
+		}
+		return off + n;
+	}
+	// The vector would start before the strings. Bytes there might not be readable.
+	for(size_t i = off; i < off + n; i += sizeof(VEC_CHAR_)){
+		const VEC_CHAR_ c1 = *(const VEC_CHAR_ *)(p1 + i);
+		const VEC_CHAR_ c2 = *(const VEC_CHAR_ *)(p2 + i);
+		if((c1 != c2) || (c1 == 0)){
+			return i;
+		}
+	}
+	return off + n;
+#endif
+}
+
+// Returns the offset in bytes of the first character that differs or is null in `p1`. If `bounded` is `true`, at most
+// `n` bytes are compared, and `n` is returned if there is no such character in them.
+VEC_TARGET_ __attribute__((__always_inline__))
+static inline size_t VEC_NAME_(mismatch)(const unsigned char *p1, const unsigned char *p2, size_t n, bool bounded){
+	size_t off = 0;
+	for(;;){
+		// This is the number of bytes that can be read from both strings without crossing a page boundary.
+		size_t avail = 0x1000 - (uintptr_t)(p1 + off) % 0x1000;
+		const size_t avail2 = 0x1000 - (uintptr_t)(p2 + off) % 0x1000;
+		if(avail > avail2){
+			avail = avail2;
+		}
+		if(bounded && (avail > n - off)){
+			avail = n - off;
+		}
+		if(_MCFCRT_EXPECT(avail >= VEC_SIZE_)){
+			// Most strings end in the first vector, so check it before loading whole blocks.
+			VEC_MASK_ bits = VEC_STOPS_(p1 + off, p2 + off);
+			if(bits != 0){
+				return off + VEC_FIRST_(bits);
+			}
+			// Align reads from `p1` to vectors, so at most half of the loads may split cache lines. Characters in between
+			// are compared twice, which is harmless.
+			const size_t skip = VEC_SIZE_ - (uintptr_t)(p1 + off) % VEC_SIZE_;
+			off += skip;
+			avail -= skip;
+			while(avail >= 4 * VEC_SIZE_){
+				const VEC_ k0 = VEC_KEY_(VEC_LOADU_(p1 + off                ), VEC_LOADU_(p2 + off                ));
+				const VEC_ k1 = VEC_KEY_(VEC_LOADU_(p1 + off + 1 * VEC_SIZE_), VEC_LOADU_(p2 + off + 1 * VEC_SIZE_));
+				const VEC_ k2 = VEC_KEY_(VEC_LOADU_(p1 + off + 2 * VEC_SIZE_), VEC_LOADU_(p2 + off + 2 * VEC_SIZE_));
+				const VEC_ k3 = VEC_KEY_(VEC_LOADU_(p1 + off + 3 * VEC_SIZE_), VEC_LOADU_(p2 + off + 3 * VEC_SIZE_));
+				if(_MCFCRT_EXPECT_NOT(VEC_BITS_(VEC_EQ_(VEC_MINU_(VEC_MINU_(k0, k1), VEC_MINU_(k2, k3)), VEC_ZERO_())) != 0)){
+					return off + VEC_NAME_(block_first)(k0, k1, k2, k3);
+				}
+				off += 4 * VEC_SIZE_;
+				avail -= 4 * VEC_SIZE_;
+			}
+			while(avail >= VEC_SIZE_){
+				bits = VEC_STOPS_(p1 + off, p2 + off);
+				if(bits != 0){
+					return off + VEC_FIRST_(bits);
+				}
+				off += VEC_SIZE_;
+				avail -= VEC_SIZE_;
+			}
+		}
+		// Compare the bytes before the page boundary (or the end), then go on with the next page.
+		if(avail != 0){
+			const size_t stop = VEC_NAME_(mismatch_partial)(p1, p2, off, avail);
+			if(stop != off + avail){
+				return stop;
+			}
+			off += avail;
+		}
+		if(bounded && (off == n)){
+			return n;
+		}
+	}
+}
+
+VEC_TARGET_ __attribute__((__always_inline__))
+static inline int VEC_NAME_(compare_at)(const unsigned char *p1, const unsigned char *p2, size_t off){
+	const VEC_CHAR_ c1 = *(const VEC_CHAR_ *)(p1 + off);
+	const VEC_CHAR_ c2 = *(const VEC_CHAR_ *)(p2 + off);
+	if(c1 == c2){
+		return 0;
+	}
+	return (c1 < c2) ? -1 : 1;
+}
+
+#if VEC_WIDE_
+
+VEC_TARGET_
+int VEC_EXPORT_(__MCFCRT_wcscmp)(const wchar_t *s1, const wchar_t *s2){
+	const unsigned char *const p1 = (const unsigned char *)s1;
+	const unsigned char *const p2 = (const unsigned char *)s2;
+	return VEC_NAME_(compare_at)(p1, p2, VEC_NAME_(mismatch)(p1, p2, 0, false));
+}
+
+VEC_TARGET_
+int VEC_EXPORT_(__MCFCRT_wcsncmp)(const wchar_t *s1, const wchar_t *s2, size_t n){
+	const unsigned char *const p1 = (const unsigned char *)s1;
+	const unsigned char *const p2 = (const unsigned char *)s2;
+	// Strings cannot be longer than the address space, so the size in bytes can be saturated.
+	const size_t size = (n <= SIZE_MAX / sizeof(wchar_t)) ? (n * sizeof(wchar_t)) : (SIZE_MAX & (size_t)-sizeof(wchar_t));
+	const size_t off = VEC_NAME_(mismatch)(p1, p2, size, true);
+	if(off == size){
+		return 0;
+	}
+	return VEC_NAME_(compare_at)(p1, p2, off);
+}
+
+VEC_TARGET_
+size_t VEC_EXPORT_(__MCFCRT_wcsmismatch)(const wchar_t *s1, const wchar_t *s2){
+	return VEC_NAME_(mismatch)((const unsigned char *)s1, (const unsigned char *)s2, 0, false) / sizeof(wchar_t);
+}
+
+#else
+
+VEC_TARGET_
+int VEC_EXPORT_(__MCFCRT_strcmp)(const char *s1, const char *s2){
+	const unsigned char *const p1 = (const unsigned char *)s1;
+	const unsigned char *const p2 = (const unsigned char *)s2;
+	return VEC_NAME_(compare_at)(p1, p2, VEC_NAME_(mismatch)(p1, p2, 0, false));
+}
+
+VEC_TARGET_
+int VEC_EXPORT_(__MCFCRT_strncmp)(const char *s1, const char *s2, size_t n){
+	const unsigned char *const p1 = (const unsigned char *)s1;
+	const unsigned char *const p2 = (const unsigned char *)s2;
+	const size_t off = VEC_NAME_(mismatch)(p1, p2, n, true);
+	if(off == n){
+		return 0;
+	}
+	return VEC_NAME_(compare_at)(p1, p2, off);
+}
+
+VEC_TARGET_
+size_t VEC_EXPORT_(__MCFCRT_strmismatch)(const char *s1, const char *s2){
+	return VEC_NAME_(mismatch)((const unsigned char *)s1, (const unsigned char *)s2, 0, false);
+}
+
+#endif
+
+#undef VEC_FIRST_
+#undef VEC_LOW_
+#undef VEC_STOPS_
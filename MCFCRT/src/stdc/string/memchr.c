@@ -5,10 +5,12 @@
 #include "../../env/_crtdef.h"
 #include "../../env/expect.h"
 #include "_sse2.h"
+#include "../../env/_string_dispatch.h"
 
 #undef memchr
 
-void *memchr(const void *s, int c, size_t n){
+__attribute__((__always_inline__))
+static inline void *memchr_generic(const void *s, int c, size_t n){
 	// 如果 arp 是对齐到字的，就不用考虑越界的问题。
 	// 因为内存按页分配的，也自然对齐到页，并且也对齐到字。
 	// 每个字内的字节的权限必然一致。
@@ -53,3 +55,11 @@ end:
 end_null:
 	return _MCFCRT_NULLPTR;
 }
+
+void *__MCFCRT_memchr_sse2(const void *s, int c, size_t n){
+	return memchr_generic(s, c, n);
+}
+
+void *memchr(const void *s, int c, size_t n){
+	return (*__MCFCRT_string_dispatch_table.__memchr)(s, c, n);
+}
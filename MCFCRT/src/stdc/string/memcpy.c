@@ -4,10 +4,12 @@
 
 #include "_memcpy_impl.h"
 #include "_memset_impl.h"
+#include "../../env/_string_dispatch.h"
 
 #undef memcpy
 
-void *memcpy(void *restrict s1, const void *restrict s2, size_t n){
+__attribute__((__always_inline__))
+static inline void *memcpy_generic(void *restrict s1, const void *restrict s2, size_t n){
 	unsigned char *wp = s1;
 	const unsigned char *rp = s2;
 #ifndef NDEBUG
@@ -16,3 +18,11 @@ void *memcpy(void *restrict s1, const void *restrict s2, size_t n){
 	__MCFCRT_memcpy_impl_fwd(wp, wp + n, rp, rp + n);
 	return s1;
 }
+
+void *__MCFCRT_memcpy_sse2(void *restrict s1, const void *restrict s2, size_t n){
+	return memcpy_generic(s1, s2, n);
+}
+
+void *memcpy(void *restrict s1, const void *restrict s2, size_t n){
+	return (*__MCFCRT_string_dispatch_table.__memcpy)(s1, s2, n);
+}
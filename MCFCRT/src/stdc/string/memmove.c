@@ -4,13 +4,13 @@
 
 #include "../../env/_crtdef.h"
 #include "../../env/expect.h"
+#include "../../env/_string_dispatch.h"
+#include "_memcpy_impl.h"
 
 #undef memmove
 
-extern void __MCFCRT_memcpy_impl_bwd(unsigned char *bwp, unsigned char *ewp, const unsigned char *brp, const unsigned char *erp);
-extern void __MCFCRT_memcpy_impl_fwd(unsigned char *bwp, unsigned char *ewp, const unsigned char *brp, const unsigned char *erp);
-
-void *memmove(void *s1, const void *s2, size_t n){
+__attribute__((__always_inline__))
+static inline void *memmove_generic(void *s1, const void *s2, size_t n){
 	unsigned char *wp = s1;
 	const unsigned char *rp = s2;
 	size_t pred = (uintptr_t)wp - (uintptr_t)rp;
@@ -21,3 +21,11 @@ void *memmove(void *s1, const void *s2, size_t n){
 	}
 	return s1;
 }
+
+void *__MCFCRT_memmove_sse2(void *s1, const void *s2, size_t n){
+	return memmove_generic(s1, s2, n);
+}
+
+void *memmove(void *s1, const void *s2, size_t n){
+	return (*__MCFCRT_string_dispatch_table.__memmove)(s1, s2, n);
+}
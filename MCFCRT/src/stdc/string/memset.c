@@ -3,18 +3,28 @@
 // Copyleft 2013 - 2018, LH_Mouse. All wrongs reserved.
 
 #include "_memset_impl.h"
+#include "../../env/_string_dispatch.h"
 
 #undef memset
 
-void *__MCFCRT_memset32(void *s, uint32_t c32, size_t n){
+__attribute__((__always_inline__))
+static inline void *memset32_generic(void *s, uint32_t c32, size_t n){
 	unsigned char *wp = s;
 	__MCFCRT_memset_impl_fwd(wp, wp + n, c32);
 	return s;
 }
 
+void *__MCFCRT_memset32_sse2(void *s, uint32_t c32, size_t n){
+	return memset32_generic(s, c32, n);
+}
+
+void *__MCFCRT_memset32(void *s, uint32_t c32, size_t n){
+	return (*__MCFCRT_string_dispatch_table.__memset32)(s, c32, n);
+}
+
 void *memset(void *s, int c, size_t n){
 	uint32_t c32 = (uint8_t)c;
 	c32 += c32 <<  8;
 	c32 += c32 << 16;
-	return __MCFCRT_memset32(s, c32, n);
+	return (*__MCFCRT_string_dispatch_table.__memset32)(s, c32, n);
 }
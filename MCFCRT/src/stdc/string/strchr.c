@@ -5,10 +5,12 @@
 #include "../../env/_crtdef.h"
 #include "../../env/expect.h"
 #include "_sse2.h"
+#include "../../env/_string_dispatch.h"
 
 #undef strchr
 
-char *strchr(const char *s, int c){
+__attribute__((__always_inline__))
+static inline char *strchr_generic(const char *s, int c){
 	// 如果 arp 是对齐到字的，就不用考虑越界的问题。
 	// 因为内存按页分配的，也自然对齐到页，并且也对齐到字。
 	// 每个字内的字节的权限必然一致。
@@ -44,3 +46,11 @@ end:
 	}
 	return _MCFCRT_NULLPTR;
 }
+
+char *__MCFCRT_strchr_sse2(const char *s, int c){
+	return strchr_generic(s, c);
+}
+
+char *strchr(const char *s, int c){
+	return (*__MCFCRT_string_dispatch_table.__strchr)(s, c);
+}
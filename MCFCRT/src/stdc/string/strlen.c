@@ -3,11 +3,15 @@
 // Copyleft 2013 - 2018, LH_Mouse. All wrongs reserved.
 
 #include "../../env/_crtdef.h"
-#include "../../ext/rawmemchr.h"
+#include "../../env/_string_dispatch.h"
 
 #undef strlen
 
-size_t strlen(const char *s){
-	const char *const p = _MCFCRT_rawmemchr(s, 0);
+size_t __MCFCRT_strlen_sse2(const char *s){
+	const char *const p = __MCFCRT_rawmemchr_sse2(s, 0);
 	return (size_t)(p - s);
 }
+
+size_t strlen(const char *s){
+	return (*__MCFCRT_string_dispatch_table.__strlen)(s);
+}
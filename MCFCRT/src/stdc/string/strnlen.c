@@ -0,0 +1,20 @@
+// 这个文件是 MCF 的一部分。
+// 有关具体授权说明，请参阅 MCFLicense.txt。
+// Copyleft 2013 - 2018, LH_Mouse. All wrongs reserved.
+
+#include "../../env/_crtdef.h"
+#include "../../env/_string_dispatch.h"
+
+#undef strnlen
+
+size_t __MCFCRT_strnlen_sse2(const char *s, size_t n){
+	const char *const p = __MCFCRT_memchr_sse2(s, 0, n);
+	if(!p){
+		return n;
+	}
+	return (size_t)(p - s);
+}
+
+size_t strnlen(const char *s, size_t n){
+	return (*__MCFCRT_string_dispatch_table.__strnlen)(s, n);
+}
@@ -0,0 +1,64 @@
+// 这个文件是 MCF 的一部分。
+// 有关具体授权说明，请参阅 MCFLicense.txt。
+// Copyleft 2013 - 2018, LH_Mouse. All wrongs reserved.
+
+#include "../../env/_crtdef.h"
+#include "../../env/expect.h"
+#include "_sse2.h"
+#include "../../env/_string_dispatch.h"
+
+#undef strrchr
+
+__attribute__((__always_inline__))
+static inline char *strrchr_generic(const char *s, int c){
+	// 如果 arp 是对齐到字的，就不用考虑越界的问题。
+	// 因为内存按页分配的，也自然对齐到页，并且也对齐到字。
+	// 每个字内的字节的权限必然一致。
+	const unsigned char *arp = (const unsigned char *)((uintptr_t)s & (uintptr_t)-32);
+	__m128i xc[1];
+	__MCFCRT_xmmsetb(xc, (uint8_t)c);
+	__m128i xz[1];
+	__MCFCRT_xmmsetz(xz);
+	// 最后一个匹配的字符。
+	const unsigned char *found = _MCFCRT_NULLPTR;
+
+	__m128i xw[2];
+	uint32_t mask_z, mask_c;
+	ptrdiff_t dist;
+//=============================================================================
+#define BEGIN	\
+	arp = __MCFCRT_xmmload_2(xw, arp, _mm_load_si128);	\
+	mask_z = __MCFCRT_xmmcmp_21b(xw, xz);	\
+	mask_c = __MCFCRT_xmmcmp_21b(xw, xc);
+#define END	\
+	if(_MCFCRT_EXPECT_NOT(mask_z != 0)){	\
+		goto end;	\
+	}	\
+	if(mask_c != 0){	\
+		found = arp - 32 + (31 - (unsigned)__builtin_clz(mask_c));	\
+	}
+//=============================================================================
+	BEGIN
+	dist = (const unsigned char *)s - (arp - 32);
+	mask_z &= (uint32_t)-1 << dist;
+	mask_c &= (uint32_t)-1 << dist;
+	for(;;){
+		END
+		BEGIN
+	}
+end:
+	// 丢弃空字符之后的匹配。如果 c 为零，这里找到的就是空字符本身。
+	mask_c &= mask_z ^ (mask_z - 1);
+	if(mask_c != 0){
+		found = arp - 32 + (31 - (unsigned)__builtin_clz(mask_c));
+	}
+	return (char *)found;
+}
+
+char *__MCFCRT_strrchr_sse2(const char *s, int c){
+	return strrchr_generic(s, c);
+}
+
+char *strrchr(const char *s, int c){
+	return (*__MCFCRT_string_dispatch_table.__strrchr)(s, c);
+}
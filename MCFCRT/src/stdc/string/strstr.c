@@ -0,0 +1,12 @@
+// 这个文件是 MCF 的一部分。
+// 有关具体授权说明，请参阅 MCFLicense.txt。
+// Copyleft 2013 - 2018, LH_Mouse. All wrongs reserved.
+
+#include "../../env/_crtdef.h"
+#include "../../env/_string_dispatch.h"
+
+#undef strstr
+
+char *strstr(const char *s1, const char *s2){
+	return (*__MCFCRT_string_dispatch_table.__strstr)(s1, s2);
+}
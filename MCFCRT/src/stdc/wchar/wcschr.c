@@ -5,10 +5,12 @@
 #include "../../env/_crtdef.h"
 #include "../../env/expect.h"
 #include "../string/_sse2.h"
+#include "../../env/_string_dispatch.h"
 
 #undef wcschr
 
-wchar_t *wcschr(const wchar_t *s, wchar_t c){
+__attribute__((__always_inline__))
+static inline wchar_t *wcschr_generic(const wchar_t *s, wchar_t c){
 	// 如果 arp 是对齐到字的，就不用考虑越界的问题。
 	// 因为内存按页分配的，也自然对齐到页，并且也对齐到字。
 	// 每个字内的字节的权限必然一致。
@@ -44,3 +46,11 @@ end:
 	}
 	return _MCFCRT_NULLPTR;
 }
+
+wchar_t *__MCFCRT_wcschr_sse2(const wchar_t *s, wchar_t c){
+	return wcschr_generic(s, c);
+}
+
+wchar_t *wcschr(const wchar_t *s, wchar_t c){
+	return (*__MCFCRT_string_dispatch_table.__wcschr)(s, c);
+}
@@ -6,10 +6,12 @@
 #include "../../env/expect.h"
 #include "../string/_sse2.h"
 #include "../string/_ssse3.h"
+#include "../../env/_string_dispatch.h"
 
 #undef wcscmp
 
-int wcscmp(const wchar_t *s1, const wchar_t *s2){
+__attribute__((__always_inline__))
+static inline size_t wcsmismatch_generic(const wchar_t *s1, const wchar_t *s2){
 	// 如果 arp1 和 arp2 是对齐到字的，就不用考虑越界的问题。
 	// 因为内存按页分配的，也自然对齐到页，并且也对齐到字。
 	// 每个字内的字节的权限必然一致。
@@ -57,11 +59,22 @@ int wcscmp(const wchar_t *s1, const wchar_t *s2){
 	}
 end:
 	arp1 = arp1 - 32 + (unsigned)__builtin_ctzl(mask);
-	arp2 = arp1 - (const wchar_t *)s1 + (const wchar_t *)s2;
-	if(*arp1 == *arp2){
-		goto end_equal;
+	return (size_t)(arp1 - (const wchar_t *)s1);
+}
+
+int __MCFCRT_wcscmp_sse2(const wchar_t *s1, const wchar_t *s2){
+	const size_t off = wcsmismatch_generic(s1, s2);
+	const wchar_t c1 = s1[off];
+	const wchar_t c2 = s2[off];
+	if(c1 == c2){
+		return 0;
 	}
-	return (*arp1 < *arp2) ? -1 : 1;
-end_equal:
-	return 0;
+	return (c1 < c2) ? -1 : 1;
+}
+size_t __MCFCRT_wcsmismatch_sse2(const wchar_t *s1, const wchar_t *s2){
+	return wcsmismatch_generic(s1, s2);
+}
+
+int wcscmp(const wchar_t *s1, const wchar_t *s2){
+	return (*__MCFCRT_string_dispatch_table.__wcscmp)(s1, s2);
 }
@@ -3,11 +3,15 @@
 // Copyleft 2013 - 2018, LH_Mouse. All wrongs reserved.
 
 #include "../../env/_crtdef.h"
-#include "../../ext/rawwmemchr.h"
+#include "../../env/_string_dispatch.h"
 
 #undef wcslen
 
-size_t wcslen(const wchar_t *s){
-	const wchar_t *const p = _MCFCRT_rawwmemchr(s, 0);
+size_t __MCFCRT_wcslen_sse2(const wchar_t *s){
+	const wchar_t *const p = __MCFCRT_rawwmemchr_sse2(s, 0);
 	return (size_t)(p - s);
 }
+
+size_t wcslen(const wchar_t *s){
+	return (*__MCFCRT_string_dispatch_table.__wcslen)(s);
+}
@@ -6,10 +6,12 @@
 #include "../../env/expect.h"
 #include "../string/_sse2.h"
 #include "../string/_ssse3.h"
+#include "../../env/_string_dispatch.h"
 
 #undef wcsncmp
 
-int wcsncmp(const wchar_t *s1, const wchar_t *s2, size_t n){
+__attribute__((__always_inline__))
+static inline int wcsncmp_generic(const wchar_t *s1, const wchar_t *s2, size_t n){
 	// 如果 arp1 和 arp2 是对齐到字的，就不用考虑越界的问题。
 	// 因为内存按页分配的，也自然对齐到页，并且也对齐到字。
 	// 每个字内的字节的权限必然一致。
@@ -50,6 +52,11 @@ int wcsncmp(const wchar_t *s1, const wchar_t *s2, size_t n){
 	if(_MCFCRT_EXPECT_NOT(n == 0)){
 		goto end_equal;
 	}
+	// 字符串不可能越过地址空间的末尾，因此截断 n，使得下面的指针运算不会溢出，指针之差也不会超出 ptrdiff_t 的范围。
+	const uintptr_t top = ((uintptr_t)s1 > (uintptr_t)s2) ? (uintptr_t)s1 : (uintptr_t)s2;
+	if(_MCFCRT_EXPECT_NOT(n > (UINTPTR_MAX - top) / 2 / sizeof(wchar_t))){
+		n = (UINTPTR_MAX - top) / 2 / sizeof(wchar_t);
+	}
 	__MCFCRT_xmmsetz_4(s2v + 4);
 	arp2 = __MCFCRT_xmmload_4(s2v + 8, arp2, _mm_load_si128);
 	mask = __MCFCRT_xmmcmp_41w(s2v + 8, xz);
@@ -77,3 +84,11 @@ end:
 end_equal:
 	return 0;
 }
+
+int __MCFCRT_wcsncmp_sse2(const wchar_t *s1, const wchar_t *s2, size_t n){
+	return wcsncmp_generic(s1, s2, n);
+}
+
+int wcsncmp(const wchar_t *s1, const wchar_t *s2, size_t n){
+	return (*__MCFCRT_string_dispatch_table.__wcsncmp)(s1, s2, n);
+}
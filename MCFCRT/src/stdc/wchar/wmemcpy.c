@@ -3,11 +3,10 @@
 // Copyleft 2013 - 2018, LH_Mouse. All wrongs reserved.
 
 #include "../../env/_crtdef.h"
+#include "../../env/_string_dispatch.h"
 
 #undef wmemcpy
 
-extern void *memcpy(void *restrict s1, const void *restrict s2, size_t n);
-
 wchar_t *wmemcpy(wchar_t *restrict s1, const wchar_t *restrict s2, size_t n){
-	return memcpy(s1, s2, n * sizeof(wchar_t));
+	return (*__MCFCRT_string_dispatch_table.__memcpy)(s1, s2, n * sizeof(wchar_t));
 }
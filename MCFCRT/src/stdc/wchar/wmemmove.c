@@ -3,11 +3,10 @@
 // Copyleft 2013 - 2018, LH_Mouse. All wrongs reserved.
 
 #include "../../env/_crtdef.h"
+#include "../../env/_string_dispatch.h"
 
 #undef wmemmove
 
-extern void *memmove(void *s1, const void *s2, size_t n);
-
 wchar_t *wmemmove(wchar_t *s1, const wchar_t *s2, size_t n){
-	return memmove(s1, s2, n * sizeof(wchar_t));
+	return (*__MCFCRT_string_dispatch_table.__memmove)(s1, s2, n * sizeof(wchar_t));
 }
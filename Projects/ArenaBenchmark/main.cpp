@@ -0,0 +1,91 @@
+#include <MCF/StdMCF.hpp>
+#include <MCF/Core/Clocks.hpp>
+#include <MCF/Core/Arena.hpp>
+#include <MCF/Containers/Vector.hpp>
+#include <MCF/Containers/List.hpp>
+#include <MCF/Containers/FlatMap.hpp>
+
+using namespace MCF;
+
+// Every request allocates a few hundred small objects and frees all of them at the end.
+
+constexpr std::size_t kRequestCount      = 100000;
+constexpr std::size_t kObjectsPerRequest = 400;
+
+Arena g_vArena;
+
+inline std::uint32_t NextRandom(std::uint32_t &u32Seed) noexcept {
+	u32Seed = u32Seed * 1664525u + 1013904223u;
+	return u32Seed >> 8;
+}
+
+void RunMalloc(){
+	void *apObjects[kObjectsPerRequest];
+	std::uint32_t u32Seed = 1;
+	const auto t1 = GetHiResMonoClock();
+	for(std::size_t uRequest = 0; uRequest < kRequestCount; ++uRequest){
+		for(std::size_t i = 0; i < kObjectsPerRequest; ++i){
+			const auto uSize = NextRandom(u32Seed) % 240 + 16;
+			const auto pObject = std::malloc(uSize);
+			if(!pObject){
+				std::abort();
+			}
+			std::memset(pObject, 0, 16);
+			apObjects[i] = pObject;
+		}
+		for(std::size_t i = 0; i < kObjectsPerRequest; ++i){
+			std::free(apObjects[i]);
+		}
+	}
+	const auto t2 = GetHiResMonoClock();
+	std::printf("%-24s : t = %10.3f ms\n", "malloc/free", t2 - t1);
+}
+void RunArena(){
+	std::uint32_t u32Seed = 1;
+	const auto t1 = GetHiResMonoClock();
+	for(std::size_t uRequest = 0; uRequest < kRequestCount; ++uRequest){
+		for(std::size_t i = 0; i < kObjectsPerRequest; ++i){
+			const auto uSize = NextRandom(u32Seed) % 240 + 16;
+			const auto pObject = g_vArena.Allocate(uSize);
+			std::memset(pObject, 0, 16);
+		}
+		g_vArena.Reset();
+	}
+	const auto t2 = GetHiResMonoClock();
+	std::printf("%-24s : t = %10.3f ms\n", "Arena", t2 - t1);
+}
+
+template<class AllocatorT>
+void RunContainers(const char *pszName, Arena &vArena){
+	const auto t1 = GetHiResMonoClock();
+	for(std::size_t uRequest = 0; uRequest < kRequestCount / 10; ++uRequest){
+		{
+			Vector<int, AllocatorT> vecInts;
+			List<int, AllocatorT> lstInts;
+			FlatMap<int, int, Less, AllocatorT> mapInts;
+			for(std::size_t i = 0; i < kObjectsPerRequest; ++i){
+				const auto nValue = static_cast<int>(i * 7 % kObjectsPerRequest);
+				vecInts.Push(nValue);
+				lstInts.Push(nValue);
+				mapInts.AddWithHint(nullptr, nValue, nValue);
+			}
+		}
+		vArena.Reset();
+	}
+	const auto t2 = GetHiResMonoClock();
+	std::printf("%-24s : t = %10.3f ms\n", pszName, t2 - t1);
+}
+
+extern "C" unsigned _MCFCRT_Main(void) noexcept {
+	RunMalloc();
+	RunArena();
+	RunContainers<DefaultAllocator>("Containers (default)", g_vArena);
+	RunContainers<ArenaAllocator<g_vArena>>("Containers (arena)", g_vArena);
+	{
+		// The arena of this thread is a local object, so it can't be used as a template argument.
+		Arena vArena;
+		const ArenaScope vScope(vArena);
+		RunContainers<ThreadLocalArenaAllocator>("Containers (scoped)", vArena);
+	}
+	return 0;
+}
@@ -0,0 +1,139 @@
+#include <MCF/StdMCF.hpp>
+#include <MCF/Core/Clocks.hpp>
+#include <MCF/Core/Array.hpp>
+#include <MCF/Thread/Thread.hpp>
+#include <MCF/Core/Atomic.hpp>
+#include <MCF/Core/MinMax.hpp>
+#include <MCF/Containers/Vector.hpp>
+#include <MCFCRT/env/heap.h>
+
+using namespace MCF;
+
+// Each thread keeps a ring of live blocks. On every iteration one block is replaced by a block of random size.
+// Every eighth block is handed over to the next thread, which frees it, so cross-thread frees are exercised, too.
+
+constexpr std::size_t kRingSize         = 1024;
+constexpr std::size_t kIterations       = 2000000;
+constexpr std::size_t kMaxThreadCount   = 16;
+
+struct MallocAllocator {
+	static const char *GetName() noexcept {
+		return "MCFCRT malloc";
+	}
+	static void *Allocate(std::size_t uSize) noexcept {
+		return std::malloc(uSize);
+	}
+	static void Deallocate(void *pBlock) noexcept {
+		std::free(pBlock);
+	}
+};
+struct LocalAllocAllocator {
+	static const char *GetName() noexcept {
+		return "LocalAlloc";
+	}
+	static void *Allocate(std::size_t uSize) noexcept {
+		return ::LocalAlloc(LMEM_FIXED, uSize);
+	}
+	static void Deallocate(void *pBlock) noexcept {
+		::LocalFree(pBlock);
+	}
+};
+
+Array<Atomic<void *>, kMaxThreadCount, kRingSize> g_aMailboxes;
+
+inline std::uint32_t NextRandom(std::uint32_t &u32Seed) noexcept {
+	u32Seed = u32Seed * 1664525u + 1013904223u;
+	return u32Seed >> 8;
+}
+inline std::size_t MakeRandomSize(std::uint32_t &u32Seed) noexcept {
+	const auto u32Random = NextRandom(u32Seed);
+	if(u32Random % 64 == 0){
+		return u32Random % 0x40000;
+	} else if(u32Random % 8 == 0){
+		return u32Random % 0x1000;
+	}
+	return u32Random % 256;
+}
+
+template<typename AllocatorT>
+void Churn(std::size_t uIndex, std::size_t uThreadCount){
+	void *apRing[kRingSize] = { };
+	std::uint32_t u32Seed = static_cast<std::uint32_t>(uIndex * 12345 + 1);
+	const auto uNext = (uIndex + 1) % uThreadCount;
+	for(std::size_t i = 0; i < kIterations; ++i){
+		const auto uSlot = NextRandom(u32Seed) % kRingSize;
+		const auto pOld = apRing[uSlot];
+		if(pOld){
+			if(i % 8 == 0){
+				const auto pVictim = g_aMailboxes[uNext][uSlot].Exchange(pOld, kAtomicAcqRel);
+				if(pVictim){
+					AllocatorT::Deallocate(pVictim);
+				}
+			} else {
+				AllocatorT::Deallocate(pOld);
+			}
+		}
+		const auto uSize = MakeRandomSize(u32Seed);
+		const auto pNew = AllocatorT::Allocate(uSize);
+		if(!pNew){
+			std::abort();
+		}
+		std::memset(pNew, 0, Min(uSize, std::size_t(64)));
+		apRing[uSlot] = pNew;
+
+		const auto pMail = g_aMailboxes[uIndex][uSlot].Exchange(nullptr, kAtomicAcqRel);
+		if(pMail){
+			AllocatorT::Deallocate(pMail);
+		}
+	}
+	for(std::size_t uSlot = 0; uSlot < kRingSize; ++uSlot){
+		if(apRing[uSlot]){
+			AllocatorT::Deallocate(apRing[uSlot]);
+		}
+	}
+}
+
+template<typename AllocatorT>
+void Run(std::size_t uThreadCount){
+	Vector<IntrusivePtr<Thread>> vecThreads;
+	const auto t1 = GetHiResMonoClock();
+	for(std::size_t i = 0; i < uThreadCount; ++i){
+		const auto fnProc = [=]{ Churn<AllocatorT>(i, uThreadCount); };
+		vecThreads.Push(MakeThread(fnProc));
+	}
+	for(const auto &pThread : vecThreads){
+		pThread->Wait();
+	}
+	const auto t2 = GetHiResMonoClock();
+	for(std::size_t i = 0; i < uThreadCount; ++i){
+		for(std::size_t uSlot = 0; uSlot < kRingSize; ++uSlot){
+			const auto pMail = g_aMailboxes[i][uSlot].Exchange(nullptr, kAtomicRelaxed);
+			if(pMail){
+				AllocatorT::Deallocate(pMail);
+			}
+		}
+	}
+	const auto dOps = static_cast<double>(kIterations * uThreadCount);
+	std::printf("%-16s threads = %2zu : t = %10.3f ms, %8.2f Mops/s\n", AllocatorT::GetName(), uThreadCount, t2 - t1, dOps / (t2 - t1) / 1000);
+}
+
+extern "C" unsigned _MCFCRT_Main(void) noexcept {
+	for(std::size_t uThreadCount = 1; uThreadCount <= kMaxThreadCount; uThreadCount *= 2){
+		Run<LocalAllocAllocator>(uThreadCount);
+		Run<MallocAllocator>(uThreadCount);
+	}
+
+	::_MCFCRT_HeapStatistics vStatistics;
+	::_MCFCRT_HeapGetStatistics(&vStatistics);
+	std::printf("allocs = %llu, reallocs = %llu, frees = %llu, live = %llu bytes, peak = %llu bytes, samples = %llu\n",
+		static_cast<unsigned long long>(vStatistics.__u64AllocCount), static_cast<unsigned long long>(vStatistics.__u64ReallocCount),
+		static_cast<unsigned long long>(vStatistics.__u64FreeCount), static_cast<unsigned long long>(vStatistics.__u64LiveBytes),
+		static_cast<unsigned long long>(vStatistics.__u64PeakBytes), static_cast<unsigned long long>(vStatistics.__u64SampleCount));
+	for(unsigned uBucket = 0; uBucket < _MCFCRT_HEAP_HISTOGRAM_SIZE; ++uBucket){
+		if(vStatistics.__au64Histogram[uBucket] != 0){
+			std::printf("  [2^%2u, 2^%2u) : %llu\n", uBucket, uBucket + 1, static_cast<unsigned long long>(vStatistics.__au64Histogram[uBucket]));
+		}
+	}
+	::_MCFCRT_HeapDumpProfile();
+	return 0;
+}
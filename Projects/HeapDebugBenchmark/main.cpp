@@ -0,0 +1,95 @@
+#include <MCF/StdMCF.hpp>
+#include <MCF/Core/Clocks.hpp>
+#include <MCF/Thread/Thread.hpp>
+#include <MCF/Containers/Vector.hpp>
+#include <MCFCRT/env/heap_debug.h>
+
+using namespace MCF;
+
+// This measures the overhead of the debug heap, which is enabled in debug builds of MCFCRT.
+// Both loops obtain storage from `std::malloc()`. The second one registers and validates every block as `__MCFCRT_HEAP_DEBUG` does.
+// Build it with the release scripts, otherwise `std::malloc()` itself goes through the debug heap.
+
+constexpr std::size_t kRingSize         = 1024;
+constexpr std::size_t kIterations       = 1000000;
+constexpr std::size_t kMaxThreadCount   = 16;
+
+inline std::uint32_t NextRandom(std::uint32_t &u32Seed) noexcept {
+	u32Seed = u32Seed * 1664525u + 1013904223u;
+	return u32Seed >> 8;
+}
+
+template<bool kDebugT>
+void Churn(std::size_t uIndex){
+	void *apRing[kRingSize] = { };
+	std::uint32_t u32Seed = static_cast<std::uint32_t>(uIndex * 12345 + 1);
+	for(std::size_t i = 0; i < kIterations; ++i){
+		const auto uSlot = NextRandom(u32Seed) % kRingSize;
+		if(apRing[uSlot]){
+			if(kDebugT){
+				std::size_t uSize, uAlignment;
+				void *pStorage;
+				if(!::__MCFCRT_HeapDebugValidateAndUnregister(&uSize, &uAlignment, &pStorage, apRing[uSlot])){
+					std::abort();
+				}
+				std::free(pStorage);
+			} else {
+				std::free(apRing[uSlot]);
+			}
+		}
+		const auto uSize = static_cast<std::size_t>(NextRandom(u32Seed) % 256);
+		void *pBlock;
+		if(kDebugT){
+			const auto pStorage = std::malloc(::__MCFCRT_HeapDebugCalculateSizeToAlloc(uSize, 1));
+			if(!pStorage){
+				std::abort();
+			}
+			::__MCFCRT_HeapDebugRegister(&pBlock, uSize, 1, pStorage, nullptr, nullptr);
+		} else {
+			pBlock = std::malloc(uSize);
+			if(!pBlock){
+				std::abort();
+			}
+		}
+		apRing[uSlot] = pBlock;
+	}
+	for(std::size_t uSlot = 0; uSlot < kRingSize; ++uSlot){
+		if(!apRing[uSlot]){
+			continue;
+		}
+		if(kDebugT){
+			std::size_t uSize, uAlignment;
+			void *pStorage;
+			if(!::__MCFCRT_HeapDebugValidateAndUnregister(&uSize, &uAlignment, &pStorage, apRing[uSlot])){
+				std::abort();
+			}
+			std::free(pStorage);
+		} else {
+			std::free(apRing[uSlot]);
+		}
+	}
+}
+
+template<bool kDebugT>
+double Run(std::size_t uThreadCount){
+	Vector<IntrusivePtr<Thread>> vecThreads;
+	const auto t1 = GetHiResMonoClock();
+	for(std::size_t i = 0; i < uThreadCount; ++i){
+		const auto fnProc = [=]{ Churn<kDebugT>(i); };
+		vecThreads.Push(MakeThread(fnProc));
+	}
+	for(const auto &pThread : vecThreads){
+		pThread->Wait();
+	}
+	const auto t2 = GetHiResMonoClock();
+	return t2 - t1;
+}
+
+extern "C" unsigned _MCFCRT_Main(void) noexcept {
+	for(std::size_t uThreadCount = 1; uThreadCount <= kMaxThreadCount; uThreadCount *= 2){
+		const auto dRelease = Run<false>(uThreadCount);
+		const auto dDebug = Run<true>(uThreadCount);
+		std::printf("threads = %2zu : release t = %10.3f ms, debug t = %10.3f ms, overhead = %6.2fx\n", uThreadCount, dRelease, dDebug, dDebug / dRelease);
+	}
+	return 0;
+}
@@ -0,0 +1,66 @@
+#include <MCF/StdMCF.hpp>
+#include <MCFCRT/env/heap.h>
+#include <cstring>
+
+// A huge block must never be resized in place into the small range, and a sized free must not trust a size or alignment
+// that no longer describes the block. For every alignment, a huge block is allocated, resized in place to a small size
+// and to a smaller huge size, then freed with the size it is supposed to have. Another huge block is moved into a small
+// one by a reallocation, then freed with its original alignment. Small blocks are allocated and freed after
+// that, which crashes if the heap has been corrupted.
+// The program prints the failures and returns the number of them.
+
+constexpr std::size_t kHugeSize        = 200000;
+constexpr std::size_t kSmallSize       = 100000;
+constexpr std::size_t kShrunkHugeSize  = 150000;
+constexpr std::size_t kMovedSize       = 64;
+constexpr std::size_t kMaxAlignment    = 0x200000;
+constexpr unsigned    kSmallBlockCount = 1000;
+
+unsigned g_uFailureCount = 0;
+
+void Check(bool bCondition, const char *pszWhat, std::size_t uAlignment){
+	if(!bCondition){
+		std::printf("FAILED: %s (alignment = %zu)\n", pszWhat, uAlignment);
+		++g_uFailureCount;
+	}
+}
+
+void ExerciseSmallBlocks(){
+	for(unsigned i = 0; i < kSmallBlockCount; ++i){
+		const auto pBlock = ::_MCFCRT_malloc(kSmallSize);
+		if(pBlock){
+			std::memset(pBlock, 0xCC, kSmallSize);
+		}
+		::_MCFCRT_free_sized(pBlock, kSmallSize);
+	}
+}
+
+extern "C" unsigned _MCFCRT_Main(void) noexcept {
+	for(std::size_t uAlignment = 1; uAlignment <= kMaxAlignment; uAlignment *= 2){
+		const auto pBlock = ::_MCFCRT_aligned_alloc(uAlignment, kHugeSize);
+		Check(pBlock, "_MCFCRT_aligned_alloc()", uAlignment);
+		if(!pBlock){
+			continue;
+		}
+		std::size_t uSize = kHugeSize;
+		// Shrinking into the small range must be refused and leave the block intact.
+		Check(!::_MCFCRT_TryExpandInPlace(pBlock, kSmallSize), "shrinking into the small range", uAlignment);
+		Check(::_MCFCRT_malloc_usable_size(pBlock) >= kHugeSize, "usable size after a refused shrink", uAlignment);
+		// Shrinking within the huge range is allowed.
+		if(::_MCFCRT_TryExpandInPlace(pBlock, kShrunkHugeSize)){
+			uSize = kShrunkHugeSize;
+		}
+		Check(::_MCFCRT_malloc_usable_size(pBlock) >= uSize, "usable size after shrinking", uAlignment);
+		std::memset(pBlock, 0x5A, uSize);
+		::_MCFCRT_free_aligned_sized(pBlock, uAlignment, uSize);
+		ExerciseSmallBlocks();
+
+		// The alignment passed to the sized free is stale after the block has been moved.
+		const auto pMovedBlock = ::_MCFCRT_realloc(::_MCFCRT_aligned_alloc(uAlignment, kHugeSize), kMovedSize);
+		Check(pMovedBlock, "_MCFCRT_realloc()", uAlignment);
+		::_MCFCRT_free_aligned_sized(pMovedBlock, uAlignment, kMovedSize);
+		ExerciseSmallBlocks();
+	}
+	std::printf("%u failure(s)\n", g_uFailureCount);
+	return g_uFailureCount;
+}
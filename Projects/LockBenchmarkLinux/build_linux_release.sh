@@ -0,0 +1,14 @@
+#!/bin/sh
+
+# This program is built natively on Linux. Only the lock algorithms and the `futex()` backend of `_park_native.h` are taken from MCFCRT.
+
+CPPFLAGS+=" -O3 -DNDEBUG -Wall -Wextra -pedantic -Wno-error=unused-parameter	\
+	-Wwrite-strings -Wconversion -Wsign-conversion -Wsuggest-attribute=noreturn -Wundef -Wshadow -Wstrict-aliasing=2	\
+	-pipe -march=core2 -mtune=intel	\
+	-I../../MCFCRT/src"
+CFLAGS+=" -O3 -DNDEBUG -std=c11"
+LDFLAGS+=" -O3 -DNDEBUG -pthread -lm"
+
+S=../../MCFCRT/src/env
+
+gcc ${CPPFLAGS} ${CFLAGS} main.c $S/mutex.c $S/condition_variable.c $S/once_flag.c $S/rwlock.c $S/wait_on_address.c $S/_mutex_profile.c $S/_park.c $S/_park_futex.c ${LDFLAGS}
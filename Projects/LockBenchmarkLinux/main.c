@@ -0,0 +1,777 @@
+// This program builds the mutex, condition variable and once flag of MCFCRT natively on Linux, using the `futex()` backend of `_park_native.h`.
+// It runs contention sweeps and spin count sweeps, and prints a histogram of per-thread shares of lock acquisitions as a measure of fairness.
+// Correctness is checked along the way: counters protected by locks must add up, and every once flag must be initialized exactly once.
+// Broadcasting to condition variables is measured with and without waiters being moved onto the mutex, by context switches and wakeup latency.
+// The readers-writer lock is compared against the old design of `MCF::ReadersWriterMutex`, which was built from two mutexes, in read-heavy workloads.
+// Waking up threads by address is measured by latency and by throughput of a semaphore under contention, against a semaphore built on a mutex and a condition variable.
+// Finally it runs a workload with mutex contention profiling enabled and prints the profile.
+
+#define _GNU_SOURCE 1
+#include <env/mutex.h>
+#include <env/condition_variable.h>
+#include <env/once_flag.h>
+#include <env/rwlock.h>
+#include <env/wait_on_address.h>
+#include <env/clocks.h>
+#include <env/xassert.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <math.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <sys/resource.h>
+
+#define MAX_THREAD_COUNT        64u
+#define RUN_DURATION_MS         300u
+#define FAIRNESS_BUCKET_COUNT   8u
+
+// These are normally provided by the CRT.
+uint64_t _MCFCRT_GetFastMonoClock(void){
+	struct timespec vNow;
+	clock_gettime(CLOCK_MONOTONIC, &vNow);
+	return (uint64_t)vNow.tv_sec * 1000 + (uint64_t)vNow.tv_nsec / 1000000;
+}
+double _MCFCRT_GetHiResMonoClock(void){
+	struct timespec vNow;
+	clock_gettime(CLOCK_MONOTONIC, &vNow);
+	return (double)vNow.tv_sec * 1.0e3 + (double)vNow.tv_nsec / 1.0e6;
+}
+uintptr_t _MCFCRT_GetCurrentThreadId(void){
+	// This reads the TEB on Windows, so don't make a system call every time.
+	static _Thread_local uintptr_t s_uThreadId;
+	if(!s_uThreadId){
+		s_uThreadId = (uintptr_t)syscall(SYS_gettid);
+	}
+	return s_uThreadId;
+}
+void __MCFCRT_OnAssertionFailure(const wchar_t *pwszExpression, const wchar_t *pwszFile, unsigned long ulLine, const wchar_t *pwszMessage){
+	fprintf(stderr, "Assertion failed: %ls (%ls:%lu) %ls\n", pwszExpression, pwszFile, ulLine, pwszMessage);
+	abort();
+}
+
+typedef struct tagWorker {
+	alignas(64) pthread_t hThread;
+	unsigned uIndex;
+	uint64_t u64Count;
+} Worker;
+
+static Worker g_aWorkers[MAX_THREAD_COUNT];
+static pthread_barrier_t g_vBarrier;
+static volatile bool g_bStop;
+
+// If `bTimed` is `true`, workers are stopped after `RUN_DURATION_MS` milliseconds. Otherwise they run to completion.
+// This function returns the number of milliseconds elapsed.
+static double RunWorkers(unsigned uThreadCount, void *(*pfnProc)(void *), bool bTimed){
+	pthread_barrier_init(&g_vBarrier, NULL, uThreadCount + 1);
+	__atomic_store_n(&g_bStop, false, __ATOMIC_RELAXED);
+	for(unsigned uIndex = 0; uIndex < uThreadCount; ++uIndex){
+		g_aWorkers[uIndex].uIndex = uIndex;
+		g_aWorkers[uIndex].u64Count = 0;
+		if(pthread_create(&(g_aWorkers[uIndex].hThread), NULL, pfnProc, g_aWorkers + uIndex) != 0){
+			abort();
+		}
+	}
+	pthread_barrier_wait(&g_vBarrier);
+	const double dBegin = _MCFCRT_GetHiResMonoClock();
+	if(bTimed){
+		struct timespec vDuration = { RUN_DURATION_MS / 1000, (RUN_DURATION_MS % 1000) * 1000000l };
+		nanosleep(&vDuration, NULL);
+		__atomic_store_n(&g_bStop, true, __ATOMIC_RELAXED);
+	}
+	for(unsigned uIndex = 0; uIndex < uThreadCount; ++uIndex){
+		pthread_join(g_aWorkers[uIndex].hThread, NULL);
+	}
+	const double dEnd = _MCFCRT_GetHiResMonoClock();
+	pthread_barrier_destroy(&g_vBarrier);
+	return dEnd - dBegin;
+}
+static uint64_t SumCounts(unsigned uThreadCount){
+	uint64_t u64Total = 0;
+	for(unsigned uIndex = 0; uIndex < uThreadCount; ++uIndex){
+		u64Total += g_aWorkers[uIndex].u64Count;
+	}
+	return u64Total;
+}
+
+// Mutex contention: every thread increments a plain counter under the mutex. A few iterations use timed waits, which exercise the timeout path.
+static _MCFCRT_Mutex g_vMutex;
+static size_t g_uSpinCount;
+static uint64_t g_u64Protected;
+
+static void *MutexProc(void *pParam){
+	Worker *const pWorker = pParam;
+	pthread_barrier_wait(&g_vBarrier);
+	uint64_t u64Count = 0;
+	while(!__atomic_load_n(&g_bStop, __ATOMIC_RELAXED)){
+		if((u64Count & 0xFF) == 0xFF){
+			if(!_MCFCRT_WaitForMutex(&g_vMutex, g_uSpinCount, _MCFCRT_GetFastMonoClock() + 1)){
+				continue;
+			}
+		} else {
+			_MCFCRT_WaitForMutexForever(&g_vMutex, g_uSpinCount);
+		}
+		++g_u64Protected;
+		_MCFCRT_SignalMutex(&g_vMutex);
+		++u64Count;
+	}
+	pWorker->u64Count = u64Count;
+	return NULL;
+}
+
+static void PrintFairness(unsigned uThreadCount, uint64_t u64Total){
+	// Each bucket counts threads whose share is within a range, relative to the average share. The last bucket counts threads with twice the average or more.
+	unsigned auHistogram[FAIRNESS_BUCKET_COUNT] = { 0 };
+	const double dAverage = (double)u64Total / uThreadCount;
+	double dMin = INFINITY, dMax = 0, dSquares = 0;
+	for(unsigned uIndex = 0; uIndex < uThreadCount; ++uIndex){
+		const double dRatio = (double)g_aWorkers[uIndex].u64Count / dAverage;
+		dMin = fmin(dMin, dRatio);
+		dMax = fmax(dMax, dRatio);
+		dSquares += (dRatio - 1) * (dRatio - 1);
+		unsigned uBucket = (unsigned)(dRatio * FAIRNESS_BUCKET_COUNT / 2);
+		if(uBucket >= FAIRNESS_BUCKET_COUNT){
+			uBucket = FAIRNESS_BUCKET_COUNT - 1;
+		}
+		++auHistogram[uBucket];
+	}
+	printf("    share/avg: min = %5.3f, max = %5.3f, stddev = %5.3f, histogram =", dMin, dMax, sqrt(dSquares / uThreadCount));
+	for(unsigned uBucket = 0; uBucket < FAIRNESS_BUCKET_COUNT; ++uBucket){
+		printf(" %2u", auHistogram[uBucket]);
+	}
+	putchar('\n');
+}
+
+static void BenchmarkMutex(void){
+	static const size_t s_auSpinCounts[] = { 0, 100, 1000, 4000 };
+	puts("=== Mutex ===");
+	for(unsigned uSpin = 0; uSpin < sizeof(s_auSpinCounts) / sizeof(s_auSpinCounts[0]); ++uSpin){
+		for(unsigned uThreadCount = 1; uThreadCount <= MAX_THREAD_COUNT; uThreadCount *= 2){
+			_MCFCRT_InitializeMutex(&g_vMutex);
+			g_uSpinCount = s_auSpinCounts[uSpin];
+			g_u64Protected = 0;
+			RunWorkers(uThreadCount, &MutexProc, true);
+			const uint64_t u64Total = SumCounts(uThreadCount);
+			if(u64Total != g_u64Protected){
+				fprintf(stderr, "Mutex is broken: expecting %llu, got %llu\n", (unsigned long long)u64Total, (unsigned long long)g_u64Protected);
+				abort();
+			}
+			printf("spin = %4zu, threads = %2u : %8.3f Mops/s\n", g_uSpinCount, uThreadCount, (double)u64Total / RUN_DURATION_MS / 1000);
+			PrintFairness(uThreadCount, u64Total);
+		}
+	}
+}
+
+// Condition variable: threads pass a token around in a ring. Each thread waits until the token is its own, and then hands it over to the next one.
+static _MCFCRT_ConditionVariable g_vConditionVariable;
+static unsigned g_uRingSize;
+static unsigned g_uToken;
+
+static intptr_t UnlockCallback(intptr_t nContext){
+	_MCFCRT_SignalMutex((_MCFCRT_Mutex *)nContext);
+	return 1;
+}
+static void RelockCallback(intptr_t nContext, intptr_t nUnlocked){
+	(void)nUnlocked;
+	_MCFCRT_WaitForMutexForever((_MCFCRT_Mutex *)nContext, g_uSpinCount);
+}
+
+static void *ConditionVariableProc(void *pParam){
+	Worker *const pWorker = pParam;
+	pthread_barrier_wait(&g_vBarrier);
+	uint64_t u64Count = 0;
+	_MCFCRT_WaitForMutexForever(&g_vMutex, g_uSpinCount);
+	for(;;){
+		while((g_uToken != pWorker->uIndex) && !__atomic_load_n(&g_bStop, __ATOMIC_RELAXED)){
+			// Wake up periodically to check for the stop flag.
+			_MCFCRT_WaitForConditionVariable(&g_vConditionVariable, &UnlockCallback, &RelockCallback, (intptr_t)&g_vMutex, g_uSpinCount, _MCFCRT_GetFastMonoClock() + 10);
+		}
+		if(__atomic_load_n(&g_bStop, __ATOMIC_RELAXED)){
+			break;
+		}
+		g_uToken = (g_uToken + 1) % g_uRingSize;
+		++u64Count;
+		_MCFCRT_BroadcastConditionVariable(&g_vConditionVariable);
+	}
+	_MCFCRT_SignalMutex(&g_vMutex);
+	pWorker->u64Count = u64Count;
+	return NULL;
+}
+
+static void BenchmarkConditionVariable(void){
+	static const size_t s_auSpinCounts[] = { 0, _MCFCRT_CONDITION_VARIABLE_SUGGESTED_SPIN_COUNT };
+	puts("=== Condition variable ===");
+	for(unsigned uSpin = 0; uSpin < sizeof(s_auSpinCounts) / sizeof(s_auSpinCounts[0]); ++uSpin){
+		for(unsigned uThreadCount = 2; uThreadCount <= MAX_THREAD_COUNT; uThreadCount *= 2){
+			_MCFCRT_InitializeMutex(&g_vMutex);
+			_MCFCRT_InitializeConditionVariable(&g_vConditionVariable);
+			g_uSpinCount = s_auSpinCounts[uSpin];
+			g_uRingSize = uThreadCount;
+			g_uToken = 0;
+			RunWorkers(uThreadCount, &ConditionVariableProc, true);
+			const uint64_t u64Total = SumCounts(uThreadCount);
+			// Every thread can get at most one turn more than the next one.
+			for(unsigned uIndex = 1; uIndex < uThreadCount; ++uIndex){
+				if(g_aWorkers[uIndex - 1].u64Count - g_aWorkers[uIndex].u64Count > 1){
+					fprintf(stderr, "Condition variable is broken: thread %u has %llu turns but thread %u has %llu\n",
+						uIndex - 1, (unsigned long long)g_aWorkers[uIndex - 1].u64Count, uIndex, (unsigned long long)g_aWorkers[uIndex].u64Count);
+					abort();
+				}
+			}
+			printf("spin = %4zu, threads = %2u : %8.3f Kpasses/s\n", g_uSpinCount, uThreadCount, (double)u64Total / RUN_DURATION_MS);
+		}
+	}
+}
+
+// Broadcast: a producer puts one item for each consumer into a queue and broadcasts while holding the mutex, then waits for the queue to be drained.
+// Consumers wait either on the condition variable alone, or on the mutex as well, in which case they are moved onto the mutex and woken up one by one.
+// Context switches are counted for the whole process. Latency is measured from the broadcast to the moment an item is taken.
+#define BROADCAST_ROUND_COUNT   2000u
+#define BROADCAST_WORK_COUNT    500u
+
+static _MCFCRT_ConditionVariable g_vNotEmpty, g_vDrained;
+static bool g_bOnMutex;
+static unsigned g_uConsumerCount;
+static double g_adQueue[MAX_THREAD_COUNT];
+static unsigned g_uQueued;
+static bool g_bProducerDone;
+static double g_adLatencySums[MAX_THREAD_COUNT];
+static double g_adLatencyMaxes[MAX_THREAD_COUNT];
+
+static void WaitForBroadcast(_MCFCRT_ConditionVariable *pConditionVariable){
+	if(g_bOnMutex){
+		_MCFCRT_WaitForConditionVariableOnMutexForever(pConditionVariable, &UnlockCallback, &RelockCallback, (intptr_t)&g_vMutex, &g_vMutex, g_uSpinCount);
+	} else {
+		_MCFCRT_WaitForConditionVariableForever(pConditionVariable, &UnlockCallback, &RelockCallback, (intptr_t)&g_vMutex, g_uSpinCount);
+	}
+}
+
+static void RunProducer(void){
+	for(unsigned uRound = 0; uRound < BROADCAST_ROUND_COUNT; ++uRound){
+		_MCFCRT_WaitForMutexForever(&g_vMutex, g_uSpinCount);
+		while(g_uQueued != 0){
+			WaitForBroadcast(&g_vDrained);
+		}
+		const double dNow = _MCFCRT_GetHiResMonoClock();
+		for(unsigned uIndex = 0; uIndex < g_uConsumerCount; ++uIndex){
+			g_adQueue[g_uQueued++] = dNow;
+		}
+		_MCFCRT_BroadcastConditionVariable(&g_vNotEmpty);
+		_MCFCRT_SignalMutex(&g_vMutex);
+	}
+	_MCFCRT_WaitForMutexForever(&g_vMutex, g_uSpinCount);
+	while(g_uQueued != 0){
+		WaitForBroadcast(&g_vDrained);
+	}
+	g_bProducerDone = true;
+	_MCFCRT_BroadcastConditionVariable(&g_vNotEmpty);
+	_MCFCRT_SignalMutex(&g_vMutex);
+}
+static void RunConsumer(Worker *pWorker){
+	uint64_t u64Count = 0;
+	double dLatencySum = 0, dLatencyMax = 0;
+	for(;;){
+		_MCFCRT_WaitForMutexForever(&g_vMutex, g_uSpinCount);
+		while((g_uQueued == 0) && !g_bProducerDone){
+			WaitForBroadcast(&g_vNotEmpty);
+		}
+		if(g_uQueued == 0){
+			_MCFCRT_SignalMutex(&g_vMutex);
+			break;
+		}
+		const double dLatency = _MCFCRT_GetHiResMonoClock() - g_adQueue[--g_uQueued];
+		if(g_uQueued == 0){
+			_MCFCRT_SignalConditionVariable(&g_vDrained, 1);
+		}
+		_MCFCRT_SignalMutex(&g_vMutex);
+		++u64Count;
+		dLatencySum += dLatency;
+		if(dLatencyMax < dLatency){
+			dLatencyMax = dLatency;
+		}
+		// Process the item without the mutex.
+		for(unsigned uWorkIndex = 0; uWorkIndex < BROADCAST_WORK_COUNT; ++uWorkIndex){
+			__builtin_ia32_pause();
+		}
+	}
+	pWorker->u64Count = u64Count;
+	g_adLatencySums[pWorker->uIndex] = dLatencySum;
+	g_adLatencyMaxes[pWorker->uIndex] = dLatencyMax;
+}
+static void *BroadcastProc(void *pParam){
+	Worker *const pWorker = pParam;
+	pthread_barrier_wait(&g_vBarrier);
+	// The last thread is the producer.
+	if(pWorker->uIndex == g_uConsumerCount){
+		RunProducer();
+	} else {
+		RunConsumer(pWorker);
+	}
+	return NULL;
+}
+
+static uint64_t GetContextSwitchCount(void){
+	struct rusage vUsage;
+	getrusage(RUSAGE_SELF, &vUsage);
+	return (uint64_t)vUsage.ru_nvcsw + (uint64_t)vUsage.ru_nivcsw;
+}
+
+static void BenchmarkBroadcast(void){
+	static const size_t s_auSpinCounts[] = { 0, _MCFCRT_CONDITION_VARIABLE_SUGGESTED_SPIN_COUNT };
+	puts("=== Condition variable broadcast ===");
+	for(unsigned uSpin = 0; uSpin < sizeof(s_auSpinCounts) / sizeof(s_auSpinCounts[0]); ++uSpin){
+		for(unsigned uConsumerCount = 2; uConsumerCount < MAX_THREAD_COUNT; uConsumerCount *= 2){
+			for(unsigned uOnMutex = 0; uOnMutex < 2; ++uOnMutex){
+				_MCFCRT_InitializeMutex(&g_vMutex);
+				_MCFCRT_InitializeConditionVariable(&g_vNotEmpty);
+				_MCFCRT_InitializeConditionVariable(&g_vDrained);
+				g_uSpinCount = s_auSpinCounts[uSpin];
+				g_bOnMutex = uOnMutex;
+				g_uConsumerCount = uConsumerCount;
+				g_uQueued = 0;
+				g_bProducerDone = false;
+				const uint64_t u64SwitchesBefore = GetContextSwitchCount();
+				const double dElapsed = RunWorkers(uConsumerCount + 1, &BroadcastProc, false);
+				const uint64_t u64Switches = GetContextSwitchCount() - u64SwitchesBefore;
+				const uint64_t u64Total = SumCounts(uConsumerCount);
+				if(u64Total != (uint64_t)BROADCAST_ROUND_COUNT * uConsumerCount){
+					fprintf(stderr, "Condition variable is broken: %llu items produced but %llu consumed\n",
+						(unsigned long long)BROADCAST_ROUND_COUNT * uConsumerCount, (unsigned long long)u64Total);
+					abort();
+				}
+				double dLatencySum = 0, dLatencyMax = 0;
+				for(unsigned uIndex = 0; uIndex < uConsumerCount; ++uIndex){
+					dLatencySum += g_adLatencySums[uIndex];
+					if(dLatencyMax < g_adLatencyMaxes[uIndex]){
+						dLatencyMax = g_adLatencyMaxes[uIndex];
+					}
+				}
+				printf("spin = %4zu, consumers = %2u, %-14s : %8.3f rounds/s, %7.2f switches/round, latency avg = %8.2f us, max = %9.2f us\n",
+					g_uSpinCount, uConsumerCount, g_bOnMutex ? "on mutex" : "without mutex", BROADCAST_ROUND_COUNT / dElapsed * 1000,
+					(double)u64Switches / BROADCAST_ROUND_COUNT, dLatencySum / (double)u64Total * 1000, dLatencyMax * 1000);
+			}
+		}
+	}
+}
+
+// Once flag: all threads race to initialize a fresh flag in every round. Exactly one of them must win.
+#define ONCE_FLAG_ROUND_COUNT   4096u
+
+static _MCFCRT_OnceFlag g_aOnceFlags[ONCE_FLAG_ROUND_COUNT];
+static unsigned g_auInitCounts[ONCE_FLAG_ROUND_COUNT];
+
+static void *OnceFlagProc(void *pParam){
+	Worker *const pWorker = pParam;
+	pthread_barrier_wait(&g_vBarrier);
+	uint64_t u64Count = 0;
+	for(unsigned uRound = 0; uRound < ONCE_FLAG_ROUND_COUNT; ++uRound){
+		_MCFCRT_OnceFlag *const pFlag = g_aOnceFlags + uRound;
+		// Abort the first attempt of every other round, so the aborted path is exercised.
+		bool bAbort = (uRound % 2) != 0;
+		for(;;){
+			const _MCFCRT_OnceResult eResult = _MCFCRT_WaitForOnceFlagForever(pFlag);
+			if(eResult == _MCFCRT_kOnceResultFinished){
+				break;
+			}
+			if(bAbort){
+				bAbort = false;
+				_MCFCRT_SignalOnceFlagAsAborted(pFlag);
+				continue;
+			}
+			++g_auInitCounts[uRound];
+			++u64Count;
+			// Give other threads a chance to get trapped.
+			sched_yield();
+			_MCFCRT_SignalOnceFlagAsFinished(pFlag);
+			break;
+		}
+	}
+	pWorker->u64Count = u64Count;
+	return NULL;
+}
+
+static void BenchmarkOnceFlag(void){
+	puts("=== Once flag ===");
+	for(unsigned uThreadCount = 1; uThreadCount <= MAX_THREAD_COUNT; uThreadCount *= 2){
+		for(unsigned uRound = 0; uRound < ONCE_FLAG_ROUND_COUNT; ++uRound){
+			_MCFCRT_InitializeOnceFlag(g_aOnceFlags + uRound);
+			g_auInitCounts[uRound] = 0;
+		}
+		const double dElapsed = RunWorkers(uThreadCount, &OnceFlagProc, false);
+		for(unsigned uRound = 0; uRound < ONCE_FLAG_ROUND_COUNT; ++uRound){
+			if(g_auInitCounts[uRound] != 1){
+				fprintf(stderr, "Once flag is broken: round %u was initialized %u times\n", uRound, g_auInitCounts[uRound]);
+				abort();
+			}
+		}
+		printf("threads = %2u : %u rounds in %8.3f ms\n", uThreadCount, ONCE_FLAG_ROUND_COUNT, dElapsed);
+	}
+}
+
+// Readers-writer lock: readers check that two words protected by the lock are equal. Writers increment both.
+#define RWLOCK_MODE_COUNT       3u
+
+typedef enum tagRwLockMode {
+	kRwLockModeTwoMutexes,
+	kRwLockModeCentral,
+	kRwLockModeDistributed,
+} RwLockMode;
+
+static const char *const g_apszRwLockModeNames[RWLOCK_MODE_COUNT] = { "two mutexes", "central", "distributed" };
+
+static RwLockMode g_eRwLockMode;
+static unsigned g_uWritePeriod;
+static _MCFCRT_RwLock g_vRwLock;
+static _MCFCRT_RwLockReaderSlots g_vReaderSlots;
+// These emulate the old `MCF::ReadersWriterMutex`.
+static _MCFCRT_Mutex g_vReaderGuard, g_vExclusive;
+static size_t g_uReaderCount;
+static volatile uint64_t g_au64RwData[2];
+static volatile uint64_t g_u64RwWrites;
+
+static void LockAsReader(void){
+	if(g_eRwLockMode == kRwLockModeTwoMutexes){
+		_MCFCRT_WaitForMutexForever(&g_vReaderGuard, _MCFCRT_MUTEX_SUGGESTED_SPIN_COUNT);
+		if(__atomic_add_fetch(&g_uReaderCount, 1, __ATOMIC_RELAXED) == 1){
+			_MCFCRT_WaitForMutexForever(&g_vExclusive, _MCFCRT_MUTEX_SUGGESTED_SPIN_COUNT);
+		}
+		_MCFCRT_SignalMutex(&g_vReaderGuard);
+	} else {
+		_MCFCRT_WaitForRwLockAsReaderForever(&g_vRwLock, _MCFCRT_RWLOCK_SUGGESTED_SPIN_COUNT);
+	}
+}
+static void UnlockAsReader(void){
+	if(g_eRwLockMode == kRwLockModeTwoMutexes){
+		if(__atomic_sub_fetch(&g_uReaderCount, 1, __ATOMIC_RELAXED) == 0){
+			_MCFCRT_SignalMutex(&g_vExclusive);
+		}
+	} else {
+		_MCFCRT_SignalRwLockAsReader(&g_vRwLock);
+	}
+}
+static bool LockAsWriter(bool bTimed){
+	if(g_eRwLockMode == kRwLockModeTwoMutexes){
+		_MCFCRT_WaitForMutexForever(&g_vReaderGuard, _MCFCRT_MUTEX_SUGGESTED_SPIN_COUNT);
+		_MCFCRT_WaitForMutexForever(&g_vExclusive, _MCFCRT_MUTEX_SUGGESTED_SPIN_COUNT);
+		return true;
+	}
+	if(bTimed){
+		return _MCFCRT_WaitForRwLockAsWriter(&g_vRwLock, _MCFCRT_RWLOCK_SUGGESTED_SPIN_COUNT, _MCFCRT_GetFastMonoClock() + 1);
+	}
+	_MCFCRT_WaitForRwLockAsWriterForever(&g_vRwLock, _MCFCRT_RWLOCK_SUGGESTED_SPIN_COUNT);
+	return true;
+}
+static void UnlockAsWriter(void){
+	if(g_eRwLockMode == kRwLockModeTwoMutexes){
+		_MCFCRT_SignalMutex(&g_vExclusive);
+		_MCFCRT_SignalMutex(&g_vReaderGuard);
+	} else {
+		_MCFCRT_SignalRwLockAsWriter(&g_vRwLock);
+	}
+}
+
+static void *RwLockProc(void *pParam){
+	Worker *const pWorker = pParam;
+	pthread_barrier_wait(&g_vBarrier);
+	uint64_t u64Count = 0;
+	// Spread writes among threads.
+	unsigned uUntilWrite = pWorker->uIndex % g_uWritePeriod + 1;
+	while(!__atomic_load_n(&g_bStop, __ATOMIC_RELAXED)){
+		if(--uUntilWrite == 0){
+			uUntilWrite = g_uWritePeriod;
+			// Some writers use timed waits, which exercise the timeout path.
+			if(LockAsWriter((u64Count & 0x10) != 0)){
+				g_au64RwData[0] = g_au64RwData[0] + 1;
+				g_au64RwData[1] = g_au64RwData[1] + 1;
+				g_u64RwWrites = g_u64RwWrites + 1;
+				UnlockAsWriter();
+			}
+		} else {
+			LockAsReader();
+			if(g_au64RwData[0] != g_au64RwData[1]){
+				fprintf(stderr, "Readers-writer lock is broken: a reader sees a partial write\n");
+				abort();
+			}
+			UnlockAsReader();
+		}
+		++u64Count;
+	}
+	pWorker->u64Count = u64Count;
+	return NULL;
+}
+
+static void BenchmarkRwLock(void){
+	// These are numbers of operations per write. `UINT_MAX` means there are virtually no writes.
+	static const unsigned s_auWritePeriods[] = { UINT_MAX, 1000, 100, 10 };
+	puts("=== Readers-writer lock ===");
+	for(unsigned uPeriod = 0; uPeriod < sizeof(s_auWritePeriods) / sizeof(s_auWritePeriods[0]); ++uPeriod){
+		for(unsigned uMode = 0; uMode < RWLOCK_MODE_COUNT; ++uMode){
+			for(unsigned uThreadCount = 1; uThreadCount <= MAX_THREAD_COUNT; uThreadCount *= 2){
+				g_eRwLockMode = (RwLockMode)uMode;
+				g_uWritePeriod = s_auWritePeriods[uPeriod];
+				_MCFCRT_InitializeRwLock(&g_vRwLock, (g_eRwLockMode == kRwLockModeDistributed) ? &g_vReaderSlots : NULL);
+				_MCFCRT_InitializeMutex(&g_vReaderGuard);
+				_MCFCRT_InitializeMutex(&g_vExclusive);
+				g_uReaderCount = 0;
+				g_au64RwData[0] = 0;
+				g_au64RwData[1] = 0;
+				g_u64RwWrites = 0;
+				RunWorkers(uThreadCount, &RwLockProc, true);
+				const uint64_t u64Total = SumCounts(uThreadCount);
+				if(g_au64RwData[0] != g_u64RwWrites){
+					fprintf(stderr, "Readers-writer lock is broken: expecting %llu writes, got %llu\n", (unsigned long long)g_u64RwWrites, (unsigned long long)g_au64RwData[0]);
+					abort();
+				}
+				printf("writes = 1/%-10u, %-11s, threads = %2u : %8.3f Mops/s, %llu writes\n",
+					g_uWritePeriod, g_apszRwLockModeNames[uMode], uThreadCount, (double)u64Total / RUN_DURATION_MS / 1000, (unsigned long long)g_u64RwWrites);
+			}
+		}
+	}
+}
+
+// Wait on address: two threads hand a word back and forth, which measures wakeup latency. Waking up an address where no thread is sleeping should be cheap.
+// Then threads contend for the permits of a semaphore, which is built either on `_MCFCRT_WaitOnAddress()` like `MCF::Semaphore`, or on a mutex and a condition variable like its old design.
+#define PING_PONG_ROUND_COUNT   20000u
+#define EMPTY_WAKE_COUNT        10000000u
+
+static volatile uint32_t g_u32PingPong;
+
+static void *PingPongProc(void *pParam){
+	Worker *const pWorker = pParam;
+	pthread_barrier_wait(&g_vBarrier);
+	for(uint32_t u32Round = 0; u32Round < PING_PONG_ROUND_COUNT; ++u32Round){
+		const uint32_t u32Mine = u32Round * 2 + pWorker->uIndex;
+		for(;;){
+			uint32_t u32Value = __atomic_load_n(&g_u32PingPong, __ATOMIC_ACQUIRE);
+			if(u32Value == u32Mine){
+				break;
+			}
+			if(u32Value > u32Mine){
+				fprintf(stderr, "Wait on address is broken: expecting %lu, got %lu\n", (unsigned long)u32Mine, (unsigned long)u32Value);
+				abort();
+			}
+			_MCFCRT_WaitOnAddressForever(&g_u32PingPong, &u32Value, sizeof(u32Value));
+		}
+		__atomic_store_n(&g_u32PingPong, u32Mine + 1, __ATOMIC_RELEASE);
+		_MCFCRT_WakeByAddressSingle(&g_u32PingPong);
+		++(pWorker->u64Count);
+	}
+	return NULL;
+}
+
+static bool g_bSemaphoreOnAddress;
+static unsigned g_uPermitCount;
+static volatile size_t g_uSemaphoreCount;
+static _MCFCRT_ConditionVariable g_vSemaphoreWaiter;
+static volatile unsigned g_uPermitsTaken;
+
+static bool TryDecrementSemaphore(void){
+	size_t uOld = __atomic_load_n(&g_uSemaphoreCount, __ATOMIC_RELAXED);
+	while(uOld != 0){
+		if(__atomic_compare_exchange_n(&g_uSemaphoreCount, &uOld, uOld - 1, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)){
+			return true;
+		}
+	}
+	return false;
+}
+static bool WaitForSemaphore(uint64_t u64UntilFastMonoClock){
+	if(g_bSemaphoreOnAddress){
+		static const size_t s_uZero = 0;
+		while(!TryDecrementSemaphore()){
+			if(!_MCFCRT_WaitOnAddress(&g_uSemaphoreCount, &s_uZero, sizeof(s_uZero), u64UntilFastMonoClock)){
+				return TryDecrementSemaphore();
+			}
+		}
+		return true;
+	}
+	_MCFCRT_WaitForMutexForever(&g_vMutex, _MCFCRT_MUTEX_SUGGESTED_SPIN_COUNT);
+	while(g_uSemaphoreCount == 0){
+		if(!_MCFCRT_WaitForConditionVariableOnMutexOrAbandon(&g_vSemaphoreWaiter, &UnlockCallback, &RelockCallback, (intptr_t)&g_vMutex, &g_vMutex, g_uSpinCount, u64UntilFastMonoClock)){
+			// The mutex is not relocked in this case.
+			return false;
+		}
+	}
+	--g_uSemaphoreCount;
+	_MCFCRT_SignalMutex(&g_vMutex);
+	return true;
+}
+static void PostSemaphore(void){
+	if(g_bSemaphoreOnAddress){
+		__atomic_fetch_add(&g_uSemaphoreCount, 1, __ATOMIC_RELEASE);
+		_MCFCRT_WakeByAddressSingle(&g_uSemaphoreCount);
+		return;
+	}
+	_MCFCRT_WaitForMutexForever(&g_vMutex, _MCFCRT_MUTEX_SUGGESTED_SPIN_COUNT);
+	++g_uSemaphoreCount;
+	_MCFCRT_SignalConditionVariable(&g_vSemaphoreWaiter, 1);
+	_MCFCRT_SignalMutex(&g_vMutex);
+}
+
+static void *SemaphoreProc(void *pParam){
+	Worker *const pWorker = pParam;
+	pthread_barrier_wait(&g_vBarrier);
+	uint64_t u64Count = 0;
+	while(!__atomic_load_n(&g_bStop, __ATOMIC_RELAXED)){
+		if((u64Count % 64) == 63){
+			if(!WaitForSemaphore(0)){
+				continue;
+			}
+		} else {
+			WaitForSemaphore(UINT64_MAX);
+		}
+		const unsigned uTaken = __atomic_add_fetch(&g_uPermitsTaken, 1, __ATOMIC_RELAXED);
+		if(uTaken > g_uPermitCount){
+			fprintf(stderr, "Semaphore is broken: %u permits taken out of %u\n", uTaken, g_uPermitCount);
+			abort();
+		}
+		// Hold the permit for a while, so there is contention.
+		for(unsigned i = 0; i < 100; ++i){
+			__builtin_ia32_pause();
+		}
+		__atomic_sub_fetch(&g_uPermitsTaken, 1, __ATOMIC_RELAXED);
+		PostSemaphore();
+		++u64Count;
+	}
+	pWorker->u64Count = u64Count;
+	return NULL;
+}
+
+static void BenchmarkWaitOnAddress(void){
+	puts("=== Wait on address ===");
+	g_u32PingPong = 0;
+	const double dPingPong = RunWorkers(2, &PingPongProc, false);
+	printf("ping-pong          : %8.3f us/handoff\n", dPingPong * 1000 / (PING_PONG_ROUND_COUNT * 2));
+
+	const double dBegin = _MCFCRT_GetHiResMonoClock();
+	size_t uWoken = 0;
+	for(unsigned i = 0; i < EMPTY_WAKE_COUNT; ++i){
+		uWoken += _MCFCRT_WakeByAddressSingle(&g_u32PingPong);
+	}
+	const double dEnd = _MCFCRT_GetHiResMonoClock();
+	if(uWoken != 0){
+		fprintf(stderr, "Wait on address is broken: %zu threads woken up from nowhere\n", uWoken);
+		abort();
+	}
+	printf("wake with no waiter: %8.3f ns/call\n", (dEnd - dBegin) * 1.0e6 / EMPTY_WAKE_COUNT);
+
+	for(unsigned uOnAddress = 0; uOnAddress < 2; ++uOnAddress){
+		for(unsigned uThreadCount = 2; uThreadCount <= MAX_THREAD_COUNT; uThreadCount *= 2){
+			_MCFCRT_InitializeMutex(&g_vMutex);
+			_MCFCRT_InitializeConditionVariable(&g_vSemaphoreWaiter);
+			g_uSpinCount = _MCFCRT_CONDITION_VARIABLE_SUGGESTED_SPIN_COUNT;
+			g_bSemaphoreOnAddress = uOnAddress;
+			g_uPermitCount = uThreadCount / 4 + 1;
+			g_uSemaphoreCount = g_uPermitCount;
+			g_uPermitsTaken = 0;
+			const uint64_t u64SwitchesBefore = GetContextSwitchCount();
+			RunWorkers(uThreadCount, &SemaphoreProc, true);
+			const uint64_t u64Switches = GetContextSwitchCount() - u64SwitchesBefore;
+			const uint64_t u64Total = SumCounts(uThreadCount);
+			if(g_uSemaphoreCount != g_uPermitCount){
+				fprintf(stderr, "Semaphore is broken: %zu permits returned out of %u\n", g_uSemaphoreCount, g_uPermitCount);
+				abort();
+			}
+			printf("semaphore, %-22s, threads = %2u, permits = %2u : %8.3f Mops/s, %7.3f switches/op\n",
+				g_bSemaphoreOnAddress ? "on address" : "mutex and cond var", uThreadCount, g_uPermitCount,
+				(double)u64Total / RUN_DURATION_MS / 1000, (double)u64Switches / (double)(u64Total ? u64Total : 1));
+		}
+	}
+}
+
+// Contention profile: threads lock a hot mutex often and a cold mutex seldom, from different call sites. Use `addr2line` to resolve call sites.
+#define PROFILE_ENTRY_COUNT     4u
+
+static _MCFCRT_Mutex g_vHotMutex, g_vColdMutex;
+
+__attribute__((__noinline__))
+static void LockHotMutex(void){
+	_MCFCRT_WaitForMutexForever(&g_vHotMutex, _MCFCRT_MUTEX_SUGGESTED_SPIN_COUNT);
+	++g_u64Protected;
+	_MCFCRT_SignalMutex(&g_vHotMutex);
+}
+__attribute__((__noinline__))
+static void LockHotMutexWithTimeout(void){
+	if(!_MCFCRT_WaitForMutex(&g_vHotMutex, _MCFCRT_MUTEX_SUGGESTED_SPIN_COUNT, _MCFCRT_GetFastMonoClock() + 1)){
+		return;
+	}
+	++g_u64Protected;
+	_MCFCRT_SignalMutex(&g_vHotMutex);
+}
+__attribute__((__noinline__))
+static void LockColdMutex(void){
+	_MCFCRT_WaitForMutexForever(&g_vColdMutex, _MCFCRT_MUTEX_SUGGESTED_SPIN_COUNT);
+	sched_yield();
+	_MCFCRT_SignalMutex(&g_vColdMutex);
+}
+
+static void *ProfileProc(void *pParam){
+	Worker *const pWorker = pParam;
+	pthread_barrier_wait(&g_vBarrier);
+	uint64_t u64Count = 0;
+	while(!__atomic_load_n(&g_bStop, __ATOMIC_RELAXED)){
+		if((u64Count & 0x3FF) == 0x3FF){
+			LockColdMutex();
+		} else if((u64Count & 0x0F) == 0x0F){
+			LockHotMutexWithTimeout();
+		} else {
+			LockHotMutex();
+		}
+		++u64Count;
+	}
+	pWorker->u64Count = u64Count;
+	return NULL;
+}
+
+static void PrintProfileEntries(const _MCFCRT_MutexProfileEntry *pEntries, size_t uCount){
+	for(size_t uIndex = 0; uIndex < uCount; ++uIndex){
+		const _MCFCRT_MutexProfileEntry *const pEntry = pEntries + uIndex;
+		const char *pszName = "";
+		if(pEntry->__pMutex == &g_vHotMutex){
+			pszName = " (hot)";
+		} else if(pEntry->__pMutex == &g_vColdMutex){
+			pszName = " (cold)";
+		}
+		printf("  mutex = %p%s, call site = %p\n", pEntry->__pMutex, pszName, pEntry->__pRetAddr);
+		printf("    waits = %llu, timeouts = %llu, spins = %llu, parks = %llu, avg trapped = %.2f, max trapped = %llu\n",
+			(unsigned long long)pEntry->__u64WaitCount, (unsigned long long)pEntry->__u64TimeoutCount, (unsigned long long)pEntry->__u64SpinCount,
+			(unsigned long long)pEntry->__u64ParkCount, pEntry->__u64ParkCount ? (double)pEntry->__u64TrappedSum / (double)pEntry->__u64ParkCount : 0.0,
+			(unsigned long long)pEntry->__u64TrappedMax);
+		printf("    wait = %llu us, parked = %llu us, histogram =", (unsigned long long)pEntry->__u64WaitMicroseconds, (unsigned long long)pEntry->__u64ParkMicroseconds);
+		for(unsigned uBucket = 0; uBucket < _MCFCRT_MUTEX_PROFILE_HISTOGRAM_SIZE; ++uBucket){
+			printf(" %llu", (unsigned long long)pEntry->__au64Histogram[uBucket]);
+		}
+		putchar('\n');
+	}
+}
+
+static void ProfileMutex(void){
+	static _MCFCRT_MutexProfileEntry s_aEntries[PROFILE_ENTRY_COUNT];
+	puts("=== Mutex contention profile ===");
+	_MCFCRT_InitializeMutex(&g_vHotMutex);
+	_MCFCRT_InitializeMutex(&g_vColdMutex);
+	g_u64Protected = 0;
+	_MCFCRT_ResetMutexProfile();
+	_MCFCRT_SetMutexProfilingEnabled(true);
+	RunWorkers(16, &ProfileProc, true);
+	_MCFCRT_SetMutexProfilingEnabled(false);
+	size_t uCount = _MCFCRT_GetMutexProfileByMutex(s_aEntries, PROFILE_ENTRY_COUNT);
+	printf("by mutex (%zu in total):\n", uCount);
+	PrintProfileEntries(s_aEntries, (uCount < PROFILE_ENTRY_COUNT) ? uCount : PROFILE_ENTRY_COUNT);
+	uCount = _MCFCRT_GetMutexProfileByCallSite(s_aEntries, PROFILE_ENTRY_COUNT);
+	printf("by call site (%zu in total):\n", uCount);
+	PrintProfileEntries(s_aEntries, (uCount < PROFILE_ENTRY_COUNT) ? uCount : PROFILE_ENTRY_COUNT);
+}
+
+int main(void){
+	BenchmarkMutex();
+	BenchmarkConditionVariable();
+	BenchmarkBroadcast();
+	BenchmarkOnceFlag();
+	BenchmarkRwLock();
+	BenchmarkWaitOnAddress();
+	ProfileMutex();
+	return 0;
+}
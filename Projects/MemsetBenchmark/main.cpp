@@ -0,0 +1,116 @@
+#include <MCF/StdMCF.hpp>
+#include <MCF/SmartPointers/UniquePtr.hpp>
+#include <MCF/Core/Clocks.hpp>
+#include <MCF/Core/DynamicLinkLibrary.hpp>
+#include <MCF/Core/String.hpp>
+#include <MCF/Core/LastError.hpp>
+#include <MCF/Core/MinMax.hpp>
+#include <MCFCRT/env/_string_dispatch.h>
+#include <MCFCRT/ext/memzero_explicit.h>
+
+using namespace MCF;
+
+// For each `memset()` implementation, every size in `kSizes` is filled at every offset (relative to a 4KiB boundary)
+// in `kOffsets`. Each measurement fills about `kBytesPerRun` bytes, or repeats at least `kMinIterations` times, and
+// the throughput is printed in GiB/s.
+// MCFCRT is measured once for each instruction set that the CPU supports, followed by `_MCFCRT_memzero_explicit()`.
+
+struct PageDeleter {
+	constexpr void *operator()() const noexcept {
+		return nullptr;
+	}
+	void operator()(void *p) const noexcept {
+		::VirtualFree(p, 0, MEM_RELEASE);
+	}
+};
+
+using Memset = void * (*)(void *, int, std::size_t);
+
+constexpr std::size_t kSizes[] = {
+	1, 7, 16, 31, 64, 100, 256, 1000, 4096, 16384, 65536, 262144,
+	0x100000, 0x400000, 0x1000000, 0x4000000, 0x10000000, 0x40000000,
+};
+constexpr std::size_t kOffsets[] = {
+	0, 1, 7, 32, 63,
+};
+constexpr std::size_t kBytesPerRun   = 0x10000000;
+constexpr std::size_t kMinIterations = 4;
+constexpr std::size_t kMaxIterations = 10000000;
+constexpr std::size_t kBufferSize    = kSizes[sizeof(kSizes) / sizeof(kSizes[0]) - 1] + 0x1000;
+
+void *g_pBuffer;
+
+void *MemzeroExplicit(void *s, int, std::size_t n){
+	::_MCFCRT_memzero_explicit(s, n);
+	return s;
+}
+
+void RunSweep(const char *pszName, Memset pfnMemset){
+	std::printf("%-24s", pszName);
+	for(const auto uOffset : kOffsets){
+		std::printf("         d+%-2u", static_cast<unsigned>(uOffset));
+	}
+	std::printf("\n");
+	for(const auto uSize : kSizes){
+		std::printf("%24zu", uSize);
+		const auto uIterations = Min(Max(kBytesPerRun / uSize, kMinIterations), kMaxIterations);
+		for(const auto uOffset : kOffsets){
+			const auto pDst = static_cast<char *>(g_pBuffer) + uOffset;
+			// Warm up.
+			(*pfnMemset)(pDst, 0x5A, uSize);
+			const auto t1 = GetHiResMonoClock();
+			for(std::size_t i = 0; i < uIterations; ++i){
+				(*pfnMemset)(pDst, 0x5A, uSize);
+				__asm__ volatile ("" : : : "memory");
+			}
+			const auto t2 = GetHiResMonoClock();
+			const auto dGibPerSec = static_cast<double>(uSize) * static_cast<double>(uIterations) / ((t2 - t1) / 1000) / 0x40000000;
+			std::printf("   %11.3f", dGibPerSec);
+		}
+		std::printf("\n");
+	}
+	std::printf("\n");
+}
+
+extern "C" unsigned _MCFCRT_Main(void) noexcept {
+	const UniquePtr<void, PageDeleter> pBuffer(::VirtualAlloc(nullptr, kBufferSize, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE));
+	if(!pBuffer){
+		std::printf("VirtualAlloc() failed\n");
+		return 1;
+	}
+	g_pBuffer = pBuffer.Get();
+	// Commit all pages.
+	for(std::size_t i = 0; i < kBufferSize; i += 0x1000){
+		static_cast<unsigned char *>(g_pBuffer)[i] = 0;
+	}
+
+	const auto test = [&](WideStringView wsvName){
+		try {
+			const DynamicLinkLibrary vDll(wsvName);
+			const auto pfnMemset = vDll.RequireProcAddress<Memset>("memset"_nsv);
+			if(wsvName != "MCFCRT-2"_wsv){
+				RunSweep(AnsiString(wsvName).GetStr(), pfnMemset);
+				return;
+			}
+			static constexpr const char *kIsaNames[] = { "MCFCRT-2 (sse2)", "MCFCRT-2 (avx2)", "MCFCRT-2 (avx512)" };
+			const auto eDefaultIsa = ::__MCFCRT_StringDispatchGetIsa();
+			for(unsigned uIsa = ::__MCFCRT_kStringIsaSse2; uIsa < ::__MCFCRT_kStringIsaEnd; ++uIsa){
+				if(!::__MCFCRT_StringDispatchSetIsa(static_cast<::__MCFCRT_StringIsa>(uIsa))){
+					std::printf("%s : not supported\n\n", kIsaNames[uIsa]);
+					continue;
+				}
+				RunSweep(kIsaNames[uIsa], pfnMemset);
+			}
+			::__MCFCRT_StringDispatchSetIsa(eDefaultIsa);
+			RunSweep("MCFCRT-2 (memzero)", &MemzeroExplicit);
+		} catch(Exception &e){
+			std::printf("%s : error %lu : %s\n\n", AnsiString(wsvName).GetStr(), e.GetErrorCode(), AnsiString(GetWin32ErrorDescription(e.GetErrorCode())).GetStr());
+		}
+	};
+
+	test("NTDLL"_wsv);
+	test("MSVCRT"_wsv);
+	test("UCRTBASE"_wsv);
+	test("MCFCRT-2"_wsv);
+	return 0;
+}
@@ -0,0 +1,92 @@
+#include <MCF/StdMCF.hpp>
+#include <MCF/Core/Clocks.hpp>
+#include <MCFCRT/env/heap.h>
+
+using namespace MCF;
+
+// A buffer is grown to `kTotalSize` bytes by appending `kChunkSize` bytes at a time.
+// Whenever the buffer grows without moving, the bytes that would have been copied are counted as avoided.
+
+constexpr std::size_t kTotalSize = (sizeof(void *) >= 8) ? 0x40000000 : 0x10000000;
+constexpr std::size_t kChunkSize = 0x10000;
+
+struct Result {
+	double dTime;
+	std::uint64_t u64BytesCopied;
+	std::uint64_t u64BytesAvoided;
+};
+
+void Print(const char *pszName, const Result &vResult){
+	std::printf("%-24s : t = %10.3f ms, copied = %14llu bytes, avoided = %14llu bytes\n",
+		pszName, vResult.dTime, static_cast<unsigned long long>(vResult.u64BytesCopied), static_cast<unsigned long long>(vResult.u64BytesAvoided));
+}
+
+template<typename ReallocT, typename FreeT>
+bool Append(Result &vResult, ReallocT &&vRealloc, FreeT &&vFree){
+	vResult = { };
+	void *pBuffer = nullptr;
+	std::size_t uSize = 0;
+	const auto t1 = GetHiResMonoClock();
+	while(uSize < kTotalSize){
+		const auto pNewBuffer = vRealloc(pBuffer, uSize + kChunkSize);
+		if(!pNewBuffer){
+			vFree(pBuffer);
+			return false;
+		}
+		if(pNewBuffer == pBuffer){
+			vResult.u64BytesAvoided += uSize;
+		} else {
+			vResult.u64BytesCopied += uSize;
+		}
+		std::memset(static_cast<unsigned char *>(pNewBuffer) + uSize, 0x5A, kChunkSize);
+		pBuffer = pNewBuffer;
+		uSize += kChunkSize;
+	}
+	const auto t2 = GetHiResMonoClock();
+	vResult.dTime = t2 - t1;
+	vFree(pBuffer);
+	return true;
+}
+
+extern "C" unsigned _MCFCRT_Main(void) noexcept {
+	Result vResult;
+
+	if(Append(vResult,
+		[](void *p, std::size_t n){ return p ? ::LocalReAlloc(p, n, LMEM_MOVEABLE) : ::LocalAlloc(LMEM_FIXED, n); },
+		[](void *p){ if(p){ ::LocalFree(p); } }))
+	{
+		Print("LocalReAlloc", vResult);
+	} else {
+		std::printf("LocalReAlloc : out of memory\n");
+	}
+
+	if(Append(vResult,
+		[](void *p, std::size_t n){ return std::realloc(p, n); },
+		[](void *p){ std::free(p); }))
+	{
+		Print("MCFCRT realloc", vResult);
+	} else {
+		std::printf("MCFCRT realloc : out of memory\n");
+	}
+
+	// This is what a container does: probe for in-place growth, then fall back to allocate, copy and free.
+	if(Append(vResult,
+		[](void *p, std::size_t n) -> void * {
+			if(::_MCFCRT_TryExpandInPlace(p, n)){
+				return p;
+			}
+			const auto pNew = std::malloc(n);
+			if(pNew && p){
+				std::memcpy(pNew, p, n - kChunkSize);
+				std::free(p);
+			}
+			return pNew;
+		},
+		[](void *p){ std::free(p); }))
+	{
+		Print("_MCFCRT_TryExpandInPlace", vResult);
+	} else {
+		std::printf("_MCFCRT_TryExpandInPlace : out of memory\n");
+	}
+	return 0;
+}
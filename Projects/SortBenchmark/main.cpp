@@ -0,0 +1,94 @@
+#include <MCF/StdMCF.hpp>
+#include <MCF/Core/Clocks.hpp>
+#include <MCF/Algorithms/Sort.hpp>
+#include <MCF/Algorithms/Parallel.hpp>
+#include <MCF/Containers/Vector.hpp>
+#include <MCF/Random/FastGenerator.hpp>
+#include <MCF/Thread/ThreadPool.hpp>
+
+using namespace MCF;
+
+// For each size, random 32-bit keys are sorted with `Sort()`, `StableSort()` and `RadixSort()` on this thread,
+// then with `ParallelSort()` using 1, 2, 4, ... workers up to the number of logical processors, and the speedup over one worker is reported.
+// Sizes whose keys (plus the temporary storage) do not fit in memory are skipped.
+
+constexpr std::size_t kSizes[] = { 10000000, 100000000, 1000000000 };
+
+Vector<std::uint32_t> g_vecKeys;
+Vector<std::uint32_t> g_vecWork;
+
+bool Check(const char *pszName){
+	for(std::size_t i = 1; i < g_vecWork.GetSize(); ++i){
+		if(g_vecWork[i - 1] > g_vecWork[i]){
+			std::printf("%s : keys are not sorted\n", pszName);
+			return false;
+		}
+	}
+	return true;
+}
+
+template<typename SortT>
+double Measure(SortT &&fnSort){
+	g_vecWork.Clear();
+	g_vecWork.Append(g_vecKeys.GetBegin(), g_vecKeys.GetEnd());
+	const auto t1 = GetHiResMonoClock();
+	fnSort();
+	const auto t2 = GetHiResMonoClock();
+	return t2 - t1;
+}
+
+bool Run(std::size_t uSize){
+	g_vecKeys.Resize(uSize);
+	g_vecWork.Reserve(uSize);
+	FastGenerator vGenerator(12345);
+	for(auto &u32Key : g_vecKeys){
+		u32Key = vGenerator.Get();
+	}
+
+	double dDelta;
+	dDelta = Measure([]{ Sort(g_vecWork); });
+	if(!Check("Sort")){
+		return false;
+	}
+	std::printf("keys = %10u : Sort          = %9.3f ms\n", static_cast<unsigned>(uSize), dDelta);
+	dDelta = Measure([]{ StableSort(g_vecWork); });
+	if(!Check("StableSort")){
+		return false;
+	}
+	std::printf("keys = %10u : StableSort    = %9.3f ms\n", static_cast<unsigned>(uSize), dDelta);
+	dDelta = Measure([]{ RadixSort(g_vecWork); });
+	if(!Check("RadixSort")){
+		return false;
+	}
+	std::printf("keys = %10u : RadixSort     = %9.3f ms\n", static_cast<unsigned>(uSize), dDelta);
+
+	::SYSTEM_INFO vSystemInfo;
+	::GetSystemInfo(&vSystemInfo);
+	double dBaseline = 0;
+	for(std::size_t uWorkerCount = 1; uWorkerCount <= vSystemInfo.dwNumberOfProcessors; uWorkerCount *= 2){
+		ThreadPool vPool(uWorkerCount);
+		dDelta = Measure([&]{ ParallelSort(vPool, g_vecWork); });
+		if(!Check("ParallelSort")){
+			return false;
+		}
+		if(uWorkerCount == 1){
+			dBaseline = dDelta;
+		}
+		std::printf("keys = %10u : ParallelSort  = %9.3f ms, workers = %2u, speedup = %5.2f\n",
+			static_cast<unsigned>(uSize), dDelta, static_cast<unsigned>(uWorkerCount), dBaseline / dDelta);
+	}
+	return true;
+}
+
+extern "C" unsigned _MCFCRT_Main(void) noexcept {
+	for(const auto uSize : kSizes){
+		try {
+			if(!Run(uSize)){
+				return 1;
+			}
+		} catch(std::bad_alloc &){
+			std::printf("keys = %10u : skipped, not enough memory\n", static_cast<unsigned>(uSize));
+		}
+	}
+	return 0;
+}
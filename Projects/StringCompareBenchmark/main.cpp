@@ -0,0 +1,111 @@
+#include <MCF/StdMCF.hpp>
+#include <MCF/Core/Clocks.hpp>
+#include <MCF/Core/MinMax.hpp>
+#include <MCFCRT/env/_string_dispatch.h>
+#include <MCFCRT/ext/strmismatch.h>
+#include <MCFCRT/ext/wcsmismatch.h>
+#include <cstring>
+#include <cwchar>
+
+using namespace MCF;
+
+// Each function compares pairs of strings which have a common prefix of every length in `kPrefixLengths` and differ in
+// the character after it. Each measurement compares about `kBytesPerRun` bytes, or repeats at least `kMinIterations`
+// times, and the time of each call is printed in nanoseconds.
+// The measurements are repeated for each instruction set that the CPU supports. The SSE2 ones are the old code.
+
+constexpr std::size_t kPrefixLengths[] = {
+	0, 1, 7, 15, 16, 31, 32, 63, 64, 100, 128, 255, 256, 512, 1000, 2048, 4095, 4096,
+};
+constexpr std::size_t kBytesPerRun   = 0x4000000;
+constexpr std::size_t kMinIterations = 0x10000;
+constexpr std::size_t kMaxIterations = 10000000;
+constexpr std::size_t kBufferSize    = (kPrefixLengths[sizeof(kPrefixLengths) / sizeof(kPrefixLengths[0]) - 1] + 2) * sizeof(wchar_t) + 0x1000;
+
+// The two strings start at different offsets from page boundaries, so both of them cross pages at different places.
+alignas(4096) char g_achBuffer1[kBufferSize];
+alignas(4096) char g_achBuffer2[kBufferSize];
+alignas(4096) wchar_t g_awcBuffer1[kBufferSize / sizeof(wchar_t)];
+alignas(4096) wchar_t g_awcBuffer2[kBufferSize / sizeof(wchar_t)];
+
+template<typename FunctionT>
+void Measure(std::size_t uBytes, FunctionT &&vFunction){
+	const auto uIterations = Min(Max(kBytesPerRun / (uBytes + 1), kMinIterations), kMaxIterations);
+	// Warm up.
+	vFunction();
+	const auto t1 = GetHiResMonoClock();
+	for(std::size_t i = 0; i < uIterations; ++i){
+		auto vResult = vFunction();
+		__asm__ volatile ("" : "+r"(vResult) : : "memory");
+	}
+	const auto t2 = GetHiResMonoClock();
+	const auto dNanoSecPerCall = (t2 - t1) * 1000000 / static_cast<double>(uIterations);
+	std::printf("   %8.1f", dNanoSecPerCall);
+}
+
+template<typename FunctionT>
+void RunNarrow(const char *pszName, FunctionT &&vFunction){
+	std::printf("%-20s", pszName);
+	for(const auto uPrefixLength : kPrefixLengths){
+		const auto pszStr1 = g_achBuffer1 + 5;
+		const auto pszStr2 = g_achBuffer2 + 42;
+		pszStr1[uPrefixLength] = 'a';
+		pszStr2[uPrefixLength] = 'b';
+		pszStr1[uPrefixLength + 1] = 0;
+		pszStr2[uPrefixLength + 1] = 0;
+		Measure(uPrefixLength, [&]{ return vFunction(pszStr1, pszStr2); });
+		pszStr1[uPrefixLength] = 'x';
+		pszStr2[uPrefixLength] = 'x';
+		pszStr1[uPrefixLength + 1] = 'x';
+		pszStr2[uPrefixLength + 1] = 'x';
+	}
+	std::printf("\n");
+}
+template<typename FunctionT>
+void RunWide(const char *pszName, FunctionT &&vFunction){
+	std::printf("%-20s", pszName);
+	for(const auto uPrefixLength : kPrefixLengths){
+		const auto pwszStr1 = g_awcBuffer1 + 5;
+		const auto pwszStr2 = g_awcBuffer2 + 42;
+		pwszStr1[uPrefixLength] = L'a';
+		pwszStr2[uPrefixLength] = L'b';
+		pwszStr1[uPrefixLength + 1] = 0;
+		pwszStr2[uPrefixLength + 1] = 0;
+		Measure(uPrefixLength * sizeof(wchar_t), [&]{ return vFunction(pwszStr1, pwszStr2); });
+		pwszStr1[uPrefixLength] = L'x';
+		pwszStr2[uPrefixLength] = L'x';
+		pwszStr1[uPrefixLength + 1] = L'x';
+		pwszStr2[uPrefixLength + 1] = L'x';
+	}
+	std::printf("\n");
+}
+
+extern "C" unsigned _MCFCRT_Main(void) noexcept {
+	std::memset(g_achBuffer1, 'x', sizeof(g_achBuffer1));
+	std::memset(g_achBuffer2, 'x', sizeof(g_achBuffer2));
+	std::wmemset(g_awcBuffer1, L'x', sizeof(g_awcBuffer1) / sizeof(wchar_t));
+	std::wmemset(g_awcBuffer2, L'x', sizeof(g_awcBuffer2) / sizeof(wchar_t));
+
+	static constexpr const char *kIsaNames[] = { "sse2", "avx2", "avx512" };
+	const auto eDefaultIsa = ::__MCFCRT_StringDispatchGetIsa();
+	for(unsigned uIsa = ::__MCFCRT_kStringIsaSse2; uIsa < ::__MCFCRT_kStringIsaEnd; ++uIsa){
+		if(!::__MCFCRT_StringDispatchSetIsa(static_cast<::__MCFCRT_StringIsa>(uIsa))){
+			std::printf("%s : not supported\n\n", kIsaNames[uIsa]);
+			continue;
+		}
+		std::printf("%-20s", kIsaNames[uIsa]);
+		for(const auto uPrefixLength : kPrefixLengths){
+			std::printf("   %8zu", uPrefixLength);
+		}
+		std::printf("\n");
+		RunNarrow("strcmp"            , [](const char *s1, const char *s2){ return std::strcmp(s1, s2); });
+		RunNarrow("strncmp"           , [](const char *s1, const char *s2){ return std::strncmp(s1, s2, 0x10000); });
+		RunNarrow("_MCFCRT_strmismatch", [](const char *s1, const char *s2){ return ::_MCFCRT_strmismatch(s1, s2); });
+		RunWide  ("wcscmp"            , [](const wchar_t *s1, const wchar_t *s2){ return std::wcscmp(s1, s2); });
+		RunWide  ("wcsncmp"           , [](const wchar_t *s1, const wchar_t *s2){ return std::wcsncmp(s1, s2, 0x10000); });
+		RunWide  ("_MCFCRT_wcsmismatch", [](const wchar_t *s1, const wchar_t *s2){ return ::_MCFCRT_wcsmismatch(s1, s2); });
+		std::printf("\n");
+	}
+	::__MCFCRT_StringDispatchSetIsa(eDefaultIsa);
+	return 0;
+}
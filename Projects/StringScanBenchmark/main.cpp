@@ -0,0 +1,102 @@
+#include <MCF/StdMCF.hpp>
+#include <MCF/Core/Clocks.hpp>
+#include <MCF/Core/MinMax.hpp>
+#include <MCFCRT/env/_string_dispatch.h>
+#include <MCFCRT/ext/memrchr.h>
+#include <MCFCRT/ext/rawmemchr.h>
+#include <cstring>
+#include <cwchar>
+
+using namespace MCF;
+
+// Each function scans strings of every length in `kLengths`, which are short, medium and long. Each measurement scans
+// about `kBytesPerRun` bytes, or repeats at least `kMinIterations` times, and the throughput is printed in GiB/s.
+// The measurements are repeated for each instruction set that the CPU supports. The SSE2 ones are the old code.
+
+constexpr std::size_t kLengths[] = {
+	15, 64, 255, 1000, 4096, 65536, 0x100000,
+};
+constexpr std::size_t kBytesPerRun   = 0x10000000;
+constexpr std::size_t kMinIterations = 16;
+constexpr std::size_t kMaxIterations = 10000000;
+constexpr std::size_t kBufferSize    = kLengths[sizeof(kLengths) / sizeof(kLengths[0]) - 1] * sizeof(wchar_t) + 0x1000;
+
+// The buffers are filled with 'a'. The last character of each string is 'z', which is followed by a null character.
+// Strings start 3 characters past page boundaries.
+alignas(4096) char g_achBuffer[kBufferSize];
+alignas(4096) wchar_t g_awcBuffer[kBufferSize / sizeof(wchar_t)];
+
+template<typename FunctionT>
+void Measure(std::size_t uBytes, FunctionT &&vFunction){
+	const auto uIterations = Min(Max(kBytesPerRun / uBytes, kMinIterations), kMaxIterations);
+	// Warm up.
+	vFunction();
+	const auto t1 = GetHiResMonoClock();
+	for(std::size_t i = 0; i < uIterations; ++i){
+		auto vResult = vFunction();
+		__asm__ volatile ("" : "+r"(vResult) : : "memory");
+	}
+	const auto t2 = GetHiResMonoClock();
+	const auto dGibPerSec = static_cast<double>(uBytes) * static_cast<double>(uIterations) / ((t2 - t1) / 1000) / 0x40000000;
+	std::printf("   %11.3f", dGibPerSec);
+}
+
+template<typename FunctionT>
+void RunNarrow(const char *pszName, FunctionT &&vFunction){
+	std::printf("%-20s", pszName);
+	for(const auto uLength : kLengths){
+		const auto pszStr = g_achBuffer + 3;
+		pszStr[uLength - 1] = 'z';
+		pszStr[uLength] = 0;
+		Measure(uLength, [&]{ return vFunction(pszStr, uLength); });
+		pszStr[uLength - 1] = 'a';
+		pszStr[uLength] = 'a';
+	}
+	std::printf("\n");
+}
+template<typename FunctionT>
+void RunWide(const char *pszName, FunctionT &&vFunction){
+	std::printf("%-20s", pszName);
+	for(const auto uLength : kLengths){
+		const auto pwszStr = g_awcBuffer + 3;
+		pwszStr[uLength - 1] = L'z';
+		pwszStr[uLength] = 0;
+		Measure(uLength * sizeof(wchar_t), [&]{ return vFunction(pwszStr, uLength); });
+		pwszStr[uLength - 1] = L'a';
+		pwszStr[uLength] = L'a';
+	}
+	std::printf("\n");
+}
+
+extern "C" unsigned _MCFCRT_Main(void) noexcept {
+	std::memset(g_achBuffer, 'a', sizeof(g_achBuffer));
+	std::wmemset(g_awcBuffer, L'a', sizeof(g_awcBuffer) / sizeof(wchar_t));
+
+	static constexpr const char *kIsaNames[] = { "sse2", "avx2", "avx512" };
+	const auto eDefaultIsa = ::__MCFCRT_StringDispatchGetIsa();
+	for(unsigned uIsa = ::__MCFCRT_kStringIsaSse2; uIsa < ::__MCFCRT_kStringIsaEnd; ++uIsa){
+		if(!::__MCFCRT_StringDispatchSetIsa(static_cast<::__MCFCRT_StringIsa>(uIsa))){
+			std::printf("%s : not supported\n\n", kIsaNames[uIsa]);
+			continue;
+		}
+		std::printf("%-20s", kIsaNames[uIsa]);
+		for(const auto uLength : kLengths){
+			std::printf("   %11zu", uLength);
+		}
+		std::printf("\n");
+		RunNarrow("strlen"         , [](const char *s, std::size_t  ){ return std::strlen(s); });
+		RunNarrow("strnlen"        , [](const char *s, std::size_t n){ return ::strnlen(s, n + 1); });
+		RunNarrow("strchr"         , [](const char *s, std::size_t  ){ return std::strchr(s, 'z'); });
+		RunNarrow("strrchr"        , [](const char *s, std::size_t  ){ return std::strrchr(s, 'a'); });
+		RunNarrow("memchr"         , [](const char *s, std::size_t n){ return std::memchr(s, 'z', n); });
+		RunNarrow("_MCFCRT_rawmemchr", [](const char *s, std::size_t  ){ return ::_MCFCRT_rawmemchr(s, 'z'); });
+		RunNarrow("_MCFCRT_memrchr", [](const char *s, std::size_t n){ return ::_MCFCRT_memrchr(s, 'y', n); });
+		RunWide  ("wcslen"         , [](const wchar_t *s, std::size_t  ){ return std::wcslen(s); });
+		RunWide  ("wcschr"         , [](const wchar_t *s, std::size_t  ){ return std::wcschr(s, L'z'); });
+		RunWide  ("wcsrchr"        , [](const wchar_t *s, std::size_t  ){ return std::wcsrchr(s, L'a'); });
+		RunWide  ("wmemchr"        , [](const wchar_t *s, std::size_t n){ return std::wmemchr(s, L'z', n); });
+		std::printf("\n");
+	}
+	::__MCFCRT_StringDispatchSetIsa(eDefaultIsa);
+	return 0;
+}
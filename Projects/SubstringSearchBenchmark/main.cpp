@@ -0,0 +1,104 @@
+#include <MCF/StdMCF.hpp>
+#include <MCF/Core/Clocks.hpp>
+#include <MCF/Core/MinMax.hpp>
+#include <MCF/Core/StringView.hpp>
+#include <MCFCRT/env/_string_dispatch.h>
+#include <cstring>
+#include <cwchar>
+
+using namespace MCF;
+
+// Each function searches a haystack of `kHaystackLength` random letters for needles of every length in
+// `kNeedleLengths`. The needles are copied from the end of the haystack, so most of the haystack is scanned before a
+// match is found. Each measurement repeats at least `kMinIterations` times, and the time of each call is printed in
+// microseconds.
+// `FindSpan` is the old code, which does not depend on the instruction set. The others are repeated for each instruction
+// set that the CPU supports.
+
+constexpr std::size_t kNeedleLengths[] = {
+	1, 2, 3, 4, 6, 8, 12, 16, 24, 32, 48, 64, 96, 128, 192, 256,
+};
+constexpr std::size_t kHaystackLength = 0x10000;
+constexpr std::size_t kMinIterations  = 0x400;
+
+char g_achHaystack[kHaystackLength + 1];
+char g_achNeedle[kHaystackLength + 1];
+wchar_t g_awcHaystack[kHaystackLength + 1];
+wchar_t g_awcNeedle[kHaystackLength + 1];
+
+template<typename FunctionT>
+void Measure(FunctionT &&vFunction){
+	// Warm up.
+	vFunction();
+	const auto t1 = GetHiResMonoClock();
+	for(std::size_t i = 0; i < kMinIterations; ++i){
+		auto vResult = vFunction();
+		__asm__ volatile ("" : "+r"(vResult) : : "memory");
+	}
+	const auto t2 = GetHiResMonoClock();
+	const auto dMicroSecPerCall = (t2 - t1) * 1000 / static_cast<double>(kMinIterations);
+	std::printf("   %8.2f", dMicroSecPerCall);
+}
+
+template<typename FunctionT>
+void RunNarrow(const char *pszName, FunctionT &&vFunction){
+	std::printf("%-20s", pszName);
+	for(const auto uNeedleLength : kNeedleLengths){
+		std::memcpy(g_achNeedle, g_achHaystack + kHaystackLength - uNeedleLength, uNeedleLength);
+		g_achNeedle[uNeedleLength] = 0;
+		Measure([&]{ return vFunction(g_achHaystack, kHaystackLength, g_achNeedle, uNeedleLength); });
+	}
+	std::printf("\n");
+}
+template<typename FunctionT>
+void RunWide(const char *pszName, FunctionT &&vFunction){
+	std::printf("%-20s", pszName);
+	for(const auto uNeedleLength : kNeedleLengths){
+		std::wmemcpy(g_awcNeedle, g_awcHaystack + kHaystackLength - uNeedleLength, uNeedleLength);
+		g_awcNeedle[uNeedleLength] = 0;
+		Measure([&]{ return vFunction(g_awcHaystack, kHaystackLength, g_awcNeedle, uNeedleLength); });
+	}
+	std::printf("\n");
+}
+
+void PrintHeader(const char *pszName){
+	std::printf("%-20s", pszName);
+	for(const auto uNeedleLength : kNeedleLengths){
+		std::printf("   %8zu", uNeedleLength);
+	}
+	std::printf("\n");
+}
+
+extern "C" unsigned _MCFCRT_Main(void) noexcept {
+	// Use a small alphabet, so short needles match partially at many places.
+	std::uint32_t u32Seed = 12345;
+	for(std::size_t i = 0; i < kHaystackLength; ++i){
+		u32Seed = u32Seed * 1664525 + 1013904223;
+		g_achHaystack[i] = static_cast<char>('a' + (u32Seed >> 24) % 8);
+		g_awcHaystack[i] = static_cast<wchar_t>(L'a' + (u32Seed >> 24) % 8);
+	}
+	g_achHaystack[kHaystackLength] = 0;
+	g_awcHaystack[kHaystackLength] = 0;
+
+	PrintHeader("FindSpan");
+	RunNarrow("char"  , [](const char *h, std::size_t hl, const char *n, std::size_t nl){ return Impl_StringTraits::FindSpan(h, h + hl, n, n + nl); });
+	RunWide  ("wchar_t", [](const wchar_t *h, std::size_t hl, const wchar_t *n, std::size_t nl){ return Impl_StringTraits::FindSpan(h, h + hl, n, n + nl); });
+	std::printf("\n");
+
+	static constexpr const char *kIsaNames[] = { "sse2", "avx2", "avx512" };
+	const auto eDefaultIsa = ::__MCFCRT_StringDispatchGetIsa();
+	for(unsigned uIsa = ::__MCFCRT_kStringIsaSse2; uIsa < ::__MCFCRT_kStringIsaEnd; ++uIsa){
+		if(!::__MCFCRT_StringDispatchSetIsa(static_cast<::__MCFCRT_StringIsa>(uIsa))){
+			std::printf("%s : not supported\n\n", kIsaNames[uIsa]);
+			continue;
+		}
+		PrintHeader(kIsaNames[uIsa]);
+		RunNarrow("StringView::Find"    , [](const char *h, std::size_t hl, const char *n, std::size_t nl){ return NarrowStringView(h, hl).Find(NarrowStringView(n, nl)); });
+		RunNarrow("strstr"              , [](const char *h, std::size_t  , const char *n, std::size_t   ){ return std::strstr(h, n); });
+		RunWide  ("WideStringView::Find", [](const wchar_t *h, std::size_t hl, const wchar_t *n, std::size_t nl){ return WideStringView(h, hl).Find(WideStringView(n, nl)); });
+		RunWide  ("wcsstr"              , [](const wchar_t *h, std::size_t  , const wchar_t *n, std::size_t   ){ return std::wcsstr(h, n); });
+		std::printf("\n");
+	}
+	::__MCFCRT_StringDispatchSetIsa(eDefaultIsa);
+	return 0;
+}
@@ -4,11 +4,16 @@
 #include <MCF/Core/DynamicLinkLibrary.hpp>
 #include <MCF/Core/String.hpp>
 #include <MCF/Core/LastError.hpp>
-#include <MCF/Core/CopyMoveFill.hpp>
 #include <MCF/Core/MinMax.hpp>
+#include <MCFCRT/env/_string_dispatch.h>
 
 using namespace MCF;
 
+// For each `memcpy()` implementation, every size in `kSizes` is copied with every pair of destination and source offsets
+// (relative to a 4KiB boundary) in `kOffsets`. Each measurement copies about `kBytesPerRun` bytes, or repeats at least
+// `kMinIterations` times, and the throughput is printed in GiB/s.
+// MCFCRT is measured once for each instruction set that the CPU supports.
+
 struct PageDeleter {
 	constexpr void *operator()() const noexcept {
 		return nullptr;
@@ -18,39 +23,89 @@ struct PageDeleter {
 	}
 };
 
-using Char = char;
+using Memcpy = void * (*)(void *, const void *, std::size_t);
 
-constexpr std::size_t size = 0x100;
+constexpr std::size_t kSizes[] = {
+	1, 7, 16, 31, 64, 100, 256, 1000, 4096, 16384, 65536, 262144,
+	0x100000, 0x400000, 0x1000000, 0x4000000,
+};
+constexpr struct {
+	std::size_t uDst;
+	std::size_t uSrc;
+} kOffsets[] = {
+	{  0,  0 }, {  0,  1 }, {  1,  0 }, {  3, 17 }, { 32,  0 }, { 63, 31 },
+};
+constexpr std::size_t kBytesPerRun   = 0x10000000;
+constexpr std::size_t kMinIterations = 16;
+constexpr std::size_t kMaxIterations = 10000000;
+constexpr std::size_t kBufferSize    = kSizes[sizeof(kSizes) / sizeof(kSizes[0]) - 1] + 0x1000;
 
-extern "C" unsigned _MCFCRT_Main(void) noexcept {
+void *g_pDst;
+void *g_pSrc;
 
-	const UniquePtr<void, PageDeleter> p1(::VirtualAlloc(nullptr, size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE));
-	const UniquePtr<void, PageDeleter> p2(::VirtualAlloc(nullptr, size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE));
-	const auto s1b = (Char *)((char *)p1.Get() + 4);
-	const auto s1e = (Char *)((char *)p1.Get() + size);
-	const auto s2b = (Char *)((char *)p2.Get() + 2);
-	const auto s2e = (Char *)((char *)p2.Get() + size);
-	const auto len = (std::size_t)Min(s1e - s1b, s2e - s2b);
-	for(std::size_t i = 0; i < len; ++i){
-		s1b[i] = s2b[i] = (Char)(i | 1);
+void RunSweep(const char *pszName, Memcpy pfnMemcpy){
+	std::printf("%-20s", pszName);
+	for(const auto &vOffset : kOffsets){
+		std::printf("   d+%-2u s+%-2u", static_cast<unsigned>(vOffset.uDst), static_cast<unsigned>(vOffset.uSrc));
 	}
-	s1e[-2] = (Char)0x1234;
-	s1b[len - 1] = s2b[len - 1] = 0;
-
-	const auto test = [&](WideStringView name){
-		const auto fname = "memcpy"_nsv;
-		try {
-			const DynamicLinkLibrary dll(name);
-			const auto pf = dll.RequireProcAddress<Char * (*)(Char *, const Char *, std::size_t)>(fname);
-			std::ptrdiff_t r;
+	std::printf("\n");
+	for(const auto uSize : kSizes){
+		std::printf("%20zu", uSize);
+		const auto uIterations = Min(Max(kBytesPerRun / uSize, kMinIterations), kMaxIterations);
+		for(const auto &vOffset : kOffsets){
+			const auto pDst = static_cast<char *>(g_pDst) + vOffset.uDst;
+			const auto pSrc = static_cast<const char *>(g_pSrc) + vOffset.uSrc;
+			// Warm up.
+			(*pfnMemcpy)(pDst, pSrc, uSize);
 			const auto t1 = GetHiResMonoClock();
-			for(std::uint64_t i = 0; i < 100000000; ++i){
-				r = (std::ptrdiff_t)(*pf)(s1b, s2b, len);
+			for(std::size_t i = 0; i < uIterations; ++i){
+				(*pfnMemcpy)(pDst, pSrc, uSize);
+				__asm__ volatile ("" : : : "memory");
 			}
 			const auto t2 = GetHiResMonoClock();
-			std::printf("%-10s.%s : t = %f, r = %td\n", AnsiString(name).GetStr(), AnsiString(fname).GetStr(), t2 - t1, r);
+			const auto dGibPerSec = static_cast<double>(uSize) * static_cast<double>(uIterations) / ((t2 - t1) / 1000) / 0x40000000;
+			std::printf("   %11.3f", dGibPerSec);
+		}
+		std::printf("\n");
+	}
+	std::printf("\n");
+}
+
+extern "C" unsigned _MCFCRT_Main(void) noexcept {
+	const UniquePtr<void, PageDeleter> pDst(::VirtualAlloc(nullptr, kBufferSize, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE));
+	const UniquePtr<void, PageDeleter> pSrc(::VirtualAlloc(nullptr, kBufferSize, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE));
+	if(!pDst || !pSrc){
+		std::printf("VirtualAlloc() failed\n");
+		return 1;
+	}
+	g_pDst = pDst.Get();
+	g_pSrc = pSrc.Get();
+	// Commit all pages.
+	for(std::size_t i = 0; i < kBufferSize; ++i){
+		static_cast<unsigned char *>(g_pDst)[i] = 0;
+		static_cast<unsigned char *>(g_pSrc)[i] = static_cast<unsigned char>(i | 1);
+	}
+
+	const auto test = [&](WideStringView wsvName){
+		try {
+			const DynamicLinkLibrary vDll(wsvName);
+			const auto pfnMemcpy = vDll.RequireProcAddress<Memcpy>("memcpy"_nsv);
+			if(wsvName != "MCFCRT-2"_wsv){
+				RunSweep(AnsiString(wsvName).GetStr(), pfnMemcpy);
+				return;
+			}
+			static constexpr const char *kIsaNames[] = { "MCFCRT-2 (sse2)", "MCFCRT-2 (avx2)", "MCFCRT-2 (avx512)" };
+			const auto eDefaultIsa = ::__MCFCRT_StringDispatchGetIsa();
+			for(unsigned uIsa = ::__MCFCRT_kStringIsaSse2; uIsa < ::__MCFCRT_kStringIsaEnd; ++uIsa){
+				if(!::__MCFCRT_StringDispatchSetIsa(static_cast<::__MCFCRT_StringIsa>(uIsa))){
+					std::printf("%s : not supported\n\n", kIsaNames[uIsa]);
+					continue;
+				}
+				RunSweep(kIsaNames[uIsa], pfnMemcpy);
+			}
+			::__MCFCRT_StringDispatchSetIsa(eDefaultIsa);
 		} catch(Exception &e){
-			std::printf("%-10s.%s : error %lu : %s\n", AnsiString(name).GetStr(), AnsiString(fname).GetStr(), e.GetErrorCode(), AnsiString(GetWin32ErrorDescription(e.GetErrorCode())).GetStr());
+			std::printf("%s : error %lu : %s\n\n", AnsiString(wsvName).GetStr(), e.GetErrorCode(), AnsiString(GetWin32ErrorDescription(e.GetErrorCode())).GetStr());
 		}
 	};
 
@@ -61,36 +116,5 @@ extern "C" unsigned _MCFCRT_Main(void) noexcept {
 	test("MSVCR120"_wsv);
 	test("UCRTBASE"_wsv);
 	test("MCFCRT-2"_wsv);
-
-/*
-	static struct { char a[21]; char s[200]; } __attribute__((__aligned__(64))) s1 = { "", "0123456789abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVW\0XYZ" };
-	static struct { char a[ 1]; char s[200]; } __attribute__((__aligned__(64))) s2 = { "", "0123456789abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVW\0XYZ" };
-	const DynamicLinkLibrary dll(L"MCFCRT-2"_wsv);
-	const auto pf = dll.RequireProcAddress<int (*)(const char *, const char *, std::size_t)>("memcmp"_nsv);
-	std::printf("%d\n", pf(s1.s, s2.s, 62));
-*/
-/*
-	static constexpr std::size_t buff_len = 2000;
-	static wchar_t dstb[buff_len], srcb[buff_len];
-	for(std::size_t i = 0; i < buff_len / 2 - 10; ++i){
-		std::memset(dstb, 'z', sizeof(dstb));
-		std::memset(srcb, 'a', sizeof(srcb));
-		wchar_t *const dst = dstb + i + 1;
-		wchar_t *const src = srcb + i + 2;
-		src[i] = 0;
-		constexpr std::size_t max_len = buff_len * 2 / 5;
-		const auto epd = ::_MCFCRT_wcppcpy(dst, dst + max_len, src);
-		std::printf("i = %zu\n", i);
-//		std::printf("  src = %s$\n", (char *)src);
-//		std::printf("  dst = %s$\n", (char *)dst);
-		const int cmp = std::wcscmp(src, dst);
-		const std::size_t len = (std::size_t)(epd - dst);
-		const int end = dst[i + 1];
-		std::printf("  cmp = %d, len = %zd, end = %x\n", cmp, len, end);
-		if((len != std::min(i, max_len - 1)) || (end != dstb[0])){
-			std::abort();
-		}
-	}
-*/
 	return 0;
 }
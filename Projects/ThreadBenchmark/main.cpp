@@ -0,0 +1,144 @@
+#include <MCF/StdMCF.hpp>
+#include <MCF/Core/Clocks.hpp>
+#include <MCFCRT/env/c11thread.h>
+#include <MCFCRT/env/_mopthread.h>
+#include <MCFCRT/env/thread.h>
+
+using namespace MCF;
+
+// Spawn latency is the time from calling `thrd_create()` until the new thread starts running, which is measured `kLatencyCount` times.
+// Then up to 16 threads are released at the same time, each of which creates and joins `kIterationCount` threads one by one.
+// Both are done without and with the thread cache, which saves creation and destruction of native threads.
+// Then the same number of threads look up the handle of a long-lived thread `kLookupCount` times each.
+// With a single registry lock both would serialize on it. They should scale with the number of spawners instead.
+
+constexpr std::size_t kLatencyCount   = 10000;
+constexpr std::size_t kIterationCount = 2000;
+constexpr std::size_t kLookupCount    = 1000000;
+constexpr std::size_t kCacheCapacity  = 64;
+
+volatile bool g_bStart;
+volatile bool g_bStop;
+volatile std::size_t g_uFailures;
+volatile std::uintptr_t g_uTarget;
+
+int Nop(void *){
+	return 0;
+}
+
+volatile double g_dStarted;
+
+int RecordStart(void *){
+	g_dStarted = GetHiResMonoClock();
+	return 0;
+}
+
+bool RunLatency(){
+	double dLatency = 0;
+	const auto t1 = GetHiResMonoClock();
+	for(std::size_t i = 0; i < kLatencyCount; ++i){
+		::thrd_t tid;
+		const auto t = GetHiResMonoClock();
+		if((::thrd_create(&tid, &RecordStart, nullptr) != thrd_success) || (::thrd_join(tid, nullptr) != thrd_success)){
+			std::printf("thrd_create() or thrd_join() failed\n");
+			return false;
+		}
+		dLatency += g_dStarted - t;
+	}
+	const auto t2 = GetHiResMonoClock();
+	std::printf("spawn latency  : %7.3f us, %7.3f us per create/join\n",
+		dLatency * 1000 / kLatencyCount, (t2 - t1) * 1000 / kLatencyCount);
+	return true;
+}
+
+unsigned long __attribute__((__stdcall__)) SpawnerProc(void *){
+	while(!__atomic_load_n(&g_bStart, __ATOMIC_ACQUIRE)){
+		__builtin_ia32_pause();
+	}
+	for(std::size_t i = 0; i < kIterationCount; ++i){
+		::thrd_t tid;
+		if((::thrd_create(&tid, &Nop, nullptr) != thrd_success) || (::thrd_join(tid, nullptr) != thrd_success)){
+			__atomic_add_fetch(&g_uFailures, 1, __ATOMIC_RELAXED);
+			return 1;
+		}
+	}
+	return 0;
+}
+
+unsigned long __attribute__((__stdcall__)) LookupProc(void *){
+	while(!__atomic_load_n(&g_bStart, __ATOMIC_ACQUIRE)){
+		__builtin_ia32_pause();
+	}
+	for(std::size_t i = 0; i < kLookupCount; ++i){
+		const auto phThread = ::__MCFCRT_MopthreadLockHandle(g_uTarget);
+		if(!phThread){
+			__atomic_add_fetch(&g_uFailures, 1, __ATOMIC_RELAXED);
+			return 1;
+		}
+		::__MCFCRT_MopthreadUnlockHandle(phThread);
+	}
+	return 0;
+}
+
+double Run(::_MCFCRT_NativeThreadProc pfnProc, std::size_t uSpawnerCount){
+	__atomic_store_n(&g_bStart, false, __ATOMIC_RELAXED);
+
+	::_MCFCRT_ThreadHandle ahThreads[64];
+	for(std::size_t i = 0; i < uSpawnerCount; ++i){
+		ahThreads[i] = ::_MCFCRT_CreateNativeThread(pfnProc, nullptr, false, nullptr);
+		if(!ahThreads[i]){
+			std::printf("_MCFCRT_CreateNativeThread() failed\n");
+			std::exit(1);
+		}
+	}
+	const auto t1 = GetHiResMonoClock();
+	__atomic_store_n(&g_bStart, true, __ATOMIC_RELEASE);
+	for(std::size_t i = 0; i < uSpawnerCount; ++i){
+		::_MCFCRT_WaitForThreadForever(ahThreads[i]);
+		::_MCFCRT_CloseThread(ahThreads[i]);
+	}
+	const auto t2 = GetHiResMonoClock();
+	if(g_uFailures != 0){
+		std::printf("threads = %2u : %u threads failed\n", static_cast<unsigned>(uSpawnerCount), static_cast<unsigned>(g_uFailures));
+		std::exit(1);
+	}
+	return t2 - t1;
+}
+
+int Idle(void *){
+	while(!__atomic_load_n(&g_bStop, __ATOMIC_ACQUIRE)){
+		::_MCFCRT_Sleep(::_MCFCRT_GetFastMonoClock() + 10);
+	}
+	return 0;
+}
+
+extern "C" unsigned _MCFCRT_Main(void) noexcept {
+	for(const auto uCapacity : { std::size_t(0), kCacheCapacity }){
+		::__MCFCRT_MopthreadSetCacheCapacity(uCapacity);
+		std::printf("--- cache capacity = %u\n", static_cast<unsigned>(uCapacity));
+		if(!RunLatency()){
+			return 1;
+		}
+		for(const auto uSpawnerCount : { 1u, 2u, 4u, 8u, 16u }){
+			const auto dDelta = Run(&SpawnerProc, uSpawnerCount);
+			std::printf("spawners = %2u : %9.3f creates/s, %7.3f us per create/join\n",
+				uSpawnerCount, uSpawnerCount * kIterationCount / dDelta * 1000, dDelta * 1000 / kIterationCount);
+		}
+	}
+	::__MCFCRT_MopthreadSetCacheCapacity(0);
+
+	::thrd_t tidTarget;
+	if(::thrd_create(&tidTarget, &Idle, nullptr) != thrd_success){
+		std::printf("thrd_create() failed\n");
+		return 1;
+	}
+	g_uTarget = tidTarget;
+	for(const auto uSpawnerCount : { 1u, 2u, 4u, 8u, 16u }){
+		const auto dDelta = Run(&LookupProc, uSpawnerCount);
+		std::printf("lookups  = %2u : %7.3f ns per handle lookup\n",
+			uSpawnerCount, dDelta * 1.0e6 / kLookupCount);
+	}
+	__atomic_store_n(&g_bStop, true, __ATOMIC_RELEASE);
+	::thrd_join(tidTarget, nullptr);
+	return 0;
+}
@@ -0,0 +1,121 @@
+#include <MCF/StdMCF.hpp>
+#include <MCF/Core/Clocks.hpp>
+#include <MCF/Thread/ThreadPool.hpp>
+#include <MCF/Containers/Vector.hpp>
+
+using namespace MCF;
+
+// Throughput: `kTaskCount` empty tasks are submitted from outside the pool, then from a single task running on a worker, which pushes them onto its own deque.
+// `ParallelFor()` then runs over `kIndexCount` indices, each of which does a tiny amount of work, so the cost is dominated by scheduling.
+// Latency is the time from `Submit()` until the task starts running, and the round trip of `Submit()` followed by `Wait()`, both measured `kLatencyCount` times.
+
+constexpr std::size_t kTaskCount    = 1000000;
+constexpr std::size_t kIndexCount   = 10000000;
+constexpr std::size_t kLatencyCount = 100000;
+
+volatile std::size_t g_uCounter;
+volatile double g_dStarted;
+
+void Increment() noexcept {
+	__atomic_add_fetch(&g_uCounter, 1, __ATOMIC_RELAXED);
+}
+
+bool RunSubmit(ThreadPool &vPool){
+	Vector<IntrusivePtr<ThreadPoolTask>> vecTasks;
+	vecTasks.Reserve(kTaskCount);
+
+	g_uCounter = 0;
+	const auto t1 = GetHiResMonoClock();
+	for(std::size_t i = 0; i < kTaskCount; ++i){
+		vecTasks.Push(vPool.Submit(&Increment));
+	}
+	for(const auto &pTask : vecTasks){
+		pTask->Wait();
+	}
+	const auto t2 = GetHiResMonoClock();
+	vecTasks.Clear();
+
+	g_uCounter = 0;
+	const auto t3 = GetHiResMonoClock();
+	const auto pRoot = vPool.Submit([&]{
+		for(std::size_t i = 0; i < kTaskCount; ++i){
+			vecTasks.Push(vPool.Submit(&Increment));
+		}
+	});
+	pRoot->Wait();
+	pRoot->Rethrow();
+	for(const auto &pTask : vecTasks){
+		pTask->Wait();
+	}
+	const auto t4 = GetHiResMonoClock();
+	vecTasks.Clear();
+
+	if(g_uCounter != kTaskCount){
+		std::printf("submit : expecting %u tasks, got %u\n", static_cast<unsigned>(kTaskCount), static_cast<unsigned>(g_uCounter));
+		return false;
+	}
+	std::printf("submit   : external = %9.3f tasks/s, internal = %9.3f tasks/s\n",
+		kTaskCount / (t2 - t1) * 1000, kTaskCount / (t4 - t3) * 1000);
+	return true;
+}
+
+bool RunParallelFor(ThreadPool &vPool){
+	Vector<std::uint32_t> vecData;
+	vecData.Append(kIndexCount, 0u);
+
+	const auto t1 = GetHiResMonoClock();
+	vPool.ParallelFor(0, kIndexCount, [&](std::size_t uIndex){
+		vecData[uIndex] = static_cast<std::uint32_t>(uIndex * 2654435761u);
+	});
+	const auto t2 = GetHiResMonoClock();
+	for(std::size_t i = 0; i < kIndexCount; ++i){
+		if(vecData[i] != static_cast<std::uint32_t>(i * 2654435761u)){
+			std::printf("parallel for : index %u was not visited\n", static_cast<unsigned>(i));
+			return false;
+		}
+	}
+	std::printf("parallel : %9.3f ns per index\n", (t2 - t1) * 1.0e6 / kIndexCount);
+
+	try {
+		vPool.ParallelFor(0, kIndexCount, [&](std::size_t uIndex){
+			if(uIndex == kIndexCount / 3){
+				throw 12345;
+			}
+		});
+		std::printf("parallel for : the exception was not rethrown\n");
+		return false;
+	} catch(int e){
+		if(e != 12345){
+			std::printf("parallel for : the wrong exception was rethrown\n");
+			return false;
+		}
+	}
+	return true;
+}
+
+bool RunLatency(ThreadPool &vPool){
+	double dLatency = 0;
+	const auto t1 = GetHiResMonoClock();
+	for(std::size_t i = 0; i < kLatencyCount; ++i){
+		const auto t = GetHiResMonoClock();
+		const auto pTask = vPool.Submit([]{ g_dStarted = GetHiResMonoClock(); });
+		pTask->Wait();
+		dLatency += g_dStarted - t;
+	}
+	const auto t2 = GetHiResMonoClock();
+	std::printf("latency  : %7.3f us to start, %7.3f us per submit/wait\n",
+		dLatency * 1000 / kLatencyCount, (t2 - t1) * 1000 / kLatencyCount);
+	return true;
+}
+
+extern "C" unsigned _MCFCRT_Main(void) noexcept {
+	for(const auto uWorkerCount : { 1u, 2u, 4u, 0u }){
+		ThreadPool vPool(uWorkerCount);
+		std::printf("--- workers = %u\n", static_cast<unsigned>(vPool.GetWorkerCount()));
+		if(!RunSubmit(vPool) || !RunParallelFor(vPool) || !RunLatency(vPool)){
+			return 1;
+		}
+		vPool.Shutdown();
+	}
+	return 0;
+}
@@ -0,0 +1,134 @@
+#include <MCF/StdMCF.hpp>
+#include <MCF/Core/Clocks.hpp>
+#include <MCFCRT/pre/tls.h>
+#include <MCFCRT/env/thread.h>
+#include <MCFCRT/env/heap.h>
+
+using namespace MCF;
+
+// Every key is required once on this thread, then looked up `kLookupCount` times in a round-robin manner.
+// Lookups should take constant time regardless of the number of live keys.
+// Then `kThreadCount` threads are created one by one, each of which requires up to `kKeysPerThread` keys and exits.
+// Heap allocations are counted, as thread-local objects are created and destroyed along with every thread.
+
+constexpr std::size_t kLookupCount = 10000000;
+constexpr std::size_t kMaxKeyCount = 1000;
+constexpr std::size_t kThreadCount   = 2000;
+constexpr std::size_t kKeysPerThread = 30;
+
+_MCFCRT_TlsKeyHandle g_ahKeys[kMaxKeyCount];
+
+unsigned long Construct(std::intptr_t nContext, void *pStorage){
+	*static_cast<std::intptr_t *>(pStorage) = nContext;
+	return 0;
+}
+
+bool Run(std::size_t uKeyCount){
+	for(std::size_t i = 0; i < uKeyCount; ++i){
+		g_ahKeys[i] = ::_MCFCRT_TlsAllocKey(sizeof(std::intptr_t), &Construct, nullptr, static_cast<std::intptr_t>(i));
+		if(!g_ahKeys[i]){
+			std::printf("keys = %4u : _MCFCRT_TlsAllocKey() failed\n", static_cast<unsigned>(uKeyCount));
+			return false;
+		}
+		void *pStorage;
+		if(!::_MCFCRT_TlsRequire(g_ahKeys[i], &pStorage)){
+			std::printf("keys = %4u : _MCFCRT_TlsRequire() failed\n", static_cast<unsigned>(uKeyCount));
+			return false;
+		}
+	}
+
+	std::intptr_t nSum = 0;
+	const auto t1 = GetHiResMonoClock();
+	for(std::size_t i = 0, j = 0; i < kLookupCount; ++i){
+		void *pStorage;
+		::_MCFCRT_TlsGet(g_ahKeys[j], &pStorage);
+		nSum += *static_cast<const std::intptr_t *>(pStorage);
+		if(++j == uKeyCount){
+			j = 0;
+		}
+	}
+	const auto t2 = GetHiResMonoClock();
+	for(std::size_t i = 0, j = 0; i < kLookupCount; ++i){
+		void *pStorage;
+		::_MCFCRT_TlsRequire(g_ahKeys[j], &pStorage);
+		nSum += *static_cast<const std::intptr_t *>(pStorage);
+		if(++j == uKeyCount){
+			j = 0;
+		}
+	}
+	const auto t3 = GetHiResMonoClock();
+	std::printf("keys = %4u : _MCFCRT_TlsGet() = %7.3f ns, _MCFCRT_TlsRequire() = %7.3f ns (checksum = %lld)\n",
+		static_cast<unsigned>(uKeyCount), (t2 - t1) * 1.0e6 / kLookupCount, (t3 - t2) * 1.0e6 / kLookupCount, static_cast<long long>(nSum));
+
+	// A key that reuses the index of a freed key must not see storage of the freed key.
+	::_MCFCRT_TlsFreeKey(g_ahKeys[0]);
+	g_ahKeys[0] = ::_MCFCRT_TlsAllocKey(sizeof(std::intptr_t), &Construct, nullptr, -1);
+	void *pStorage;
+	if(g_ahKeys[0] && ::_MCFCRT_TlsGet(g_ahKeys[0], &pStorage)){
+		std::printf("keys = %4u : storage of a freed key was found\n", static_cast<unsigned>(uKeyCount));
+		return false;
+	}
+
+	for(std::size_t i = 0; i < uKeyCount; ++i){
+		::_MCFCRT_TlsFreeKey(g_ahKeys[i]);
+	}
+	return true;
+}
+
+unsigned long __attribute__((__stdcall__)) ThreadProc(void *pParam){
+	const auto uKeyCount = *static_cast<const std::size_t *>(pParam);
+	for(std::size_t i = 0; i < uKeyCount; ++i){
+		void *pStorage;
+		if(!::_MCFCRT_TlsRequire(g_ahKeys[i], &pStorage)){
+			return 1;
+		}
+	}
+	return 0;
+}
+
+bool RunThreads(std::size_t uKeyCount){
+	for(std::size_t i = 0; i < uKeyCount; ++i){
+		g_ahKeys[i] = ::_MCFCRT_TlsAllocKey(sizeof(std::intptr_t), &Construct, nullptr, static_cast<std::intptr_t>(i));
+		if(!g_ahKeys[i]){
+			std::printf("threads : _MCFCRT_TlsAllocKey() failed\n");
+			return false;
+		}
+	}
+
+	::_MCFCRT_HeapStatistics vStatsBefore, vStatsAfter;
+	::_MCFCRT_HeapGetStatistics(&vStatsBefore);
+	const auto t1 = GetHiResMonoClock();
+	for(std::size_t i = 0; i < kThreadCount; ++i){
+		const auto hThread = ::_MCFCRT_CreateNativeThread(&ThreadProc, &uKeyCount, false, nullptr);
+		if(!hThread){
+			std::printf("threads : _MCFCRT_CreateNativeThread() failed\n");
+			return false;
+		}
+		::_MCFCRT_WaitForThreadForever(hThread);
+		::_MCFCRT_CloseThread(hThread);
+	}
+	const auto t2 = GetHiResMonoClock();
+	::_MCFCRT_HeapGetStatistics(&vStatsAfter);
+	std::printf("threads = %4u, keys per thread = %2u : %9.3f threads/s, %7.2f allocations/thread\n",
+		static_cast<unsigned>(kThreadCount), static_cast<unsigned>(uKeyCount), kThreadCount / (t2 - t1) * 1000,
+		static_cast<double>(vStatsAfter.__u64AllocCount - vStatsBefore.__u64AllocCount) / kThreadCount);
+
+	for(std::size_t i = 0; i < uKeyCount; ++i){
+		::_MCFCRT_TlsFreeKey(g_ahKeys[i]);
+	}
+	return true;
+}
+
+extern "C" unsigned _MCFCRT_Main(void) noexcept {
+	for(const auto uKeyCount : { 1u, 16u, 1000u }){
+		if(!Run(uKeyCount)){
+			return 1;
+		}
+	}
+	for(const auto uKeyCount : { std::size_t(0), std::size_t(1), kKeysPerThread }){
+		if(!RunThreads(uKeyCount)){
+			return 1;
+		}
+	}
+	return 0;
+}